@@ -0,0 +1,1470 @@
+/*--------------------------------------------------------------------*/
+/* benchhashext.c                                                     */
+/* Author: Ryan Chen                                                  */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE
+#include "symtablehash.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <time.h>
+#include <string.h>
+#include <assert.h>
+#include <ctype.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+/*--------------------------------------------------------------------*/
+
+/* A Benchmark pairs the name given on the command line with the
+   function that runs it for a binding count. */
+struct Benchmark
+{
+   /* the name of the benchmark */
+   const char *pcName;
+
+   /* the function that runs the benchmark */
+   void (*pfRun)(int iBindingCount);
+};
+
+/*--------------------------------------------------------------------*/
+
+/* A Position is a small struct of the kind a symbol table binds to
+   each name. */
+struct Position
+{
+   int iLine;
+   int iColumn;
+   double dWeight;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Return the CPU time in seconds consumed between iInitialClock and
+   iFinalClock. */
+
+static double seconds(clock_t iInitialClock, clock_t iFinalClock)
+{
+   return ((double)(iFinalClock - iInitialClock)) / CLOCKS_PER_SEC;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return an array of iKeyCount keys "0", "1", ... so that key
+   formatting is not part of any timing. Exit with EXIT_FAILURE if
+   insufficient memory is available. */
+
+static char **makeKeys(int iKeyCount)
+{
+   enum {MAX_KEY_LENGTH = 12};
+
+   char **ppcKeys;
+   int i;
+
+   ppcKeys = (char**)malloc(sizeof(char*) * (size_t)(iKeyCount + 1));
+   if (ppcKeys == NULL)
+   {
+      fprintf(stderr, "Insufficient memory\n");
+      exit(EXIT_FAILURE);
+   }
+
+   for (i = 0; i < iKeyCount; i++)
+   {
+      ppcKeys[i] = (char*)malloc(MAX_KEY_LENGTH);
+      if (ppcKeys[i] == NULL)
+      {
+         fprintf(stderr, "Insufficient memory\n");
+         exit(EXIT_FAILURE);
+      }
+      sprintf(ppcKeys[i], "%d", i);
+   }
+
+   return ppcKeys;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a copy of the iKeyCount pointers in ppcKeys in a fixed
+   pseudo-random order, so that lookups do not walk the table in the
+   order the keys were generated. Exit with EXIT_FAILURE if
+   insufficient memory is available. */
+
+static char **shuffleKeys(char **ppcKeys, int iKeyCount)
+{
+   char **ppcShuffled;
+   char *pcTemp;
+   unsigned long ulSeed = 12345;
+   int i;
+   int j;
+
+   ppcShuffled = (char**)malloc(sizeof(char*) * (size_t)(iKeyCount + 1));
+   if (ppcShuffled == NULL)
+   {
+      fprintf(stderr, "Insufficient memory\n");
+      exit(EXIT_FAILURE);
+   }
+   memcpy(ppcShuffled, ppcKeys, sizeof(char*) * (size_t)iKeyCount);
+
+   for (i = iKeyCount - 1; i > 0; i--)
+   {
+      ulSeed = ulSeed * 1103515245UL + 12345UL;
+      j = (int)((ulSeed >> 8) % (unsigned long)(i + 1));
+      pcTemp = ppcShuffled[i];
+      ppcShuffled[i] = ppcShuffled[j];
+      ppcShuffled[j] = pcTemp;
+   }
+
+   return ppcShuffled;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Free the iKeyCount keys in ppcKeys, and ppcKeys itself. */
+
+static void freeKeys(char **ppcKeys, int iKeyCount)
+{
+   int i;
+
+   assert(ppcKeys != NULL);
+
+   for (i = 0; i < iKeyCount; i++)
+      free(ppcKeys[i]);
+   free(ppcKeys);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Free the Position that pvValue points to. */
+
+static void freePosition(const char *pcKey, void *pvValue,
+   void *pvExtra)
+{
+   (void)pcKey;
+   (void)pvExtra;
+   free(pvValue);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Bind iBindingCount keys to Positions, then read the line of each in
+   shuffled order, then free the table. Do it once with each Position
+   allocated separately and bound by pointer, and once with the
+   Positions stored inline by SymTable_putValue. */
+
+static void benchInline(int iBindingCount)
+{
+   enum {LOOKUP_ROUNDS = 10};
+
+   SymTable_T oSymTable;
+   struct Position sPosition;
+   struct Position *psPosition;
+   char **ppcKeys;
+   char **ppcShuffled;
+   clock_t iInitialClock;
+   double dLoad;
+   double dLookup;
+   double dFree;
+   long lSum;
+   int iPass;
+   int iRound;
+   int iSuccessful;
+   int i;
+
+   if (iBindingCount == 0)
+      return;
+
+   ppcKeys = makeKeys(iBindingCount);
+   ppcShuffled = shuffleKeys(ppcKeys, iBindingCount);
+
+   for (iPass = 0; iPass < 2; iPass++)
+   {
+      iInitialClock = clock();
+      if (iPass == 0)
+         oSymTable = SymTable_new();
+      else
+         oSymTable = SymTable_newInline(sizeof(struct Position));
+      assert(oSymTable != NULL);
+      for (i = 0; i < iBindingCount; i++)
+      {
+         sPosition.iLine = i;
+         sPosition.iColumn = 0;
+         sPosition.dWeight = 1.0;
+         if (iPass == 0)
+         {
+            psPosition = (struct Position*)malloc(sizeof(sPosition));
+            if (psPosition == NULL)
+            {
+               fprintf(stderr, "Insufficient memory\n");
+               exit(EXIT_FAILURE);
+            }
+            *psPosition = sPosition;
+            iSuccessful = SymTable_put(oSymTable, ppcKeys[i],
+               psPosition);
+         }
+         else
+            iSuccessful = SymTable_putValue(oSymTable, ppcKeys[i],
+               &sPosition);
+         assert(iSuccessful);
+         (void)iSuccessful;
+      }
+      dLoad = seconds(iInitialClock, clock());
+
+      lSum = 0;
+      iInitialClock = clock();
+      for (iRound = 0; iRound < LOOKUP_ROUNDS; iRound++)
+         for (i = 0; i < iBindingCount; i++)
+         {
+            if (iPass == 0)
+               psPosition = (struct Position*)SymTable_get(oSymTable,
+                  ppcShuffled[i]);
+            else
+               psPosition = (struct Position*)SymTable_getRef(oSymTable,
+                  ppcShuffled[i]);
+            lSum += psPosition->iLine;
+         }
+      dLookup = seconds(iInitialClock, clock()) * 1e9
+                / ((double)iBindingCount * LOOKUP_ROUNDS);
+
+      iInitialClock = clock();
+      if (iPass == 0)
+         SymTable_map(oSymTable, freePosition, NULL);
+      SymTable_free(oSymTable);
+      dFree = seconds(iInitialClock, clock());
+
+      /* Keep the lookups from being optimized away. */
+      if (lSum == -1)
+         printf("unreachable\n");
+
+      printf("inline (%d bindings, %s):  load %f seconds, "
+         "%.1f ns per lookup, free %f seconds\n", iBindingCount,
+         iPass == 0 ? "pointers" : "inline", dLoad, dLookup, dFree);
+      fflush(stdout);
+   }
+
+   free(ppcShuffled);
+   freeKeys(ppcKeys, iBindingCount);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Bind iBindingCount keys outside any scope, open SCOPE_DEPTH nested
+   scopes that each bind a few locals, then look up every key from the
+   innermost scope in shuffled order. Do it once the way a compiler
+   chains one SymTable per scope, and once with the scopes of a single
+   SymTable. Then time popping the scopes. */
+
+static void benchScope(int iBindingCount)
+{
+   enum {SCOPE_DEPTH = 16, LOCAL_COUNT = 8, MAX_KEY_LENGTH = 24};
+
+   SymTable_T aoChain[SCOPE_DEPTH + 1];
+   SymTable_T oSymTable;
+   char **ppcKeys;
+   char **ppcShuffled;
+   char acLocal[MAX_KEY_LENGTH];
+   clock_t iInitialClock;
+   double dLookup;
+   double dPop;
+   void *pvValue;
+   long lFound;
+   int iPass;
+   int iDepth;
+   int i;
+
+   if (iBindingCount == 0)
+      return;
+
+   ppcKeys = makeKeys(iBindingCount);
+   ppcShuffled = shuffleKeys(ppcKeys, iBindingCount);
+
+   for (iPass = 0; iPass < 2; iPass++)
+   {
+      oSymTable = SymTable_new();
+      assert(oSymTable != NULL);
+      aoChain[0] = oSymTable;
+      for (i = 0; i < iBindingCount; i++)
+         (void)SymTable_put(oSymTable, ppcKeys[i], ppcKeys[i]);
+
+      for (iDepth = 1; iDepth <= SCOPE_DEPTH; iDepth++)
+      {
+         if (iPass == 0)
+         {
+            aoChain[iDepth] = SymTable_new();
+            assert(aoChain[iDepth] != NULL);
+         }
+         else if (! SymTable_pushScope(oSymTable))
+         {
+            fprintf(stderr, "Insufficient memory\n");
+            exit(EXIT_FAILURE);
+         }
+         for (i = 0; i < LOCAL_COUNT; i++)
+         {
+            sprintf(acLocal, "local%d", i);
+            (void)SymTable_put(iPass == 0 ? aoChain[iDepth] : oSymTable,
+               acLocal, acLocal);
+         }
+      }
+
+      lFound = 0;
+      iInitialClock = clock();
+      for (i = 0; i < iBindingCount; i++)
+      {
+         if (iPass == 0)
+         {
+            pvValue = NULL;
+            for (iDepth = SCOPE_DEPTH; iDepth >= 0; iDepth--)
+            {
+               pvValue = SymTable_get(aoChain[iDepth], ppcShuffled[i]);
+               if (pvValue != NULL)
+                  break;
+            }
+         }
+         else
+            pvValue = SymTable_get(oSymTable, ppcShuffled[i]);
+         lFound += pvValue != NULL;
+      }
+      dLookup = seconds(iInitialClock, clock()) * 1e9 / iBindingCount;
+      assert(lFound == iBindingCount);
+
+      iInitialClock = clock();
+      for (iDepth = SCOPE_DEPTH; iDepth >= 1; iDepth--)
+      {
+         if (iPass == 0)
+            SymTable_free(aoChain[iDepth]);
+         else
+            SymTable_popScope(oSymTable);
+      }
+      dPop = seconds(iInitialClock, clock());
+
+      printf("scope (%d bindings, %d scopes, %s):  %.1f ns per lookup, "
+         "pop %f seconds\n", iBindingCount, SCOPE_DEPTH,
+         iPass == 0 ? "chained tables" : "one scoped table", dLookup,
+         dPop);
+      fflush(stdout);
+
+      SymTable_free(oSymTable);
+   }
+
+   free(ppcShuffled);
+   freeKeys(ppcKeys, iBindingCount);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Build a table of iBindingCount bindings, once with one SymTable_put
+   per key and once with SymTable_putBatch, then time merging it into
+   an empty table and into one that already binds half of its keys. */
+
+static void benchBatch(int iBindingCount)
+{
+   SymTable_T oSymTable;
+   SymTable_T oDest;
+   char **ppcKeys;
+   clock_t iInitialClock;
+   double dPut;
+   double dBatch;
+   double dMergeEmpty;
+   double dMergeHalf;
+   int iSuccessful;
+   int i;
+
+   ppcKeys = makeKeys(iBindingCount);
+
+   iInitialClock = clock();
+   oSymTable = SymTable_new();
+   assert(oSymTable != NULL);
+   for (i = 0; i < iBindingCount; i++)
+   {
+      iSuccessful = SymTable_put(oSymTable, ppcKeys[i], ppcKeys[i]);
+      assert(iSuccessful);
+   }
+   dPut = seconds(iInitialClock, clock());
+   SymTable_free(oSymTable);
+
+   iInitialClock = clock();
+   oSymTable = SymTable_new();
+   assert(oSymTable != NULL);
+   iSuccessful = SymTable_putBatch(oSymTable, ppcKeys,
+      (void *const *)ppcKeys, (size_t)iBindingCount);
+   assert(iSuccessful);
+   dBatch = seconds(iInitialClock, clock());
+
+   iInitialClock = clock();
+   oDest = SymTable_new();
+   assert(oDest != NULL);
+   iSuccessful = SymTable_merge(oDest, oSymTable, SYMTABLE_KEEP_OLD);
+   assert(iSuccessful);
+   dMergeEmpty = seconds(iInitialClock, clock());
+   SymTable_free(oDest);
+
+   oDest = SymTable_new();
+   assert(oDest != NULL);
+   iSuccessful = SymTable_putBatch(oDest, ppcKeys,
+      (void *const *)ppcKeys, (size_t)iBindingCount / 2);
+   assert(iSuccessful);
+   iInitialClock = clock();
+   iSuccessful = SymTable_merge(oDest, oSymTable, SYMTABLE_REPLACE_OLD);
+   assert(iSuccessful);
+   (void)iSuccessful;
+   dMergeHalf = seconds(iInitialClock, clock());
+   SymTable_free(oDest);
+
+   printf("batch (%d bindings):  put %f seconds, putBatch %f seconds, "
+      "merge %f seconds, merge over half %f seconds\n", iBindingCount,
+      dPut, dBatch, dMergeEmpty, dMergeHalf);
+   fflush(stdout);
+
+   SymTable_free(oSymTable);
+   freeKeys(ppcKeys, iBindingCount);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Bind iBindingCount keys, then search for iBindingCount keys of
+   which MISS_PERCENT percent are not bound, in a fixed random order,
+   once without a lookup filter and once with one. Report the times,
+   the size of the filter and its false-positive rate. */
+
+static void benchFilter(int iBindingCount)
+{
+   enum {MISS_PERCENT = 70};
+
+   SymTable_T oSymTable;
+   struct SymTableStats sStats;
+   char **ppcKeys;
+   char **ppcProbes;
+   char **ppcShuffled;
+   clock_t iInitialClock;
+   double adSeconds[2];
+   int iFound;
+   int iPass;
+   int iSuccessful;
+   int i;
+
+   ppcKeys = makeKeys(2 * iBindingCount);
+   ppcProbes = (char**)malloc(sizeof(char*) * (size_t)iBindingCount);
+   if (ppcProbes == NULL)
+   {
+      fprintf(stderr, "Insufficient memory\n");
+      exit(EXIT_FAILURE);
+   }
+
+   /* Keys iBindingCount and up are never bound. */
+   for (i = 0; i < iBindingCount; i++)
+      ppcProbes[i] = i % 100 < MISS_PERCENT
+         ? ppcKeys[iBindingCount + i] : ppcKeys[i];
+   ppcShuffled = shuffleKeys(ppcProbes, iBindingCount);
+
+   oSymTable = SymTable_new();
+   assert(oSymTable != NULL);
+   for (i = 0; i < iBindingCount; i++)
+   {
+      iSuccessful = SymTable_put(oSymTable, ppcKeys[i], ppcKeys[i]);
+      assert(iSuccessful);
+   }
+
+   for (iPass = 0; iPass < 2; iPass++)
+   {
+      iSuccessful = SymTable_setFilter(oSymTable, iPass);
+      assert(iSuccessful);
+      (void)iSuccessful;
+
+      iFound = 0;
+      iInitialClock = clock();
+      for (i = 0; i < iBindingCount; i++)
+         iFound += SymTable_contains(oSymTable, ppcShuffled[i]);
+      adSeconds[iPass] = seconds(iInitialClock, clock());
+      assert(iFound == iBindingCount - (iBindingCount / 100
+         * MISS_PERCENT + (iBindingCount % 100 < MISS_PERCENT
+         ? iBindingCount % 100 : MISS_PERCENT)));
+   }
+
+   SymTable_getStats(oSymTable, &sStats);
+   printf("filter (%d bindings, %d%% misses):  unfiltered %f seconds, "
+      "filtered %f seconds, filter %lu bytes, false positives %.2f%%\n",
+      iBindingCount, MISS_PERCENT, adSeconds[0], adSeconds[1],
+      (unsigned long)sStats.filterBytes,
+      100.0 * sStats.filterFalsePositiveRate);
+   fflush(stdout);
+
+   SymTable_free(oSymTable);
+   free(ppcShuffled);
+   free(ppcProbes);
+   freeKeys(ppcKeys, 2 * iBindingCount);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Run a stream of STREAM_FACTOR * iBindingCount lookups, drawn with a
+   skew towards small keys from STREAM_FACTOR * iBindingCount keys,
+   binding each key that misses. Do it once in a cache of iBindingCount
+   bindings and once in a table without a bound. Report the times, the
+   hit rates and the nodes each table ended up with. */
+
+static void benchCache(int iBindingCount)
+{
+   enum {STREAM_FACTOR = 10};
+
+   SymTable_T oSymTable;
+   struct SymTableStats sStats;
+   char **ppcKeys;
+   clock_t iInitialClock;
+   double adSeconds[2];
+   int aiHits[2];
+   size_t auNodes[2];
+   unsigned long ulSeed;
+   int iKeyCount;
+   int iKey;
+   int iPass;
+   int i;
+
+   if (iBindingCount > INT_MAX / STREAM_FACTOR)
+   {
+      fprintf(stderr, "Too many bindings\n");
+      exit(EXIT_FAILURE);
+   }
+   iKeyCount = STREAM_FACTOR * iBindingCount;
+   ppcKeys = makeKeys(iKeyCount);
+
+   for (iPass = 0; iPass < 2; iPass++)
+   {
+      if (iPass == 0)
+         oSymTable = SymTable_newCache((size_t)iBindingCount, NULL, NULL);
+      else
+         oSymTable = SymTable_new();
+      assert(oSymTable != NULL);
+
+      ulSeed = 12345;
+      aiHits[iPass] = 0;
+      iInitialClock = clock();
+      for (i = 0; i < iKeyCount; i++)
+      {
+         ulSeed = ulSeed * 1103515245UL + 12345UL;
+         iKey = (int)((ulSeed >> 8) % (unsigned long)iKeyCount);
+         ulSeed = ulSeed * 1103515245UL + 12345UL;
+         iKey = (int)((ulSeed >> 8) % (unsigned long)(iKey + 1));
+
+         if (SymTable_get(oSymTable, ppcKeys[iKey]) != NULL)
+            aiHits[iPass]++;
+         else
+            (void)SymTable_put(oSymTable, ppcKeys[iKey], ppcKeys[iKey]);
+      }
+      adSeconds[iPass] = seconds(iInitialClock, clock());
+
+      SymTable_getStats(oSymTable, &sStats);
+      auNodes[iPass] = sStats.nodeCount;
+      SymTable_free(oSymTable);
+   }
+
+   printf("cache (%d bindings, %d lookups):  cache %f seconds, "
+      "%.1f%% hits, %lu nodes; unbounded %f seconds, %.1f%% hits, "
+      "%lu nodes\n", iBindingCount, iKeyCount, adSeconds[0],
+      100.0 * aiHits[0] / iKeyCount, (unsigned long)auNodes[0],
+      adSeconds[1], 100.0 * aiHits[1] / iKeyCount,
+      (unsigned long)auNodes[1]);
+   fflush(stdout);
+
+   freeKeys(ppcKeys, iKeyCount);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* The time that benchClock reports */
+static uint64_t uBenchTime;
+
+/* Return uBenchTime, the time as benchExpiry moves it. */
+
+static uint64_t benchClock(void)
+{
+   return uBenchTime;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* A Sweep collects the keys that a SymTable_map sweep finds expired. */
+
+struct Sweep
+{
+   /* the keys found so far */
+   const char **ppcKeys;
+
+   /* number of keys found so far */
+   int iKeyCount;
+};
+
+/* If the deadline that pvValue points to has passed, add pcKey to the
+   Sweep that pvExtra points to. */
+
+static void sweepExpired(const char *pcKey, void *pvValue,
+   void *pvExtra)
+{
+   struct Sweep *psSweep = (struct Sweep*)pvExtra;
+
+   if (*(uint64_t*)pvValue <= uBenchTime)
+      psSweep->ppcKeys[psSweep->iKeyCount++] = pcKey;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Bind iBindingCount keys with times to live spread over
+   STEP_COUNT ticks, then move time forward a tick at a time until all
+   have expired. Do it once with a SymTable_map sweep and
+   SymTable_remove calls each tick, and once with SymTable_expireDue. */
+
+static void benchExpiry(int iBindingCount)
+{
+   enum {STEP_COUNT = 1000};
+
+   SymTable_T oSymTable;
+   struct Sweep sSweep;
+   char **ppcKeys;
+   uint64_t *puDeadlines;
+   clock_t iInitialClock;
+   double dSweep;
+   double dWheel;
+   size_t uExpired;
+   int iSuccessful;
+   int iStep;
+   int i;
+
+   ppcKeys = makeKeys(iBindingCount);
+   puDeadlines = (uint64_t*)malloc(sizeof(uint64_t)
+      * (size_t)iBindingCount);
+   sSweep.ppcKeys = (const char**)malloc(sizeof(char*)
+      * (size_t)iBindingCount);
+   if (puDeadlines == NULL || sSweep.ppcKeys == NULL)
+   {
+      fprintf(stderr, "Insufficient memory\n");
+      exit(EXIT_FAILURE);
+   }
+   for (i = 0; i < iBindingCount; i++)
+      puDeadlines[i] = 1 + (uint64_t)i * 7919 % STEP_COUNT;
+
+   uBenchTime = 0;
+   oSymTable = SymTable_new();
+   assert(oSymTable != NULL);
+   for (i = 0; i < iBindingCount; i++)
+   {
+      iSuccessful = SymTable_put(oSymTable, ppcKeys[i], &puDeadlines[i]);
+      assert(iSuccessful);
+   }
+   iInitialClock = clock();
+   for (iStep = 1; iStep <= STEP_COUNT; iStep++)
+   {
+      uBenchTime = (uint64_t)iStep;
+      sSweep.iKeyCount = 0;
+      SymTable_map(oSymTable, sweepExpired, &sSweep);
+      for (i = 0; i < sSweep.iKeyCount; i++)
+         (void)SymTable_remove(oSymTable, sSweep.ppcKeys[i]);
+   }
+   dSweep = seconds(iInitialClock, clock());
+   assert(SymTable_getLength(oSymTable) == 0);
+   SymTable_free(oSymTable);
+
+   uBenchTime = 0;
+   oSymTable = SymTable_newExpiring(benchClock, NULL, NULL);
+   assert(oSymTable != NULL);
+   for (i = 0; i < iBindingCount; i++)
+   {
+      iSuccessful = SymTable_putWithTTL(oSymTable, ppcKeys[i],
+         &puDeadlines[i], puDeadlines[i]);
+      assert(iSuccessful);
+   }
+   uExpired = 0;
+   iInitialClock = clock();
+   for (iStep = 1; iStep <= STEP_COUNT; iStep++)
+   {
+      uBenchTime = (uint64_t)iStep;
+      uExpired += SymTable_expireDue(oSymTable, uBenchTime);
+   }
+   dWheel = seconds(iInitialClock, clock());
+   assert(uExpired == (size_t)iBindingCount);
+   (void)uExpired;
+   (void)iSuccessful;
+   SymTable_free(oSymTable);
+
+   printf("expiry (%d bindings, %d ticks):  sweep %f seconds, "
+      "expireDue %f seconds\n", iBindingCount, STEP_COUNT, dSweep,
+      dWheel);
+   fflush(stdout);
+
+   free(sSweep.ppcKeys);
+   free(puDeadlines);
+   freeKeys(ppcKeys, iBindingCount);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Compare the doubles that pvFirst and pvSecond point to for
+   qsort. */
+
+static int compareDoubles(const void *pvFirst, const void *pvSecond)
+{
+   double dFirst = *(const double*)pvFirst;
+   double dSecond = *(const double*)pvSecond;
+
+   return (dFirst > dSecond) - (dFirst < dSecond);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the wall-clock time in nanoseconds since some fixed point. */
+
+static double nanoseconds(void)
+{
+   struct timespec sNow;
+
+   clock_gettime(CLOCK_MONOTONIC, &sNow);
+   return (double)sNow.tv_sec * 1e9 + (double)sNow.tv_nsec;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Time each of iBindingCount puts into a table that starts empty, so
+   that it grows many times, once resizing in the foreground and once
+   resizing in the background, where a worker allocates each bucket
+   array and moves the bindings over while the puts go on. Report the
+   median, the tail and the slowest put. */
+
+static void benchLatency(int iBindingCount)
+{
+   SymTable_T oSymTable;
+   char **ppcKeys;
+   double *pdLatencies;
+   double dStart;
+   double dTotal;
+   int iSuccessful;
+   int iPass;
+   int i;
+
+   if (iBindingCount == 0)
+      return;
+
+   ppcKeys = makeKeys(iBindingCount);
+   pdLatencies = (double*)malloc(sizeof(double) * (size_t)iBindingCount);
+   if (pdLatencies == NULL)
+   {
+      fprintf(stderr, "Insufficient memory\n");
+      exit(EXIT_FAILURE);
+   }
+
+   for (iPass = 0; iPass < 2; iPass++)
+   {
+      oSymTable = SymTable_new();
+      assert(oSymTable != NULL);
+      if (iPass == 1 && ! SymTable_setBackgroundResize(oSymTable, 1))
+      {
+         fprintf(stderr, "Cannot start the resize worker\n");
+         exit(EXIT_FAILURE);
+      }
+
+      dTotal = 0.0;
+      for (i = 0; i < iBindingCount; i++)
+      {
+         dStart = nanoseconds();
+         iSuccessful = SymTable_put(oSymTable, ppcKeys[i], ppcKeys[i]);
+         pdLatencies[i] = nanoseconds() - dStart;
+         dTotal += pdLatencies[i];
+         assert(iSuccessful);
+         (void)iSuccessful;
+      }
+      qsort(pdLatencies, (size_t)iBindingCount, sizeof(double),
+         compareDoubles);
+
+      printf("latency (%d puts, %s):  total %.3f seconds, "
+         "p50 %.0f ns, p99 %.0f ns, p99.9 %.0f ns, p99.99 %.0f ns, "
+         "max %.0f ns\n", iBindingCount,
+         iPass == 0 ? "foreground" : "background", dTotal / 1e9,
+         pdLatencies[iBindingCount / 2],
+         pdLatencies[(int)(iBindingCount * 0.99)],
+         pdLatencies[(int)(iBindingCount * 0.999)],
+         pdLatencies[(int)(iBindingCount * 0.9999)],
+         pdLatencies[iBindingCount - 1]);
+      fflush(stdout);
+
+      SymTable_free(oSymTable);
+   }
+
+   free(pdLatencies);
+   freeKeys(ppcKeys, iBindingCount);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* A Corpus is a text split into words, which point into its
+   buffer. */
+struct Corpus
+{
+   /* the text, with a nul after each word, or NULL if the words are
+      keys from makeKeys */
+   char *pcText;
+
+   /* the words, in the order they occur */
+   char **ppcWords;
+
+   /* number of words */
+   int iWordCount;
+};
+
+/* Fill in *psCorpus with the words of the file named by the
+   WORDCOUNT_CORPUS environment variable or, if it is not set, with
+   WORD_FACTOR * iBindingCount words drawn with a skew towards small
+   keys from the iBindingCount keys of ppcKeys. Exit with EXIT_FAILURE
+   if the file cannot be read or insufficient memory is available. */
+
+static void readCorpus(struct Corpus *psCorpus, char **ppcKeys,
+   int iBindingCount)
+{
+   enum {WORD_FACTOR = 10};
+
+   const char *pcFileName;
+   FILE *psFile;
+   long lLength;
+   unsigned long ulSeed = 12345;
+   char *pc;
+   int iKey;
+   int i;
+
+   pcFileName = getenv("WORDCOUNT_CORPUS");
+   if (pcFileName == NULL)
+   {
+      if (iBindingCount > INT_MAX / WORD_FACTOR)
+      {
+         fprintf(stderr, "Too many bindings\n");
+         exit(EXIT_FAILURE);
+      }
+      psCorpus->pcText = NULL;
+      psCorpus->iWordCount = WORD_FACTOR * iBindingCount;
+      psCorpus->ppcWords = (char**)malloc(sizeof(char*)
+         * (size_t)(psCorpus->iWordCount + 1));
+      if (psCorpus->ppcWords == NULL)
+      {
+         fprintf(stderr, "Insufficient memory\n");
+         exit(EXIT_FAILURE);
+      }
+      for (i = 0; i < psCorpus->iWordCount; i++)
+      {
+         ulSeed = ulSeed * 1103515245UL + 12345UL;
+         iKey = (int)((ulSeed >> 8) % (unsigned long)iBindingCount);
+         ulSeed = ulSeed * 1103515245UL + 12345UL;
+         iKey = (int)((ulSeed >> 8) % (unsigned long)(iKey + 1));
+         psCorpus->ppcWords[i] = ppcKeys[iKey];
+      }
+      return;
+   }
+
+   psFile = fopen(pcFileName, "rb");
+   if (psFile == NULL || fseek(psFile, 0L, SEEK_END) != 0
+       || (lLength = ftell(psFile)) < 0 || fseek(psFile, 0L, SEEK_SET) != 0)
+   {
+      fprintf(stderr, "Cannot read %s\n", pcFileName);
+      exit(EXIT_FAILURE);
+   }
+   psCorpus->pcText = (char*)malloc((size_t)lLength + 1);
+   psCorpus->ppcWords = (char**)malloc(sizeof(char*)
+      * ((size_t)lLength / 2 + 1));
+   if (psCorpus->pcText == NULL || psCorpus->ppcWords == NULL)
+   {
+      fprintf(stderr, "Insufficient memory\n");
+      exit(EXIT_FAILURE);
+   }
+   if (fread(psCorpus->pcText, 1, (size_t)lLength, psFile)
+       != (size_t)lLength)
+   {
+      fprintf(stderr, "Cannot read %s\n", pcFileName);
+      exit(EXIT_FAILURE);
+   }
+   fclose(psFile);
+   psCorpus->pcText[lLength] = '\0';
+
+   /* Split the text at white space, in place. */
+   psCorpus->iWordCount = 0;
+   pc = psCorpus->pcText;
+   for (;;)
+   {
+      while (*pc != '\0' && isspace((unsigned char)*pc))
+         pc++;
+      if (*pc == '\0')
+         break;
+      psCorpus->ppcWords[psCorpus->iWordCount++] = pc;
+      while (*pc != '\0' && ! isspace((unsigned char)*pc))
+         pc++;
+      if (*pc != '\0')
+         *pc++ = '\0';
+   }
+}
+
+/* What each thread of benchWordCount counts */
+struct WordCountWork
+{
+   /* the table of counters, with every word already bound */
+   SymTable_T oSymTable;
+
+   /* the words this thread counts */
+   char **ppcWords;
+
+   /* number of words */
+   int iWordCount;
+};
+
+/* Count the words of the struct WordCountWork that pvWork points to
+   with SymTable_incrementAtomic. Return NULL. */
+
+static void *countWords(void *pvWork)
+{
+   struct WordCountWork *psWork = (struct WordCountWork*)pvWork;
+   int i;
+
+   for (i = 0; i < psWork->iWordCount; i++)
+      (void)SymTable_incrementAtomic(psWork->oSymTable,
+         psWork->ppcWords[i], 1);
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Count the words of a corpus (see readCorpus) three ways: with
+   SymTable_get and SymTable_put of a malloc'd counter, with
+   SymTable_increment, and with SymTable_incrementAtomic from
+   THREAD_COUNT threads into a table whose words are already bound.
+   Report the words counted per second of wall-clock time. */
+
+static void benchWordCount(int iBindingCount)
+{
+   enum {THREAD_COUNT = 4};
+
+   SymTable_T oSymTable;
+   struct Corpus sCorpus;
+   struct WordCountWork asWork[THREAD_COUNT];
+   pthread_t aThreads[THREAD_COUNT];
+   char **ppcKeys;
+   long *plCount;
+   double dStart;
+   double adSeconds[3];
+   size_t uDistinct;
+   int iSuccessful;
+   int iWordCount;
+   int iFirst;
+   int i;
+
+   if (iBindingCount == 0)
+      return;
+
+   ppcKeys = makeKeys(iBindingCount);
+   readCorpus(&sCorpus, ppcKeys, iBindingCount);
+   iWordCount = sCorpus.iWordCount;
+   if (iWordCount == 0)
+   {
+      fprintf(stderr, "The corpus has no words\n");
+      exit(EXIT_FAILURE);
+   }
+
+   /* SymTable_get, and SymTable_put on a miss */
+   oSymTable = SymTable_new();
+   assert(oSymTable != NULL);
+   dStart = nanoseconds();
+   for (i = 0; i < iWordCount; i++)
+   {
+      plCount = (long*)SymTable_get(oSymTable, sCorpus.ppcWords[i]);
+      if (plCount != NULL)
+         (*plCount)++;
+      else
+      {
+         plCount = (long*)malloc(sizeof(long));
+         assert(plCount != NULL);
+         *plCount = 1;
+         iSuccessful = SymTable_put(oSymTable, sCorpus.ppcWords[i],
+            plCount);
+         assert(iSuccessful);
+      }
+   }
+   adSeconds[0] = (nanoseconds() - dStart) / 1e9;
+   uDistinct = SymTable_getLength(oSymTable);
+   SymTable_map(oSymTable, freePosition, NULL);
+   SymTable_free(oSymTable);
+
+   /* SymTable_increment */
+   oSymTable = SymTable_newCounter();
+   assert(oSymTable != NULL);
+   dStart = nanoseconds();
+   for (i = 0; i < iWordCount; i++)
+   {
+      iSuccessful = SymTable_increment(oSymTable, sCorpus.ppcWords[i], 1);
+      assert(iSuccessful);
+   }
+   adSeconds[1] = (nanoseconds() - dStart) / 1e9;
+   assert(SymTable_getLength(oSymTable) == uDistinct);
+
+   /* SymTable_incrementAtomic from several threads, every word bound
+      by the pass above */
+   dStart = nanoseconds();
+   iFirst = 0;
+   for (i = 0; i < THREAD_COUNT; i++)
+   {
+      asWork[i].oSymTable = oSymTable;
+      asWork[i].ppcWords = sCorpus.ppcWords + iFirst;
+      asWork[i].iWordCount = (int)((long)iWordCount * (i + 1)
+         / THREAD_COUNT) - iFirst;
+      iFirst += asWork[i].iWordCount;
+      if (pthread_create(&aThreads[i], NULL, countWords, &asWork[i])
+          != 0)
+      {
+         fprintf(stderr, "Cannot start a thread\n");
+         exit(EXIT_FAILURE);
+      }
+   }
+   for (i = 0; i < THREAD_COUNT; i++)
+      pthread_join(aThreads[i], NULL);
+   adSeconds[2] = (nanoseconds() - dStart) / 1e9;
+
+   /* Counting the corpus twice doubles every count. */
+   assert(SymTable_getCount(oSymTable, sCorpus.ppcWords[0]) % 2 == 0);
+   (void)iSuccessful;
+   SymTable_free(oSymTable);
+
+   printf("wordcount (%d words, %lu distinct):  get+put %.1f Mwords/s, "
+      "increment %.1f Mwords/s, incrementAtomic x%d %.1f Mwords/s\n",
+      iWordCount, (unsigned long)uDistinct,
+      iWordCount / adSeconds[0] / 1e6, iWordCount / adSeconds[1] / 1e6,
+      THREAD_COUNT, iWordCount / adSeconds[2] / 1e6);
+   fflush(stdout);
+
+   free(sCorpus.pcText);
+   free(sCorpus.ppcWords);
+   freeKeys(ppcKeys, iBindingCount);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Bind iBindingCount numeric IDs, look each up LOOKUP_ROUNDS times and
+   remove them all, once formatting each ID with sprintf for
+   SymTable_put, SymTable_get and SymTable_remove, and once passing it
+   to SymTable_putU64, SymTable_getU64 and SymTable_removeU64. */
+
+static void benchU64(int iBindingCount)
+{
+   enum {LOOKUP_ROUNDS = 4, MAX_KEY_LENGTH = 24};
+
+   SymTable_T oSymTable;
+   char acKey[MAX_KEY_LENGTH];
+   clock_t iInitialClock;
+   double adPut[2];
+   double adGet[2];
+   double adRemove[2];
+   uint64_t uId;
+   unsigned long ulSeed;
+   long lFound;
+   int iSuccessful;
+   int iPass;
+   int iRound;
+   int i;
+
+   if (iBindingCount == 0)
+      return;
+
+   for (iPass = 0; iPass < 2; iPass++)
+   {
+      oSymTable = iPass == 0 ? SymTable_new() : SymTable_newU64();
+      assert(oSymTable != NULL);
+
+      /* IDs are spread out, as database keys are. */
+      iInitialClock = clock();
+      for (i = 0; i < iBindingCount; i++)
+      {
+         uId = (uint64_t)i * 7919 + 1000000;
+         if (iPass == 0)
+         {
+            sprintf(acKey, "%lu", (unsigned long)uId);
+            iSuccessful = SymTable_put(oSymTable, acKey, &adPut[0]);
+         }
+         else
+            iSuccessful = SymTable_putU64(oSymTable, uId, &adPut[0]);
+         assert(iSuccessful);
+      }
+      adPut[iPass] = seconds(iInitialClock, clock());
+
+      lFound = 0;
+      ulSeed = 12345;
+      iInitialClock = clock();
+      for (iRound = 0; iRound < LOOKUP_ROUNDS; iRound++)
+      {
+         for (i = 0; i < iBindingCount; i++)
+         {
+            ulSeed = ulSeed * 1103515245UL + 12345UL;
+            uId = (uint64_t)((ulSeed >> 8) % (unsigned long)iBindingCount)
+               * 7919 + 1000000;
+            if (iPass == 0)
+            {
+               sprintf(acKey, "%lu", (unsigned long)uId);
+               lFound += SymTable_get(oSymTable, acKey) != NULL;
+            }
+            else
+               lFound += SymTable_getU64(oSymTable, uId) != NULL;
+         }
+      }
+      adGet[iPass] = seconds(iInitialClock, clock());
+      assert(lFound == (long)iBindingCount * LOOKUP_ROUNDS);
+
+      iInitialClock = clock();
+      for (i = 0; i < iBindingCount; i++)
+      {
+         uId = (uint64_t)i * 7919 + 1000000;
+         if (iPass == 0)
+         {
+            sprintf(acKey, "%lu", (unsigned long)uId);
+            lFound -= SymTable_remove(oSymTable, acKey) != NULL;
+         }
+         else
+            lFound -= SymTable_removeU64(oSymTable, uId) != NULL;
+      }
+      adRemove[iPass] = seconds(iInitialClock, clock());
+      assert(SymTable_getLength(oSymTable) == 0);
+      SymTable_free(oSymTable);
+   }
+   (void)iSuccessful;
+   (void)lFound;
+
+   printf("u64 (%d bindings):  sprintf+put %f, putU64 %f; "
+      "sprintf+get %f, getU64 %f; sprintf+remove %f, removeU64 %f "
+      "seconds\n", iBindingCount, adPut[0], adPut[1], adGet[0],
+      adGet[1], adRemove[0], adRemove[1]);
+   fflush(stdout);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Add the length of pcKey to the size_t that pvExtra points to, so
+   that a scan reads every key as well as visiting its binding. */
+
+static void addKeyLength(const char *pcKey, void *pvValue,
+   void *pvExtra)
+{
+   (void)pvValue;
+   *(size_t*)pvExtra += strlen(pcKey);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the nanoseconds per lookup of iRounds passes of SymTable_get
+   over the iKeyCount keys of ppcKeys in oSymTable. */
+
+static double timeGets(SymTable_T oSymTable, char **ppcKeys,
+   int iKeyCount, int iRounds)
+{
+   clock_t iInitialClock;
+   long lFound = 0;
+   int iRound;
+   int i;
+
+   iInitialClock = clock();
+   for (iRound = 0; iRound < iRounds; iRound++)
+      for (i = 0; i < iKeyCount; i++)
+         lFound += SymTable_get(oSymTable, ppcKeys[i]) != NULL;
+   assert(lFound == (long)iKeyCount * iRounds);
+   (void)lFound;
+
+   return seconds(iInitialClock, clock()) * 1e9
+      / ((double)iKeyCount * iRounds);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the nanoseconds per binding of iRounds SymTable_map passes
+   over oSymTable. */
+
+static double timeScans(SymTable_T oSymTable, int iRounds)
+{
+   clock_t iInitialClock;
+   size_t uKeyBytes = 0;
+   int iRound;
+
+   iInitialClock = clock();
+   for (iRound = 0; iRound < iRounds; iRound++)
+      SymTable_map(oSymTable, addKeyLength, &uKeyBytes);
+   assert(uKeyBytes > 0);
+
+   return seconds(iInitialClock, clock()) * 1e9
+      / ((double)SymTable_getLength(oSymTable) * iRounds);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Bind iBindingCount keys, then churn the table by removing and
+   rebinding random keys until the free list has handed its nodes, and
+   malloc its key copies, out in no useful order. Time lookups in
+   shuffled order and full scans, then compact the table and time them
+   again. */
+
+static void benchCompact(int iBindingCount)
+{
+   enum {CHURN_ROUNDS = 4, LOOKUP_ROUNDS = 4, SCAN_ROUNDS = 20};
+
+   SymTable_T oSymTable;
+   char **ppcKeys;
+   char **ppcShuffled;
+   clock_t iInitialClock;
+   double dCompact;
+   double adGet[2];
+   double adScan[2];
+   unsigned long ulSeed = 12345;
+   int iSuccessful;
+   int i;
+   int j;
+
+   if (iBindingCount == 0)
+      return;
+
+   ppcKeys = makeKeys(iBindingCount);
+   ppcShuffled = shuffleKeys(ppcKeys, iBindingCount);
+
+   oSymTable = SymTable_new();
+   assert(oSymTable != NULL);
+   for (i = 0; i < iBindingCount; i++)
+   {
+      iSuccessful = SymTable_put(oSymTable, ppcKeys[i], ppcKeys[i]);
+      assert(iSuccessful);
+   }
+   for (i = 0; i < CHURN_ROUNDS * iBindingCount; i++)
+   {
+      ulSeed = ulSeed * 1103515245UL + 12345UL;
+      j = (int)((ulSeed >> 8) % (unsigned long)iBindingCount);
+      (void)SymTable_remove(oSymTable, ppcKeys[j]);
+      iSuccessful = SymTable_put(oSymTable, ppcKeys[j], ppcKeys[j]);
+      assert(iSuccessful);
+   }
+   (void)iSuccessful;
+
+   adGet[0] = timeGets(oSymTable, ppcShuffled, iBindingCount,
+      LOOKUP_ROUNDS);
+   adScan[0] = timeScans(oSymTable, SCAN_ROUNDS);
+
+   iInitialClock = clock();
+   iSuccessful = SymTable_compact(oSymTable);
+   dCompact = seconds(iInitialClock, clock());
+   assert(iSuccessful);
+
+   adGet[1] = timeGets(oSymTable, ppcShuffled, iBindingCount,
+      LOOKUP_ROUNDS);
+   adScan[1] = timeScans(oSymTable, SCAN_ROUNDS);
+
+   printf("compact (%d bindings):  lookup %.1f -> %.1f ns, "
+      "scan %.1f -> %.1f ns per binding; compacting %f seconds\n",
+      iBindingCount, adGet[0], adGet[1], adScan[0], adScan[1],
+      dCompact);
+   fflush(stdout);
+
+   SymTable_free(oSymTable);
+   free(ppcShuffled);
+   freeKeys(ppcKeys, iBindingCount);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a file descriptor counting the data TLB read misses of this
+   thread in user space, stopped and reset, or -1 if the system cannot
+   count them. */
+
+static int openTlbCounter(void)
+{
+   struct perf_event_attr sAttr;
+
+   memset(&sAttr, 0, sizeof(sAttr));
+   sAttr.size = sizeof(sAttr);
+   sAttr.type = PERF_TYPE_HW_CACHE;
+   sAttr.config = PERF_COUNT_HW_CACHE_DTLB
+      | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+      | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+   sAttr.disabled = 1;
+   sAttr.exclude_kernel = 1;
+   sAttr.exclude_hv = 1;
+
+   return (int)syscall(SYS_perf_event_open, &sAttr, 0, -1, -1, 0);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the kilobytes of this process in transparent huge pages, or
+   -1 if the system does not say. */
+
+static long hugePageKilobytes(void)
+{
+   enum {MAX_LINE_LENGTH = 256};
+
+   FILE *psFile;
+   char acLine[MAX_LINE_LENGTH];
+   long lKilobytes = -1;
+
+   psFile = fopen("/proc/self/smaps_rollup", "r");
+   if (psFile == NULL)
+      return -1;
+   while (fgets(acLine, sizeof(acLine), psFile) != NULL)
+      if (sscanf(acLine, "AnonHugePages: %ld", &lKilobytes) == 1)
+         break;
+   fclose(psFile);
+
+   return lKilobytes;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Bind iBindingCount keys, then time lookups of them in shuffled order
+   and count the data TLB misses they take, once with the table in
+   ordinary pages and once with SymTable_setHugePages. Report how much
+   of the process ended up in huge pages, since the kernel may not
+   have any to give. */
+
+static void benchHugePages(int iBindingCount)
+{
+   enum {LOOKUP_ROUNDS = 4};
+
+   SymTable_T oSymTable;
+   char **ppcKeys;
+   char **ppcShuffled;
+   double adGet[2];
+   double adMisses[2];
+   long alHugeKilobytes[2];
+   long long llMisses;
+   int iCounter;
+   int iSuccessful;
+   int iPass;
+   int i;
+
+   if (iBindingCount == 0)
+      return;
+
+   ppcKeys = makeKeys(iBindingCount);
+   ppcShuffled = shuffleKeys(ppcKeys, iBindingCount);
+   iCounter = openTlbCounter();
+
+   for (iPass = 0; iPass < 2; iPass++)
+   {
+      oSymTable = SymTable_new();
+      assert(oSymTable != NULL);
+      SymTable_setHugePages(oSymTable, iPass);
+      for (i = 0; i < iBindingCount; i++)
+      {
+         iSuccessful = SymTable_put(oSymTable, ppcKeys[i], ppcKeys[i]);
+         assert(iSuccessful);
+      }
+      (void)iSuccessful;
+      alHugeKilobytes[iPass] = hugePageKilobytes();
+
+      llMisses = -1;
+      if (iCounter >= 0)
+      {
+         ioctl(iCounter, PERF_EVENT_IOC_RESET, 0);
+         ioctl(iCounter, PERF_EVENT_IOC_ENABLE, 0);
+      }
+      adGet[iPass] = timeGets(oSymTable, ppcShuffled, iBindingCount,
+         LOOKUP_ROUNDS);
+      if (iCounter >= 0)
+      {
+         ioctl(iCounter, PERF_EVENT_IOC_DISABLE, 0);
+         if (read(iCounter, &llMisses, sizeof(llMisses))
+             != (ssize_t)sizeof(llMisses))
+            llMisses = -1;
+      }
+      adMisses[iPass] = llMisses < 0 ? -1.0
+         : (double)llMisses / ((double)iBindingCount * LOOKUP_ROUNDS);
+
+      SymTable_free(oSymTable);
+   }
+   if (iCounter >= 0)
+      close(iCounter);
+
+   printf("hugepages (%d bindings):  lookup %.1f -> %.1f ns, ",
+      iBindingCount, adGet[0], adGet[1]);
+   if (adMisses[0] < 0.0 || adMisses[1] < 0.0)
+      printf("dTLB misses not countable here, ");
+   else
+      printf("dTLB misses %.2f -> %.2f per lookup, ", adMisses[0],
+         adMisses[1]);
+   printf("%ld -> %ld kB in huge pages\n", alHugeKilobytes[0],
+      alHugeKilobytes[1]);
+   fflush(stdout);
+
+   free(ppcShuffled);
+   freeKeys(ppcKeys, iBindingCount);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* The benchmarks that can be named on the command line. */
+static const struct Benchmark asBenchmarks[] =
+{
+   {"inline", benchInline},
+   {"scope", benchScope},
+   {"batch", benchBatch},
+   {"filter", benchFilter},
+   {"cache", benchCache},
+   {"expiry", benchExpiry},
+   {"latency", benchLatency},
+   {"wordcount", benchWordCount},
+   {"u64", benchU64},
+   {"compact", benchCompact},
+   {"hugepages", benchHugePages}
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Benchmark the operations of symtablehash.h.  Write the time each
+   benchmark takes to stdout.  argv[1] is the number of bindings each
+   benchmark uses.  Any further arguments name the benchmarks to run;
+   with none, run them all.  Exit with EXIT_FAILURE if argv[1] is
+   missing, not numeric, or negative, or if a benchmark name is
+   unknown.  Otherwise return 0. */
+
+int main(int argc, char *argv[])
+{
+   enum {BENCHMARK_COUNT =
+      sizeof(asBenchmarks) / sizeof(asBenchmarks[0])};
+
+   int iBindingCount;
+   int iArg;
+   size_t u;
+
+   if (argc < 2)
+   {
+      fprintf(stderr, "Usage: %s bindingcount [benchmark ...]\n",
+         argv[0]);
+      exit(EXIT_FAILURE);
+   }
+
+   if (sscanf(argv[1], "%d", &iBindingCount) != 1)
+   {
+      fprintf(stderr, "bindingcount must be numeric\n");
+      exit(EXIT_FAILURE);
+   }
+   if (iBindingCount < 0)
+   {
+      fprintf(stderr, "bindingcount cannot be negative\n");
+      exit(EXIT_FAILURE);
+   }
+
+   if (argc == 2)
+   {
+      for (u = 0; u < BENCHMARK_COUNT; u++)
+         (*asBenchmarks[u].pfRun)(iBindingCount);
+      return 0;
+   }
+
+   for (iArg = 2; iArg < argc; iArg++)
+   {
+      for (u = 0; u < BENCHMARK_COUNT; u++)
+         if (strcmp(argv[iArg], asBenchmarks[u].pcName) == 0)
+            break;
+      if (u == BENCHMARK_COUNT)
+      {
+         fprintf(stderr, "unknown benchmark: %s\n", argv[iArg]);
+         exit(EXIT_FAILURE);
+      }
+      (*asBenchmarks[u].pfRun)(iBindingCount);
+   }
+
+   return 0;
+}
@@ -0,0 +1,321 @@
+/*--------------------------------------------------------------------*/
+/* benchsnapshot.c                                                    */
+/* Author: Ryan Chen                                                  */
+/*--------------------------------------------------------------------*/
+
+#include "symtablehamt.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <string.h>
+#include <assert.h>
+
+/*--------------------------------------------------------------------*/
+
+/* A Benchmark pairs the name given on the command line with the
+   function that runs it for a binding count. */
+struct Benchmark
+{
+   /* the name of the benchmark */
+   const char *pcName;
+
+   /* the function that runs the benchmark */
+   void (*pfRun)(int iBindingCount);
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Return the CPU time in seconds consumed between iInitialClock and
+   iFinalClock. */
+
+static double seconds(clock_t iInitialClock, clock_t iFinalClock)
+{
+   return ((double)(iFinalClock - iInitialClock)) / CLOCKS_PER_SEC;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return an array of iKeyCount keys "0", "1", ... so that key
+   formatting is not part of any timing. Exit with EXIT_FAILURE if
+   insufficient memory is available. */
+
+static char **makeKeys(int iKeyCount)
+{
+   enum {MAX_KEY_LENGTH = 12};
+
+   char **ppcKeys;
+   int i;
+
+   ppcKeys = (char**)malloc(sizeof(char*) * (size_t)(iKeyCount + 1));
+   if (ppcKeys == NULL)
+   {
+      fprintf(stderr, "Insufficient memory\n");
+      exit(EXIT_FAILURE);
+   }
+
+   for (i = 0; i < iKeyCount; i++)
+   {
+      ppcKeys[i] = (char*)malloc(MAX_KEY_LENGTH);
+      if (ppcKeys[i] == NULL)
+      {
+         fprintf(stderr, "Insufficient memory\n");
+         exit(EXIT_FAILURE);
+      }
+      sprintf(ppcKeys[i], "%d", i);
+   }
+
+   return ppcKeys;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a copy of the iKeyCount pointers in ppcKeys in a fixed
+   pseudo-random order, so that lookups do not walk the table in the
+   order the keys were generated. Exit with EXIT_FAILURE if
+   insufficient memory is available. */
+
+static char **shuffleKeys(char **ppcKeys, int iKeyCount)
+{
+   char **ppcShuffled;
+   char *pcTemp;
+   unsigned long ulSeed = 12345;
+   int i;
+   int j;
+
+   ppcShuffled = (char**)malloc(sizeof(char*) * (size_t)(iKeyCount + 1));
+   if (ppcShuffled == NULL)
+   {
+      fprintf(stderr, "Insufficient memory\n");
+      exit(EXIT_FAILURE);
+   }
+   memcpy(ppcShuffled, ppcKeys, sizeof(char*) * (size_t)iKeyCount);
+
+   for (i = iKeyCount - 1; i > 0; i--)
+   {
+      ulSeed = ulSeed * 1103515245UL + 12345UL;
+      j = (int)((ulSeed >> 8) % (unsigned long)(i + 1));
+      pcTemp = ppcShuffled[i];
+      ppcShuffled[i] = ppcShuffled[j];
+      ppcShuffled[j] = pcTemp;
+   }
+
+   return ppcShuffled;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Free the iKeyCount keys in ppcKeys, and ppcKeys itself. */
+
+static void freeKeys(char **ppcKeys, int iKeyCount)
+{
+   int i;
+
+   assert(ppcKeys != NULL);
+
+   for (i = 0; i < iKeyCount; i++)
+      free(ppcKeys[i]);
+   free(ppcKeys);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Bind the value that pvValue points to to pcKey in the SymTable_T
+   that pvExtra points to. Exit with EXIT_FAILURE if insufficient memory
+   is available. */
+
+static void copyBinding(const char *pcKey, void *pvValue, void *pvExtra)
+{
+   if (! SymTable_put(*(SymTable_T*)pvExtra, pcKey, pvValue))
+   {
+      fprintf(stderr, "Insufficient memory\n");
+      exit(EXIT_FAILURE);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new SymTable_T bound to iBindingCount keys from ppcKeys.
+   Exit with EXIT_FAILURE if insufficient memory is available. */
+
+static SymTable_T makeTable(char **ppcKeys, int iBindingCount)
+{
+   SymTable_T oSymTable;
+   int i;
+
+   oSymTable = SymTable_new();
+   if (oSymTable == NULL)
+   {
+      fprintf(stderr, "Insufficient memory\n");
+      exit(EXIT_FAILURE);
+   }
+   for (i = 0; i < iBindingCount; i++)
+      copyBinding(ppcKeys[i], ppcKeys[i], &oSymTable);
+   return oSymTable;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Time taking a consistent copy of a table of iBindingCount bindings,
+   once by re-putting every binding into a new table and once with
+   SymTable_snapshot. */
+
+static void benchSnapshot(int iBindingCount)
+{
+   enum {SNAPSHOT_COUNT = 100000};
+
+   SymTable_T oSymTable;
+   SymTable_T oCopy;
+   char **ppcKeys;
+   clock_t iInitialClock;
+   double dCopy;
+   double dSnapshot;
+   int i;
+
+   ppcKeys = makeKeys(iBindingCount);
+   oSymTable = makeTable(ppcKeys, iBindingCount);
+
+   iInitialClock = clock();
+   oCopy = SymTable_new();
+   assert(oCopy != NULL);
+   SymTable_map(oSymTable, copyBinding, &oCopy);
+   dCopy = seconds(iInitialClock, clock());
+   SymTable_free(oCopy);
+
+   iInitialClock = clock();
+   for (i = 0; i < SNAPSHOT_COUNT; i++)
+   {
+      oCopy = SymTable_snapshot(oSymTable);
+      assert(oCopy != NULL);
+      SymTable_free(oCopy);
+   }
+   dSnapshot = seconds(iInitialClock, clock()) * 1e9 / SNAPSHOT_COUNT;
+
+   printf("snapshot (%d bindings):  copy %f seconds, "
+      "snapshot and free %.1f ns\n", iBindingCount, dCopy, dSnapshot);
+   fflush(stdout);
+
+   SymTable_free(oSymTable);
+   freeKeys(ppcKeys, iBindingCount);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Time replacing each of iBindingCount bindings in shuffled order,
+   once with no snapshot alive and once with a snapshot that shares
+   every node, so that each write must copy its path. */
+
+static void benchWrite(int iBindingCount)
+{
+   SymTable_T oSymTable;
+   SymTable_T oSnapshot = NULL;
+   char **ppcKeys;
+   char **ppcShuffled;
+   clock_t iInitialClock;
+   void *pvOld;
+   int iPass;
+   int i;
+
+   if (iBindingCount == 0)
+      return;
+
+   ppcKeys = makeKeys(iBindingCount);
+   ppcShuffled = shuffleKeys(ppcKeys, iBindingCount);
+
+   for (iPass = 0; iPass < 2; iPass++)
+   {
+      oSymTable = makeTable(ppcKeys, iBindingCount);
+      if (iPass == 1)
+      {
+         oSnapshot = SymTable_snapshot(oSymTable);
+         assert(oSnapshot != NULL);
+      }
+
+      iInitialClock = clock();
+      for (i = 0; i < iBindingCount; i++)
+      {
+         pvOld = SymTable_replace(oSymTable, ppcShuffled[i], NULL);
+         assert(pvOld == ppcShuffled[i]);
+         (void)pvOld;
+      }
+
+      printf("write (%d bindings, %s):  %.1f ns per replace\n",
+         iBindingCount, iPass == 0 ? "no snapshot" : "snapshot",
+         seconds(iInitialClock, clock()) * 1e9 / iBindingCount);
+      fflush(stdout);
+
+      SymTable_free(oSymTable);
+      if (oSnapshot != NULL)
+         SymTable_free(oSnapshot);
+   }
+
+   free(ppcShuffled);
+   freeKeys(ppcKeys, iBindingCount);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* The benchmarks that can be named on the command line. */
+static const struct Benchmark asBenchmarks[] =
+{
+   {"snapshot", benchSnapshot},
+   {"write", benchWrite}
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Benchmark the operations of symtablehamt.h.  Write the time each
+   benchmark takes to stdout.  argv[1] is the number of bindings each
+   benchmark uses.  Any further arguments name the benchmarks to run;
+   with none, run them all.  Exit with EXIT_FAILURE if argv[1] is
+   missing, not numeric, or negative, or if a benchmark name is
+   unknown.  Otherwise return 0. */
+
+int main(int argc, char *argv[])
+{
+   enum {BENCHMARK_COUNT =
+      sizeof(asBenchmarks) / sizeof(asBenchmarks[0])};
+
+   int iBindingCount;
+   int iArg;
+   size_t u;
+
+   if (argc < 2)
+   {
+      fprintf(stderr, "Usage: %s bindingcount [benchmark ...]\n",
+         argv[0]);
+      exit(EXIT_FAILURE);
+   }
+
+   if (sscanf(argv[1], "%d", &iBindingCount) != 1)
+   {
+      fprintf(stderr, "bindingcount must be numeric\n");
+      exit(EXIT_FAILURE);
+   }
+   if (iBindingCount < 0)
+   {
+      fprintf(stderr, "bindingcount cannot be negative\n");
+      exit(EXIT_FAILURE);
+   }
+
+   if (argc == 2)
+   {
+      for (u = 0; u < BENCHMARK_COUNT; u++)
+         (*asBenchmarks[u].pfRun)(iBindingCount);
+      return 0;
+   }
+
+   for (iArg = 2; iArg < argc; iArg++)
+   {
+      for (u = 0; u < BENCHMARK_COUNT; u++)
+         if (strcmp(argv[iArg], asBenchmarks[u].pcName) == 0)
+            break;
+      if (u == BENCHMARK_COUNT)
+      {
+         fprintf(stderr, "unknown benchmark: %s\n", argv[iArg]);
+         exit(EXIT_FAILURE);
+      }
+      (*asBenchmarks[u].pfRun)(iBindingCount);
+   }
+
+   return 0;
+}
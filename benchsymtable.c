@@ -0,0 +1,896 @@
+/*--------------------------------------------------------------------*/
+/* benchsymtable.c                                                    */
+/* Author: Ryan Chen                                                  */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200112L
+
+#include "symtable.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <string.h>
+#include <assert.h>
+#include <stdint.h>
+
+/*--------------------------------------------------------------------*/
+
+/* A Benchmark pairs the name given on the command line with the
+   function that runs it for a binding count. */
+struct Benchmark
+{
+   /* the name of the benchmark */
+   const char *pcName;
+
+   /* the function that runs the benchmark */
+   void (*pfRun)(int iBindingCount);
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Return the CPU time in seconds consumed between iInitialClock and
+   iFinalClock. */
+
+static double seconds(clock_t iInitialClock, clock_t iFinalClock)
+{
+   return ((double)(iFinalClock - iInitialClock)) / CLOCKS_PER_SEC;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the current time on a monotonic clock in nanoseconds. */
+
+static double nanoseconds(void)
+{
+   struct timespec sNow;
+
+   clock_gettime(CLOCK_MONOTONIC, &sNow);
+   return (double)sNow.tv_sec * 1e9 + (double)sNow.tv_nsec;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return an array of iKeyCount keys "0", "1", ... so that key
+   formatting is not part of any timing. Exit with EXIT_FAILURE if
+   insufficient memory is available. */
+
+static char **makeKeys(int iKeyCount)
+{
+   enum {MAX_KEY_LENGTH = 12};
+
+   char **ppcKeys;
+   int i;
+
+   ppcKeys = (char**)malloc(sizeof(char*) * (size_t)(iKeyCount + 1));
+   if (ppcKeys == NULL)
+   {
+      fprintf(stderr, "Insufficient memory\n");
+      exit(EXIT_FAILURE);
+   }
+
+   for (i = 0; i < iKeyCount; i++)
+   {
+      ppcKeys[i] = (char*)malloc(MAX_KEY_LENGTH);
+      if (ppcKeys[i] == NULL)
+      {
+         fprintf(stderr, "Insufficient memory\n");
+         exit(EXIT_FAILURE);
+      }
+      sprintf(ppcKeys[i], "%d", i);
+   }
+
+   return ppcKeys;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a copy of the iKeyCount pointers in ppcKeys in a fixed
+   pseudo-random order, so that lookups do not walk the table in the
+   order the keys were generated. Exit with EXIT_FAILURE if
+   insufficient memory is available. */
+
+static char **shuffleKeys(char **ppcKeys, int iKeyCount)
+{
+   char **ppcShuffled;
+   char *pcTemp;
+   unsigned long ulSeed = 12345;
+   int i;
+   int j;
+
+   ppcShuffled = (char**)malloc(sizeof(char*) * (size_t)(iKeyCount + 1));
+   if (ppcShuffled == NULL)
+   {
+      fprintf(stderr, "Insufficient memory\n");
+      exit(EXIT_FAILURE);
+   }
+   memcpy(ppcShuffled, ppcKeys, sizeof(char*) * (size_t)iKeyCount);
+
+   for (i = iKeyCount - 1; i > 0; i--)
+   {
+      ulSeed = ulSeed * 1103515245UL + 12345UL;
+      j = (int)((ulSeed >> 8) % (unsigned long)(i + 1));
+      pcTemp = ppcShuffled[i];
+      ppcShuffled[i] = ppcShuffled[j];
+      ppcShuffled[j] = pcTemp;
+   }
+
+   return ppcShuffled;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Free the iKeyCount keys in ppcKeys, and ppcKeys itself. */
+
+static void freeKeys(char **ppcKeys, int iKeyCount)
+{
+   int i;
+
+   assert(ppcKeys != NULL);
+
+   for (i = 0; i < iKeyCount; i++)
+      free(ppcKeys[i]);
+   free(ppcKeys);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Put the first iBindingCount keys of ppcKeys into oSymTable, each
+   bound to itself. */
+
+static void putKeys(SymTable_T oSymTable, char **ppcKeys,
+   int iBindingCount)
+{
+   int i;
+   int iSuccessful;
+
+   for (i = 0; i < iBindingCount; i++)
+   {
+      iSuccessful = SymTable_put(oSymTable, ppcKeys[i], ppcKeys[i]);
+      assert(iSuccessful);
+      (void)iSuccessful;
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Compare loading iBindingCount bindings into a table created with
+   SymTable_new() against a table created with
+   SymTable_newWithCapacity(). */
+
+static void benchLoad(int iBindingCount)
+{
+   SymTable_T oSymTable;
+   char **ppcKeys;
+   clock_t iInitialClock;
+   double dCold;
+   double dReserved;
+
+   ppcKeys = makeKeys(iBindingCount);
+
+   iInitialClock = clock();
+   oSymTable = SymTable_new();
+   assert(oSymTable != NULL);
+   putKeys(oSymTable, ppcKeys, iBindingCount);
+   dCold = seconds(iInitialClock, clock());
+   SymTable_free(oSymTable);
+
+   iInitialClock = clock();
+   oSymTable = SymTable_newWithCapacity((size_t)iBindingCount);
+   assert(oSymTable != NULL);
+   putKeys(oSymTable, ppcKeys, iBindingCount);
+   dReserved = seconds(iInitialClock, clock());
+   SymTable_free(oSymTable);
+
+   printf("load (%d bindings):  cold %f seconds, reserved %f seconds\n",
+      iBindingCount, dCold, dReserved);
+   fflush(stdout);
+
+   freeKeys(ppcKeys, iBindingCount);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Count one binding in the size_t that pvExtra points to. */
+
+static void countBinding(const char *pcKey, void *pvValue,
+   void *pvExtra)
+{
+   assert(pcKey != NULL);
+   assert(pvExtra != NULL);
+   (void)pvValue;
+
+   (*(size_t*)pvExtra)++;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Load iBindingCount bindings and time full SymTable_map() passes over
+   them, in nanoseconds per binding visited. */
+
+static void benchScan(int iBindingCount)
+{
+   enum {MIN_VISITS = 10000000};
+
+   SymTable_T oSymTable;
+   char **ppcKeys;
+   clock_t iInitialClock;
+   size_t uVisited = 0;
+   int iMapCount;
+   int i;
+
+   ppcKeys = makeKeys(iBindingCount);
+
+   oSymTable = SymTable_new();
+   assert(oSymTable != NULL);
+   putKeys(oSymTable, ppcKeys, iBindingCount);
+
+   iMapCount = iBindingCount > 0 ? MIN_VISITS / iBindingCount + 1 : 1;
+   iInitialClock = clock();
+   for (i = 0; i < iMapCount; i++)
+      SymTable_map(oSymTable, countBinding, &uVisited);
+
+   printf("scan (%d bindings):  %d maps, %.2f ns per binding\n",
+      iBindingCount, iMapCount,
+      uVisited > 0 ? seconds(iInitialClock, clock()) * 1e9 / uVisited
+                   : 0.0);
+   fflush(stdout);
+
+   SymTable_free(oSymTable);
+   freeKeys(ppcKeys, iBindingCount);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Load iBindingCount bindings, remove all but a few of them, and time
+   repeated SymTable_map() calls over what remains. */
+
+static void benchDrain(int iBindingCount)
+{
+   enum {KEPT_COUNT = 100, MAP_COUNT = 1000};
+
+   SymTable_T oSymTable;
+   char **ppcKeys;
+   clock_t iInitialClock;
+   size_t uVisited = 0;
+   int i;
+
+   ppcKeys = makeKeys(iBindingCount);
+
+   oSymTable = SymTable_new();
+   assert(oSymTable != NULL);
+   putKeys(oSymTable, ppcKeys, iBindingCount);
+   for (i = KEPT_COUNT; i < iBindingCount; i++)
+      (void)SymTable_remove(oSymTable, ppcKeys[i]);
+
+   iInitialClock = clock();
+   for (i = 0; i < MAP_COUNT; i++)
+      SymTable_map(oSymTable, countBinding, &uVisited);
+
+   printf("drain (%d bindings):  %d maps over %lu bindings "
+      "%f seconds\n", iBindingCount, MAP_COUNT,
+      (unsigned long)SymTable_getLength(oSymTable),
+      seconds(iInitialClock, clock()));
+   fflush(stdout);
+
+   SymTable_free(oSymTable);
+   freeKeys(ppcKeys, iBindingCount);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Time iLookupCount SymTable_get() calls for the keys in ppcKeys,
+   repeated until at least MIN_LOOKUP_COUNT lookups are made. Return
+   the average time per lookup in nanoseconds. */
+
+static double timeLookups(SymTable_T oSymTable, char **ppcKeys,
+   int iLookupCount)
+{
+   enum {MIN_LOOKUP_COUNT = 10000000};
+
+   clock_t iInitialClock;
+   int iRoundCount;
+   int iRound;
+   int i;
+   size_t uFound = 0;
+
+   assert(iLookupCount > 0);
+
+   iRoundCount = MIN_LOOKUP_COUNT / iLookupCount + 1;
+
+   iInitialClock = clock();
+   for (iRound = 0; iRound < iRoundCount; iRound++)
+      for (i = 0; i < iLookupCount; i++)
+         if (SymTable_get(oSymTable, ppcKeys[i]) != NULL)
+            uFound++;
+
+   /* Keep the lookups from being optimized away. */
+   if (uFound == (size_t)-1)
+      printf("unreachable\n");
+
+   return seconds(iInitialClock, clock()) * 1e9
+          / ((double)iLookupCount * iRoundCount);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Load iBindingCount bindings and time successful SymTable_get() calls
+   over them in shuffled order. */
+
+static void benchLookup(int iBindingCount)
+{
+   SymTable_T oSymTable;
+   char **ppcKeys;
+   char **ppcShuffled;
+
+   if (iBindingCount == 0)
+      return;
+
+   ppcKeys = makeKeys(iBindingCount);
+
+   oSymTable = SymTable_new();
+   assert(oSymTable != NULL);
+   putKeys(oSymTable, ppcKeys, iBindingCount);
+   ppcShuffled = shuffleKeys(ppcKeys, iBindingCount);
+
+   printf("lookup (%d bindings):  %.1f ns per lookup\n", iBindingCount,
+      timeLookups(oSymTable, ppcShuffled, iBindingCount));
+   fflush(stdout);
+
+   SymTable_free(oSymTable);
+   free(ppcShuffled);
+   freeKeys(ppcKeys, iBindingCount);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Load iBindingCount bindings and time lookups of as many keys that
+   are not in the table. */
+
+static void benchMiss(int iBindingCount)
+{
+   SymTable_T oSymTable;
+   char **ppcKeys;
+   char **ppcShuffled;
+
+   if (iBindingCount == 0)
+      return;
+
+   ppcKeys = makeKeys(2 * iBindingCount);
+
+   oSymTable = SymTable_new();
+   assert(oSymTable != NULL);
+   putKeys(oSymTable, ppcKeys, iBindingCount);
+   ppcShuffled = shuffleKeys(ppcKeys + iBindingCount, iBindingCount);
+
+   printf("miss (%d bindings):  %.1f ns per miss\n", iBindingCount,
+      timeLookups(oSymTable, ppcShuffled, iBindingCount));
+   fflush(stdout);
+
+   SymTable_free(oSymTable);
+   free(ppcShuffled);
+   freeKeys(ppcKeys, 2 * iBindingCount);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Load the table to nine tenths of a power of two not above
+   iBindingCount, the most an open-addressed table holds before it
+   grows, and time hits and misses there. */
+
+static void benchHighLoad(int iBindingCount)
+{
+   SymTable_T oSymTable;
+   char **ppcKeys;
+   char **ppcHits;
+   char **ppcMisses;
+   int iPower = 16;
+   int iLoaded;
+
+   if (iBindingCount < iPower)
+      return;
+
+   while (iPower <= iBindingCount / 2)
+      iPower *= 2;
+   iLoaded = iPower / 10 * 9;
+
+   ppcKeys = makeKeys(2 * iLoaded);
+
+   oSymTable = SymTable_new();
+   assert(oSymTable != NULL);
+   putKeys(oSymTable, ppcKeys, iLoaded);
+   ppcHits = shuffleKeys(ppcKeys, iLoaded);
+   ppcMisses = shuffleKeys(ppcKeys + iLoaded, iLoaded);
+
+   printf("highload (%d bindings):  %.1f ns per hit, "
+      "%.1f ns per miss\n", iLoaded,
+      timeLookups(oSymTable, ppcHits, iLoaded),
+      timeLookups(oSymTable, ppcMisses, iLoaded));
+   fflush(stdout);
+
+   SymTable_free(oSymTable);
+   free(ppcHits);
+   free(ppcMisses);
+   freeKeys(ppcKeys, 2 * iLoaded);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the bucket that symtablehash.c gives pcKey in a table of
+   uBucketCount buckets. This copies its unseeded hash function, as an
+   attacker who has read the source could. */
+
+static size_t chainedBucket(const char *pcKey, size_t uBucketCount)
+{
+   size_t uHash = 0;
+   uint64_t uMixed;
+   size_t u;
+
+   for (u = 0; pcKey[u] != '\0'; u++)
+      uHash = uHash * 65599 + (size_t)pcKey[u];
+
+   uMixed = (uint64_t)uHash;
+   uMixed ^= uMixed >> 32;
+   uMixed *= UINT64_C(0x9E3779B97F4A7C15);
+   return (size_t)(((uMixed >> 32) * (uint64_t)uBucketCount) >> 32);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of buckets symtablehash.c uses for a table created
+   to hold uCapacity bindings: the first of the largest primes below
+   512, 1024, 2048, ... that is at least uCapacity. */
+
+static size_t chainedBucketCount(size_t uCapacity)
+{
+   size_t uPower;
+   size_t uPrime;
+   size_t uDivisor;
+
+   for (uPower = 512; ; uPower *= 2)
+   {
+      for (uPrime = uPower - 1; ; uPrime--)
+      {
+         for (uDivisor = 2; uDivisor * uDivisor <= uPrime; uDivisor++)
+            if (uPrime % uDivisor == 0)
+               break;
+         if (uDivisor * uDivisor > uPrime)
+            break;
+      }
+      if (uPrime >= uCapacity)
+         return uPrime;
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return an array of iKeyCount keys that all fall into one bucket of
+   a symtablehash.c table created to hold iKeyCount bindings. Exit with
+   EXIT_FAILURE if insufficient memory is available. */
+
+static char **makeCollidingKeys(int iKeyCount)
+{
+   enum {MAX_KEY_LENGTH = 24};
+
+   char **ppcKeys;
+   char acCandidate[MAX_KEY_LENGTH];
+   size_t uBucketCount = chainedBucketCount((size_t)iKeyCount);
+   size_t uTarget;
+   unsigned long ulCandidate = 0;
+   int i = 0;
+
+   ppcKeys = makeKeys(iKeyCount);
+
+   sprintf(acCandidate, "a%lu", ulCandidate);
+   uTarget = chainedBucket(acCandidate, uBucketCount);
+
+   while (i < iKeyCount)
+   {
+      sprintf(acCandidate, "a%lu", ulCandidate++);
+      if (chainedBucket(acCandidate, uBucketCount) == uTarget)
+         strcpy(ppcKeys[i++], acCandidate);
+   }
+
+   return ppcKeys;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Look up each of the iKeyCount keys in ppcKeys repeatedly in
+   oSymTable. Store the average and worst per-key lookup times in
+   nanoseconds in *pdAverage and *pdWorst. Each key's time is the best
+   of TRIAL_COUNT batches, so that an interrupt does not pass for a slow
+   key. */
+
+static void timeEachKey(SymTable_T oSymTable, char **ppcKeys,
+   int iKeyCount, double *pdAverage, double *pdWorst)
+{
+   enum {TRIAL_COUNT = 3, REPEAT_COUNT = 10};
+
+   double dStart;
+   double dTrial;
+   double dKey;
+   double dTotal = 0.0;
+   int iTrial;
+   int iRepeat;
+   int i;
+
+   *pdWorst = 0.0;
+   for (i = 0; i < iKeyCount; i++)
+   {
+      dKey = 0.0;
+      for (iTrial = 0; iTrial < TRIAL_COUNT; iTrial++)
+      {
+         dStart = nanoseconds();
+         for (iRepeat = 0; iRepeat < REPEAT_COUNT; iRepeat++)
+            if (SymTable_get(oSymTable, ppcKeys[i]) != ppcKeys[i])
+               assert(0);
+         dTrial = (nanoseconds() - dStart) / REPEAT_COUNT;
+         if (iTrial == 0 || dTrial < dKey)
+            dKey = dTrial;
+      }
+
+      dTotal += dKey;
+      if (dKey > *pdWorst)
+         *pdWorst = dKey;
+   }
+   *pdAverage = dTotal / iKeyCount;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Compare lookups of ordinary keys with lookups of keys crafted to
+   share one bucket of symtablehash.c. Uses at most MAX_KEY_COUNT of
+   the iBindingCount bindings, since crafting keys is slow. */
+
+static void benchAdversarial(int iBindingCount)
+{
+   enum {MAX_KEY_COUNT = 2048};
+
+   SymTable_T oSymTable;
+   char **ppcKeys;
+   int iKeyCount = iBindingCount;
+   int iPass;
+   double dAverage;
+   double dWorst;
+
+   if (iKeyCount > MAX_KEY_COUNT)
+      iKeyCount = MAX_KEY_COUNT;
+   if (iKeyCount == 0)
+      return;
+
+   for (iPass = 0; iPass < 2; iPass++)
+   {
+      if (iPass == 0)
+         ppcKeys = makeKeys(iKeyCount);
+      else
+         ppcKeys = makeCollidingKeys(iKeyCount);
+
+      oSymTable = SymTable_newWithCapacity((size_t)iKeyCount);
+      assert(oSymTable != NULL);
+      putKeys(oSymTable, ppcKeys, iKeyCount);
+
+      timeEachKey(oSymTable, ppcKeys, iKeyCount, &dAverage, &dWorst);
+      printf("adversarial (%d %s keys):  %.1f ns average, "
+         "%.1f ns worst key\n", iKeyCount,
+         iPass == 0 ? "ordinary" : "colliding", dAverage, dWorst);
+      fflush(stdout);
+
+      SymTable_free(oSymTable);
+      freeKeys(ppcKeys, iKeyCount);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return an array of iKeyCount keys that share a long prefix, the way
+   qualified names in one namespace do. If iColliding, the keys also
+   all fall into one bucket of a symtablehash.c table created to hold
+   iKeyCount bindings. Exit with EXIT_FAILURE if insufficient memory is
+   available. */
+
+static char **makePrefixedKeys(int iKeyCount, int iColliding)
+{
+   enum {MAX_KEY_LENGTH = 64};
+
+   static const char acPrefix[] = "org.example.compiler.frontend.scope.";
+   char **ppcKeys;
+   size_t uBucketCount = chainedBucketCount((size_t)iKeyCount);
+   size_t uTarget = 0;
+   unsigned long ulCandidate = 0;
+   int i = 0;
+
+   ppcKeys = (char**)malloc(sizeof(char*) * (size_t)(iKeyCount + 1));
+   if (ppcKeys == NULL)
+   {
+      fprintf(stderr, "Insufficient memory\n");
+      exit(EXIT_FAILURE);
+   }
+
+   while (i < iKeyCount)
+   {
+      ppcKeys[i] = (char*)malloc(MAX_KEY_LENGTH);
+      if (ppcKeys[i] == NULL)
+      {
+         fprintf(stderr, "Insufficient memory\n");
+         exit(EXIT_FAILURE);
+      }
+      sprintf(ppcKeys[i], "%s%lu", acPrefix, ulCandidate++);
+
+      if (i == 0)
+         uTarget = chainedBucket(ppcKeys[i], uBucketCount);
+      if (! iColliding ||
+          chainedBucket(ppcKeys[i], uBucketCount) == uTarget)
+         i++;
+      else
+         free(ppcKeys[i]);
+   }
+
+   return ppcKeys;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Time lookups of keys that share a long prefix, which a byte-by-byte
+   compare must read through before it finds a difference. Do it for
+   keys spread over the table and for keys crafted to share one bucket
+   of symtablehash.c. Uses at most MAX_KEY_COUNT of the iBindingCount
+   bindings, since a list compares against every key. */
+
+static void benchPrefix(int iBindingCount)
+{
+   enum {MAX_KEY_COUNT = 512};
+
+   SymTable_T oSymTable;
+   char **ppcKeys;
+   char **ppcShuffled;
+   int iKeyCount = iBindingCount;
+   int iPass;
+
+   if (iKeyCount > MAX_KEY_COUNT)
+      iKeyCount = MAX_KEY_COUNT;
+   if (iKeyCount == 0)
+      return;
+
+   for (iPass = 0; iPass < 2; iPass++)
+   {
+      ppcKeys = makePrefixedKeys(iKeyCount, iPass);
+
+      oSymTable = SymTable_newWithCapacity((size_t)iKeyCount);
+      assert(oSymTable != NULL);
+      putKeys(oSymTable, ppcKeys, iKeyCount);
+      ppcShuffled = shuffleKeys(ppcKeys, iKeyCount);
+
+      printf("prefix (%d %s keys):  %.1f ns per lookup\n", iKeyCount,
+         iPass == 0 ? "ordinary" : "colliding",
+         timeLookups(oSymTable, ppcShuffled, iKeyCount));
+      fflush(stdout);
+
+      SymTable_free(oSymTable);
+      free(ppcShuffled);
+      freeKeys(ppcKeys, iKeyCount);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Spread iBindingCount bindings over many tables of SMALL_SIZE
+   bindings each, the way a compiler keeps one table per scope, and time
+   creating, filling, reading and freeing them. */
+
+static void benchSmall(int iBindingCount)
+{
+   enum {SMALL_SIZE = 8, LOOKUP_ROUNDS = 4};
+
+   SymTable_T oSymTable;
+   char **ppcKeys;
+   clock_t iInitialClock;
+   int iTableCount = iBindingCount / SMALL_SIZE;
+   int iTable;
+   int iRound;
+   int i;
+
+   ppcKeys = makeKeys(SMALL_SIZE);
+
+   iInitialClock = clock();
+   for (iTable = 0; iTable < iTableCount; iTable++)
+   {
+      oSymTable = SymTable_new();
+      assert(oSymTable != NULL);
+      putKeys(oSymTable, ppcKeys, SMALL_SIZE);
+      for (iRound = 0; iRound < LOOKUP_ROUNDS; iRound++)
+         for (i = 0; i < SMALL_SIZE; i++)
+            if (SymTable_get(oSymTable, ppcKeys[i]) != ppcKeys[i])
+               assert(0);
+      SymTable_free(oSymTable);
+   }
+
+   printf("small (%d tables of %d bindings):  %f seconds\n",
+      iTableCount, SMALL_SIZE, seconds(iInitialClock, clock()));
+   fflush(stdout);
+
+   freeKeys(ppcKeys, SMALL_SIZE);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return an array of iLookupCount keys drawn from the iKeyCount keys
+   in ppcKeys with a Zipf distribution: ppcKeys[i] is drawn in
+   proportion to 1 / (i + 1), so the first keys put are the hot ones.
+   Exit with EXIT_FAILURE if insufficient memory is available. */
+
+static char **makeZipfLookups(char **ppcKeys, int iKeyCount,
+   int iLookupCount)
+{
+   char **ppcLookups;
+   double *pdCumulative;
+   double dTotal = 0.0;
+   double dDraw;
+   unsigned long ulSeed = 12345;
+   int iLow;
+   int iHigh;
+   int iMid;
+   int i;
+
+   ppcLookups = (char**)malloc(sizeof(char*) * (size_t)iLookupCount);
+   pdCumulative = (double*)malloc(sizeof(double) * (size_t)iKeyCount);
+   if (ppcLookups == NULL || pdCumulative == NULL)
+   {
+      fprintf(stderr, "Insufficient memory\n");
+      exit(EXIT_FAILURE);
+   }
+
+   for (i = 0; i < iKeyCount; i++)
+   {
+      dTotal += 1.0 / (double)(i + 1);
+      pdCumulative[i] = dTotal;
+   }
+
+   for (i = 0; i < iLookupCount; i++)
+   {
+      ulSeed = ulSeed * 1103515245UL + 12345UL;
+      dDraw = (double)((ulSeed >> 8) & 0xFFFFFFUL) / 16777216.0 * dTotal;
+
+      /* Find the first key whose cumulative weight exceeds dDraw. */
+      iLow = 0;
+      iHigh = iKeyCount - 1;
+      while (iLow < iHigh)
+      {
+         iMid = iLow + (iHigh - iLow) / 2;
+         if (pdCumulative[iMid] > dDraw)
+            iHigh = iMid;
+         else
+            iLow = iMid + 1;
+      }
+      ppcLookups[i] = ppcKeys[iLow];
+   }
+
+   free(pdCumulative);
+   return ppcLookups;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Time Zipf-distributed lookups over a table in the order SymTable_put()
+   leaves it, which puts the hot keys last, and again with the table
+   self-organizing. Do it for ordinary keys and for keys crafted to
+   share one bucket of symtablehash.c. Uses at most MAX_KEY_COUNT of the
+   iBindingCount bindings, since a list searches every key. */
+
+static void benchZipf(int iBindingCount)
+{
+   enum {MAX_KEY_COUNT = 512, LOOKUP_COUNT = 1000000};
+
+   SymTable_T oSymTable;
+   char **ppcKeys;
+   char **ppcLookups;
+   int iKeyCount = iBindingCount;
+   int iPass;
+   double dStatic;
+   double dOrganizing;
+
+   if (iKeyCount > MAX_KEY_COUNT)
+      iKeyCount = MAX_KEY_COUNT;
+   if (iKeyCount == 0)
+      return;
+
+   for (iPass = 0; iPass < 2; iPass++)
+   {
+      if (iPass == 0)
+         ppcKeys = makeKeys(iKeyCount);
+      else
+         ppcKeys = makeCollidingKeys(iKeyCount);
+      ppcLookups = makeZipfLookups(ppcKeys, iKeyCount, LOOKUP_COUNT);
+
+      oSymTable = SymTable_newWithCapacity((size_t)iKeyCount);
+      assert(oSymTable != NULL);
+      putKeys(oSymTable, ppcKeys, iKeyCount);
+
+      dStatic = timeLookups(oSymTable, ppcLookups, LOOKUP_COUNT);
+      SymTable_setSelfOrganizing(oSymTable, 1);
+      dOrganizing = timeLookups(oSymTable, ppcLookups, LOOKUP_COUNT);
+
+      printf("zipf (%d %s keys):  static %.1f ns, "
+         "self-organizing %.1f ns per lookup\n", iKeyCount,
+         iPass == 0 ? "ordinary" : "colliding", dStatic, dOrganizing);
+      fflush(stdout);
+
+      SymTable_free(oSymTable);
+      free(ppcLookups);
+      freeKeys(ppcKeys, iKeyCount);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* The benchmarks that can be named on the command line. */
+static const struct Benchmark asBenchmarks[] =
+{
+   {"load", benchLoad},
+   {"drain", benchDrain},
+   {"scan", benchScan},
+   {"lookup", benchLookup},
+   {"miss", benchMiss},
+   {"highload", benchHighLoad},
+   {"adversarial", benchAdversarial},
+   {"small", benchSmall},
+   {"zipf", benchZipf},
+   {"prefix", benchPrefix}
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Benchmark the SymTable ADT.  Write the CPU time of each benchmark to
+   stdout.  argv[1] is the number of bindings each benchmark uses.  Any
+   further arguments name the benchmarks to run; with none, run them
+   all.  Exit with EXIT_FAILURE if argv[1] is missing, not numeric, or
+   negative, or if a benchmark name is unknown.  Otherwise return 0. */
+
+int main(int argc, char *argv[])
+{
+   enum {BENCHMARK_COUNT =
+      sizeof(asBenchmarks) / sizeof(asBenchmarks[0])};
+
+   int iBindingCount;
+   int iArg;
+   size_t u;
+
+   if (argc < 2)
+   {
+      fprintf(stderr, "Usage: %s bindingcount [benchmark ...]\n",
+         argv[0]);
+      exit(EXIT_FAILURE);
+   }
+
+   if (sscanf(argv[1], "%d", &iBindingCount) != 1)
+   {
+      fprintf(stderr, "bindingcount must be numeric\n");
+      exit(EXIT_FAILURE);
+   }
+   if (iBindingCount < 0)
+   {
+      fprintf(stderr, "bindingcount cannot be negative\n");
+      exit(EXIT_FAILURE);
+   }
+
+   if (argc == 2)
+   {
+      for (u = 0; u < BENCHMARK_COUNT; u++)
+         (*asBenchmarks[u].pfRun)(iBindingCount);
+      return 0;
+   }
+
+   for (iArg = 2; iArg < argc; iArg++)
+   {
+      for (u = 0; u < BENCHMARK_COUNT; u++)
+         if (strcmp(argv[iArg], asBenchmarks[u].pcName) == 0)
+            break;
+      if (u == BENCHMARK_COUNT)
+      {
+         fprintf(stderr, "unknown benchmark: %s\n", argv[iArg]);
+         exit(EXIT_FAILURE);
+      }
+      (*asBenchmarks[u].pfRun)(iBindingCount);
+   }
+
+   return 0;
+}
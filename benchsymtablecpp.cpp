@@ -0,0 +1,245 @@
+/*--------------------------------------------------------------------*/
+/* benchsymtablecpp.cpp                                               */
+/* Author: Ryan Chen                                                  */
+/*--------------------------------------------------------------------*/
+
+#include "symtable.hpp"
+#include "symtable.h"
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+
+/*--------------------------------------------------------------------*/
+
+/* Return the CPU time in seconds consumed between iInitialClock and
+   iFinalClock. */
+
+static double seconds(std::clock_t iInitialClock, std::clock_t iFinalClock)
+{
+   return ((double)(iFinalClock - iInitialClock)) / CLOCKS_PER_SEC;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return iKeyCount keys "0", "1", ... in a fixed pseudo-random order,
+   so that lookups do not walk the table in the order the keys were
+   generated. */
+
+static std::vector<std::string> makeShuffledKeys(int iKeyCount)
+{
+   std::vector<std::string> oKeys;
+   unsigned long ulSeed = 12345;
+   int i;
+   int j;
+
+   for (i = 0; i < iKeyCount; i++)
+      oKeys.push_back(std::to_string(i));
+
+   for (i = iKeyCount - 1; i > 0; i--)
+   {
+      ulSeed = ulSeed * 1103515245UL + 12345UL;
+      j = (int)((ulSeed >> 8) % (unsigned long)(i + 1));
+      std::swap(oKeys[i], oKeys[j]);
+   }
+
+   return oKeys;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Add the int that pvValue points to to the long that pvExtra points
+   to. */
+
+static void sumValue(const char *pcKey, void *pvValue, void *pvExtra)
+{
+   (void)pcKey;
+   *(long*)pvExtra += *(int*)pvValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Time loading, looking up and mapping over iBindingCount bindings of
+   int values, through the C interface to symtablehash.c and through
+   symtab::SymTable. */
+
+static void benchTable(int iBindingCount)
+{
+   enum {LOOKUP_ROUNDS = 10};
+
+   std::vector<std::string> oKeys = makeShuffledKeys(iBindingCount);
+   std::vector<int> oValues(iBindingCount);
+   std::clock_t iInitialClock;
+   SymTable_T oSymTable;
+   double dLoad;
+   double dLookup;
+   double dMap;
+   long lSum = 0;
+   int iRound;
+   int i;
+
+   /* The C interface stores pointers, so the values live apart. */
+   iInitialClock = std::clock();
+   oSymTable = SymTable_new();
+   assert(oSymTable != NULL);
+   for (i = 0; i < iBindingCount; i++)
+   {
+      oValues[i] = i;
+      SymTable_put(oSymTable, oKeys[i].c_str(), &oValues[i]);
+   }
+   dLoad = seconds(iInitialClock, std::clock());
+
+   iInitialClock = std::clock();
+   for (iRound = 0; iRound < LOOKUP_ROUNDS; iRound++)
+      for (i = 0; i < iBindingCount; i++)
+         lSum += *(int*)SymTable_get(oSymTable, oKeys[i].c_str());
+   dLookup = seconds(iInitialClock, std::clock()) * 1e9
+             / ((double)iBindingCount * LOOKUP_ROUNDS);
+
+   iInitialClock = std::clock();
+   for (iRound = 0; iRound < LOOKUP_ROUNDS; iRound++)
+      SymTable_map(oSymTable, sumValue, &lSum);
+   dMap = seconds(iInitialClock, std::clock());
+   SymTable_free(oSymTable);
+
+   std::printf("table (%d bindings, C):  load %f seconds, "
+      "%.1f ns per lookup, map %f seconds\n", iBindingCount, dLoad,
+      dLookup, dMap);
+
+   {
+      symtab::SymTable<int> oTable;
+
+      iInitialClock = std::clock();
+      for (i = 0; i < iBindingCount; i++)
+         oTable.put(oKeys[i], i);
+      dLoad = seconds(iInitialClock, std::clock());
+
+      iInitialClock = std::clock();
+      for (iRound = 0; iRound < LOOKUP_ROUNDS; iRound++)
+         for (i = 0; i < iBindingCount; i++)
+            lSum += *oTable.get(oKeys[i]);
+      dLookup = seconds(iInitialClock, std::clock()) * 1e9
+                / ((double)iBindingCount * LOOKUP_ROUNDS);
+
+      iInitialClock = std::clock();
+      for (iRound = 0; iRound < LOOKUP_ROUNDS; iRound++)
+         oTable.map([&](std::string_view oKey, int &iValue)
+            {
+               (void)oKey;
+               lSum += iValue;
+            });
+      dMap = seconds(iInitialClock, std::clock());
+   }
+
+   std::printf("table (%d bindings, C++):  load %f seconds, "
+      "%.1f ns per lookup, map %f seconds\n", iBindingCount, dLoad,
+      dLookup, dMap);
+
+   /* Keep the lookups from being optimized away. */
+   if (lSum == -1)
+      std::printf("unreachable\n");
+   std::fflush(stdout);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Keywords known at compile time */
+static constexpr auto oKeywords = symtab::makeFixedSymTable<int>(
+   {{"if", 1}, {"else", 2}, {"while", 3}, {"for", 4}, {"return", 5},
+    {"int", 6}, {"char", 7}, {"struct", 8}, {"void", 9}, {"do", 10},
+    {"break", 11}, {"continue", 12}, {"switch", 13}, {"case", 14},
+    {"static", 15}, {"const", 16}});
+
+/*--------------------------------------------------------------------*/
+
+/* Time classifying iBindingCount words, half of them keywords, with a
+   C table of the keywords and with a symtab::FixedSymTable. */
+
+static void benchKeywords(int iBindingCount)
+{
+   static const char *apcWords[] =
+      {"if", "x", "while", "count", "return", "i", "int", "node",
+       "struct", "next", "for", "value", "else", "key", "const", "n"};
+   enum {WORD_COUNT = sizeof(apcWords) / sizeof(apcWords[0])};
+
+   std::clock_t iInitialClock;
+   SymTable_T oSymTable;
+   std::vector<int> oValues(WORD_COUNT);
+   double dC;
+   double dFixed;
+   long lSum = 0;
+   int i;
+
+   oSymTable = SymTable_new();
+   assert(oSymTable != NULL);
+   oKeywords.map([&](std::string_view oKey, const int &iValue)
+      {
+         std::string oCopy(oKey);
+         oValues[iValue - 1] = iValue;
+         SymTable_put(oSymTable, oCopy.c_str(), &oValues[iValue - 1]);
+      });
+
+   iInitialClock = std::clock();
+   for (i = 0; i < iBindingCount; i++)
+   {
+      int *piValue =
+         (int*)SymTable_get(oSymTable, apcWords[i % WORD_COUNT]);
+      if (piValue != NULL)
+         lSum += *piValue;
+   }
+   dC = seconds(iInitialClock, std::clock());
+   SymTable_free(oSymTable);
+
+   iInitialClock = std::clock();
+   for (i = 0; i < iBindingCount; i++)
+   {
+      const int *piValue = oKeywords.get(apcWords[i % WORD_COUNT]);
+      if (piValue != nullptr)
+         lSum += *piValue;
+   }
+   dFixed = seconds(iInitialClock, std::clock());
+
+   if (lSum == -1)
+      std::printf("unreachable\n");
+
+   std::printf("keywords (%d words):  C %.1f ns, fixed %.1f ns "
+      "per word\n", iBindingCount, dC * 1e9 / iBindingCount,
+      dFixed * 1e9 / iBindingCount);
+   std::fflush(stdout);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Compare symtable.hpp with the C interface to symtablehash.c.
+   argv[1] is the number of bindings each benchmark uses. Exit with
+   EXIT_FAILURE if argv[1] is missing, not numeric, or not positive.
+   Otherwise return 0. */
+
+int main(int argc, char *argv[])
+{
+   int iBindingCount;
+
+   if (argc != 2)
+   {
+      std::fprintf(stderr, "Usage: %s bindingcount\n", argv[0]);
+      std::exit(EXIT_FAILURE);
+   }
+
+   if (std::sscanf(argv[1], "%d", &iBindingCount) != 1)
+   {
+      std::fprintf(stderr, "bindingcount must be numeric\n");
+      std::exit(EXIT_FAILURE);
+   }
+   if (iBindingCount <= 0)
+   {
+      std::fprintf(stderr, "bindingcount must be positive\n");
+      std::exit(EXIT_FAILURE);
+   }
+
+   benchTable(iBindingCount);
+   benchKeywords(iBindingCount);
+   return 0;
+}
@@ -0,0 +1,187 @@
+/*--------------------------------------------------------------------*/
+/* symtable-load.c                                                    */
+/* Author: Ryan Chen                                                  */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+#include "symtableload.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <assert.h>
+
+/*--------------------------------------------------------------------*/
+
+/* Return the wall-clock time in seconds since some fixed point. */
+
+static double wallSeconds(void)
+{
+   struct timespec sNow;
+
+   clock_gettime(CLOCK_MONOTONIC, &sNow);
+   return (double)sNow.tv_sec + (double)sNow.tv_nsec / 1e9;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Free the value that pvValue points to. */
+
+static void freeValue(const char *pcKey, void *pvValue, void *pvExtra)
+{
+   (void)pcKey;
+   (void)pvExtra;
+   free(pvValue);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Load the file pcFileName into a new table the way loaders did before
+   SymTableLoad_file: one line at a time with getline, copying each
+   value and calling SymTable_put. Print the time it took and the
+   throughput in MB/s. Exit with EXIT_FAILURE if the file cannot be
+   read or insufficient memory is available. */
+
+static void loadSerially(const char *pcFileName)
+{
+   SymTable_T oSymTable;
+   FILE *psFile;
+   char *pcLine = NULL;
+   size_t uCapacity = 0;
+   ssize_t iLength;
+   char *pcTab;
+   char *pcValue;
+   double dStart;
+   double dSeconds;
+   size_t uBytes = 0;
+
+   psFile = fopen(pcFileName, "r");
+   if (psFile == NULL)
+   {
+      fprintf(stderr, "Cannot read %s\n", pcFileName);
+      exit(EXIT_FAILURE);
+   }
+   oSymTable = SymTable_new();
+   if (oSymTable == NULL)
+   {
+      fprintf(stderr, "Insufficient memory\n");
+      exit(EXIT_FAILURE);
+   }
+
+   dStart = wallSeconds();
+   while ((iLength = getline(&pcLine, &uCapacity, psFile)) > 0)
+   {
+      uBytes += (size_t)iLength;
+      if (pcLine[iLength - 1] == '\n')
+         pcLine[--iLength] = '\0';
+      if (iLength > 0 && pcLine[iLength - 1] == '\r')
+         pcLine[--iLength] = '\0';
+      if (iLength == 0)
+         continue;
+
+      pcTab = strchr(pcLine, '\t');
+      if (pcTab != NULL)
+         *pcTab = '\0';
+      pcValue = (char*)malloc(strlen(pcTab != NULL ? pcTab + 1 : "") + 1);
+      if (pcValue == NULL)
+      {
+         fprintf(stderr, "Insufficient memory\n");
+         exit(EXIT_FAILURE);
+      }
+      strcpy(pcValue, pcTab != NULL ? pcTab + 1 : "");
+      if (! SymTable_put(oSymTable, pcLine, pcValue))
+         free(pcValue);
+   }
+   dSeconds = wallSeconds() - dStart;
+   fclose(psFile);
+   free(pcLine);
+
+   printf("getline+put:  %lu bindings, %.1f MB in %.3f s, "
+      "%.1f MB/s\n", (unsigned long)SymTable_getLength(oSymTable),
+      uBytes / 1e6, dSeconds, uBytes / 1e6 / dSeconds);
+
+   SymTable_map(oSymTable, freeValue, NULL);
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Load the tab-separated key/value file named on the command line
+   into a table with SymTableLoad_file, with as many threads as the
+   second argument says or as there are processors, and print the
+   throughput in MB/s. With -s, first load it the serial way too, for
+   comparison. Return 0, or EXIT_FAILURE if the file cannot be
+   loaded. */
+
+int main(int argc, char *argv[])
+{
+   SymTable_T oSymTable;
+   SymTableLoad_T oSymTableLoad;
+   const char *pcFileName;
+   long lThreadCount;
+   double dStart;
+   double dSeconds;
+   size_t uBytes;
+   int iSerial = 0;
+   int iArg = 1;
+
+   if (iArg < argc && strcmp(argv[iArg], "-s") == 0)
+   {
+      iSerial = 1;
+      iArg++;
+   }
+   if (iArg >= argc || argc - iArg > 2)
+   {
+      fprintf(stderr, "Usage: %s [-s] file [threadcount]\n", argv[0]);
+      exit(EXIT_FAILURE);
+   }
+   pcFileName = argv[iArg];
+
+   if (iArg + 1 < argc)
+   {
+      if (sscanf(argv[iArg + 1], "%ld", &lThreadCount) != 1 ||
+          lThreadCount <= 0)
+      {
+         fprintf(stderr, "threadcount must be a positive number\n");
+         exit(EXIT_FAILURE);
+      }
+   }
+   else
+   {
+      lThreadCount = sysconf(_SC_NPROCESSORS_ONLN);
+      if (lThreadCount <= 0)
+         lThreadCount = 1;
+   }
+
+   if (iSerial)
+      loadSerially(pcFileName);
+
+   oSymTable = SymTable_new();
+   if (oSymTable == NULL)
+   {
+      fprintf(stderr, "Insufficient memory\n");
+      exit(EXIT_FAILURE);
+   }
+
+   dStart = wallSeconds();
+   oSymTableLoad = SymTableLoad_file(oSymTable, pcFileName,
+      (size_t)lThreadCount);
+   dSeconds = wallSeconds() - dStart;
+   if (oSymTableLoad == NULL)
+   {
+      fprintf(stderr, "Cannot load %s\n", pcFileName);
+      exit(EXIT_FAILURE);
+   }
+
+   uBytes = SymTableLoad_getByteCount(oSymTableLoad);
+   printf("SymTableLoad_file (%ld threads):  %lu lines, %lu bindings, "
+      "%.1f MB in %.3f s, %.1f MB/s\n", lThreadCount,
+      (unsigned long)SymTableLoad_getLineCount(oSymTableLoad),
+      (unsigned long)SymTable_getLength(oSymTable), uBytes / 1e6,
+      dSeconds, uBytes / 1e6 / dSeconds);
+
+   SymTable_free(oSymTable);
+   SymTableLoad_free(oSymTableLoad);
+   return 0;
+}
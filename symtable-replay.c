@@ -0,0 +1,349 @@
+/*--------------------------------------------------------------------*/
+/* symtable-replay.c                                                  */
+/* Author: Ryan Chen                                                  */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+#include "symtable.h"
+#include "symtabletrace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <assert.h>
+
+/*--------------------------------------------------------------------*/
+
+/* One operation of a trace, ready to replay */
+
+struct Operation
+{
+   /* the SymTableTraceOp */
+   unsigned char ucOp;
+
+   /* the result the traced table gave */
+   unsigned char ucResult;
+
+   /* the index of the table in the order the trace created them */
+   size_t uTable;
+
+   /* the offset of the key in the key text, if the operation takes
+      one */
+   size_t uKeyOffset;
+};
+
+/* A whole trace, loaded into memory so that replaying it reads no
+   file */
+
+struct Trace
+{
+   /* the operations, in order */
+   struct Operation *psOperations;
+   size_t uOperationCount;
+
+   /* the keys, each ending in '\0' */
+   char *pcKeyText;
+   size_t uKeyTextLength;
+
+   /* the ids of the tables, in the order they were created */
+   unsigned long *pulTableIds;
+   size_t uTableCount;
+};
+
+/* The value every replayed binding is bound to. Only whether a value
+   is NULL shows in a trace. */
+
+static int iValue;
+
+/*--------------------------------------------------------------------*/
+
+/* Return the wall-clock time in seconds since some fixed point. */
+
+static double wallSeconds(void)
+{
+   struct timespec sNow;
+
+   clock_gettime(CLOCK_MONOTONIC, &sNow);
+   return (double)sNow.tv_sec + (double)sNow.tv_nsec / 1e9;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Make room in the array *ppvArray, of *puCapacity elements of
+   uElementSize bytes each, for at least one more than uLength
+   elements. Exit with EXIT_FAILURE if insufficient memory is
+   available. */
+
+static void makeRoom(void **ppvArray, size_t *puCapacity, size_t uLength,
+   size_t uElementSize)
+{
+   void *pvMore;
+   size_t uCapacity = *puCapacity;
+
+   if (uLength < uCapacity)
+      return;
+   uCapacity = uCapacity == 0 ? 1024 : 2 * uCapacity;
+   pvMore = realloc(*ppvArray, uCapacity * uElementSize);
+   if (pvMore == NULL)
+   {
+      fprintf(stderr, "Insufficient memory\n");
+      exit(EXIT_FAILURE);
+   }
+   *ppvArray = pvMore;
+   *puCapacity = uCapacity;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the index in psTrace of the table with id ulTableId, or
+   psTrace->uTableCount if the trace has not created it. Ids grow in
+   the order tables are created, so a binary search finds it. */
+
+static size_t findTable(const struct Trace *psTrace,
+   unsigned long ulTableId)
+{
+   size_t uLow = 0;
+   size_t uHigh = psTrace->uTableCount;
+   size_t uMiddle;
+
+   while (uLow < uHigh)
+   {
+      uMiddle = uLow + (uHigh - uLow) / 2;
+      if (psTrace->pulTableIds[uMiddle] < ulTableId)
+         uLow = uMiddle + 1;
+      else
+         uHigh = uMiddle;
+   }
+   if (uLow < psTrace->uTableCount &&
+       psTrace->pulTableIds[uLow] == ulTableId)
+      return uLow;
+   return psTrace->uTableCount;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Load the trace in the file pcFileName into *psTrace. A trace that
+   ends in a malformed record, as one cut short by a crash does, is
+   loaded up to that record, with a warning. Exit with EXIT_FAILURE if
+   the file is not a trace, or insufficient memory is available. */
+
+static void loadTrace(const char *pcFileName, struct Trace *psTrace)
+{
+   SymTableTraceReader_T oReader;
+   struct SymTableTraceRecord sRecord;
+   struct Operation *psOperation;
+   size_t uOperationCapacity = 0;
+   size_t uKeyTextCapacity = 0;
+   size_t uTableCapacity = 0;
+   size_t uTable;
+   int iStatus;
+
+   oReader = SymTableTraceReader_open(pcFileName);
+   if (oReader == NULL)
+   {
+      fprintf(stderr, "Cannot read a trace from %s\n", pcFileName);
+      exit(EXIT_FAILURE);
+   }
+
+   memset(psTrace, 0, sizeof(*psTrace));
+   makeRoom((void **)&psTrace->pcKeyText, &uKeyTextCapacity, 0, 1);
+   while ((iStatus = SymTableTraceReader_next(oReader, &sRecord)) == 1)
+   {
+      if (sRecord.op == SYMTABLE_TRACE_NEW)
+      {
+         if (psTrace->uTableCount > 0 && sRecord.tableId <=
+             psTrace->pulTableIds[psTrace->uTableCount - 1])
+            break;
+         makeRoom((void **)&psTrace->pulTableIds, &uTableCapacity,
+            psTrace->uTableCount, sizeof(unsigned long));
+         psTrace->pulTableIds[psTrace->uTableCount] = sRecord.tableId;
+         uTable = psTrace->uTableCount++;
+      }
+      else
+      {
+         uTable = findTable(psTrace, sRecord.tableId);
+         if (uTable == psTrace->uTableCount)
+            break;
+      }
+
+      makeRoom((void **)&psTrace->psOperations, &uOperationCapacity,
+         psTrace->uOperationCount, sizeof(struct Operation));
+      psOperation = &psTrace->psOperations[psTrace->uOperationCount++];
+      psOperation->ucOp = (unsigned char)sRecord.op;
+      psOperation->ucResult = (unsigned char)sRecord.result;
+      psOperation->uTable = uTable;
+      psOperation->uKeyOffset = psTrace->uKeyTextLength;
+
+      if (sRecord.pcKey != NULL)
+      {
+         while (uKeyTextCapacity - psTrace->uKeyTextLength <=
+                sRecord.keyLength)
+            makeRoom((void **)&psTrace->pcKeyText, &uKeyTextCapacity,
+               uKeyTextCapacity, 1);
+         memcpy(psTrace->pcKeyText + psTrace->uKeyTextLength,
+            sRecord.pcKey, sRecord.keyLength);
+         psTrace->uKeyTextLength += sRecord.keyLength;
+         psTrace->pcKeyText[psTrace->uKeyTextLength++] = '\0';
+      }
+   }
+
+   if (iStatus != 0)
+      fprintf(stderr, "%s ends in a malformed record; replaying the "
+         "%lu operations before it\n", pcFileName,
+         (unsigned long)psTrace->uOperationCount);
+   SymTableTraceReader_free(oReader);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Count the binding that pcKey, pvValue and pvExtra describe in the
+   size_t that pvExtra points to. */
+
+static void countBinding(const char *pcKey, void *pvValue,
+   void *pvExtra)
+{
+   (void)pcKey;
+   (void)pvValue;
+   *(size_t *)pvExtra += 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Replay the operations of psTrace once, on tables of this program's
+   implementation held in poTables, which has a slot for each table of
+   the trace, and free the tables the trace leaves in use. Return the
+   number of operations whose result differed from the one the traced
+   table gave. Exit with EXIT_FAILURE if insufficient memory is
+   available. */
+
+static size_t replay(const struct Trace *psTrace, SymTable_T poTables[])
+{
+   const struct Operation *psOperation;
+   const struct Operation *psEnd;
+   SymTable_T oSymTable;
+   const char *pcKey;
+   size_t uMismatches = 0;
+   size_t uBindings = 0;
+   size_t uTable;
+   int iResult;
+
+   psEnd = psTrace->psOperations + psTrace->uOperationCount;
+   for (psOperation = psTrace->psOperations; psOperation < psEnd;
+        psOperation++)
+   {
+      oSymTable = poTables[psOperation->uTable];
+      pcKey = psTrace->pcKeyText + psOperation->uKeyOffset;
+      switch (psOperation->ucOp)
+      {
+         case SYMTABLE_TRACE_NEW:
+            oSymTable = SymTable_new();
+            if (oSymTable == NULL)
+            {
+               fprintf(stderr, "Insufficient memory\n");
+               exit(EXIT_FAILURE);
+            }
+            poTables[psOperation->uTable] = oSymTable;
+            iResult = 1;
+            break;
+         case SYMTABLE_TRACE_FREE:
+            SymTable_free(oSymTable);
+            poTables[psOperation->uTable] = NULL;
+            iResult = 1;
+            break;
+         case SYMTABLE_TRACE_PUT:
+            iResult = SymTable_put(oSymTable, pcKey, &iValue);
+            break;
+         case SYMTABLE_TRACE_GET:
+            iResult = SymTable_get(oSymTable, pcKey) != NULL;
+            break;
+         case SYMTABLE_TRACE_CONTAINS:
+            iResult = SymTable_contains(oSymTable, pcKey);
+            break;
+         case SYMTABLE_TRACE_REPLACE:
+            iResult = SymTable_replace(oSymTable, pcKey, &iValue)
+               != NULL;
+            break;
+         case SYMTABLE_TRACE_REMOVE:
+            iResult = SymTable_remove(oSymTable, pcKey) != NULL;
+            break;
+         default:
+            SymTable_map(oSymTable, countBinding, &uBindings);
+            iResult = 1;
+            break;
+      }
+      if (iResult != psOperation->ucResult)
+         uMismatches++;
+   }
+
+   for (uTable = 0; uTable < psTrace->uTableCount; uTable++)
+   {
+      if (poTables[uTable] != NULL)
+         SymTable_free(poTables[uTable]);
+      poTables[uTable] = NULL;
+   }
+   return uMismatches;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Replay the trace named on the command line, as many times as the
+   second argument says or once, against this program's SymTable
+   implementation, and print the time each operation took on average
+   and how many results differed from the traced ones. Results differ
+   wherever the traced tables did something no trace records, such as
+   evicting a binding, popping a scope, or binding NULL. Return 0, or
+   EXIT_FAILURE if the trace cannot be replayed. */
+
+int main(int argc, char *argv[])
+{
+   struct Trace sTrace;
+   SymTable_T *poTables;
+   long lPassCount = 1;
+   long lPass;
+   double dStart;
+   double dSeconds;
+   size_t uMismatches;
+
+   if (argc < 2 || argc > 3)
+   {
+      fprintf(stderr, "Usage: %s tracefile [passcount]\n", argv[0]);
+      exit(EXIT_FAILURE);
+   }
+   if (argc == 3 &&
+       (sscanf(argv[2], "%ld", &lPassCount) != 1 || lPassCount <= 0))
+   {
+      fprintf(stderr, "passcount must be a positive number\n");
+      exit(EXIT_FAILURE);
+   }
+
+   loadTrace(argv[1], &sTrace);
+   poTables = (SymTable_T *)calloc(sTrace.uTableCount + 1,
+      sizeof(SymTable_T));
+   if (poTables == NULL)
+   {
+      fprintf(stderr, "Insufficient memory\n");
+      exit(EXIT_FAILURE);
+   }
+
+   /* Each pass starts from no tables, as the traced process did, so
+      every pass does the same work. */
+   uMismatches = replay(&sTrace, poTables);
+   dStart = wallSeconds();
+   for (lPass = 0; lPass < lPassCount; lPass++)
+      (void)replay(&sTrace, poTables);
+   dSeconds = wallSeconds() - dStart;
+
+   printf("%lu operations on %lu tables, %ld passes: %.3f s, "
+      "%.1f ns per operation, %lu results differ from the trace\n",
+      (unsigned long)sTrace.uOperationCount,
+      (unsigned long)sTrace.uTableCount, lPassCount, dSeconds,
+      sTrace.uOperationCount == 0 ? 0.0 :
+      dSeconds * 1e9 / ((double)sTrace.uOperationCount * lPassCount),
+      (unsigned long)uMismatches);
+
+   free(poTables);
+   free(sTrace.psOperations);
+   free(sTrace.pcKeyText);
+   free(sTrace.pulTableIds);
+   return 0;
+}
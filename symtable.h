@@ -7,6 +7,10 @@
 #define symtable
 #include <stddef.h>
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 /* A SymTable_T object is a last-in-first-out collection of bindings. */
 typedef struct SymTable *SymTable_T;
 
@@ -14,6 +18,28 @@ typedef struct SymTable *SymTable_T;
    available. */
 SymTable_T SymTable_new(void);
 
+/* Return a new SymTable_T object that can hold uCapacity bindings
+   without growing, or NULL if insufficient memory is available. */
+SymTable_T SymTable_newWithCapacity(size_t uCapacity);
+
+/* Grows oSymTable so that it can hold uCapacity bindings in total
+   without growing again. Never shrinks oSymTable. Returns 1 if
+   successful, 0 if insufficient memory is available, in which case the
+   bindings of oSymTable are left unchanged. */
+int SymTable_reserve(SymTable_T oSymTable, size_t uCapacity);
+
+/* Releases storage oSymTable holds beyond what its current bindings
+   need, including capacity reserved by SymTable_newWithCapacity or
+   SymTable_reserve. The bindings are left unchanged. */
+void SymTable_shrinkToFit(SymTable_T oSymTable);
+
+/* Sets whether oSymTable reorganizes itself as it is searched. While
+   iEnabled is nonzero, SymTable_get and SymTable_contains move each
+   binding they find to where the next search looks first, so keys that
+   are looked up often become cheap to find. Implementations that fix
+   where each binding is stored ignore the setting. */
+void SymTable_setSelfOrganizing(SymTable_T oSymTable, int iEnabled);
+
 /* Free all memory associated with oSymTable. */
 void SymTable_free(SymTable_T oSymTable);
 
@@ -51,4 +77,8 @@ void SymTable_map(SymTable_T oSymTable,
     void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
     const void *pvExtra);
   
+#ifdef __cplusplus
+}
+#endif
+
 #endif
\ No newline at end of file
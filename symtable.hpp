@@ -0,0 +1,625 @@
+/*--------------------------------------------------------------------*/
+/* symtable.hpp                                                       */
+/* Author: Ryan Chen                                                  */
+/*--------------------------------------------------------------------*/
+
+#ifndef symtablehpp
+#define symtablehpp
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+
+/* A header-only C++ front end that uses the chained hash table design
+   of symtablehash.c: the same hash, bucket counts, reduction and
+   resizing. Because it is a template over the value type, values are
+   stored in the nodes by value and may be move-only. The hash, the key
+   compare and the function given to map are all inlined rather than
+   called through pointers. Memory comes from Alloc, and running out of
+   it throws, as it does for std containers. */
+
+/* The namespace is not called symtable because symtable.h defines
+   that name as its include guard. */
+namespace symtab
+{
+    namespace detail
+    {
+        /* Bucket counts to expand to, the same as symtablehash.c. */
+        inline constexpr std::size_t bucketCount[] =
+            {509, 1021, 2039, 4093, 8191, 16381, 32749, 65521, 131071,
+             262139, 524287, 1048573, 2097143, 4194301, 8388593,
+             16777213, 33554393, 67108859, 134217689, 268435399,
+             536870909, 1073741789, 2147483647};
+
+        /* Number of entries in bucketCount */
+        inline constexpr std::size_t BUCKET_COUNT_LENGTH =
+            sizeof(bucketCount) / sizeof(bucketCount[0]);
+
+        /* The buckets shrink once there are more than SHRINK_DIVISOR
+           buckets per binding. */
+        inline constexpr std::size_t SHRINK_DIVISOR = 8;
+
+        /* Returns the index of the smallest bucket count that holds
+           uCapacity bindings at one binding per bucket. */
+        constexpr std::size_t indexForCapacity(std::size_t uCapacity)
+        {
+            std::size_t uIndex = 0;
+
+            while (uIndex < BUCKET_COUNT_LENGTH - 1 &&
+                   bucketCount[uIndex] < uCapacity)
+                uIndex++;
+
+            return uIndex;
+        }
+
+        /* Maps the high 32 bits of uHash onto [0, uBucketCount) with
+           a multiply and a shift, as symtablehash.c does. */
+        constexpr std::size_t reduce(std::uint64_t uHash,
+                                     std::size_t uBucketCount)
+        {
+            return static_cast<std::size_t>(
+                ((uHash >> 32) * static_cast<std::uint64_t>(uBucketCount))
+                >> 32);
+        }
+    }
+
+    /* Hashes a key the way symtablehash.c does: the polynomial hash
+       with multiplier 65599, mixed so that its high bits depend on
+       every character. A replacement Hash must likewise spread keys
+       over the high 32 bits of its result. */
+    struct StringHash
+    {
+        constexpr std::uint64_t operator()(std::string_view oKey)
+            const noexcept
+        {
+            std::size_t uHash = 0;
+
+            for (char c : oKey)
+                uHash = uHash * 65599 + static_cast<std::size_t>(c);
+
+            std::uint64_t uMixed = static_cast<std::uint64_t>(uHash);
+            uMixed ^= uMixed >> 32;
+            uMixed *= UINT64_C(0x9E3779B97F4A7C15);
+            return uMixed;
+        }
+    };
+
+    /* Compares two keys, length first. */
+    struct StringEqual
+    {
+        constexpr bool operator()(std::string_view oKey1,
+                                  std::string_view oKey2) const noexcept
+        {
+            return oKey1 == oKey2;
+        }
+    };
+
+    /* A SymTable binds copies of string keys to values of type V.
+       It is move-only. */
+    template <class V, class Hash = StringHash, class KeyEq = StringEqual,
+              class Alloc = std::allocator<V>>
+    class SymTable
+    {
+      private:
+        /* Each Node stores one binding, with the full hash of its key
+           so that rehashing and most mismatches never read the key. */
+        struct Node
+        {
+            /* address of next Node in the bucket */
+            Node *psNextNode;
+
+            /* the hash of the key */
+            std::uint64_t uHash;
+
+            /* the key, owned by the Node */
+            char *pcKey;
+
+            /* the length of the key */
+            std::size_t uLength;
+
+            /* the value */
+            V value;
+
+            template <class... Args>
+            Node(std::uint64_t uHashIn, char *pcKeyIn,
+                 std::size_t uLengthIn, Args &&...args)
+                : psNextNode(nullptr), uHash(uHashIn), pcKey(pcKeyIn),
+                  uLength(uLengthIn), value(std::forward<Args>(args)...)
+            {
+            }
+
+            std::string_view key() const noexcept
+            {
+                return std::string_view(pcKey, uLength);
+            }
+        };
+
+        using AllocTraits = std::allocator_traits<Alloc>;
+        using NodeAlloc =
+            typename AllocTraits::template rebind_alloc<Node>;
+        using NodeTraits = std::allocator_traits<NodeAlloc>;
+        using CharAlloc =
+            typename AllocTraits::template rebind_alloc<char>;
+        using CharTraits = std::allocator_traits<CharAlloc>;
+        using BucketAlloc =
+            typename AllocTraits::template rebind_alloc<Node *>;
+        using BucketTraits = std::allocator_traits<BucketAlloc>;
+
+        Node **ppsBuckets;
+        std::size_t uBucketCount;
+        std::size_t uBindingCount;
+        std::size_t uBucketIndex;
+        std::size_t uMinBucketIndex;
+        Hash oHash;
+        KeyEq oKeyEq;
+        NodeAlloc oNodeAlloc;
+        CharAlloc oCharAlloc;
+        BucketAlloc oBucketAlloc;
+
+        /* The link findLink returns in a table that has no buckets
+           because it was moved from. Nothing is ever stored in it. */
+        inline static Node *psNoBucket = nullptr;
+
+        /* Returns a zeroed array of detail::bucketCount[uIndex]
+           buckets. */
+        Node **allocBuckets(std::size_t uIndex)
+        {
+            std::size_t uCount = detail::bucketCount[uIndex];
+            Node **ppsNew = BucketTraits::allocate(oBucketAlloc, uCount);
+
+            for (std::size_t u = 0; u < uCount; u++)
+                ppsNew[u] = nullptr;
+            return ppsNew;
+        }
+
+        /* Moves every node into a new array of
+           detail::bucketCount[uNewIndex] buckets. Keys are not
+           rehashed: each node keeps its hash. */
+        void rehash(std::size_t uNewIndex)
+        {
+            std::size_t uNewCount = detail::bucketCount[uNewIndex];
+            Node **ppsNew = allocBuckets(uNewIndex);
+            Node *psNode;
+            Node *psNext;
+            std::size_t uNew;
+
+            for (std::size_t u = 0; u < uBucketCount; u++)
+            {
+                for (psNode = ppsBuckets[u]; psNode != nullptr;
+                     psNode = psNext)
+                {
+                    psNext = psNode->psNextNode;
+                    uNew = detail::reduce(psNode->uHash, uNewCount);
+                    psNode->psNextNode = ppsNew[uNew];
+                    ppsNew[uNew] = psNode;
+                }
+            }
+
+            if (ppsBuckets != nullptr)
+                BucketTraits::deallocate(oBucketAlloc, ppsBuckets,
+                                         uBucketCount);
+            ppsBuckets = ppsNew;
+            uBucketCount = uNewCount;
+            uBucketIndex = uNewIndex;
+        }
+
+        /* Returns the address of the link that points to the node for
+           oKey, whose hash is uHash, or to the null link at the end of
+           its bucket if oKey is absent. */
+        Node **findLink(std::string_view oKey, std::uint64_t uHash) const
+        {
+            Node **ppsLink;
+
+            if (uBucketCount == 0)
+                return &psNoBucket;
+
+            ppsLink = &ppsBuckets[detail::reduce(uHash, uBucketCount)];
+
+            while (*ppsLink != nullptr &&
+                   ((*ppsLink)->uHash != uHash ||
+                    ! oKeyEq((*ppsLink)->key(), oKey)))
+                ppsLink = &(*ppsLink)->psNextNode;
+
+            return ppsLink;
+        }
+
+        /* Unlinks the node that *ppsLink points to and destroys it. */
+        void destroyNode(Node **ppsLink)
+        {
+            Node *psNode = *ppsLink;
+
+            *ppsLink = psNode->psNextNode;
+            CharTraits::deallocate(oCharAlloc, psNode->pcKey,
+                                   psNode->uLength + 1);
+            NodeTraits::destroy(oNodeAlloc, psNode);
+            NodeTraits::deallocate(oNodeAlloc, psNode, 1);
+            uBindingCount--;
+        }
+
+        /* Shrinks the buckets once the table is mostly empty. */
+        void contract()
+        {
+            std::size_t uIndex;
+
+            if (uBucketIndex <= uMinBucketIndex ||
+                uBindingCount * detail::SHRINK_DIVISOR >= uBucketCount)
+                return;
+
+            uIndex = detail::indexForCapacity(2 * uBindingCount);
+            if (uIndex < uMinBucketIndex)
+                uIndex = uMinBucketIndex;
+            rehash(uIndex);
+        }
+
+        /* Frees every node and the buckets. */
+        void release() noexcept
+        {
+            if (ppsBuckets == nullptr)
+                return;
+
+            for (std::size_t u = 0; u < uBucketCount; u++)
+                while (ppsBuckets[u] != nullptr)
+                    destroyNode(&ppsBuckets[u]);
+
+            BucketTraits::deallocate(oBucketAlloc, ppsBuckets,
+                                     uBucketCount);
+            ppsBuckets = nullptr;
+        }
+
+      public:
+        /* Creates a table that can hold uCapacity bindings without
+           growing. */
+        explicit SymTable(std::size_t uCapacity = 0,
+                          const Hash &oHashIn = Hash(),
+                          const KeyEq &oKeyEqIn = KeyEq(),
+                          const Alloc &oAlloc = Alloc())
+            : ppsBuckets(nullptr), uBucketCount(0), uBindingCount(0),
+              uBucketIndex(detail::indexForCapacity(uCapacity)),
+              uMinBucketIndex(uBucketIndex), oHash(oHashIn),
+              oKeyEq(oKeyEqIn), oNodeAlloc(oAlloc), oCharAlloc(oAlloc),
+              oBucketAlloc(oAlloc)
+        {
+            ppsBuckets = allocBuckets(uBucketIndex);
+            uBucketCount = detail::bucketCount[uBucketIndex];
+        }
+
+        SymTable(const SymTable &) = delete;
+        SymTable &operator=(const SymTable &) = delete;
+
+        /* Moving a table leaves the source empty, with no buckets until
+           it is next bound to, but usable as any empty table is. */
+        SymTable(SymTable &&oOther) noexcept
+            : ppsBuckets(oOther.ppsBuckets),
+              uBucketCount(oOther.uBucketCount),
+              uBindingCount(oOther.uBindingCount),
+              uBucketIndex(oOther.uBucketIndex),
+              uMinBucketIndex(oOther.uMinBucketIndex),
+              oHash(std::move(oOther.oHash)),
+              oKeyEq(std::move(oOther.oKeyEq)),
+              oNodeAlloc(std::move(oOther.oNodeAlloc)),
+              oCharAlloc(std::move(oOther.oCharAlloc)),
+              oBucketAlloc(std::move(oOther.oBucketAlloc))
+        {
+            oOther.ppsBuckets = nullptr;
+            oOther.uBucketCount = 0;
+            oOther.uBindingCount = 0;
+            oOther.uBucketIndex = 0;
+            oOther.uMinBucketIndex = 0;
+        }
+
+        SymTable &operator=(SymTable &&oOther) noexcept
+        {
+            if (this != &oOther)
+            {
+                release();
+                ppsBuckets = oOther.ppsBuckets;
+                uBucketCount = oOther.uBucketCount;
+                uBindingCount = oOther.uBindingCount;
+                uBucketIndex = oOther.uBucketIndex;
+                uMinBucketIndex = oOther.uMinBucketIndex;
+                oHash = std::move(oOther.oHash);
+                oKeyEq = std::move(oOther.oKeyEq);
+                oNodeAlloc = std::move(oOther.oNodeAlloc);
+                oCharAlloc = std::move(oOther.oCharAlloc);
+                oBucketAlloc = std::move(oOther.oBucketAlloc);
+                oOther.ppsBuckets = nullptr;
+                oOther.uBucketCount = 0;
+                oOther.uBindingCount = 0;
+                oOther.uBucketIndex = 0;
+                oOther.uMinBucketIndex = 0;
+            }
+            return *this;
+        }
+
+        ~SymTable()
+        {
+            release();
+        }
+
+        /* Returns the number of bindings. */
+        std::size_t getLength() const noexcept
+        {
+            return uBindingCount;
+        }
+
+        /* Grows the table so that it can hold uCapacity bindings in
+           total without growing again. Never shrinks it. */
+        void reserve(std::size_t uCapacity)
+        {
+            std::size_t uIndex = detail::indexForCapacity(uCapacity);
+
+            if (uIndex > uMinBucketIndex)
+                uMinBucketIndex = uIndex;
+            if (uIndex > uBucketIndex)
+                rehash(uIndex);
+        }
+
+        /* Releases buckets beyond what the current bindings need,
+           including capacity that was reserved. */
+        void shrinkToFit()
+        {
+            std::size_t uIndex = detail::indexForCapacity(uBindingCount);
+
+            uMinBucketIndex = 0;
+            if (uIndex < uBucketIndex)
+                rehash(uIndex);
+        }
+
+        /* Binds oKey to a value constructed from args if oKey is not
+           bound. Returns true if it added the binding, false if oKey
+           was already bound, in which case args are not used. */
+        template <class... Args>
+        bool emplace(std::string_view oKey, Args &&...args)
+        {
+            std::uint64_t uHash = oHash(oKey);
+            Node **ppsLink;
+            Node *psNode;
+            char *pcKey;
+            std::size_t uBucket;
+
+            if (ppsBuckets == nullptr)
+            {
+                ppsBuckets = allocBuckets(uBucketIndex);
+                uBucketCount = detail::bucketCount[uBucketIndex];
+            }
+
+            if (uBindingCount > uBucketCount &&
+                uBucketIndex < detail::BUCKET_COUNT_LENGTH - 1)
+                rehash(uBucketIndex + 1);
+
+            ppsLink = findLink(oKey, uHash);
+            if (*ppsLink != nullptr)
+                return false;
+
+            pcKey = CharTraits::allocate(oCharAlloc, oKey.size() + 1);
+            oKey.copy(pcKey, oKey.size());
+            pcKey[oKey.size()] = '\0';
+
+            try
+            {
+                psNode = NodeTraits::allocate(oNodeAlloc, 1);
+                try
+                {
+                    NodeTraits::construct(oNodeAlloc, psNode, uHash,
+                                          pcKey, oKey.size(),
+                                          std::forward<Args>(args)...);
+                }
+                catch (...)
+                {
+                    NodeTraits::deallocate(oNodeAlloc, psNode, 1);
+                    throw;
+                }
+            }
+            catch (...)
+            {
+                CharTraits::deallocate(oCharAlloc, pcKey,
+                                       oKey.size() + 1);
+                throw;
+            }
+
+            /* Prepend, as symtablehash.c does. */
+            uBucket = detail::reduce(uHash, uBucketCount);
+            psNode->psNextNode = ppsBuckets[uBucket];
+            ppsBuckets[uBucket] = psNode;
+            uBindingCount++;
+            return true;
+        }
+
+        /* Binds oKey to value if oKey is not bound. Returns true if it
+           added the binding, false if oKey was already bound. */
+        bool put(std::string_view oKey, V value)
+        {
+            return emplace(oKey, std::move(value));
+        }
+
+        /* Replaces the value bound to oKey with value. Returns the old
+           value, or nothing if oKey is not bound. */
+        std::optional<V> replace(std::string_view oKey, V value)
+        {
+            Node *psNode = *findLink(oKey, oHash(oKey));
+            std::optional<V> oOld;
+
+            if (psNode == nullptr)
+                return oOld;
+
+            oOld.emplace(std::move(psNode->value));
+            psNode->value = std::move(value);
+            return oOld;
+        }
+
+        /* Returns true if oKey is bound, false otherwise. */
+        bool contains(std::string_view oKey) const
+        {
+            return *findLink(oKey, oHash(oKey)) != nullptr;
+        }
+
+        /* Returns the address of the value bound to oKey, or nullptr
+           if oKey is not bound. The address stays valid until oKey is
+           removed or the table is destroyed. */
+        V *get(std::string_view oKey)
+        {
+            Node *psNode = *findLink(oKey, oHash(oKey));
+
+            return psNode == nullptr ? nullptr : &psNode->value;
+        }
+
+        const V *get(std::string_view oKey) const
+        {
+            const Node *psNode = *findLink(oKey, oHash(oKey));
+
+            return psNode == nullptr ? nullptr : &psNode->value;
+        }
+
+        /* Removes the binding for oKey. Returns its value, or nothing
+           if oKey is not bound. */
+        std::optional<V> remove(std::string_view oKey)
+        {
+            Node **ppsLink = findLink(oKey, oHash(oKey));
+            std::optional<V> oOld;
+
+            if (*ppsLink == nullptr)
+                return oOld;
+
+            oOld.emplace(std::move((*ppsLink)->value));
+            destroyNode(ppsLink);
+            contract();
+            return oOld;
+        }
+
+        /* Calls fApply(key, value) for each binding, where key is a
+           std::string_view and value a V &. */
+        template <class F>
+        void map(F &&fApply)
+        {
+            for (std::size_t u = 0; u < uBucketCount; u++)
+                for (Node *psNode = ppsBuckets[u]; psNode != nullptr;
+                     psNode = psNode->psNextNode)
+                    fApply(psNode->key(), psNode->value);
+        }
+
+        template <class F>
+        void map(F &&fApply) const
+        {
+            for (std::size_t u = 0; u < uBucketCount; u++)
+                for (const Node *psNode = ppsBuckets[u];
+                     psNode != nullptr; psNode = psNode->psNextNode)
+                    fApply(psNode->key(), psNode->value);
+        }
+    };
+
+    /* A FixedSymTable is an immutable table of N bindings built at
+       compile time, for symbol sets such as keywords that are known in
+       advance. It is open-addressed with linear probing over a power
+       of two at least twice N, so a lookup usually reads one slot. V
+       must be a literal type that can be default constructed. */
+    template <class V, std::size_t N, class Hash = StringHash,
+              class KeyEq = StringEqual>
+    class FixedSymTable
+    {
+      public:
+        /* A binding as given to the constructor */
+        using Entry = std::pair<std::string_view, V>;
+
+      private:
+        /* Returns the number of slots for N bindings. */
+        static constexpr std::size_t slotsFor(std::size_t uCount)
+        {
+            std::size_t uSlots = 1;
+
+            while (uSlots < 2 * uCount)
+                uSlots *= 2;
+            return uSlots;
+        }
+
+        static constexpr std::size_t SLOT_COUNT = slotsFor(N);
+
+        /* Each Slot holds one binding or is empty. */
+        struct Slot
+        {
+            std::string_view oKey;
+            V value;
+            bool bUsed;
+        };
+
+        std::array<Slot, SLOT_COUNT> aoSlots;
+
+        /* Returns the slot where oKey is or would be. */
+        constexpr std::size_t find(std::string_view oKey) const
+        {
+            std::size_t uIndex =
+                static_cast<std::size_t>(Hash()(oKey) >> 32) &
+                (SLOT_COUNT - 1);
+
+            while (aoSlots[uIndex].bUsed &&
+                   ! KeyEq()(aoSlots[uIndex].oKey, oKey))
+                uIndex = (uIndex + 1) & (SLOT_COUNT - 1);
+            return uIndex;
+        }
+
+      public:
+        /* Builds the table from aoEntries. Keys must be distinct:
+           a repeated key fails to compile in a constant expression and
+           throws std::logic_error otherwise. The keys are not copied,
+           so they must outlive the table, as string literals do. */
+        constexpr explicit FixedSymTable(const Entry (&aoEntries)[N])
+            : aoSlots{}
+        {
+            for (std::size_t u = 0; u < N; u++)
+            {
+                std::size_t uIndex = find(aoEntries[u].first);
+
+                if (aoSlots[uIndex].bUsed)
+                    throw std::logic_error("FixedSymTable: repeated key");
+                aoSlots[uIndex].oKey = aoEntries[u].first;
+                aoSlots[uIndex].value = aoEntries[u].second;
+                aoSlots[uIndex].bUsed = true;
+            }
+        }
+
+        /* Returns the number of bindings. */
+        constexpr std::size_t getLength() const noexcept
+        {
+            return N;
+        }
+
+        /* Returns true if oKey is bound, false otherwise. */
+        constexpr bool contains(std::string_view oKey) const
+        {
+            return aoSlots[find(oKey)].bUsed;
+        }
+
+        /* Returns the address of the value bound to oKey, or nullptr if
+           oKey is not bound. */
+        constexpr const V *get(std::string_view oKey) const
+        {
+            const Slot &oSlot = aoSlots[find(oKey)];
+
+            return oSlot.bUsed ? &oSlot.value : nullptr;
+        }
+
+        /* Calls fApply(key, value) for each binding. */
+        template <class F>
+        constexpr void map(F &&fApply) const
+        {
+            for (const Slot &oSlot : aoSlots)
+                if (oSlot.bUsed)
+                    fApply(oSlot.oKey, oSlot.value);
+        }
+    };
+
+    /* Returns a FixedSymTable built from aoEntries, with N deduced:
+       makeFixedSymTable<int>({{"if", 1}, {"else", 2}}). */
+    template <class V, std::size_t N>
+    constexpr FixedSymTable<V, N> makeFixedSymTable(
+        const std::pair<std::string_view, V> (&aoEntries)[N])
+    {
+        return FixedSymTable<V, N>(aoEntries);
+    }
+}
+
+#endif
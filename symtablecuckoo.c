@@ -0,0 +1,722 @@
+/*--------------------------------------------------------------------*/
+/* symtablecuckoo.c                                                   */
+/* Author: Ryan Chen                                                  */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200112L
+
+#include "symtable.h"
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+/* Sizes of the fixed arrays below, and the bytes in a cache line,
+   which each SymTableBucket fills exactly */
+enum {SLOTS_PER_BUCKET = 4, STASH_SIZE = 4, MAX_SEARCH_NODES = 256,
+      CACHE_LINE_SIZE = 64};
+
+/* Fewest buckets a SymTable ever has. Must be a power of two, and at
+   least 2 so that a key's two buckets differ. */
+static const size_t MIN_BUCKET_COUNT = 4;
+
+/* The table grows once more than MAX_LOAD_TENTHS tenths of its slots
+   are full. */
+static const size_t MAX_LOAD_TENTHS = 9;
+
+/* The table shrinks once it has more than SHRINK_DIVISOR slots per
+   binding, leaving a gap with the growth threshold so that remove/put
+   cycles do not resize back and forth. */
+static const size_t SHRINK_DIVISOR = 8;
+
+/* Position SymTable_find returns when a key is absent */
+static const size_t NOT_FOUND = (size_t)-1;
+
+/* A SymTableBucket holds SLOTS_PER_BUCKET keys in one cache line. Each
+   key has a 32-bit tag taken from its hash, so a lookup compares the
+   tags and only reads a key whose tag matches. The value of a slot
+   lives in a parallel array and is read only on a hit. */
+struct SymTableBucket
+{
+    /* the tag of each key */
+    uint32_t tags[SLOTS_PER_BUCKET];
+
+    /* each key, or NULL if the slot is empty */
+    const char *keys[SLOTS_PER_BUCKET];
+
+    /* unused, to fill the cache line */
+    char padding[CACHE_LINE_SIZE -
+                 SLOTS_PER_BUCKET * (sizeof(uint32_t) +
+                                     sizeof(const char *))];
+};
+
+/* A SymTableStep is one entry of the breadth-first search for a free
+   slot: the bucket it reached, and how it got there. */
+struct SymTableStep
+{
+    /* the bucket this step reached */
+    size_t bucket;
+
+    /* index of the step this one came from, or -1 for a starting
+       bucket */
+    int parent;
+
+    /* slot of the parent's bucket whose key would move here */
+    int slot;
+};
+
+/* SymTable represents a bucketized cuckoo hash table. Each key may
+   live in exactly two buckets, so a lookup reads at most two bucket
+   cache lines and then a small stash, whatever keys are stored. The
+   second bucket is derived from the first and the key's tag, so keys
+   can be moved between their buckets without rehashing them. */
+struct SymTable
+{
+    /* the array of buckets, aligned to a cache line */
+    struct SymTableBucket *buckets;
+
+    /* the value of each slot, SLOTS_PER_BUCKET per bucket */
+    const void **values;
+
+    /* number of buckets, always a power of two */
+    size_t bucketCount;
+
+    /* total number of bindings in the SymTable, stash included */
+    size_t bindingCount;
+
+    /* fewest buckets the table shrinks back to on its own, set by the
+       capacity the client asked for */
+    size_t minBucketCount;
+
+    /* the seed of the hash function */
+    uint64_t seed;
+
+    /* keys no search could place, each with its value */
+    const char *stashKeys[STASH_SIZE];
+    const void *stashValues[STASH_SIZE];
+
+    /* number of keys in the stash */
+    size_t stashCount;
+};
+
+/* Function that hashes pcKey with uSeed, so that a table can choose a
+   new hash function if its keys will not fit. Returns the hash, mixed
+   so that both its halves depend on every character. */
+static uint64_t SymTable_hash(const char *pcKey, uint64_t uSeed)
+{
+    const uint64_t HASH_MULTIPLIER = UINT64_C(0x100000001B3);
+    const uint64_t MIX_MULTIPLIER = UINT64_C(0x9E3779B97F4A7C15);
+    uint64_t uHash = uSeed;
+    size_t u;
+
+    assert(pcKey != NULL);
+
+    for (u = 0; pcKey[u] != '\0'; u++)
+        uHash = (uHash ^ (unsigned char)pcKey[u]) * HASH_MULTIPLIER;
+
+    uHash ^= uHash >> 32;
+    uHash *= MIX_MULTIPLIER;
+    uHash ^= uHash >> 29;
+
+    return uHash;
+}
+
+/* Function that returns the tag of a key whose hash is uHash. */
+static uint32_t SymTable_tag(uint64_t uHash)
+{
+    return (uint32_t)(uHash >> 32);
+}
+
+/* Function that returns the other bucket of a key whose tag is uTag
+   and which may live in bucket uBucket, in a table of uBucketCount
+   buckets. Applying it twice gives back uBucket. */
+static size_t SymTable_altBucket(size_t uBucket, uint32_t uTag,
+                                 size_t uBucketCount)
+{
+    size_t uOffset = (size_t)(uTag * UINT32_C(0x5BD1E995));
+
+    return uBucket ^ ((uOffset & (uBucketCount - 1)) | 1);
+}
+
+/* Function that returns a new seed derived from uSeed. */
+static uint64_t SymTable_nextSeed(uint64_t uSeed)
+{
+    uSeed += UINT64_C(0x9E3779B97F4A7C15);
+    uSeed ^= uSeed >> 31;
+    uSeed *= UINT64_C(0xBF58476D1CE4E5B9);
+    return uSeed ^ (uSeed >> 27);
+}
+
+/* Function that returns the smallest bucket count that holds uCapacity
+   bindings without growing, or 0 if no bucket count a size_t can hold
+   does. */
+static size_t SymTable_bucketsForCapacity(size_t uCapacity)
+{
+    size_t uBucketCount = MIN_BUCKET_COUNT;
+
+    if (uCapacity > (size_t)-1 / 10)
+        return 0;
+
+    while (uBucketCount * SLOTS_PER_BUCKET * MAX_LOAD_TENTHS <
+           uCapacity * 10)
+    {
+        if (uBucketCount >
+            (size_t)-1 / 2 / SLOTS_PER_BUCKET / MAX_LOAD_TENTHS)
+            return 0;
+        uBucketCount *= 2;
+    }
+
+    return uBucketCount;
+}
+
+/* Function that allocates empty buckets and values for oSymTable to
+   hold uBucketCount buckets. Returns 1 if successful, or 0 if
+   insufficient memory is available, in which case oSymTable is left
+   unchanged. */
+static int SymTable_allocBuckets(SymTable_T oSymTable,
+                                 size_t uBucketCount)
+{
+    void *pvBuckets;
+    const void **values;
+
+    if (posix_memalign(&pvBuckets, CACHE_LINE_SIZE,
+                       uBucketCount * sizeof(struct SymTableBucket)) != 0)
+        return 0;
+
+    values = (const void **)malloc(uBucketCount * SLOTS_PER_BUCKET *
+                                   sizeof(const void *));
+    if (values == NULL)
+    {
+        free(pvBuckets);
+        return 0;
+    }
+
+    memset(pvBuckets, 0, uBucketCount * sizeof(struct SymTableBucket));
+    oSymTable->buckets = (struct SymTableBucket *)pvBuckets;
+    oSymTable->values = values;
+    oSymTable->bucketCount = uBucketCount;
+    return 1;
+}
+
+/* Function that stores pcKey, tagged uTag, and pvValue in the empty
+   slot iSlot of bucket uBucket of oSymTable. */
+static void SymTable_store(SymTable_T oSymTable, size_t uBucket,
+                           int iSlot, const char *pcKey, uint32_t uTag,
+                           const void *pvValue)
+{
+    oSymTable->buckets[uBucket].keys[iSlot] = pcKey;
+    oSymTable->buckets[uBucket].tags[iSlot] = uTag;
+    oSymTable->values[uBucket * SLOTS_PER_BUCKET + (size_t)iSlot] =
+        pvValue;
+}
+
+/* Function that returns an empty slot of bucket uBucket of oSymTable,
+   or -1 if it is full. */
+static int SymTable_emptySlot(SymTable_T oSymTable, size_t uBucket)
+{
+    int iSlot;
+
+    for (iSlot = 0; iSlot < SLOTS_PER_BUCKET; iSlot++)
+        if (oSymTable->buckets[uBucket].keys[iSlot] == NULL)
+            return iSlot;
+
+    return -1;
+}
+
+/* Function that returns 1 if the key in slot iSlot of bucket uBucket
+   is already moved by the search path ending at step iStep of asSteps,
+   or 0 otherwise. A path must not move the same key twice. */
+static int SymTable_onPath(const struct SymTableStep *asSteps,
+                           int iStep, size_t uBucket, int iSlot)
+{
+    for (; asSteps[iStep].parent != -1; iStep = asSteps[iStep].parent)
+    {
+        if (asSteps[iStep].slot == iSlot &&
+            asSteps[asSteps[iStep].parent].bucket == uBucket)
+            return 1;
+    }
+    return 0;
+}
+
+/* Function that places pcKey, whose hash is uHash and which is known to
+   be absent, with pvValue in oSymTable. Searches breadth-first from the
+   key's two buckets for the shortest chain of moves that frees a slot
+   for it, and falls back to the stash. Returns 1 if successful, or 0 if
+   both the search and the stash are exhausted. Does not change
+   bindingCount. */
+static int SymTable_place(SymTable_T oSymTable, const char *pcKey,
+                          uint64_t uHash, const void *pvValue)
+{
+    struct SymTableStep asSteps[MAX_SEARCH_NODES];
+    struct SymTableBucket *psBucket;
+    uint32_t uTag = SymTable_tag(uHash);
+    size_t uMask = oSymTable->bucketCount - 1;
+    size_t uAlt;
+    int iHead;
+    int iTail;
+    int iSlot;
+    int iFree;
+    int iStep;
+    int iParent;
+
+    asSteps[0].bucket = (size_t)uHash & uMask;
+    asSteps[0].parent = -1;
+    asSteps[0].slot = -1;
+    asSteps[1].bucket = SymTable_altBucket(asSteps[0].bucket, uTag,
+                                           oSymTable->bucketCount);
+    asSteps[1].parent = -1;
+    asSteps[1].slot = -1;
+    iTail = 2;
+
+    for (iHead = 0; iHead < iTail; iHead++)
+    {
+        iFree = SymTable_emptySlot(oSymTable, asSteps[iHead].bucket);
+        if (iFree != -1)
+        {
+            /* Walk the path back to its start, moving each key one
+               step forward into the slot just freed. */
+            for (iStep = iHead; asSteps[iStep].parent != -1;
+                 iStep = iParent)
+            {
+                iParent = asSteps[iStep].parent;
+                psBucket = &oSymTable->buckets[asSteps[iParent].bucket];
+                SymTable_store(oSymTable, asSteps[iStep].bucket, iFree,
+                    psBucket->keys[asSteps[iStep].slot],
+                    psBucket->tags[asSteps[iStep].slot],
+                    oSymTable->values[asSteps[iParent].bucket *
+                        SLOTS_PER_BUCKET +
+                        (size_t)asSteps[iStep].slot]);
+                psBucket->keys[asSteps[iStep].slot] = NULL;
+                iFree = asSteps[iStep].slot;
+            }
+            SymTable_store(oSymTable, asSteps[iStep].bucket, iFree,
+                           pcKey, uTag, pvValue);
+            return 1;
+        }
+
+        psBucket = &oSymTable->buckets[asSteps[iHead].bucket];
+        for (iSlot = 0;
+             iSlot < SLOTS_PER_BUCKET && iTail < MAX_SEARCH_NODES;
+             iSlot++)
+        {
+            if (SymTable_onPath(asSteps, iHead, asSteps[iHead].bucket,
+                                iSlot))
+                continue;
+            uAlt = SymTable_altBucket(asSteps[iHead].bucket,
+                                      psBucket->tags[iSlot],
+                                      oSymTable->bucketCount);
+            asSteps[iTail].bucket = uAlt;
+            asSteps[iTail].parent = iHead;
+            asSteps[iTail].slot = iSlot;
+            iTail++;
+        }
+    }
+
+    if (oSymTable->stashCount == STASH_SIZE)
+        return 0;
+
+    oSymTable->stashKeys[oSymTable->stashCount] = pcKey;
+    oSymTable->stashValues[oSymTable->stashCount] = pvValue;
+    oSymTable->stashCount++;
+    return 1;
+}
+
+/* Function that moves every binding of oSymTable into new buckets, at
+   least uNewBucketCount of them. If the keys do not all fit with the
+   current seed, tries new seeds and doubles the bucket count until they
+   do. Returns 1 if successful, or 0 if insufficient memory is
+   available, in which case oSymTable is left unchanged. */
+static int SymTable_rebuild(SymTable_T oSymTable, size_t uNewBucketCount)
+{
+    struct SymTable sNew;
+    size_t uBucket;
+    size_t u;
+    int iSlot;
+    int iPlaced;
+    const char *pcKey;
+
+    sNew = *oSymTable;
+
+    for (;;)
+    {
+        if (! SymTable_allocBuckets(&sNew, uNewBucketCount))
+            return 0;
+        sNew.stashCount = 0;
+
+        iPlaced = 1;
+        for (uBucket = 0;
+             iPlaced && uBucket < oSymTable->bucketCount; uBucket++)
+        {
+            for (iSlot = 0; iPlaced && iSlot < SLOTS_PER_BUCKET; iSlot++)
+            {
+                pcKey = oSymTable->buckets[uBucket].keys[iSlot];
+                if (pcKey != NULL)
+                    iPlaced = SymTable_place(&sNew, pcKey,
+                        SymTable_hash(pcKey, sNew.seed),
+                        oSymTable->values[uBucket * SLOTS_PER_BUCKET +
+                                          (size_t)iSlot]);
+            }
+        }
+        for (u = 0; iPlaced && u < oSymTable->stashCount; u++)
+            iPlaced = SymTable_place(&sNew, oSymTable->stashKeys[u],
+                SymTable_hash(oSymTable->stashKeys[u], sNew.seed),
+                oSymTable->stashValues[u]);
+
+        if (iPlaced)
+            break;
+
+        /* Some key would not fit: pick another hash function and give
+           the keys more room. */
+        free(sNew.buckets);
+        free(sNew.values);
+        sNew.seed = SymTable_nextSeed(sNew.seed);
+        uNewBucketCount *= 2;
+    }
+
+    free(oSymTable->buckets);
+    free(oSymTable->values);
+    *oSymTable = sNew;
+    return 1;
+}
+
+/* Function that shrinks the buckets of oSymTable once they are mostly
+   empty, leaving about two slots per binding but never going below
+   minBucketCount. If memory runs out the table keeps its buckets. */
+static void SymTable_contract(SymTable_T oSymTable)
+{
+    size_t uBucketCount;
+
+    if (oSymTable->bucketCount <= oSymTable->minBucketCount ||
+        oSymTable->bindingCount * SHRINK_DIVISOR >=
+        oSymTable->bucketCount * SLOTS_PER_BUCKET)
+    {
+        return;
+    }
+
+    uBucketCount =
+        SymTable_bucketsForCapacity(2 * oSymTable->bindingCount);
+    if (uBucketCount < oSymTable->minBucketCount)
+        uBucketCount = oSymTable->minBucketCount;
+
+    (void)SymTable_rebuild(oSymTable, uBucketCount);
+}
+
+/* Function that returns the position of pcKey in oSymTable, or
+   NOT_FOUND if it is absent. A position below bucketCount *
+   SLOTS_PER_BUCKET is a bucket slot; above it is an index into the
+   stash. Reads at most the key's two buckets, then the stash. */
+static size_t SymTable_find(SymTable_T oSymTable, const char *pcKey)
+{
+    struct SymTableBucket *psBucket;
+    uint64_t uHash = SymTable_hash(pcKey, oSymTable->seed);
+    uint32_t uTag = SymTable_tag(uHash);
+    size_t uBucket = (size_t)uHash & (oSymTable->bucketCount - 1);
+    size_t u;
+    int iTry;
+    int iSlot;
+
+    for (iTry = 0; iTry < 2; iTry++)
+    {
+        psBucket = &oSymTable->buckets[uBucket];
+        for (iSlot = 0; iSlot < SLOTS_PER_BUCKET; iSlot++)
+        {
+            if (psBucket->tags[iSlot] == uTag &&
+                psBucket->keys[iSlot] != NULL &&
+                strcmp(psBucket->keys[iSlot], pcKey) == 0)
+                return uBucket * SLOTS_PER_BUCKET + (size_t)iSlot;
+        }
+        uBucket = SymTable_altBucket(uBucket, uTag,
+                                     oSymTable->bucketCount);
+    }
+
+    for (u = 0; u < oSymTable->stashCount; u++)
+        if (strcmp(oSymTable->stashKeys[u], pcKey) == 0)
+            return oSymTable->bucketCount * SLOTS_PER_BUCKET + u;
+
+    return NOT_FOUND;
+}
+
+/* Function that returns the address of the value at position uPosition
+   of oSymTable, as returned by SymTable_find. */
+static const void **SymTable_valueAt(SymTable_T oSymTable,
+                                     size_t uPosition)
+{
+    size_t uSlotTotal = oSymTable->bucketCount * SLOTS_PER_BUCKET;
+
+    if (uPosition < uSlotTotal)
+        return &oSymTable->values[uPosition];
+    return &oSymTable->stashValues[uPosition - uSlotTotal];
+}
+
+SymTable_T SymTable_new(void)
+{
+    return SymTable_newWithCapacity(0);
+}
+
+SymTable_T SymTable_newWithCapacity(size_t uCapacity)
+{
+    SymTable_T oSymTable;
+    size_t uBucketCount;
+
+    oSymTable = (SymTable_T)malloc(sizeof(struct SymTable));
+
+    if (oSymTable == NULL)
+        return NULL;
+
+    uBucketCount = SymTable_bucketsForCapacity(uCapacity);
+
+    if (uBucketCount == 0 ||
+        ! SymTable_allocBuckets(oSymTable, uBucketCount))
+    {
+        free(oSymTable);
+        return NULL;
+    }
+
+    oSymTable->bindingCount = 0;
+    oSymTable->minBucketCount = uBucketCount;
+    oSymTable->stashCount = 0;
+
+    /* Seed each table differently so that no fixed set of keys
+       collides in every table. Built with -DSYMTABLE_FIXED_SEED=n,
+       every table starts from seed n instead, so that a test can
+       choose keys that collide. */
+#ifdef SYMTABLE_FIXED_SEED
+    oSymTable->seed = (uint64_t)SYMTABLE_FIXED_SEED;
+#else
+    oSymTable->seed = SymTable_nextSeed((uint64_t)(size_t)oSymTable ^
+                                        (uint64_t)time(NULL) ^
+                                        (uint64_t)clock());
+#endif
+
+    return oSymTable;
+}
+
+int SymTable_reserve(SymTable_T oSymTable, size_t uCapacity)
+{
+    size_t uBucketCount;
+
+    assert(oSymTable != NULL);
+
+    uBucketCount = SymTable_bucketsForCapacity(uCapacity);
+    if (uBucketCount == 0)
+        return 0;
+    if (uBucketCount > oSymTable->minBucketCount)
+        oSymTable->minBucketCount = uBucketCount;
+    if (uBucketCount > oSymTable->bucketCount)
+        return SymTable_rebuild(oSymTable, uBucketCount);
+
+    return 1;
+}
+
+void SymTable_shrinkToFit(SymTable_T oSymTable)
+{
+    size_t uBucketCount;
+
+    assert(oSymTable != NULL);
+
+    oSymTable->minBucketCount = MIN_BUCKET_COUNT;
+    uBucketCount = SymTable_bucketsForCapacity(oSymTable->bindingCount);
+    if (uBucketCount < oSymTable->bucketCount)
+        (void)SymTable_rebuild(oSymTable, uBucketCount);
+}
+
+void SymTable_setSelfOrganizing(SymTable_T oSymTable, int iEnabled)
+{
+    assert(oSymTable != NULL);
+    (void)iEnabled;
+
+    /* Each key lives in one of two buckets chosen by its hash, so
+       there is no order to reorganize. */
+}
+
+void SymTable_free(SymTable_T oSymTable)
+{
+    size_t uBucket;
+    size_t u;
+    int iSlot;
+
+    assert(oSymTable != NULL);
+
+    for (uBucket = 0; uBucket < oSymTable->bucketCount; uBucket++)
+        for (iSlot = 0; iSlot < SLOTS_PER_BUCKET; iSlot++)
+            free((void *)oSymTable->buckets[uBucket].keys[iSlot]);
+
+    for (u = 0; u < oSymTable->stashCount; u++)
+        free((void *)oSymTable->stashKeys[u]);
+
+    free(oSymTable->buckets);
+    free(oSymTable->values);
+    free(oSymTable);
+}
+
+size_t SymTable_getLength(SymTable_T oSymTable)
+{
+    assert(oSymTable != NULL);
+    return oSymTable->bindingCount;
+}
+
+int SymTable_put(SymTable_T oSymTable,
+                 const char *pcKey, const void *pvValue)
+{
+    char *keyCopy;
+    uint64_t uOldSeed;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    if (SymTable_find(oSymTable, pcKey) != NOT_FOUND)
+        return 0;
+
+    /* Grow before the load passes MAX_LOAD_TENTHS; if memory runs out
+       the table can still take bindings while there is room. */
+    if ((oSymTable->bindingCount + 1) * 10 >
+        oSymTable->bucketCount * SLOTS_PER_BUCKET * MAX_LOAD_TENTHS)
+        (void)SymTable_rebuild(oSymTable, oSymTable->bucketCount * 2);
+
+    keyCopy = (char *)malloc(strlen(pcKey) + 1);
+    if (keyCopy == NULL)
+        return 0;
+    strcpy(keyCopy, pcKey);
+
+    if (! SymTable_place(oSymTable, keyCopy,
+                         SymTable_hash(keyCopy, oSymTable->seed),
+                         pvValue))
+    {
+        /* The stash is full: rebuild with a new hash function, which
+           empties it, and try again. */
+        uOldSeed = oSymTable->seed;
+        oSymTable->seed = SymTable_nextSeed(uOldSeed);
+        if (! SymTable_rebuild(oSymTable, oSymTable->bucketCount))
+        {
+            oSymTable->seed = uOldSeed;
+            free(keyCopy);
+            return 0;
+        }
+        if (! SymTable_place(oSymTable, keyCopy,
+                             SymTable_hash(keyCopy, oSymTable->seed),
+                             pvValue))
+        {
+            free(keyCopy);
+            return 0;
+        }
+    }
+
+    oSymTable->bindingCount += 1;
+    return 1;
+}
+
+void *SymTable_replace(SymTable_T oSymTable,
+                       const char *pcKey, const void *pvValue)
+{
+    const void **ppvValue;
+    void *oldValue;
+    size_t uPosition;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uPosition = SymTable_find(oSymTable, pcKey);
+    if (uPosition == NOT_FOUND)
+        return NULL;
+
+    ppvValue = SymTable_valueAt(oSymTable, uPosition);
+    oldValue = (void *)*ppvValue;
+    *ppvValue = pvValue;
+    return oldValue;
+}
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey)
+{
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    return SymTable_find(oSymTable, pcKey) != NOT_FOUND;
+}
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey)
+{
+    size_t uPosition;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uPosition = SymTable_find(oSymTable, pcKey);
+    if (uPosition == NOT_FOUND)
+        return NULL;
+
+    return (void *)*SymTable_valueAt(oSymTable, uPosition);
+}
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
+{
+    struct SymTableBucket *psBucket;
+    void *pvValue;
+    size_t uPosition;
+    size_t uSlotTotal;
+    size_t uStash;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uPosition = SymTable_find(oSymTable, pcKey);
+    if (uPosition == NOT_FOUND)
+        return NULL;
+
+    pvValue = (void *)*SymTable_valueAt(oSymTable, uPosition);
+
+    uSlotTotal = oSymTable->bucketCount * SLOTS_PER_BUCKET;
+    if (uPosition < uSlotTotal)
+    {
+        psBucket = &oSymTable->buckets[uPosition / SLOTS_PER_BUCKET];
+        free((void *)psBucket->keys[uPosition % SLOTS_PER_BUCKET]);
+        psBucket->keys[uPosition % SLOTS_PER_BUCKET] = NULL;
+    }
+    else
+    {
+        /* Fill the hole in the stash with its last key. */
+        uStash = uPosition - uSlotTotal;
+        free((void *)oSymTable->stashKeys[uStash]);
+        oSymTable->stashCount--;
+        oSymTable->stashKeys[uStash] =
+            oSymTable->stashKeys[oSymTable->stashCount];
+        oSymTable->stashValues[uStash] =
+            oSymTable->stashValues[oSymTable->stashCount];
+    }
+
+    oSymTable->bindingCount -= 1;
+    SymTable_contract(oSymTable);
+
+    return pvValue;
+}
+
+void SymTable_map(SymTable_T oSymTable,
+                  void (*pfApply)(const char *pcKey, void *pvValue,
+                                  void *pvExtra),
+                  const void *pvExtra)
+{
+    struct SymTableBucket *psBucket;
+    size_t uBucket;
+    size_t u;
+    int iSlot;
+
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+
+    for (uBucket = 0; uBucket < oSymTable->bucketCount; uBucket++)
+    {
+        psBucket = &oSymTable->buckets[uBucket];
+        for (iSlot = 0; iSlot < SLOTS_PER_BUCKET; iSlot++)
+        {
+            if (psBucket->keys[iSlot] != NULL)
+                (*pfApply)(psBucket->keys[iSlot],
+                           (void *)oSymTable->values[uBucket *
+                               SLOTS_PER_BUCKET + (size_t)iSlot],
+                           (void *)pvExtra);
+        }
+    }
+
+    for (u = 0; u < oSymTable->stashCount; u++)
+        (*pfApply)(oSymTable->stashKeys[u],
+                   (void *)oSymTable->stashValues[u], (void *)pvExtra);
+}
@@ -0,0 +1,552 @@
+/*--------------------------------------------------------------------*/
+/* symtabledict.c                                                     */
+/* Author: Ryan Chen                                                  */
+/*--------------------------------------------------------------------*/
+
+#include "symtable.h"
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include <stdint.h>
+
+/* Fewest index slots a SymTable ever has. Must be a power of two. */
+static const size_t MIN_INDEX_SIZE = 8;
+
+/* The table holds at most USABLE_NUMERATOR / USABLE_DENOMINATOR
+   entries per index slot, counting removed entries not yet
+   compacted away. */
+static const size_t USABLE_NUMERATOR = 2;
+static const size_t USABLE_DENOMINATOR = 3;
+
+/* The table shrinks once it has more than SHRINK_DIVISOR index slots
+   per binding, leaving a gap with the growth threshold so that
+   remove/put cycles do not resize back and forth. */
+static const size_t SHRINK_DIVISOR = 8;
+
+/* Number of bits of the hash mixed into each later probe */
+enum {PERTURB_SHIFT = 5};
+
+/* Values of an index slot that hold no entry number: one that was
+   never used, and one whose entry was removed, which probes must
+   pass over. */
+enum {SLOT_EMPTY = -1, SLOT_REMOVED = -2};
+
+/* Each SymTableEntry stores one binding, along with the full hash of
+   its key so that probing and resizing never rehash a key. */
+struct SymTableEntry
+{
+    /* the hash of the key */
+    size_t uHash;
+
+    /* the key, or NULL if the binding was removed */
+    const char *pcKey;
+
+    /* the value */
+    const void *pvValue;
+};
+
+/* SymTable represents a compact hash table: the bindings are a dense
+   array of entries in the order they were made, and a separate sparse
+   index, open-addressed, maps each hash to an entry number. Index
+   slots are as narrow as the entry numbers allow, 1, 2, 4 or 8 bytes,
+   so the sparse part costs far less than an array of pointers, and
+   SymTable_map is a linear scan in insertion order. */
+struct SymTable
+{
+    /* the entries, entryCount of them in use, in insertion order */
+    struct SymTableEntry *entries;
+
+    /* number of entries made, including removed ones */
+    size_t entryCount;
+
+    /* the index: indexSize slots of indexWidth bytes each, each
+       holding an entry number, SLOT_EMPTY or SLOT_REMOVED */
+    void *pvIndex;
+
+    /* number of index slots, always a power of two */
+    size_t indexSize;
+
+    /* size of each index slot in bytes */
+    size_t indexWidth;
+
+    /* total number of bindings in the SymTable */
+    size_t bindingCount;
+
+    /* fewest index slots the table shrinks back to on its own, set by
+       the capacity the client asked for */
+    size_t minIndexSize;
+};
+
+/* Function that hashes pcKey. Returns the hash, mixed so that its low
+   bits depend on every character and can index the slots directly. */
+static size_t SymTable_hash(const char *pcKey)
+{
+    const size_t HASH_MULTIPLIER = 65599;
+    const uint64_t MIX_MULTIPLIER = UINT64_C(0x9E3779B97F4A7C15);
+    size_t u;
+    size_t uHash = 0;
+    uint64_t uMixed;
+
+    assert(pcKey != NULL);
+
+    for (u = 0; pcKey[u] != '\0'; u++)
+        uHash = uHash * HASH_MULTIPLIER + (size_t)pcKey[u];
+
+    uMixed = (uint64_t)uHash;
+    uMixed ^= uMixed >> 32;
+    uMixed *= MIX_MULTIPLIER;
+    uMixed ^= uMixed >> 29;
+
+    return (size_t)uMixed;
+}
+
+/* Function that returns how many entries an index of uIndexSize slots
+   can take. */
+static size_t SymTable_usable(size_t uIndexSize)
+{
+    return uIndexSize / USABLE_DENOMINATOR * USABLE_NUMERATOR;
+}
+
+/* Function that returns the smallest index size whose table holds
+   uCapacity bindings without growing, or 0 if no index size a size_t
+   can hold does. */
+static size_t SymTable_indexForCapacity(size_t uCapacity)
+{
+    size_t uIndexSize = MIN_INDEX_SIZE;
+
+    while (SymTable_usable(uIndexSize) < uCapacity)
+    {
+        if (uIndexSize > (size_t)-1 / 2)
+            return 0;
+        uIndexSize *= 2;
+    }
+
+    return uIndexSize;
+}
+
+/* Function that returns the width in bytes of the slots of an index of
+   uIndexSize slots: the narrowest signed integer that holds every
+   entry number the index can point to. */
+static size_t SymTable_widthFor(size_t uIndexSize)
+{
+    if (uIndexSize <= (size_t)INT8_MAX)
+        return sizeof(int8_t);
+    if (uIndexSize <= (size_t)INT16_MAX)
+        return sizeof(int16_t);
+    if (uIndexSize <= (size_t)INT32_MAX)
+        return sizeof(int32_t);
+    return sizeof(int64_t);
+}
+
+/* Function that returns what slot uSlot of the index of oSymTable
+   holds. */
+static long long SymTable_getSlot(SymTable_T oSymTable, size_t uSlot)
+{
+    switch (oSymTable->indexWidth)
+    {
+        case sizeof(int8_t):
+            return ((const int8_t *)oSymTable->pvIndex)[uSlot];
+        case sizeof(int16_t):
+            return ((const int16_t *)oSymTable->pvIndex)[uSlot];
+        case sizeof(int32_t):
+            return ((const int32_t *)oSymTable->pvIndex)[uSlot];
+        default:
+            return ((const int64_t *)oSymTable->pvIndex)[uSlot];
+    }
+}
+
+/* Function that stores llValue in slot uSlot of the index of
+   oSymTable. */
+static void SymTable_setSlot(SymTable_T oSymTable, size_t uSlot,
+                             long long llValue)
+{
+    switch (oSymTable->indexWidth)
+    {
+        case sizeof(int8_t):
+            ((int8_t *)oSymTable->pvIndex)[uSlot] = (int8_t)llValue;
+            break;
+        case sizeof(int16_t):
+            ((int16_t *)oSymTable->pvIndex)[uSlot] = (int16_t)llValue;
+            break;
+        case sizeof(int32_t):
+            ((int32_t *)oSymTable->pvIndex)[uSlot] = (int32_t)llValue;
+            break;
+        default:
+            ((int64_t *)oSymTable->pvIndex)[uSlot] = (int64_t)llValue;
+            break;
+    }
+}
+
+/* Function that returns the index slot of oSymTable that a probe for
+   uHash visits after uSlot, updating *puPerturb. Every later probe
+   mixes in more high bits of the hash, so keys whose low bits collide
+   soon part ways, and once *puPerturb runs out the probes visit every
+   slot. */
+static size_t SymTable_nextSlot(SymTable_T oSymTable, size_t uSlot,
+                                size_t *puPerturb)
+{
+    *puPerturb >>= PERTURB_SHIFT;
+    return (uSlot * 5 + *puPerturb + 1) & (oSymTable->indexSize - 1);
+}
+
+/* Function that returns the index slot of oSymTable where probing for
+   pcKey, whose hash is uHash, stops: the slot holding its entry
+   number, or the empty slot that ends the probe if pcKey is absent. */
+static size_t SymTable_findSlot(SymTable_T oSymTable, const char *pcKey,
+                                size_t uHash)
+{
+    const struct SymTableEntry *psEntry;
+    size_t uPerturb = uHash;
+    size_t uSlot = uHash & (oSymTable->indexSize - 1);
+    long long llEntry;
+
+    for (;;)
+    {
+        llEntry = SymTable_getSlot(oSymTable, uSlot);
+        if (llEntry == SLOT_EMPTY)
+            return uSlot;
+
+        if (llEntry >= 0)
+        {
+            psEntry = &oSymTable->entries[llEntry];
+            if (psEntry->uHash == uHash &&
+                strcmp(psEntry->pcKey, pcKey) == 0)
+                return uSlot;
+        }
+
+        uSlot = SymTable_nextSlot(oSymTable, uSlot, &uPerturb);
+    }
+}
+
+/* Function that returns the first index slot of oSymTable that holds
+   no entry, along the probe sequence of uHash. */
+static size_t SymTable_freeSlot(SymTable_T oSymTable, size_t uHash)
+{
+    size_t uPerturb = uHash;
+    size_t uSlot = uHash & (oSymTable->indexSize - 1);
+
+    while (SymTable_getSlot(oSymTable, uSlot) >= 0)
+        uSlot = SymTable_nextSlot(oSymTable, uSlot, &uPerturb);
+
+    return uSlot;
+}
+
+/* Function that rebuilds oSymTable with an index of uNewIndexSize
+   slots, moving its bindings, in order, to the front of a new entry
+   array and leaving removed ones behind. Returns 1 if successful, or 0
+   if insufficient memory is available, in which case oSymTable is left
+   unchanged. */
+static int SymTable_resize(SymTable_T oSymTable, size_t uNewIndexSize)
+{
+    struct SymTableEntry *newEntries;
+    void *pvNewIndex;
+    size_t uNewWidth;
+    size_t uFrom;
+    size_t uTo = 0;
+
+    assert(SymTable_usable(uNewIndexSize) >= oSymTable->bindingCount);
+
+    uNewWidth = SymTable_widthFor(uNewIndexSize);
+    pvNewIndex = malloc(uNewIndexSize * uNewWidth);
+    if (pvNewIndex == NULL)
+        return 0;
+
+    newEntries = (struct SymTableEntry *)malloc(
+        SymTable_usable(uNewIndexSize) * sizeof(struct SymTableEntry));
+    if (newEntries == NULL)
+    {
+        free(pvNewIndex);
+        return 0;
+    }
+
+    for (uFrom = 0; uFrom < oSymTable->entryCount; uFrom++)
+        if (oSymTable->entries[uFrom].pcKey != NULL)
+            newEntries[uTo++] = oSymTable->entries[uFrom];
+
+    free(oSymTable->entries);
+    free(oSymTable->pvIndex);
+    oSymTable->entries = newEntries;
+    oSymTable->entryCount = uTo;
+    oSymTable->pvIndex = pvNewIndex;
+    oSymTable->indexSize = uNewIndexSize;
+    oSymTable->indexWidth = uNewWidth;
+
+    /* Every byte of SLOT_EMPTY is 0xFF at any width. */
+    memset(pvNewIndex, 0xFF, uNewIndexSize * uNewWidth);
+    for (uTo = 0; uTo < oSymTable->entryCount; uTo++)
+        SymTable_setSlot(oSymTable,
+            SymTable_freeSlot(oSymTable, newEntries[uTo].uHash),
+            (long long)uTo);
+
+    return 1;
+}
+
+/* Function that shrinks oSymTable once its index is mostly empty,
+   leaving room for about twice its bindings but never going below
+   minIndexSize. If memory runs out the table keeps its current
+   arrays. */
+static void SymTable_contract(SymTable_T oSymTable)
+{
+    size_t uIndexSize;
+
+    if (oSymTable->indexSize <= oSymTable->minIndexSize ||
+        oSymTable->bindingCount * SHRINK_DIVISOR >= oSymTable->indexSize)
+    {
+        return;
+    }
+
+    uIndexSize = SymTable_indexForCapacity(2 * oSymTable->bindingCount);
+    if (uIndexSize < oSymTable->minIndexSize)
+        uIndexSize = oSymTable->minIndexSize;
+
+    (void)SymTable_resize(oSymTable, uIndexSize);
+}
+
+/* Function that returns the entry of oSymTable holding pcKey, or NULL
+   if there is none. */
+static struct SymTableEntry *SymTable_find(SymTable_T oSymTable,
+                                           const char *pcKey)
+{
+    long long llEntry;
+
+    llEntry = SymTable_getSlot(oSymTable,
+        SymTable_findSlot(oSymTable, pcKey, SymTable_hash(pcKey)));
+    if (llEntry < 0)
+        return NULL;
+
+    return &oSymTable->entries[llEntry];
+}
+
+SymTable_T SymTable_new(void)
+{
+    return SymTable_newWithCapacity(0);
+}
+
+SymTable_T SymTable_newWithCapacity(size_t uCapacity)
+{
+    SymTable_T oSymTable;
+    size_t uIndexSize;
+
+    oSymTable = (SymTable_T)malloc(sizeof(struct SymTable));
+
+    if (oSymTable == NULL)
+        return NULL;
+
+    uIndexSize = SymTable_indexForCapacity(uCapacity);
+    if (uIndexSize == 0)
+    {
+        free(oSymTable);
+        return NULL;
+    }
+
+    oSymTable->entries = NULL;
+    oSymTable->entryCount = 0;
+    oSymTable->pvIndex = NULL;
+    oSymTable->indexSize = 0;
+    oSymTable->indexWidth = 0;
+    oSymTable->bindingCount = 0;
+    oSymTable->minIndexSize = uIndexSize;
+
+    if (! SymTable_resize(oSymTable, uIndexSize))
+    {
+        free(oSymTable);
+        return NULL;
+    }
+
+    return oSymTable;
+}
+
+int SymTable_reserve(SymTable_T oSymTable, size_t uCapacity)
+{
+    size_t uIndexSize;
+
+    assert(oSymTable != NULL);
+
+    uIndexSize = SymTable_indexForCapacity(uCapacity);
+    if (uIndexSize == 0)
+        return 0;
+    if (uIndexSize > oSymTable->minIndexSize)
+        oSymTable->minIndexSize = uIndexSize;
+    if (uIndexSize > oSymTable->indexSize)
+        return SymTable_resize(oSymTable, uIndexSize);
+
+    return 1;
+}
+
+void SymTable_shrinkToFit(SymTable_T oSymTable)
+{
+    size_t uIndexSize;
+
+    assert(oSymTable != NULL);
+
+    oSymTable->minIndexSize = MIN_INDEX_SIZE;
+    uIndexSize = SymTable_indexForCapacity(oSymTable->bindingCount);
+    if (uIndexSize < oSymTable->indexSize ||
+        oSymTable->entryCount > oSymTable->bindingCount)
+        (void)SymTable_resize(oSymTable, uIndexSize);
+}
+
+void SymTable_setSelfOrganizing(SymTable_T oSymTable, int iEnabled)
+{
+    assert(oSymTable != NULL);
+    (void)iEnabled;
+
+    /* Entries stay in insertion order, and each index slot follows
+       from its hash, so there is no order to reorganize. */
+}
+
+void SymTable_free(SymTable_T oSymTable)
+{
+    size_t u;
+
+    assert(oSymTable != NULL);
+
+    for (u = 0; u < oSymTable->entryCount; u++)
+        free((void *)oSymTable->entries[u].pcKey);
+
+    free(oSymTable->entries);
+    free(oSymTable->pvIndex);
+    free(oSymTable);
+}
+
+size_t SymTable_getLength(SymTable_T oSymTable)
+{
+    assert(oSymTable != NULL);
+    return oSymTable->bindingCount;
+}
+
+int SymTable_put(SymTable_T oSymTable,
+                 const char *pcKey, const void *pvValue)
+{
+    struct SymTableEntry *psEntry;
+    char *keyCopy;
+    size_t uHash;
+    size_t uIndexSize;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uHash = SymTable_hash(pcKey);
+    if (SymTable_getSlot(oSymTable,
+            SymTable_findSlot(oSymTable, pcKey, uHash)) >= 0)
+        return 0;
+
+    /* The entry array is full: compact away removed entries, growing
+       the index too if the bindings alone would fill half of it. */
+    if (oSymTable->entryCount == SymTable_usable(oSymTable->indexSize))
+    {
+        uIndexSize = oSymTable->indexSize;
+        if (oSymTable->bindingCount * 2 >= SymTable_usable(uIndexSize))
+            uIndexSize *= 2;
+        if (! SymTable_resize(oSymTable, uIndexSize))
+            return 0;
+    }
+
+    keyCopy = (char *)malloc(strlen(pcKey) + 1);
+    if (keyCopy == NULL)
+        return 0;
+    strcpy(keyCopy, pcKey);
+
+    psEntry = &oSymTable->entries[oSymTable->entryCount];
+    psEntry->uHash = uHash;
+    psEntry->pcKey = keyCopy;
+    psEntry->pvValue = pvValue;
+
+    /* A removed slot along the probe can be reused, since pcKey is not
+       further along it. */
+    SymTable_setSlot(oSymTable, SymTable_freeSlot(oSymTable, uHash),
+                     (long long)oSymTable->entryCount);
+    oSymTable->entryCount += 1;
+    oSymTable->bindingCount += 1;
+
+    return 1;
+}
+
+void *SymTable_replace(SymTable_T oSymTable,
+                       const char *pcKey, const void *pvValue)
+{
+    struct SymTableEntry *psEntry;
+    void *oldValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    psEntry = SymTable_find(oSymTable, pcKey);
+    if (psEntry == NULL)
+        return NULL;
+
+    oldValue = (void *)psEntry->pvValue;
+    psEntry->pvValue = pvValue;
+    return oldValue;
+}
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey)
+{
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    return SymTable_find(oSymTable, pcKey) != NULL;
+}
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey)
+{
+    struct SymTableEntry *psEntry;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    psEntry = SymTable_find(oSymTable, pcKey);
+    if (psEntry == NULL)
+        return NULL;
+
+    return (void *)psEntry->pvValue;
+}
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
+{
+    struct SymTableEntry *psEntry;
+    void *pvValue;
+    size_t uSlot;
+    long long llEntry;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uSlot = SymTable_findSlot(oSymTable, pcKey, SymTable_hash(pcKey));
+    llEntry = SymTable_getSlot(oSymTable, uSlot);
+    if (llEntry < 0)
+        return NULL;
+
+    /* The entry stays, keyless, until the next resize compacts the
+       entries, so later entries keep their numbers. */
+    psEntry = &oSymTable->entries[llEntry];
+    pvValue = (void *)psEntry->pvValue;
+    free((void *)psEntry->pcKey);
+    psEntry->pcKey = NULL;
+    SymTable_setSlot(oSymTable, uSlot, SLOT_REMOVED);
+
+    oSymTable->bindingCount -= 1;
+    SymTable_contract(oSymTable);
+
+    return pvValue;
+}
+
+void SymTable_map(SymTable_T oSymTable,
+                  void (*pfApply)(const char *pcKey, void *pvValue,
+                                  void *pvExtra),
+                  const void *pvExtra)
+{
+    size_t u;
+
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+
+    /* Bindings are visited in the order they were made. */
+    for (u = 0; u < oSymTable->entryCount; u++)
+    {
+        if (oSymTable->entries[u].pcKey != NULL)
+            (*pfApply)(oSymTable->entries[u].pcKey,
+                       (void *)oSymTable->entries[u].pvValue,
+                       (void *)pvExtra);
+    }
+}
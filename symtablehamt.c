@@ -0,0 +1,901 @@
+/*--------------------------------------------------------------------*/
+/* symtablehamt.c                                                     */
+/* Author: Ryan Chen                                                  */
+/*--------------------------------------------------------------------*/
+
+#include "symtablehamt.h"
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include <stdint.h>
+
+/* Number of hash bits that pick a slot at each level of the trie */
+enum {BITS_PER_LEVEL = 5};
+
+/* Number of bits in a hash. A node this many bits deep holds keys with
+   equal hashes in a plain array. */
+enum {HASH_BITS = 32};
+
+/* A SymTableKey is a copy of a client's key. Keys are shared by every
+   snapshot that contains them and are freed with the last one. */
+struct SymTableKey
+{
+    /* number of references to the SymTableKey */
+    size_t refCount;
+
+    /* the hash of the key */
+    uint32_t uHash;
+
+    /* the length of the key */
+    size_t length;
+
+    /* the characters of the key, ending in '\0' */
+    char acKey[1];
+};
+
+/* A SymTableSlot holds either one binding or a child node. */
+struct SymTableSlot
+{
+    /* the key of the binding, or NULL if the slot holds a child */
+    struct SymTableKey *psKey;
+
+    /* the value of the binding */
+    const void *pvValue;
+
+    /* the child, if psKey is NULL */
+    struct SymTableNode *psChild;
+};
+
+/* A SymTableNode is one level of the trie. Its bitmap has a bit set for
+   each of the 32 hash chunks at this level that is in use, and its
+   slots hold those chunks in order. Nodes are never changed once they
+   are reachable: an update copies the path to the change, so any
+   number of SymTables can share a node. */
+struct SymTableNode
+{
+    /* number of references to the SymTableNode */
+    size_t refCount;
+
+    /* which hash chunks have a slot, or 0 in a node HASH_BITS deep */
+    uint32_t bitmap;
+
+    /* number of slots */
+    uint32_t slotCount;
+
+    /* the slots */
+    struct SymTableSlot slots[1];
+};
+
+/* SymTable represents a hash array mapped trie: a tree of 32-way nodes
+   indexed by successive 5-bit chunks of each key's hash. */
+struct SymTable
+{
+    /* the root node, or NULL if the SymTable is empty */
+    struct SymTableNode *psRoot;
+
+    /* total number of bindings in the SymTable */
+    size_t bindingCount;
+};
+
+/* Function that hashes the uLength characters of pcKey. Returns the
+   high 32 bits of the mixed hash, so that every 5-bit chunk depends on
+   every character. */
+static uint32_t SymTable_hash(const char *pcKey, size_t uLength)
+{
+    const size_t HASH_MULTIPLIER = 65599;
+    const uint64_t MIX_MULTIPLIER = UINT64_C(0x9E3779B97F4A7C15);
+    size_t u;
+    size_t uHash = 0;
+    uint64_t uMixed;
+
+    for (u = 0; u < uLength; u++)
+        uHash = uHash * HASH_MULTIPLIER + (size_t)pcKey[u];
+
+    uMixed = (uint64_t)uHash;
+    uMixed ^= uMixed >> 32;
+    uMixed *= MIX_MULTIPLIER;
+
+    return (uint32_t)(uMixed >> 32);
+}
+
+/* Function that returns the number of bits set in uBits. */
+static uint32_t SymTable_popcount(uint32_t uBits)
+{
+    uBits = uBits - ((uBits >> 1) & 0x55555555u);
+    uBits = (uBits & 0x33333333u) + ((uBits >> 2) & 0x33333333u);
+    uBits = (uBits + (uBits >> 4)) & 0x0F0F0F0Fu;
+    return (uBits * 0x01010101u) >> 24;
+}
+
+/* Function that returns the bit of a node's bitmap that uHash uses at
+   the level uShift bits deep. */
+static uint32_t SymTable_bit(uint32_t uHash, unsigned uShift)
+{
+    return (uint32_t)1 << ((uHash >> uShift) & ((1u << BITS_PER_LEVEL) - 1));
+}
+
+/* Function that adds a reference to *pRefCount. The count is updated
+   atomically so that a snapshot can be freed in one thread while the
+   SymTable it came from changes in another. */
+static void SymTable_retain(size_t *pRefCount)
+{
+    __atomic_add_fetch(pRefCount, 1, __ATOMIC_RELAXED);
+}
+
+/* Function that drops a reference from *pRefCount. Returns 1 if that
+   was the last reference, or 0 otherwise. */
+static int SymTable_drop(size_t *pRefCount)
+{
+    return __atomic_sub_fetch(pRefCount, 1, __ATOMIC_ACQ_REL) == 0;
+}
+
+/* Function that drops a reference to psKey, freeing it with the last
+   reference. */
+static void SymTable_releaseKey(struct SymTableKey *psKey)
+{
+    if (SymTable_drop(&psKey->refCount))
+        free(psKey);
+}
+
+/* Function that drops a reference to psNode, freeing it and dropping
+   its references to its keys and children with the last reference.
+   psNode may be NULL. */
+static void SymTable_releaseNode(struct SymTableNode *psNode)
+{
+    uint32_t u;
+
+    if (psNode == NULL || ! SymTable_drop(&psNode->refCount))
+        return;
+
+    for (u = 0; u < psNode->slotCount; u++)
+    {
+        if (psNode->slots[u].psKey != NULL)
+            SymTable_releaseKey(psNode->slots[u].psKey);
+        else
+            SymTable_releaseNode(psNode->slots[u].psChild);
+    }
+    free(psNode);
+}
+
+/* Function that returns a new node with uSlotCount uninitialized slots
+   and one reference, or NULL if insufficient memory is available. */
+static struct SymTableNode *SymTable_newNode(uint32_t uBitmap,
+                                             uint32_t uSlotCount)
+{
+    struct SymTableNode *psNode;
+
+    assert(uSlotCount > 0);
+
+    psNode = (struct SymTableNode *)malloc(sizeof(struct SymTableNode)
+                 + (uSlotCount - 1) * sizeof(struct SymTableSlot));
+    if (psNode == NULL)
+        return NULL;
+
+    psNode->refCount = 1;
+    psNode->bitmap = uBitmap;
+    psNode->slotCount = uSlotCount;
+    return psNode;
+}
+
+/* Function that stores a binding of psKey to pvValue in *psSlot,
+   taking a reference to psKey. */
+static void SymTable_setEntry(struct SymTableSlot *psSlot,
+                              struct SymTableKey *psKey,
+                              const void *pvValue)
+{
+    SymTable_retain(&psKey->refCount);
+    psSlot->psKey = psKey;
+    psSlot->pvValue = pvValue;
+    psSlot->psChild = NULL;
+}
+
+/* Function that stores psChild in *psSlot. The slot takes over the
+   caller's reference to psChild. */
+static void SymTable_setChild(struct SymTableSlot *psSlot,
+                              struct SymTableNode *psChild)
+{
+    psSlot->psKey = NULL;
+    psSlot->pvValue = NULL;
+    psSlot->psChild = psChild;
+}
+
+/* Function that returns a copy of psOld with bitmap uBitmap and iDelta
+   more slots, where iDelta is -1, 0 or 1. The copy holds references to
+   everything it shares with psOld. Slot uIndex of the copy is left for
+   the caller to fill unless iDelta is -1, in which case slot uIndex of
+   psOld is left out. Returns NULL if insufficient memory is
+   available. */
+static struct SymTableNode *SymTable_copyNode(
+    const struct SymTableNode *psOld, uint32_t uBitmap, uint32_t uIndex,
+    int iDelta)
+{
+    struct SymTableNode *psNew;
+    const struct SymTableSlot *psFrom;
+    uint32_t uFrom;
+    uint32_t uTo = 0;
+
+    psNew = SymTable_newNode(uBitmap, psOld->slotCount + iDelta);
+    if (psNew == NULL)
+        return NULL;
+
+    for (uFrom = 0; uFrom < psOld->slotCount; uFrom++)
+    {
+        if (uFrom == uIndex && iDelta <= 0)
+        {
+            /* Slot uIndex is replaced or removed. */
+            if (iDelta == 0)
+                uTo++;
+            continue;
+        }
+        if (uTo == uIndex && iDelta > 0)
+            uTo++;
+
+        psFrom = &psOld->slots[uFrom];
+        psNew->slots[uTo] = *psFrom;
+        if (psFrom->psKey != NULL)
+            SymTable_retain(&psFrom->psKey->refCount);
+        else
+            SymTable_retain(&psFrom->psChild->refCount);
+        uTo++;
+    }
+
+    return psNew;
+}
+
+/* Function that returns 1 if psNode may be changed in place, or 0 if
+   it must be copied first. A node may be changed in place only if
+   iParentOwned, meaning that nothing but this SymTable can reach its
+   parent, and its parent holds the only reference to it. */
+static int SymTable_owns(struct SymTableNode *psNode, int iParentOwned)
+{
+    return iParentOwned &&
+           __atomic_load_n(&psNode->refCount, __ATOMIC_ACQUIRE) == 1;
+}
+
+/* Function that adds an uninitialized slot uIndex to psNode, which may
+   be changed in place, and gives it bitmap uBitmap. Returns the
+   possibly moved node, or NULL if insufficient memory is available, in
+   which case psNode is unchanged. */
+static struct SymTableNode *SymTable_grow(struct SymTableNode *psNode,
+                                          uint32_t uBitmap,
+                                          uint32_t uIndex)
+{
+    struct SymTableNode *psNew;
+
+    psNew = (struct SymTableNode *)realloc(psNode,
+                 sizeof(struct SymTableNode)
+                 + psNode->slotCount * sizeof(struct SymTableSlot));
+    if (psNew == NULL)
+        return NULL;
+
+    memmove(&psNew->slots[uIndex + 1], &psNew->slots[uIndex],
+            (psNew->slotCount - uIndex) * sizeof(struct SymTableSlot));
+    psNew->bitmap = uBitmap;
+    psNew->slotCount += 1;
+    return psNew;
+}
+
+/* Function that stores psChild, the result of changing the child in
+   *psSlot, in *psSlot of a node that may be changed in place. Drops
+   the reference to the old child unless iChildOwned, in which case
+   psChild took it over. */
+static void SymTable_replaceChild(struct SymTableSlot *psSlot,
+                                  struct SymTableNode *psChild,
+                                  int iChildOwned)
+{
+    if (! iChildOwned)
+        SymTable_releaseNode(psSlot->psChild);
+    psSlot->psChild = psChild;
+}
+
+/* Function that returns 1 if psSlot holds a binding for pcKey, whose
+   length is uLength and whose hash is uHash, or 0 otherwise. */
+static int SymTable_matches(const struct SymTableSlot *psSlot,
+                            const char *pcKey, size_t uLength,
+                            uint32_t uHash)
+{
+    return psSlot->psKey != NULL && psSlot->psKey->uHash == uHash &&
+           psSlot->psKey->length == uLength &&
+           memcmp(psSlot->psKey->acKey, pcKey, uLength) == 0;
+}
+
+/* Function that returns the slot holding the binding for pcKey below
+   psNode, which is uShift bits deep, or NULL if there is none. */
+static struct SymTableSlot *SymTable_find(struct SymTableNode *psNode,
+                                          const char *pcKey,
+                                          size_t uLength, uint32_t uHash)
+{
+    unsigned uShift = 0;
+    uint32_t uBit;
+    uint32_t u;
+    struct SymTableSlot *psSlot;
+
+    while (psNode != NULL)
+    {
+        if (uShift >= HASH_BITS)
+        {
+            for (u = 0; u < psNode->slotCount; u++)
+                if (SymTable_matches(&psNode->slots[u], pcKey, uLength,
+                                     uHash))
+                    return &psNode->slots[u];
+            return NULL;
+        }
+
+        uBit = SymTable_bit(uHash, uShift);
+        if ((psNode->bitmap & uBit) == 0)
+            return NULL;
+
+        psSlot = &psNode->slots[SymTable_popcount(psNode->bitmap
+                                                  & (uBit - 1))];
+        if (psSlot->psKey != NULL)
+            return SymTable_matches(psSlot, pcKey, uLength, uHash)
+                   ? psSlot : NULL;
+
+        psNode = psSlot->psChild;
+        uShift += BITS_PER_LEVEL;
+    }
+
+    return NULL;
+}
+
+/* Function that builds the smallest subtree, uShift bits deep, that
+   holds the binding in *psOld and a binding of psKey to pvValue.
+   Stores it in *ppsResult. Returns 1 if successful, or 0 if
+   insufficient memory is available. */
+static int SymTable_merge(const struct SymTableSlot *psOld,
+                          struct SymTableKey *psKey, const void *pvValue,
+                          unsigned uShift,
+                          struct SymTableNode **ppsResult)
+{
+    struct SymTableNode *psNode;
+    struct SymTableNode *psChild;
+    uint32_t uOldBit;
+    uint32_t uNewBit;
+
+    if (uShift >= HASH_BITS)
+    {
+        psNode = SymTable_newNode(0, 2);
+        if (psNode == NULL)
+            return 0;
+        SymTable_setEntry(&psNode->slots[0], psOld->psKey,
+                          psOld->pvValue);
+        SymTable_setEntry(&psNode->slots[1], psKey, pvValue);
+        *ppsResult = psNode;
+        return 1;
+    }
+
+    uOldBit = SymTable_bit(psOld->psKey->uHash, uShift);
+    uNewBit = SymTable_bit(psKey->uHash, uShift);
+
+    if (uOldBit == uNewBit)
+    {
+        if (! SymTable_merge(psOld, psKey, pvValue,
+                             uShift + BITS_PER_LEVEL, &psChild))
+            return 0;
+        psNode = SymTable_newNode(uOldBit, 1);
+        if (psNode == NULL)
+        {
+            SymTable_releaseNode(psChild);
+            return 0;
+        }
+        SymTable_setChild(&psNode->slots[0], psChild);
+        *ppsResult = psNode;
+        return 1;
+    }
+
+    psNode = SymTable_newNode(uOldBit | uNewBit, 2);
+    if (psNode == NULL)
+        return 0;
+    SymTable_setEntry(&psNode->slots[uOldBit < uNewBit ? 0 : 1],
+                      psOld->psKey, psOld->pvValue);
+    SymTable_setEntry(&psNode->slots[uOldBit < uNewBit ? 1 : 0],
+                      psKey, pvValue);
+    *ppsResult = psNode;
+    return 1;
+}
+
+/* Function that stores in *ppsResult psNode, which is uShift bits deep
+   and may be NULL, with a binding of psKey to pvValue added. psKey
+   must not be bound below psNode. If iOwned, psNode is changed in place
+   and the caller's reference to it passes to the result; otherwise
+   psNode is left as it was and the result is a new node. Returns 1 if
+   successful, or 0 if insufficient memory is available, in which case
+   psNode is unchanged. */
+static int SymTable_insert(struct SymTableNode *psNode,
+                           struct SymTableKey *psKey, const void *pvValue,
+                           unsigned uShift, int iOwned,
+                           struct SymTableNode **ppsResult)
+{
+    struct SymTableNode *psNew;
+    struct SymTableNode *psChild;
+    struct SymTableSlot *psSlot;
+    uint32_t uBit = 0;
+    uint32_t uIndex;
+    int iChildOwned;
+
+    if (psNode == NULL)
+    {
+        uBit = SymTable_bit(psKey->uHash, uShift);
+        psNew = SymTable_newNode(uBit, 1);
+        if (psNew == NULL)
+            return 0;
+        SymTable_setEntry(&psNew->slots[0], psKey, pvValue);
+        *ppsResult = psNew;
+        return 1;
+    }
+
+    if (uShift >= HASH_BITS)
+        uIndex = psNode->slotCount;
+    else
+    {
+        uBit = SymTable_bit(psKey->uHash, uShift);
+        uIndex = SymTable_popcount(psNode->bitmap & (uBit - 1));
+    }
+
+    if (uShift >= HASH_BITS || (psNode->bitmap & uBit) == 0)
+    {
+        if (iOwned)
+            psNew = SymTable_grow(psNode, psNode->bitmap | uBit, uIndex);
+        else
+            psNew = SymTable_copyNode(psNode, psNode->bitmap | uBit,
+                                      uIndex, 1);
+        if (psNew == NULL)
+            return 0;
+        SymTable_setEntry(&psNew->slots[uIndex], psKey, pvValue);
+        *ppsResult = psNew;
+        return 1;
+    }
+
+    psSlot = &psNode->slots[uIndex];
+    iChildOwned = 0;
+    if (psSlot->psKey != NULL)
+    {
+        if (! SymTable_merge(psSlot, psKey, pvValue,
+                             uShift + BITS_PER_LEVEL, &psChild))
+            return 0;
+    }
+    else
+    {
+        iChildOwned = SymTable_owns(psSlot->psChild, iOwned);
+        if (! SymTable_insert(psSlot->psChild, psKey, pvValue,
+                              uShift + BITS_PER_LEVEL, iChildOwned,
+                              &psChild))
+            return 0;
+    }
+
+    if (iOwned)
+    {
+        if (psSlot->psKey != NULL)
+        {
+            SymTable_releaseKey(psSlot->psKey);
+            SymTable_setChild(psSlot, psChild);
+        }
+        else
+            SymTable_replaceChild(psSlot, psChild, iChildOwned);
+        *ppsResult = psNode;
+        return 1;
+    }
+
+    psNew = SymTable_copyNode(psNode, psNode->bitmap, uIndex, 0);
+    if (psNew == NULL)
+    {
+        SymTable_releaseNode(psChild);
+        return 0;
+    }
+    SymTable_setChild(&psNew->slots[uIndex], psChild);
+    *ppsResult = psNew;
+    return 1;
+}
+
+/* Function that returns the index in psNode, which is uShift bits
+   deep, of the slot on the way to the binding for pcKey. pcKey, whose
+   length is uLength and whose hash is uHash, must be bound below
+   psNode. */
+static uint32_t SymTable_indexOf(const struct SymTableNode *psNode,
+                                 const char *pcKey, size_t uLength,
+                                 uint32_t uHash, unsigned uShift)
+{
+    uint32_t uIndex = 0;
+
+    if (uShift < HASH_BITS)
+        return SymTable_popcount(psNode->bitmap
+                                 & (SymTable_bit(uHash, uShift) - 1));
+
+    while (! SymTable_matches(&psNode->slots[uIndex], pcKey, uLength,
+                              uHash))
+        uIndex++;
+    return uIndex;
+}
+
+/* Function that stores in *ppsResult psNode, which is uShift bits
+   deep, with the binding for pcKey changed to pvValue. pcKey, whose
+   length is uLength and whose hash is uHash, must be bound below
+   psNode. iOwned is as for SymTable_insert. Returns 1 if successful, or
+   0 if insufficient memory is available, in which case psNode is
+   unchanged. */
+static int SymTable_update(struct SymTableNode *psNode,
+                           const char *pcKey, size_t uLength,
+                           uint32_t uHash, const void *pvValue,
+                           unsigned uShift, int iOwned,
+                           struct SymTableNode **ppsResult)
+{
+    struct SymTableNode *psNew;
+    struct SymTableNode *psChild;
+    struct SymTableSlot *psSlot;
+    uint32_t uIndex;
+    int iChildOwned;
+
+    uIndex = SymTable_indexOf(psNode, pcKey, uLength, uHash, uShift);
+    psSlot = &psNode->slots[uIndex];
+
+    if (psSlot->psKey != NULL)
+    {
+        if (iOwned)
+        {
+            psSlot->pvValue = pvValue;
+            *ppsResult = psNode;
+            return 1;
+        }
+        psNew = SymTable_copyNode(psNode, psNode->bitmap, uIndex, 0);
+        if (psNew == NULL)
+            return 0;
+        SymTable_setEntry(&psNew->slots[uIndex], psSlot->psKey, pvValue);
+        *ppsResult = psNew;
+        return 1;
+    }
+
+    iChildOwned = SymTable_owns(psSlot->psChild, iOwned);
+    if (! SymTable_update(psSlot->psChild, pcKey, uLength, uHash,
+                          pvValue, uShift + BITS_PER_LEVEL, iChildOwned,
+                          &psChild))
+        return 0;
+
+    if (iOwned)
+    {
+        SymTable_replaceChild(psSlot, psChild, iChildOwned);
+        *ppsResult = psNode;
+        return 1;
+    }
+
+    psNew = SymTable_copyNode(psNode, psNode->bitmap, uIndex, 0);
+    if (psNew == NULL)
+    {
+        SymTable_releaseNode(psChild);
+        return 0;
+    }
+    SymTable_setChild(&psNew->slots[uIndex], psChild);
+    *ppsResult = psNew;
+    return 1;
+}
+
+/* Function that stores in *ppsResult psNode, which is uShift bits
+   deep, without the binding for pcKey, or NULL if nothing would be
+   left. pcKey, whose length is uLength and whose hash is uHash, must be
+   bound below psNode. A child left holding a single binding is folded
+   into its parent, so the trie stays as shallow as its keys allow.
+   iOwned is as for SymTable_insert. Returns 1 if successful, or 0 if
+   insufficient memory is available, in which case psNode is
+   unchanged. */
+static int SymTable_erase(struct SymTableNode *psNode,
+                          const char *pcKey, size_t uLength,
+                          uint32_t uHash, unsigned uShift, int iOwned,
+                          struct SymTableNode **ppsResult)
+{
+    struct SymTableNode *psNew;
+    struct SymTableNode *psChild;
+    struct SymTableSlot *psSlot;
+    uint32_t uBit = 0;
+    uint32_t uIndex;
+    int iChildOwned;
+
+    if (uShift < HASH_BITS)
+        uBit = SymTable_bit(uHash, uShift);
+    uIndex = SymTable_indexOf(psNode, pcKey, uLength, uHash, uShift);
+    psSlot = &psNode->slots[uIndex];
+
+    if (psSlot->psKey != NULL)
+    {
+        if (psNode->slotCount == 1)
+        {
+            if (iOwned)
+                SymTable_releaseNode(psNode);
+            *ppsResult = NULL;
+            return 1;
+        }
+        if (iOwned)
+        {
+            SymTable_releaseKey(psSlot->psKey);
+            memmove(psSlot, psSlot + 1, (psNode->slotCount - uIndex - 1)
+                    * sizeof(struct SymTableSlot));
+            psNode->bitmap &= ~uBit;
+            psNode->slotCount -= 1;
+            *ppsResult = psNode;
+            return 1;
+        }
+        psNew = SymTable_copyNode(psNode, psNode->bitmap & ~uBit, uIndex,
+                                  -1);
+        if (psNew == NULL)
+            return 0;
+        *ppsResult = psNew;
+        return 1;
+    }
+
+    iChildOwned = SymTable_owns(psSlot->psChild, iOwned);
+    if (! SymTable_erase(psSlot->psChild, pcKey, uLength, uHash,
+                         uShift + BITS_PER_LEVEL, iChildOwned, &psChild))
+        return 0;
+
+    /* A child holds at least two bindings, so it cannot empty. */
+    assert(psChild != NULL);
+
+    if (iOwned)
+    {
+        SymTable_replaceChild(psSlot, psChild, iChildOwned);
+        psNew = psNode;
+    }
+    else
+    {
+        psNew = SymTable_copyNode(psNode, psNode->bitmap, uIndex, 0);
+        if (psNew == NULL)
+        {
+            SymTable_releaseNode(psChild);
+            return 0;
+        }
+        SymTable_setChild(&psNew->slots[uIndex], psChild);
+    }
+
+    /* Fold a child that is down to one binding into this node. If this
+       node is then down to that one binding, its parent folds it in
+       turn. */
+    if (psChild->slotCount == 1 && psChild->slots[0].psKey != NULL)
+    {
+        SymTable_setEntry(&psNew->slots[uIndex], psChild->slots[0].psKey,
+                          psChild->slots[0].pvValue);
+        SymTable_releaseNode(psChild);
+    }
+
+    *ppsResult = psNew;
+    return 1;
+}
+
+/* Function that calls pfApply for each binding below psNode, passing
+   pvExtra. */
+static void SymTable_mapNode(const struct SymTableNode *psNode,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    void *pvExtra)
+{
+    uint32_t u;
+
+    if (psNode == NULL)
+        return;
+
+    for (u = 0; u < psNode->slotCount; u++)
+    {
+        if (psNode->slots[u].psKey != NULL)
+            (*pfApply)(psNode->slots[u].psKey->acKey,
+                       (void *)psNode->slots[u].pvValue, pvExtra);
+        else
+            SymTable_mapNode(psNode->slots[u].psChild, pfApply, pvExtra);
+    }
+}
+
+SymTable_T SymTable_new(void)
+{
+    SymTable_T oSymTable;
+
+    oSymTable = (SymTable_T)malloc(sizeof(struct SymTable));
+    if (oSymTable == NULL)
+        return NULL;
+
+    oSymTable->psRoot = NULL;
+    oSymTable->bindingCount = 0;
+    return oSymTable;
+}
+
+SymTable_T SymTable_newWithCapacity(size_t uCapacity)
+{
+    /* Nodes are allocated as the keys that need them arrive. */
+    (void)uCapacity;
+    return SymTable_new();
+}
+
+SymTable_T SymTable_snapshot(SymTable_T oSymTable)
+{
+    SymTable_T oSnapshot;
+
+    assert(oSymTable != NULL);
+
+    oSnapshot = SymTable_new();
+    if (oSnapshot == NULL)
+        return NULL;
+
+    if (oSymTable->psRoot != NULL)
+        SymTable_retain(&oSymTable->psRoot->refCount);
+    oSnapshot->psRoot = oSymTable->psRoot;
+    oSnapshot->bindingCount = oSymTable->bindingCount;
+    return oSnapshot;
+}
+
+int SymTable_reserve(SymTable_T oSymTable, size_t uCapacity)
+{
+    assert(oSymTable != NULL);
+
+    /* A trie has nothing to size up front. */
+    (void)uCapacity;
+    return 1;
+}
+
+void SymTable_shrinkToFit(SymTable_T oSymTable)
+{
+    assert(oSymTable != NULL);
+
+    /* Every node is exactly as large as its slots. */
+}
+
+void SymTable_setSelfOrganizing(SymTable_T oSymTable, int iEnabled)
+{
+    assert(oSymTable != NULL);
+    (void)iEnabled;
+
+    /* Each key's place follows from its hash, so there is no order to
+       reorganize. */
+}
+
+void SymTable_free(SymTable_T oSymTable)
+{
+    assert(oSymTable != NULL);
+
+    SymTable_releaseNode(oSymTable->psRoot);
+    free(oSymTable);
+}
+
+size_t SymTable_getLength(SymTable_T oSymTable)
+{
+    assert(oSymTable != NULL);
+    return oSymTable->bindingCount;
+}
+
+int SymTable_put(SymTable_T oSymTable,
+                 const char *pcKey, const void *pvValue)
+{
+    struct SymTableKey *psKey;
+    struct SymTableNode *psRoot;
+    size_t uLength;
+    uint32_t uHash;
+    int iOwned;
+    int iSuccessful;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uLength = strlen(pcKey);
+    uHash = SymTable_hash(pcKey, uLength);
+    if (SymTable_find(oSymTable->psRoot, pcKey, uLength, uHash) != NULL)
+        return 0;
+
+    psKey = (struct SymTableKey *)malloc(sizeof(struct SymTableKey)
+                                         + uLength);
+    if (psKey == NULL)
+        return 0;
+    psKey->refCount = 1;
+    psKey->uHash = uHash;
+    psKey->length = uLength;
+    memcpy(psKey->acKey, pcKey, uLength + 1);
+
+    iOwned = oSymTable->psRoot != NULL &&
+             SymTable_owns(oSymTable->psRoot, 1);
+    iSuccessful = SymTable_insert(oSymTable->psRoot, psKey, pvValue, 0,
+                                  iOwned, &psRoot);
+
+    /* The trie holds its own references to psKey by now. */
+    SymTable_releaseKey(psKey);
+    if (! iSuccessful)
+        return 0;
+
+    if (! iOwned)
+        SymTable_releaseNode(oSymTable->psRoot);
+    oSymTable->psRoot = psRoot;
+    oSymTable->bindingCount += 1;
+    return 1;
+}
+
+void *SymTable_replace(SymTable_T oSymTable,
+                       const char *pcKey, const void *pvValue)
+{
+    struct SymTableSlot *psSlot;
+    struct SymTableNode *psRoot;
+    size_t uLength;
+    uint32_t uHash;
+    int iOwned;
+    void *oldValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uLength = strlen(pcKey);
+    uHash = SymTable_hash(pcKey, uLength);
+    psSlot = SymTable_find(oSymTable->psRoot, pcKey, uLength, uHash);
+    if (psSlot == NULL)
+        return NULL;
+
+    oldValue = (void *)psSlot->pvValue;
+    iOwned = SymTable_owns(oSymTable->psRoot, 1);
+    if (! SymTable_update(oSymTable->psRoot, pcKey, uLength, uHash,
+                          pvValue, 0, iOwned, &psRoot))
+        return NULL;
+
+    if (! iOwned)
+        SymTable_releaseNode(oSymTable->psRoot);
+    oSymTable->psRoot = psRoot;
+    return oldValue;
+}
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey)
+{
+    size_t uLength;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uLength = strlen(pcKey);
+    return SymTable_find(oSymTable->psRoot, pcKey, uLength,
+                         SymTable_hash(pcKey, uLength)) != NULL;
+}
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey)
+{
+    struct SymTableSlot *psSlot;
+    size_t uLength;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uLength = strlen(pcKey);
+    psSlot = SymTable_find(oSymTable->psRoot, pcKey, uLength,
+                           SymTable_hash(pcKey, uLength));
+    if (psSlot == NULL)
+        return NULL;
+    return (void *)psSlot->pvValue;
+}
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
+{
+    struct SymTableSlot *psSlot;
+    struct SymTableNode *psRoot;
+    size_t uLength;
+    uint32_t uHash;
+    int iOwned;
+    void *pvValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uLength = strlen(pcKey);
+    uHash = SymTable_hash(pcKey, uLength);
+    psSlot = SymTable_find(oSymTable->psRoot, pcKey, uLength, uHash);
+    if (psSlot == NULL)
+        return NULL;
+
+    pvValue = (void *)psSlot->pvValue;
+    iOwned = SymTable_owns(oSymTable->psRoot, 1);
+    if (! SymTable_erase(oSymTable->psRoot, pcKey, uLength, uHash, 0,
+                         iOwned, &psRoot))
+        return NULL;
+
+    if (! iOwned)
+        SymTable_releaseNode(oSymTable->psRoot);
+    oSymTable->psRoot = psRoot;
+    oSymTable->bindingCount -= 1;
+    return pvValue;
+}
+
+void SymTable_map(SymTable_T oSymTable,
+                  void (*pfApply)(const char *pcKey, void *pvValue,
+                                  void *pvExtra),
+                  const void *pvExtra)
+{
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+
+    SymTable_mapNode(oSymTable->psRoot, pfApply, (void *)pvExtra);
+}
@@ -0,0 +1,30 @@
+/*--------------------------------------------------------------------*/
+/* symtablehamt.h                                                     */
+/* Author: Ryan Chen                                                  */
+/*--------------------------------------------------------------------*/
+
+#ifndef symtablehamt
+#define symtablehamt
+#include "symtable.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Operations that only the persistent trie implementation in
+   symtablehamt.c provides, on top of those in symtable.h. */
+
+/* Return a new SymTable_T object holding the same bindings as
+   oSymTable, or NULL if insufficient memory is available. Takes
+   constant time: the two tables share their structure, and a later
+   change to either one copies only the nodes on the path to the
+   changed key, so the other never sees it. Either table can be freed
+   first. Reference counts are updated atomically, so a snapshot may be
+   read and freed in another thread while oSymTable keeps changing. */
+SymTable_T SymTable_snapshot(SymTable_T oSymTable);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -3,17 +3,146 @@
 /* Author: Ryan Chen                                                  */
 /*--------------------------------------------------------------------*/
 
-#include "symtable.h"
+#define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE
+#include "symtablehash.h"
+#include <pthread.h>
+#include <sys/mman.h>
 #include <stdlib.h>
 #include <assert.h>
 #include <string.h>
-
-/* Bucket counts to expand to */
+#include <stdint.h>
+
+#ifdef SYMTABLE_TRACE
+#include "symtabletrace.h"
+
+/* Records operation eOp, just completed on oSymTable with the key
+   pcKey and the result iResult, if oSymTable is traced */
+#define SYMTABLE_TRACE_OP(oSymTable, eOp, pcKey, iResult)             \
+    do                                                                 \
+    {                                                                  \
+        if ((oSymTable)->traceId != 0)                                 \
+            SymTableTrace_record((oSymTable)->traceId, (eOp), (pcKey), \
+                                 (iResult));                           \
+    } while (0)
+#else
+#define SYMTABLE_TRACE_OP(oSymTable, eOp, pcKey, iResult) ((void)0)
+#endif
+
+/* Bucket counts to expand to. Each is the largest prime below a power
+   of two. */
 static const size_t bucketCount[] = {509, 1021, 2039, 4093, 8191,
-                                     16381, 32749, 65521};
-
-/* Max bucket count per assignment specs */
-static const size_t MAX_BUCKET_COUNT = 65521;
+                                     16381, 32749, 65521, 131071,
+                                     262139, 524287, 1048573, 2097143,
+                                     4194301, 8388593, 16777213,
+                                     33554393, 67108859, 134217689,
+                                     268435399, 536870909, 1073741789,
+                                     2147483647};
+
+/* Number of entries in bucketCount */
+static const size_t BUCKET_COUNT_LENGTH =
+    sizeof(bucketCount) / sizeof(bucketCount[0]);
+
+/* The bucket array shrinks once it has more than SHRINK_DIVISOR buckets
+   per binding. It grows at one binding per bucket, so the gap between
+   the two keeps remove/put cycles from resizing back and forth. */
+static const size_t SHRINK_DIVISOR = 8;
+
+/* Fewest SymTableNodes allocated at once when the free list runs out */
+static const size_t MIN_BLOCK_NODES = 16;
+
+/* Most SymTableNodes allocated at once when the free list runs out */
+static const size_t MAX_BLOCK_NODES = 65536;
+
+/* With background resizing, the next bucket array is requested once
+   the table holds RESIZE_AHEAD_NUMERATOR / RESIZE_AHEAD_DENOMINATOR
+   bindings per bucket, so that it is ready by the time it is needed */
+static const size_t RESIZE_AHEAD_NUMERATOR = 3;
+static const size_t RESIZE_AHEAD_DENOMINATOR = 4;
+
+/* With background resizing, the most bindings per bucket the table
+   lets build up while waiting for the worker before it grows in the
+   foreground after all */
+static const size_t MAX_WAITING_LOAD = 2;
+
+/* Number of locks that each of the old and the new bucket array is
+   striped over while the worker migrates bindings between them. Bucket
+   i of an array is guarded by lock i % LOCK_STRIPES of its stripe. */
+enum {LOCK_STRIPES = 64};
+
+/* With automatic compaction, fewest nodes freed since the last
+   compaction before another is worth its cost. Also the fewest unused
+   nodes worth looking through for node blocks to free. */
+static const size_t MIN_COMPACT_RELEASES = 1024;
+
+/* Size of the huge pages that bucket arrays and node blocks are mapped
+   in when a table asks for them. Smaller arrays and blocks are not
+   worth a huge page. */
+static const size_t HUGE_PAGE_SIZE = (size_t)2 << 20;
+
+/* Fewest entries allocated for the undo log or the scope stack */
+static const size_t MIN_LOG_LENGTH = 16;
+
+/* Number of leading key bytes copied into each SymTableNode */
+enum {PREFIX_SIZE = sizeof(uint64_t)};
+
+/* Tags stored in the byte before each key copy, telling whether the
+   copy was allocated on its own or inside a SymTableKeyBlock or a
+   compacted SymTableBlock */
+enum {KEY_IN_BLOCK, KEY_ALLOCATED};
+
+/* Number of keys ahead whose buckets SymTable_putMany prefetches */
+enum {PREFETCH_DISTANCE = 8};
+
+/* Number of 32-bit words in each block of a filter. A key sets one bit
+   in each word of its block, so a block is 32 bytes and a probe reads
+   a single cache line. */
+enum {FILTER_BLOCK_WORDS = 8};
+
+/* Alignment of a filter, so that no block straddles two cache lines */
+static const size_t FILTER_ALIGNMENT = 64;
+
+/* Bits of filter per key it is sized for. With one bit per word of a
+   block, this gives a false-positive rate of a few percent when full.
+   A filter is sized for twice the keys it starts with, so it is well
+   under 1% just after it is built. */
+static const size_t FILTER_BITS_PER_KEY = 8;
+
+/* Fewest keys a filter is sized for */
+static const size_t MIN_FILTER_KEYS = 1024;
+
+/* Each level of a timer wheel has 1 << WHEEL_SLOT_BITS slots, one bit
+   of a 64-bit occupancy mask each, and covers WHEEL_SLOT_BITS more bits
+   of time than the level below. Deadlines beyond the top level wait in
+   it and are filed again when their slot comes round. */
+enum {WHEEL_SLOT_BITS = 6, WHEEL_SLOTS = 1 << WHEEL_SLOT_BITS,
+      WHEEL_LEVELS = 4};
+
+/* Deadline of a binding that never expires */
+static const uint64_t NO_DEADLINE = UINT64_MAX;
+
+/* slotIndex of a binding that is on no slot of the timer wheel */
+static const size_t NOT_SCHEDULED = (size_t)-1;
+
+/* slotIndex of the list of bindings whose deadline had already passed
+   the wheel's time when they were filed */
+enum {OVERDUE_SLOT = WHEEL_LEVELS * WHEEL_SLOTS};
+
+/* Odd multipliers that pick, from the hash of a key, the bit it sets
+   in each word of its filter block */
+static const uint32_t filterSalt[FILTER_BLOCK_WORDS] = {
+    0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+    0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U};
+
+/* A SymTableAlign is as strictly aligned as any type a client is
+   likely to store as an inline value. */
+union SymTableAlign
+{
+    long double ldValue;
+    void *pvValue;
+    void (*pfValue)(void);
+    uint64_t uValue;
+};
 
 /* Each SymTableNode stores a key-pair pair. SymTableNodes are linked to
    form a list.  */
@@ -27,6 +156,199 @@ struct SymTableNode
 
     /* address of next SymTableNode */
     struct SymTableNode *psNextNode;
+
+    /* the length of the key */
+    size_t keyLength;
+
+    /* the first PREFIX_SIZE bytes of the key, padded with zeros */
+    uint64_t keyPrefix;
+};
+
+/* A SymTableRecency links a node of a cache, a table from
+   SymTable_newCache, into the list of its bindings from most to least
+   recently used. It follows the node in its block, where an inline
+   value would be. */
+struct SymTableRecency
+{
+    /* the node used just after this one, or NULL if it is the newest */
+    struct SymTableNode *psNewer;
+
+    /* the node used just before this one, or NULL if it is the
+       oldest */
+    struct SymTableNode *psOlder;
+};
+
+/* A SymTableTimer holds the deadline of a node of an expiring table, a
+   table from SymTable_newExpiring, and links it into its slot of the
+   timer wheel. Like a SymTableRecency, it follows the node in its
+   block. */
+struct SymTableTimer
+{
+    /* the time at which the binding expires, or NO_DEADLINE */
+    uint64_t deadline;
+
+    /* the next node in the same slot, or NULL */
+    struct SymTableNode *psNextTimer;
+
+    /* the pointer to this node: the slot itself or the psNextTimer of
+       the node before it */
+    struct SymTableNode **ppsPrevTimer;
+
+    /* level times WHEEL_SLOTS plus slot of the wheel the node is on,
+       OVERDUE_SLOT, or NOT_SCHEDULED */
+    size_t slotIndex;
+};
+
+/* A SymTableWheel is the hierarchical timer wheel of an expiring
+   table. A node whose deadline agrees with the wheel's time in every
+   field of WHEEL_SLOT_BITS bits above level L, but not in level L,
+   waits in level L at the slot given by that field of its deadline.
+   Moving the wheel forward then only visits the slots whose field the
+   move passes, at each level. */
+struct SymTableWheel
+{
+    /* the time the wheel has been moved up to */
+    uint64_t now;
+
+    /* function that returns the current time */
+    uint64_t (*pfNow)(void);
+
+    /* for each level, a bit for each slot that holds a node */
+    uint64_t occupied[WHEEL_LEVELS];
+
+    /* the first node in each slot of each level, and then in the
+       overdue list, which every move of the wheel empties */
+    struct SymTableNode *slots[WHEEL_LEVELS * WHEEL_SLOTS + 1];
+};
+
+/* A SymTableUndo records one binding made inside a scope, so that
+   popping the scope can take it back out. */
+struct SymTableUndo
+{
+    /* the binding, or NULL if it was removed before the scope ended */
+    struct SymTableNode *psNode;
+
+    /* the binding of the same key that psNode hides, or NULL if there
+       is none. It is off every bucket until psNode goes away. */
+    struct SymTableNode *psShadowed;
+};
+
+/* A SymTableSearch holds what SymTable_search learned about a key, so
+   that SymTable_link can bind it without searching again. */
+struct SymTableSearch
+{
+    /* the length of the key, and its first PREFIX_SIZE bytes, padded
+       with zeros */
+    size_t keyLength;
+    uint64_t keyPrefix;
+
+    /* the bucket the key belongs in */
+    struct SymTableNode **ppsBucket;
+
+    /* the visible binding of the key, or NULL if there is none, and
+       the node before it in its bucket, or NULL if it is first */
+    struct SymTableNode *psFound;
+    struct SymTableNode *psBeforeFound;
+};
+
+/* A SymTableBlock heads one allocation that holds a run of
+   SymTableNodes directly after it, each followed by its inline value if
+   the table has them. The block SymTable_compact makes holds the keys
+   of its nodes after them. Blocks are linked so that they can
+   all be freed with the SymTable. */
+struct SymTableBlock
+{
+    /* address of next SymTableBlock */
+    struct SymTableBlock *psNextBlock;
+
+    /* number of SymTableNodes that follow this header */
+    size_t nodeCount;
+};
+
+/* A SymTableLarge heads each bucket array and SymTableBlock, recording
+   how it was allocated so that SymTable_freeLarge can give it back. */
+struct SymTableLarge
+{
+    /* size of the mapping it starts, or 0 if it came from malloc */
+    size_t mappedSize;
+};
+
+/* A SymTableKeyBlock heads one allocation that holds the key copies
+   of one batch directly after it. Its keys are not freed one at a
+   time; the whole block goes with the SymTable. */
+struct SymTableKeyBlock
+{
+    /* address of next SymTableKeyBlock */
+    struct SymTableKeyBlock *psNextKeyBlock;
+};
+
+/* A SymTableResizer is the worker thread that resizes a SymTable with
+   background resizing, along with what it shares with the thread that
+   uses the SymTable. The worker allocates each bigger bucket array,
+   faulting its pages in, and once the table has switched to it, moves
+   the bindings over from the old array while the table goes on being
+   used. While the bindings move, both threads lock a bucket before
+   touching it. */
+struct SymTableResizer
+{
+    /* the worker thread */
+    pthread_t thread;
+
+    /* guards every field below up to the stripe locks */
+    pthread_mutex_t mutex;
+
+    /* signaled when a request arrives or the worker should stop */
+    pthread_cond_t wakeUp;
+
+    /* signaled when the worker has finished a migration */
+    pthread_cond_t migrated;
+
+    /* index into bucketCount of the array to allocate next, or 0 if
+       there is no request waiting */
+    size_t requestedIndex;
+
+    /* nonzero once the worker has finished a request */
+    int isReady;
+
+    /* the array the worker allocated, or NULL if it ran out of
+       memory */
+    struct SymTableNode **preparedBuckets;
+
+    /* index into bucketCount of preparedBuckets */
+    size_t preparedIndex;
+
+    /* nonzero once the table has switched to a new array, until the
+       worker starts moving the bindings over to it */
+    int mustMigrate;
+
+    /* nonzero once the worker has moved every binding of the old array
+       to the new one */
+    int isMigrated;
+
+    /* the array the bindings are migrating from, and its number of
+       buckets */
+    struct SymTableNode **oldBuckets;
+    size_t oldBucketCount;
+
+    /* the array the bindings are migrating to, and its number of
+       buckets */
+    struct SymTableNode **newBuckets;
+    size_t newBucketCount;
+
+    /* nonzero once the worker should exit */
+    int isStopping;
+
+    /* nonzero if the requested array should be in huge pages */
+    int hugePages;
+
+    /* nonzero if the table has integer keys */
+    int integerKeys;
+
+    /* the locks over the buckets of the old array, and those over the
+       buckets of the new one. The worker takes an old lock, then a new
+       one; the thread that uses the table only ever holds one. */
+    pthread_mutex_t oldLocks[LOCK_STRIPES];
+    pthread_mutex_t newLocks[LOCK_STRIPES];
 };
 
 /* SymTable represents a hash table that stores key-value pairs. Each
@@ -41,323 +363,3463 @@ struct SymTable
     /* current number of buckets in the SymTable */
     size_t bucketCount;
 
-    /* total number of bindings in the SymTable */
-    size_t bindingCount;
+    /* total number of bindings in the SymTable */
+    size_t bindingCount;
+
+    /* tracks which index the bucketCount is at in order to dynamically
+       expand */
+    size_t currentBucketIndex;
+
+    /* smallest index the buckets shrink back to on their own, set by
+       the capacity the client asked for */
+    size_t minBucketIndex;
+
+    /* linked list of SymTableNodes that are allocated but unused */
+    struct SymTableNode *psFreeNodes;
+
+    /* linked list of every SymTableBlock the nodes came from */
+    struct SymTableBlock *psBlocks;
+
+    /* linked list of every SymTableKeyBlock batches copied keys to */
+    struct SymTableKeyBlock *psKeyBlocks;
+
+    /* total number of SymTableNodes across all blocks, used or not */
+    size_t nodeCount;
+
+    /* number of bindings the client asked room for, which contracting
+       leaves nodes for */
+    size_t reservedCount;
+
+    /* nonzero if lookups move the node they find to the front of its
+       bucket */
+    int selfOrganizing;
+
+    /* size of each value stored inside the table, or 0 if the table
+       stores the client's pointers */
+    size_t valueSize;
+
+    /* bytes from the start of one SymTableNode to the next in a
+       SymTableBlock */
+    size_t nodeSize;
+
+    /* offset in each node of its log position, or 0 if nodes have none
+       because no scope was ever opened. The log position is 0 if the
+       binding was made outside any scope, or else 1 plus the index of
+       its entry in the undo log. */
+    size_t positionOffset;
+
+    /* one entry for each binding made inside a scope still open, in
+       the order they were made */
+    struct SymTableUndo *undoLog;
+
+    /* number of entries in use in undoLog */
+    size_t undoLength;
+
+    /* number of entries allocated for undoLog */
+    size_t undoCapacity;
+
+    /* number of bindings hidden by a binding in an inner scope. Each
+       still holds a node, though it is not counted in bindingCount. */
+    size_t shadowedCount;
+
+    /* for each open scope, outermost first, the undoLength at the time
+       it was pushed */
+    size_t *scopeStarts;
+
+    /* number of open scopes */
+    size_t scopeDepth;
+
+    /* number of entries allocated for scopeStarts */
+    size_t scopeCapacity;
+
+    /* while psResizer is migrating bindings to a bigger bucket array,
+       the array they are leaving, or NULL otherwise. A bucket the
+       worker has emptied holds migratedBucket, and a key whose old
+       bucket does is in its bucket of the new array. */
+    struct SymTableNode **oldBuckets;
+
+    /* number of buckets in oldBuckets */
+    size_t oldBucketCount;
+
+    /* the worker that resizes the buckets in the background, or NULL
+       if the table resizes them itself when it grows */
+    struct SymTableResizer *psResizer;
+
+    /* index into bucketCount of the array requested from psResizer and
+       not yet taken, or 0 if there is none */
+    size_t scheduledIndex;
+
+    /* blocked Bloom filter over the hashes of the keys in the table,
+       with filterBlockCount blocks of FILTER_BLOCK_WORDS words, or
+       NULL if the table has no filter. Removing a key leaves its bits
+       set. */
+    uint32_t *filter;
+
+    /* number of blocks in filter */
+    size_t filterBlockCount;
+
+    /* number of keys added to filter since it was built, including
+       keys removed since */
+    size_t filterKeys;
+
+    /* number of keys filter was sized for. It is rebuilt once
+       filterKeys goes past this. */
+    size_t filterCapacity;
+
+    /* number of searches that filter answered on its own */
+    size_t filterRejects;
+
+    /* number of searches that filter let through and that then found
+       nothing */
+    size_t filterFalsePositives;
+
+    /* most bindings the table holds before it evicts the least
+       recently used one, or 0 if it is not a cache */
+    size_t maxBindings;
+
+    /* the most and least recently used bindings of a cache, or NULL if
+       it is empty or the table is not a cache */
+    struct SymTableNode *psNewest;
+    struct SymTableNode *psOldest;
+
+    /* function called with each binding a cache evicts or an
+       expiring table expires, or NULL */
+    void (*pfEvict)(const char *pcKey, void *pvValue, void *pvExtra);
+
+    /* extra argument passed to pfEvict */
+    const void *pvEvictExtra;
+
+    /* number of bindings the cache has evicted */
+    size_t evictionCount;
+
+    /* the timer wheel of an expiring table, or NULL */
+    struct SymTableWheel *psWheel;
+
+    /* number of bindings the expiring table has expired */
+    size_t expiredCount;
+
+    /* nonzero if the table is from SymTable_newU64, whose nodes hold
+       an integer key in keyPrefix and a NULL pcKey */
+    int integerKeys;
+
+    /* nonzero if adding a binding compacts the table once enough nodes
+       have been freed */
+    int autoCompact;
+
+    /* number of nodes returned to the free list since the table was
+       last compacted */
+    size_t releasedCount;
+
+    /* value of releasedCount at which removing a binding next looks
+       for node blocks to free */
+    size_t releaseCheckCount;
+
+    /* nonzero if bucket arrays and node blocks allocated from now on
+       are mapped in huge pages */
+    int hugePages;
+
+#ifdef SYMTABLE_TRACE
+    /* id the table's operations are traced under, or 0 if they are
+       not traced */
+    unsigned long traceId;
+#endif
+};
+
+/* Node that no key is ever bound to, whose address the worker leaves in
+   each old bucket it has migrated */
+static struct SymTableNode migratedBucket;
+
+/* Function that returns the mixed hash of pcKey that SymTable_reduce
+   maps onto a bucket. */
+static uint32_t SymTable_mix(const char *pcKey)
+{
+    const size_t HASH_MULTIPLIER = 65599;
+    const uint64_t MIX_MULTIPLIER = UINT64_C(0x9E3779B97F4A7C15);
+    size_t u;
+    size_t uHash = 0;
+    uint64_t uMixed;
+
+    assert(pcKey != NULL);
+
+    for (u = 0; pcKey[u] != '\0'; u++)
+        uHash = uHash * HASH_MULTIPLIER + (size_t)pcKey[u];
+
+    uMixed = (uint64_t)uHash;
+    uMixed ^= uMixed >> 32;
+    uMixed *= MIX_MULTIPLIER;
+
+    return (uint32_t)(uMixed >> 32);
+}
+
+/* Function that maps uMixed, a hash from SymTable_mix, onto
+   [0, uBucketCount). */
+static size_t SymTable_reduce(uint32_t uMixed, size_t uBucketCount)
+{
+    assert(uBucketCount <= UINT32_MAX);
+
+    return (size_t)(((uint64_t)uMixed * (uint64_t)uBucketCount) >> 32);
+}
+
+/* Function that returns the mixed hash of uKey, a key of a table from
+   SymTable_newU64, that SymTable_reduce maps onto a bucket: a single
+   multiply and xorshift, with the high bits, which depend on every bit
+   of uKey, taken last. */
+static uint32_t SymTable_mixU64(uint64_t uKey)
+{
+    const uint64_t MIX_MULTIPLIER = UINT64_C(0x9E3779B97F4A7C15);
+
+    uKey *= MIX_MULTIPLIER;
+    uKey ^= uKey >> 29;
+
+    return (uint32_t)(uKey >> 32);
+}
+
+/* Function that hashes the key of psNode, a node of oSymTable, based
+   on uBucketCount. Returns which bucket it goes into. The key's hash
+   is first mixed so that its high bits depend on every character, or
+   every bit of an integer key, then mapped onto [0, uBucketCount) by
+   taking the high half of a 32-by-32-bit product (Lemire's
+   multiply-shift reduction) instead of a modulus, which would cost a
+   hardware divide on every operation. */
+static size_t SymTable_nodeHash(SymTable_T oSymTable,
+                                const struct SymTableNode *psNode,
+                                size_t uBucketCount)
+{
+    uint32_t uMixed;
+
+    if (oSymTable->integerKeys)
+        uMixed = SymTable_mixU64(psNode->keyPrefix);
+    else
+        uMixed = SymTable_mix(psNode->pcKey);
+
+    return SymTable_reduce(uMixed, uBucketCount);
+}
+
+/* Function that returns uSize rounded up to a multiple of the size of
+   union SymTableAlign, or 0 if that does not fit in a size_t. */
+static size_t SymTable_roundUp(size_t uSize)
+{
+    const size_t ALIGN_SIZE = sizeof(union SymTableAlign);
+
+    if (uSize > (size_t)-1 - (ALIGN_SIZE - 1))
+        return 0;
+    return (uSize + ALIGN_SIZE - 1) / ALIGN_SIZE * ALIGN_SIZE;
+}
+
+/* Function that returns the first PREFIX_SIZE bytes of the uLength
+   bytes of pcKey as one integer, padded with zeros if the key is
+   shorter. */
+static uint64_t SymTable_prefix(const char *pcKey, size_t uLength)
+{
+    uint64_t uPrefix = 0;
+
+    memcpy(&uPrefix, pcKey,
+           uLength < PREFIX_SIZE ? uLength : (size_t)PREFIX_SIZE);
+    return uPrefix;
+}
+
+/* Function that returns 1 if psNode holds pcKey, whose length is
+   uLength and whose prefix is uPrefix, or 0 otherwise. Most mismatches
+   differ in length or prefix, which are stored in psNode itself, so
+   the key is only read once both agree, and then only past the
+   prefix. */
+static int SymTable_matches(const struct SymTableNode *psNode,
+                            const char *pcKey, size_t uLength,
+                            uint64_t uPrefix)
+{
+    if (psNode->keyPrefix != uPrefix || psNode->keyLength != uLength)
+        return 0;
+    if (uLength <= PREFIX_SIZE)
+        return 1;
+    return memcmp((const char *)psNode->pcKey + PREFIX_SIZE,
+                  pcKey + PREFIX_SIZE, uLength - PREFIX_SIZE) == 0;
+}
+
+/* Function that returns a copy of the uLength characters of pcKey,
+   ending in '\0' and tagged KEY_ALLOCATED, or NULL if insufficient
+   memory is available. */
+static char *SymTable_copyKey(const char *pcKey, size_t uLength)
+{
+    char *pcCopy;
+
+    if (uLength > (size_t)-1 - 2)
+        return NULL;
+
+    pcCopy = (char *)malloc(uLength + 2);
+    if (pcCopy == NULL)
+        return NULL;
+
+    pcCopy[0] = KEY_ALLOCATED;
+    memcpy(pcCopy + 1, pcKey, uLength + 1);
+    return pcCopy + 1;
+}
+
+/* Function that frees pvKey, a key copy owned by a SymTable, unless it
+   lives in a SymTableKeyBlock or is NULL, as the key of a node with an
+   integer key is. */
+static void SymTable_freeKey(const void *pvKey)
+{
+    const char *pcTag;
+
+    if (pvKey == NULL)
+        return;
+
+    pcTag = (const char *)pvKey - 1;
+    if (*pcTag == KEY_ALLOCATED)
+        free((void *)pcTag);
+}
+
+#if defined(MAP_ANONYMOUS) && defined(MADV_HUGEPAGE)
+/* Function that maps uSize bytes, a multiple of HUGE_PAGE_SIZE, at an
+   address that is also a multiple of it, and advises the kernel to
+   back them with transparent huge pages. It does so whenever it can,
+   in pages the mapping covers whole, which is why the mapping is
+   aligned. Returns the mapping, or MAP_FAILED if it cannot be made. */
+static void *SymTable_mapTransparent(size_t uSize)
+{
+    char *pcMapping;
+    size_t uLead;
+
+    if (uSize > (size_t)-1 - HUGE_PAGE_SIZE)
+        return MAP_FAILED;
+
+    /* Map a huge page more than needed, and trim the mapping at both
+       ends to the first aligned uSize bytes. */
+    pcMapping = (char *)mmap(NULL, uSize + HUGE_PAGE_SIZE,
+                             PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if ((void *)pcMapping == MAP_FAILED)
+        return MAP_FAILED;
+
+    uLead = (HUGE_PAGE_SIZE - (uintptr_t)pcMapping % HUGE_PAGE_SIZE)
+            % HUGE_PAGE_SIZE;
+    if (uLead > 0)
+        (void)munmap(pcMapping, uLead);
+    (void)munmap(pcMapping + uLead + uSize, HUGE_PAGE_SIZE - uLead);
+    pcMapping += uLead;
+
+    /* Without transparent huge pages the mapping still works, in
+       ordinary pages. */
+    (void)madvise(pcMapping, uSize, MADV_HUGEPAGE);
+    return pcMapping;
+}
+#endif
+
+/* Function that allocates *puSize bytes for a bucket array or a
+   SymTableBlock, zeroed if iZeroed. If iHugePages and the request fills
+   at least one huge page, the memory is mapped in huge pages: from the
+   pool the kernel reserves if it has any left, or else as transparent
+   huge pages. Memory that cannot be mapped that way, or that is asked
+   for without iHugePages, comes from malloc. Sets *puSize to the
+   number of bytes usable, which a mapping may round up. Returns the
+   memory, to be freed with SymTable_freeLarge, or NULL if insufficient
+   memory is available. */
+static void *SymTable_allocLarge(size_t *puSize, int iHugePages,
+                                 int iZeroed)
+{
+    struct SymTableLarge *psLarge;
+    size_t uHeaderSize = SymTable_roundUp(sizeof(struct SymTableLarge));
+    void *pvMapping;
+    size_t uMappedSize;
+
+    if (*puSize > (size_t)-1 - uHeaderSize - HUGE_PAGE_SIZE)
+        return NULL;
+
+#if defined(MAP_ANONYMOUS) && defined(MADV_HUGEPAGE)
+    if (iHugePages && *puSize >= HUGE_PAGE_SIZE)
+    {
+        uMappedSize = (*puSize + uHeaderSize + HUGE_PAGE_SIZE - 1)
+                      / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+        pvMapping = MAP_FAILED;
+#ifdef MAP_HUGETLB
+        pvMapping = mmap(NULL, uMappedSize, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+        if (pvMapping == MAP_FAILED)
+            pvMapping = SymTable_mapTransparent(uMappedSize);
+
+        /* Anonymous mappings start out zeroed. */
+        if (pvMapping != MAP_FAILED)
+        {
+            psLarge = (struct SymTableLarge *)pvMapping;
+            psLarge->mappedSize = uMappedSize;
+            *puSize = uMappedSize - uHeaderSize;
+            return (char *)pvMapping + uHeaderSize;
+        }
+    }
+#else
+    (void)iHugePages;
+    (void)pvMapping;
+    (void)uMappedSize;
+#endif
+
+    if (iZeroed)
+        psLarge = (struct SymTableLarge *)calloc(1, uHeaderSize + *puSize);
+    else
+        psLarge = (struct SymTableLarge *)malloc(uHeaderSize + *puSize);
+    if (psLarge == NULL)
+        return NULL;
+
+    psLarge->mappedSize = 0;
+    return (char *)psLarge + uHeaderSize;
+}
+
+/* Function that frees pvMemory, which SymTable_allocLarge returned, or
+   does nothing if it is NULL. */
+static void SymTable_freeLarge(void *pvMemory)
+{
+    struct SymTableLarge *psLarge;
+
+    if (pvMemory == NULL)
+        return;
+
+    psLarge = (struct SymTableLarge *)(void *)((char *)pvMemory
+                  - SymTable_roundUp(sizeof(struct SymTableLarge)));
+    if (psLarge->mappedSize != 0)
+        (void)munmap(psLarge, psLarge->mappedSize);
+    else
+        free(psLarge);
+}
+
+/* Function that returns a new zeroed array of uBucketCount buckets for
+   oSymTable, in huge pages if it asked for them and the array is large
+   enough, or NULL if insufficient memory is available. */
+static struct SymTableNode **SymTable_allocBuckets(SymTable_T oSymTable,
+                                                   size_t uBucketCount)
+{
+    size_t uSize = uBucketCount * sizeof(struct SymTableNode *);
+
+    return (struct SymTableNode **)SymTable_allocLarge(&uSize,
+                                       oSymTable->hugePages, 1);
+}
+
+/* Function that ends the migration of oSymTable, which must be
+   migrating, if the worker has finished it, and frees the old array.
+   Never waits for the worker. */
+static void SymTable_pollMigration(SymTable_T oSymTable)
+{
+    struct SymTableResizer *psResizer = oSymTable->psResizer;
+    int iMigrated;
+
+    if (pthread_mutex_trylock(&psResizer->mutex) != 0)
+        return;
+    iMigrated = psResizer->isMigrated;
+    psResizer->isMigrated = 0;
+    pthread_mutex_unlock(&psResizer->mutex);
+
+    if (iMigrated)
+    {
+        SymTable_freeLarge(oSymTable->oldBuckets);
+        oSymTable->oldBuckets = NULL;
+    }
+}
+
+/* Function that completes any migration in progress in oSymTable,
+   waiting for the worker to move the bindings it has left, and frees
+   the old array. The caller must hold no bucket lock. */
+static void SymTable_finishMigration(SymTable_T oSymTable)
+{
+    struct SymTableResizer *psResizer = oSymTable->psResizer;
+
+    if (oSymTable->oldBuckets == NULL)
+        return;
+
+    pthread_mutex_lock(&psResizer->mutex);
+    while (! psResizer->isMigrated)
+        pthread_cond_wait(&psResizer->migrated, &psResizer->mutex);
+    psResizer->isMigrated = 0;
+    pthread_mutex_unlock(&psResizer->mutex);
+
+    SymTable_freeLarge(oSymTable->oldBuckets);
+    oSymTable->oldBuckets = NULL;
+}
+
+/* Function that returns the bucket of oSymTable that a key whose
+   SymTable_mix hash is uMixed belongs in: its bucket in the old array
+   if the worker has not migrated it yet, or else its bucket in the
+   current array. While a migration is in progress, the caller must
+   hold the lock that SymTable_lockBucket took for that bucket. */
+static struct SymTableNode **SymTable_bucketFor(SymTable_T oSymTable,
+                                                uint32_t uMixed)
+{
+    size_t oldBucketIndex;
+
+    if (oSymTable->oldBuckets != NULL)
+    {
+        oldBucketIndex = SymTable_reduce(uMixed,
+                                         oSymTable->oldBucketCount);
+        if (oSymTable->oldBuckets[oldBucketIndex] != &migratedBucket)
+            return &oSymTable->oldBuckets[oldBucketIndex];
+    }
+
+    return &oSymTable->buckets[SymTable_reduce(uMixed,
+                                               oSymTable->bucketCount)];
+}
+
+/* Function that returns the bucket of oSymTable that a key whose
+   SymTable_mix hash is uMixed belongs in, as SymTable_bucketFor does.
+   While a migration is in progress, it first locks that bucket, so
+   that the worker leaves it alone until SymTable_unlockBucket is
+   called with *ppsLock; otherwise it sets *ppsLock to NULL. A key
+   whose old bucket the worker has migrated stays in the new array, so
+   only the old bucket needs checking under its lock. */
+static struct SymTableNode **SymTable_lockBucket(SymTable_T oSymTable,
+                                                 uint32_t uMixed,
+                                                 pthread_mutex_t **ppsLock)
+{
+    struct SymTableResizer *psResizer = oSymTable->psResizer;
+    size_t oldBucketIndex;
+    size_t newBucketIndex;
+
+    if (oSymTable->oldBuckets == NULL)
+    {
+        *ppsLock = NULL;
+        return &oSymTable->buckets[SymTable_reduce(uMixed,
+                                       oSymTable->bucketCount)];
+    }
+
+    oldBucketIndex = SymTable_reduce(uMixed, oSymTable->oldBucketCount);
+    *ppsLock = &psResizer->oldLocks[oldBucketIndex % LOCK_STRIPES];
+    pthread_mutex_lock(*ppsLock);
+    if (oSymTable->oldBuckets[oldBucketIndex] != &migratedBucket)
+        return &oSymTable->oldBuckets[oldBucketIndex];
+    pthread_mutex_unlock(*ppsLock);
+
+    newBucketIndex = SymTable_reduce(uMixed, oSymTable->bucketCount);
+    *ppsLock = &psResizer->newLocks[newBucketIndex % LOCK_STRIPES];
+    pthread_mutex_lock(*ppsLock);
+    return &oSymTable->buckets[newBucketIndex];
+}
+
+/* Function that releases psLock, a lock from SymTable_lockBucket, if
+   it is not NULL. */
+static void SymTable_unlockBucket(pthread_mutex_t *psLock)
+{
+    if (psLock != NULL)
+        pthread_mutex_unlock(psLock);
+}
+
+/* Function that rehashes every node of oSymTable into a new array of
+   bucketCount[uNewIndex] buckets. Returns 1 if successful, or 0 if
+   insufficient memory is available, in which case oSymTable is left
+   unchanged. */
+static int SymTable_rehash(SymTable_T oSymTable, size_t uNewIndex)
+{
+    struct SymTableNode **moreBuckets;
+    struct SymTableNode *psCurrentNode;
+    struct SymTableNode *psNextNode;
+    size_t oldBucketCount;
+    size_t newBucketCount;
+    size_t oldBucketIndex;
+    size_t newBucketIndex;
+
+    assert(uNewIndex < BUCKET_COUNT_LENGTH);
+
+    SymTable_finishMigration(oSymTable);
+
+    oldBucketCount = oSymTable->bucketCount;
+    newBucketCount = bucketCount[uNewIndex];
+
+    moreBuckets = SymTable_allocBuckets(oSymTable, newBucketCount);
+    if (moreBuckets == NULL)
+        return 0; 
+
+    /* Rehashes nodes from old buckets into the new buckets */
+    for (oldBucketIndex = 0; 
+         oldBucketIndex < oldBucketCount; 
+         oldBucketIndex++)
+    {
+        for (psCurrentNode = oSymTable->buckets[oldBucketIndex]; 
+             psCurrentNode != NULL; 
+             psCurrentNode = psNextNode)
+        {
+            psNextNode = psCurrentNode->psNextNode;
+
+            newBucketIndex = SymTable_nodeHash(oSymTable, psCurrentNode,
+                                               newBucketCount);
+
+            psCurrentNode->psNextNode = moreBuckets[newBucketIndex];
+            moreBuckets[newBucketIndex] = psCurrentNode;
+        }
+    }
+
+    SymTable_freeLarge(oSymTable->buckets);
+
+    oSymTable->buckets = moreBuckets;
+    oSymTable->bucketCount = newBucketCount;
+    oSymTable->currentBucketIndex = uNewIndex;
+    return 1;
+}
+
+/* Function that takes oSymTable and expands the buckets in it if it
+   reaches the max bucket count, listed in bucketCount. Index zero is
+   what the starting number of buckets is, and each index after is what
+   it should expand to. Stops expanding at the last entry. If memory
+   runs out the table keeps its current buckets. */
+static void SymTable_expand(SymTable_T oSymTable)
+{
+    if (oSymTable->currentBucketIndex == BUCKET_COUNT_LENGTH - 1)
+    {
+        return;
+    }
+
+    (void)SymTable_rehash(oSymTable, oSymTable->currentBucketIndex + 1);
+}
+
+/* Function that returns the index of the smallest entry of bucketCount
+   that holds uCapacity bindings without expanding, or the last index
+   if none does. */
+static size_t SymTable_indexForCapacity(size_t uCapacity)
+{
+    size_t uIndex = 0;
+
+    while (uIndex < BUCKET_COUNT_LENGTH - 1 &&
+           bucketCount[uIndex] < uCapacity)
+        uIndex++;
+
+    return uIndex;
+}
+
+/* Function that allocates a SymTableBlock of at least uNodeCount nodes
+   for oSymTable and pushes its nodes onto the free list. A block in
+   huge pages gets as many nodes as fit in them. Returns 1 if
+   successful, or 0 if insufficient memory is available. */
+static int SymTable_addBlock(SymTable_T oSymTable, size_t uNodeCount)
+{
+    struct SymTableBlock *psBlock;
+    struct SymTableNode *psNode;
+    size_t uHeaderSize = SymTable_roundUp(sizeof(struct SymTableBlock));
+    size_t uSize;
+    size_t u;
+
+    assert(uNodeCount > 0);
+
+    if (uNodeCount > ((size_t)-1 - uHeaderSize) / oSymTable->nodeSize)
+        return 0;
+
+    uSize = uHeaderSize + uNodeCount * oSymTable->nodeSize;
+    psBlock = (struct SymTableBlock *)SymTable_allocLarge(&uSize,
+                  oSymTable->hugePages, 0);
+    if (psBlock == NULL)
+        return 0;
+    uNodeCount = (uSize - uHeaderSize) / oSymTable->nodeSize;
+
+    psBlock->nodeCount = uNodeCount;
+    psBlock->psNextBlock = oSymTable->psBlocks;
+    oSymTable->psBlocks = psBlock;
+    oSymTable->nodeCount += uNodeCount;
+
+    /* Nodes sit right after the header, nodeSize bytes apart. Push
+       them in reverse so the free list hands them out in address
+       order. */
+    for (u = uNodeCount; u > 0; u--)
+    {
+        psNode = (struct SymTableNode *)(void *)((char *)psBlock
+                    + uHeaderSize + (u - 1) * oSymTable->nodeSize);
+        psNode->psNextNode = oSymTable->psFreeNodes;
+        oSymTable->psFreeNodes = psNode;
+    }
+
+    return 1;
+}
+
+/* Function that compares the addresses of the SymTableBlocks that
+   pvFirst and pvSecond point to, for qsort. */
+static int SymTable_compareBlocks(const void *pvFirst,
+                                  const void *pvSecond)
+{
+    uintptr_t uFirst =
+        (uintptr_t)*(struct SymTableBlock *const *)pvFirst;
+    uintptr_t uSecond =
+        (uintptr_t)*(struct SymTableBlock *const *)pvSecond;
+
+    return (uFirst > uSecond) - (uFirst < uSecond);
+}
+
+/* Function that returns the index, in ppsBlocks, an array of
+   uBlockCount SymTableBlocks sorted by address, of the block holding
+   psNode: the last one that starts below it. */
+static size_t SymTable_blockIndex(struct SymTableBlock *const ppsBlocks[],
+                                  size_t uBlockCount,
+                                  const struct SymTableNode *psNode)
+{
+    size_t uLow = 0;
+    size_t uHigh = uBlockCount;
+    size_t uMiddle;
+
+    while (uHigh - uLow > 1)
+    {
+        uMiddle = uLow + (uHigh - uLow) / 2;
+        if ((uintptr_t)ppsBlocks[uMiddle] < (uintptr_t)psNode)
+            uLow = uMiddle;
+        else
+            uHigh = uMiddle;
+    }
+
+    return uLow;
+}
+
+/* Function that frees each SymTableBlock of oSymTable that holds no
+   node in use, taking its nodes off the free list, for as long as
+   oSymTable keeps at least uKeep nodes. Unlike SymTable_compact it
+   moves no binding, so it frees nothing from a block that still holds
+   one. If memory runs out nothing is freed. */
+static void SymTable_releaseBlocks(SymTable_T oSymTable, size_t uKeep)
+{
+    struct SymTableBlock **ppsBlocks;
+    struct SymTableBlock *psBlock;
+    struct SymTableBlock **ppsBlockLink;
+    struct SymTableNode **ppsFreeLink;
+    size_t *puUnused;
+    size_t uBlockCount = 0;
+    size_t uFreedCount = 0;
+    size_t u;
+
+    for (psBlock = oSymTable->psBlocks;
+         psBlock != NULL;
+         psBlock = psBlock->psNextBlock)
+        uBlockCount++;
+
+    ppsBlocks = (struct SymTableBlock **)malloc(
+                    uBlockCount * sizeof(struct SymTableBlock *));
+    puUnused = (size_t *)calloc(uBlockCount, sizeof(size_t));
+    if (ppsBlocks == NULL || puUnused == NULL)
+    {
+        free(ppsBlocks);
+        free(puUnused);
+        return;
+    }
+
+    u = 0;
+    for (psBlock = oSymTable->psBlocks;
+         psBlock != NULL;
+         psBlock = psBlock->psNextBlock)
+        ppsBlocks[u++] = psBlock;
+    qsort(ppsBlocks, uBlockCount, sizeof(struct SymTableBlock *),
+          SymTable_compareBlocks);
+
+    for (ppsFreeLink = &oSymTable->psFreeNodes;
+         *ppsFreeLink != NULL;
+         ppsFreeLink = &(*ppsFreeLink)->psNextNode)
+        puUnused[SymTable_blockIndex(ppsBlocks, uBlockCount,
+                                     *ppsFreeLink)] += 1;
+
+    /* From here on puUnused[u] is nonzero if block u is to be freed. */
+    for (u = 0; u < uBlockCount; u++)
+    {
+        if (puUnused[u] == ppsBlocks[u]->nodeCount &&
+            oSymTable->nodeCount - ppsBlocks[u]->nodeCount >= uKeep)
+        {
+            oSymTable->nodeCount -= ppsBlocks[u]->nodeCount;
+            uFreedCount++;
+        }
+        else
+            puUnused[u] = 0;
+    }
+
+    if (uFreedCount > 0)
+    {
+        ppsFreeLink = &oSymTable->psFreeNodes;
+        while (*ppsFreeLink != NULL)
+        {
+            if (puUnused[SymTable_blockIndex(ppsBlocks, uBlockCount,
+                                             *ppsFreeLink)] != 0)
+                *ppsFreeLink = (*ppsFreeLink)->psNextNode;
+            else
+                ppsFreeLink = &(*ppsFreeLink)->psNextNode;
+        }
+
+        ppsBlockLink = &oSymTable->psBlocks;
+        while (*ppsBlockLink != NULL)
+        {
+            psBlock = *ppsBlockLink;
+            u = SymTable_blockIndex(ppsBlocks, uBlockCount,
+                                    (struct SymTableNode *)(void *)
+                                        (psBlock + 1));
+            if (puUnused[u] != 0)
+            {
+                *ppsBlockLink = psBlock->psNextBlock;
+                SymTable_freeLarge(psBlock);
+            }
+            else
+                ppsBlockLink = &psBlock->psNextBlock;
+        }
+    }
+
+    free(ppsBlocks);
+    free(puUnused);
+}
+
+/* Function that shrinks the buckets of oSymTable once they are mostly
+   empty, leaving about two buckets per binding but never going below
+   minBucketIndex. Waits for any migration to finish first. Then, once
+   unused nodes outnumber those in use, and those reserved, by
+   SHRINK_DIVISOR to one, frees the node blocks that hold no binding.
+   Bindings never move here, so their keys stay where they are. Each
+   look through the unused nodes waits for another nodeCount /
+   SHRINK_DIVISOR of them to be freed, so that it costs each removal
+   little. If memory runs out the table keeps its
+   current buckets and nodes. */
+static void SymTable_contract(SymTable_T oSymTable)
+{
+    size_t uIndex;
+    size_t uLive;
+    size_t uKeep;
+
+    if (oSymTable->currentBucketIndex > oSymTable->minBucketIndex &&
+        oSymTable->bindingCount * SHRINK_DIVISOR <
+        oSymTable->bucketCount && oSymTable->oldBuckets == NULL)
+    {
+        uIndex = SymTable_indexForCapacity(2 * oSymTable->bindingCount);
+        if (uIndex < oSymTable->minBucketIndex)
+            uIndex = oSymTable->minBucketIndex;
+
+        (void)SymTable_rehash(oSymTable, uIndex);
+    }
+
+    /* Inline values live in the nodes, and the address SymTable_remove
+       returned for one must stay valid until the next put, so those
+       tables keep their nodes until then. */
+    uLive = oSymTable->bindingCount + oSymTable->shadowedCount;
+    uKeep = uLive > oSymTable->reservedCount ? uLive
+                                              : oSymTable->reservedCount;
+    if (oSymTable->valueSize > 0 ||
+        oSymTable->nodeCount - uLive < MIN_COMPACT_RELEASES ||
+        oSymTable->nodeCount / SHRINK_DIVISOR <= uKeep ||
+        oSymTable->releasedCount < oSymTable->releaseCheckCount)
+        return;
+
+    SymTable_releaseBlocks(oSymTable, uKeep);
+    oSymTable->releaseCheckCount = oSymTable->releasedCount
+        + (oSymTable->nodeCount / SHRINK_DIVISOR > MIN_COMPACT_RELEASES
+           ? oSymTable->nodeCount / SHRINK_DIVISOR : MIN_COMPACT_RELEASES);
+}
+
+/* Function that takes a node off the free list of oSymTable, adding a
+   block first if the list is empty. Each new block is as large as all
+   earlier ones combined, within MIN_BLOCK_NODES and MAX_BLOCK_NODES.
+   Returns NULL if insufficient memory is available. */
+static struct SymTableNode *SymTable_allocNode(SymTable_T oSymTable)
+{
+    struct SymTableNode *psNode;
+    size_t uBlockNodes;
+
+    if (oSymTable->psFreeNodes == NULL)
+    {
+        uBlockNodes = oSymTable->nodeCount;
+        if (uBlockNodes < MIN_BLOCK_NODES)
+            uBlockNodes = MIN_BLOCK_NODES;
+        if (uBlockNodes > MAX_BLOCK_NODES)
+            uBlockNodes = MAX_BLOCK_NODES;
+
+        if (! SymTable_addBlock(oSymTable, uBlockNodes))
+            return NULL;
+    }
+
+    psNode = oSymTable->psFreeNodes;
+    oSymTable->psFreeNodes = psNode->psNextNode;
+    return psNode;
+}
+
+/* Function that returns psNode to the free list of oSymTable. */
+static void SymTable_freeNode(SymTable_T oSymTable,
+                              struct SymTableNode *psNode)
+{
+    psNode->psNextNode = oSymTable->psFreeNodes;
+    oSymTable->psFreeNodes = psNode;
+    oSymTable->releasedCount += 1;
+}
+
+/* Function that moves every binding in the old array of psResizer to
+   its new array, one old bucket at a time, and leaves migratedBucket in
+   each old bucket it empties. Runs on the worker, while the thread that
+   uses the table goes on using it. */
+static void SymTable_migrateBuckets(struct SymTableResizer *psResizer)
+{
+    struct SymTableNode *psCurrentNode;
+    struct SymTableNode *psNextNode;
+    pthread_mutex_t *psOldLock;
+    pthread_mutex_t *psNewLock;
+    uint32_t uMixed;
+    size_t oldBucketIndex;
+    size_t newBucketIndex;
+
+    for (oldBucketIndex = 0;
+         oldBucketIndex < psResizer->oldBucketCount;
+         oldBucketIndex++)
+    {
+        psOldLock = &psResizer->oldLocks[oldBucketIndex % LOCK_STRIPES];
+        pthread_mutex_lock(psOldLock);
+        for (psCurrentNode = psResizer->oldBuckets[oldBucketIndex];
+             psCurrentNode != NULL;
+             psCurrentNode = psNextNode)
+        {
+            psNextNode = psCurrentNode->psNextNode;
+
+            if (psResizer->integerKeys)
+                uMixed = SymTable_mixU64(psCurrentNode->keyPrefix);
+            else
+                uMixed = SymTable_mix(psCurrentNode->pcKey);
+            newBucketIndex = SymTable_reduce(uMixed,
+                                             psResizer->newBucketCount);
+
+            psNewLock = &psResizer->newLocks[newBucketIndex
+                                             % LOCK_STRIPES];
+            pthread_mutex_lock(psNewLock);
+            psCurrentNode->psNextNode =
+                psResizer->newBuckets[newBucketIndex];
+            psResizer->newBuckets[newBucketIndex] = psCurrentNode;
+            pthread_mutex_unlock(psNewLock);
+        }
+        psResizer->oldBuckets[oldBucketIndex] = &migratedBucket;
+        pthread_mutex_unlock(psOldLock);
+    }
+}
+
+/* Function that runs the SymTableResizer that pvResizer points to:
+   waits for requests, and answers each request for an array with a
+   zeroed bucket array of the requested size, and each request to
+   migrate by moving the bindings over. Writing the zeros here, rather
+   than getting them from calloc, makes this thread take the page
+   faults. Returns NULL once the worker is stopped. */
+static void *SymTable_resizeWorker(void *pvResizer)
+{
+    struct SymTableResizer *psResizer;
+    struct SymTableNode **ppsBuckets;
+    size_t uIndex;
+    size_t uSize;
+    int iHugePages;
+
+    psResizer = (struct SymTableResizer *)pvResizer;
+
+    pthread_mutex_lock(&psResizer->mutex);
+    for (;;)
+    {
+        while (! psResizer->isStopping &&
+               psResizer->requestedIndex == 0 &&
+               ! psResizer->mustMigrate)
+            pthread_cond_wait(&psResizer->wakeUp, &psResizer->mutex);
+        if (psResizer->isStopping)
+            break;
+
+        if (psResizer->mustMigrate)
+        {
+            psResizer->mustMigrate = 0;
+            pthread_mutex_unlock(&psResizer->mutex);
+
+            SymTable_migrateBuckets(psResizer);
+
+            pthread_mutex_lock(&psResizer->mutex);
+            psResizer->isMigrated = 1;
+            pthread_cond_signal(&psResizer->migrated);
+            continue;
+        }
+
+        uIndex = psResizer->requestedIndex;
+        iHugePages = psResizer->hugePages;
+        psResizer->requestedIndex = 0;
+        pthread_mutex_unlock(&psResizer->mutex);
+
+        uSize = bucketCount[uIndex] * sizeof(struct SymTableNode *);
+        ppsBuckets = (struct SymTableNode **)SymTable_allocLarge(&uSize,
+                         iHugePages, 0);
+        if (ppsBuckets != NULL)
+            memset(ppsBuckets, 0,
+                   bucketCount[uIndex] * sizeof(struct SymTableNode *));
+
+        pthread_mutex_lock(&psResizer->mutex);
+        SymTable_freeLarge(psResizer->preparedBuckets);
+        psResizer->preparedBuckets = ppsBuckets;
+        psResizer->preparedIndex = uIndex;
+        psResizer->isReady = 1;
+    }
+    pthread_mutex_unlock(&psResizer->mutex);
+
+    return NULL;
+}
+
+/* Function that asks the worker of oSymTable for a bucket array of
+   bucketCount[uIndex] buckets. */
+static void SymTable_requestResize(SymTable_T oSymTable, size_t uIndex)
+{
+    struct SymTableResizer *psResizer = oSymTable->psResizer;
+
+    pthread_mutex_lock(&psResizer->mutex);
+    psResizer->requestedIndex = uIndex;
+    psResizer->hugePages = oSymTable->hugePages;
+    pthread_cond_signal(&psResizer->wakeUp);
+    pthread_mutex_unlock(&psResizer->mutex);
+
+    oSymTable->scheduledIndex = uIndex;
+}
+
+/* Function that grows the buckets of oSymTable, which has a worker,
+   without making the caller wait for a new array or a rehash. Once the
+   table is mostly full it asks the worker for the next size. Once it
+   is full and the worker has delivered, the new array replaces the
+   current one, and the worker moves the bindings over while the table
+   goes on being used. If the worker falls far behind, or runs out of
+   memory, the table grows in the foreground after all. */
+static void SymTable_growInBackground(SymTable_T oSymTable)
+{
+    struct SymTableResizer *psResizer = oSymTable->psResizer;
+    struct SymTableNode **ppsPrepared;
+    size_t uPreparedIndex;
+
+    if (oSymTable->oldBuckets != NULL ||
+        oSymTable->currentBucketIndex == BUCKET_COUNT_LENGTH - 1)
+        return;
+
+    if (oSymTable->scheduledIndex == 0)
+    {
+        if (oSymTable->bindingCount * RESIZE_AHEAD_DENOMINATOR >=
+            oSymTable->bucketCount * RESIZE_AHEAD_NUMERATOR)
+            SymTable_requestResize(oSymTable,
+                                   oSymTable->currentBucketIndex + 1);
+        return;
+    }
+
+    if (oSymTable->bindingCount <= oSymTable->bucketCount)
+        return;
+
+    /* Never wait on the worker: if it holds the mutex, try again on
+       the next put. */
+    if (pthread_mutex_trylock(&psResizer->mutex) != 0)
+        return;
+
+    if (! psResizer->isReady)
+    {
+        pthread_mutex_unlock(&psResizer->mutex);
+        if (oSymTable->bindingCount >
+            oSymTable->bucketCount * MAX_WAITING_LOAD)
+            SymTable_expand(oSymTable);
+        return;
+    }
+
+    ppsPrepared = psResizer->preparedBuckets;
+    uPreparedIndex = psResizer->preparedIndex;
+    psResizer->isReady = 0;
+    psResizer->preparedBuckets = NULL;
+    oSymTable->scheduledIndex = 0;
+
+    if (ppsPrepared == NULL)
+    {
+        pthread_mutex_unlock(&psResizer->mutex);
+        SymTable_expand(oSymTable);
+        return;
+    }
+    if (uPreparedIndex <= oSymTable->currentBucketIndex)
+    {
+        /* The table grew in the foreground in the meantime. */
+        pthread_mutex_unlock(&psResizer->mutex);
+        SymTable_freeLarge(ppsPrepared);
+        return;
+    }
+
+    /* The worker locks each bucket before moving it, so the table can
+       switch arrays now and keep going. */
+    oSymTable->oldBuckets = oSymTable->buckets;
+    oSymTable->oldBucketCount = oSymTable->bucketCount;
+    oSymTable->buckets = ppsPrepared;
+    oSymTable->bucketCount = bucketCount[uPreparedIndex];
+    oSymTable->currentBucketIndex = uPreparedIndex;
+
+    psResizer->oldBuckets = oSymTable->oldBuckets;
+    psResizer->oldBucketCount = oSymTable->oldBucketCount;
+    psResizer->newBuckets = oSymTable->buckets;
+    psResizer->newBucketCount = oSymTable->bucketCount;
+    psResizer->mustMigrate = 1;
+    pthread_cond_signal(&psResizer->wakeUp);
+    pthread_mutex_unlock(&psResizer->mutex);
+}
+
+/* Function that stops the worker of oSymTable once it has finished any
+   migration, waits for it to exit, and frees it. */
+static void SymTable_stopResizer(SymTable_T oSymTable)
+{
+    struct SymTableResizer *psResizer = oSymTable->psResizer;
+    size_t u;
+
+    SymTable_finishMigration(oSymTable);
+
+    pthread_mutex_lock(&psResizer->mutex);
+    psResizer->isStopping = 1;
+    pthread_cond_signal(&psResizer->wakeUp);
+    pthread_mutex_unlock(&psResizer->mutex);
+
+    pthread_join(psResizer->thread, NULL);
+
+    for (u = 0; u < LOCK_STRIPES; u++)
+    {
+        pthread_mutex_destroy(&psResizer->oldLocks[u]);
+        pthread_mutex_destroy(&psResizer->newLocks[u]);
+    }
+    SymTable_freeLarge(psResizer->preparedBuckets);
+    pthread_cond_destroy(&psResizer->migrated);
+    pthread_cond_destroy(&psResizer->wakeUp);
+    pthread_mutex_destroy(&psResizer->mutex);
+    free(psResizer);
+
+    oSymTable->psResizer = NULL;
+    oSymTable->scheduledIndex = 0;
+}
+
+/* Function that makes room for at least one more of the uEntrySize
+   byte entries of *ppvArray, which has *puCapacity entries and all of
+   them in use, by doubling it. Returns 1 if successful, or 0 if
+   insufficient memory is available, in which case the array is left
+   unchanged. */
+static int SymTable_growArray(void **ppvArray, size_t *puCapacity,
+                              size_t uEntrySize)
+{
+    void *pvNewArray;
+    size_t uNewCapacity;
+
+    if (*puCapacity == 0)
+        uNewCapacity = MIN_LOG_LENGTH;
+    else if (*puCapacity > (size_t)-1 / 2 / uEntrySize)
+        return 0;
+    else
+        uNewCapacity = *puCapacity * 2;
+
+    pvNewArray = realloc(*ppvArray, uNewCapacity * uEntrySize);
+    if (pvNewArray == NULL)
+        return 0;
+
+    *ppvArray = pvNewArray;
+    *puCapacity = uNewCapacity;
+    return 1;
+}
+
+/* Function that unlinks psNode from its bucket in oSymTable. Returns
+   that bucket. */
+static struct SymTableNode **SymTable_unlink(SymTable_T oSymTable,
+                                             struct SymTableNode *psNode)
+{
+    struct SymTableNode **ppsBucket;
+    struct SymTableNode **ppsLink;
+
+    assert(! oSymTable->integerKeys);
+
+    ppsBucket = SymTable_bucketFor(oSymTable,
+                                   SymTable_mix(psNode->pcKey));
+
+    for (ppsLink = ppsBucket;
+         *ppsLink != psNode;
+         ppsLink = &(*ppsLink)->psNextNode)
+        assert(*ppsLink != NULL);
+
+    *ppsLink = psNode->psNextNode;
+    return ppsBucket;
+}
+
+/* Function that sets the bits of a key whose SymTable_mix hash is
+   uMixed in puFilter, a filter of uBlockCount blocks. */
+static void SymTable_filterSet(uint32_t *puFilter, size_t uBlockCount,
+                               uint32_t uMixed)
+{
+    uint32_t *puBlock;
+    size_t u;
+
+    puBlock = puFilter + SymTable_reduce(uMixed, uBlockCount)
+                         * FILTER_BLOCK_WORDS;
+    for (u = 0; u < FILTER_BLOCK_WORDS; u++)
+        puBlock[u] |= (uint32_t)1 << ((uMixed * filterSalt[u]) >> 27);
+}
+
+/* Function that returns 1 if the filter of oSymTable shows that no key
+   whose SymTable_mix hash is uMixed is in oSymTable, counting the
+   search as rejected, or 0 if there is no filter or the key may be
+   there. */
+static int SymTable_filterExcludes(SymTable_T oSymTable, uint32_t uMixed)
+{
+    const uint32_t *puBlock;
+    uint32_t uMissing = 0;
+    size_t u;
+
+    if (oSymTable->filter == NULL)
+        return 0;
+
+    puBlock = oSymTable->filter
+              + SymTable_reduce(uMixed, oSymTable->filterBlockCount)
+                * FILTER_BLOCK_WORDS;
+    for (u = 0; u < FILTER_BLOCK_WORDS; u++)
+        uMissing |= ~puBlock[u]
+                    & ((uint32_t)1 << ((uMixed * filterSalt[u]) >> 27));
+
+    if (uMissing == 0)
+        return 0;
+    oSymTable->filterRejects += 1;
+    return 1;
+}
+
+/* Function that replaces the filter of oSymTable with a new one sized
+   for uCapacity keys, holding every key in oSymTable, shadowed or not.
+   Returns 1 if successful, or 0 if insufficient memory is available,
+   in which case the old filter is kept. */
+static int SymTable_buildFilter(SymTable_T oSymTable, size_t uCapacity)
+{
+    struct SymTableNode *psCurrentNode;
+    void *pvFilter;
+    uint32_t *puFilter;
+    size_t uBlockCount;
+    size_t bucketIndex;
+    size_t u;
+
+    if (uCapacity < MIN_FILTER_KEYS)
+        uCapacity = MIN_FILTER_KEYS;
+    if (uCapacity > (size_t)UINT32_MAX / FILTER_BITS_PER_KEY)
+        uCapacity = (size_t)UINT32_MAX / FILTER_BITS_PER_KEY;
+
+    uBlockCount = (uCapacity * FILTER_BITS_PER_KEY
+                   + FILTER_BLOCK_WORDS * 32 - 1)
+                  / (FILTER_BLOCK_WORDS * 32);
+    if (uBlockCount > (size_t)-1 / sizeof(uint32_t) / FILTER_BLOCK_WORDS)
+        return 0;
+
+    if (posix_memalign(&pvFilter, FILTER_ALIGNMENT,
+                       uBlockCount * FILTER_BLOCK_WORDS
+                       * sizeof(uint32_t)) != 0)
+        return 0;
+    puFilter = (uint32_t *)pvFilter;
+    memset(puFilter, 0, uBlockCount * FILTER_BLOCK_WORDS
+                        * sizeof(uint32_t));
+
+    SymTable_finishMigration(oSymTable);
+    for (bucketIndex = 0;
+         bucketIndex < oSymTable->bucketCount;
+         bucketIndex++)
+    {
+        for (psCurrentNode = oSymTable->buckets[bucketIndex];
+             psCurrentNode != NULL;
+             psCurrentNode = psCurrentNode->psNextNode)
+        {
+            SymTable_filterSet(puFilter, uBlockCount,
+                               SymTable_mix(psCurrentNode->pcKey));
+        }
+    }
+
+    /* Shadowed bindings are on no bucket, but come back later. */
+    for (u = 0; u < oSymTable->undoLength; u++)
+    {
+        if (oSymTable->undoLog[u].psShadowed != NULL)
+            SymTable_filterSet(puFilter, uBlockCount,
+                SymTable_mix(oSymTable->undoLog[u].psShadowed->pcKey));
+    }
+
+    free(oSymTable->filter);
+    oSymTable->filter = puFilter;
+    oSymTable->filterBlockCount = uBlockCount;
+    oSymTable->filterKeys = oSymTable->bindingCount
+                            + oSymTable->shadowedCount;
+    oSymTable->filterCapacity = uCapacity;
+    return 1;
+}
+
+/* Function that returns the log position of psNode, a node of
+   oSymTable, which must have opened a scope. */
+static size_t *SymTable_logPosition(SymTable_T oSymTable,
+                                    struct SymTableNode *psNode)
+{
+    assert(oSymTable->positionOffset != 0);
+    return (size_t *)(void *)((char *)psNode + oSymTable->positionOffset);
+}
+
+/* Function that returns the recency links of psNode, a node of a
+   cache. */
+static struct SymTableRecency *SymTable_recency(
+    struct SymTableNode *psNode)
+{
+    return (struct SymTableRecency *)(void *)((char *)psNode
+               + SymTable_roundUp(sizeof(struct SymTableNode)));
+}
+
+/* Function that makes psNode, a node of oSymTable that is not in its
+   recency list, the most recently used binding of oSymTable. */
+static void SymTable_pushNewest(SymTable_T oSymTable,
+                                struct SymTableNode *psNode)
+{
+    struct SymTableRecency *psLinks = SymTable_recency(psNode);
+
+    psLinks->psNewer = NULL;
+    psLinks->psOlder = oSymTable->psNewest;
+    if (oSymTable->psNewest != NULL)
+        SymTable_recency(oSymTable->psNewest)->psNewer = psNode;
+    else
+        oSymTable->psOldest = psNode;
+    oSymTable->psNewest = psNode;
+}
+
+/* Function that takes psNode out of the recency list of oSymTable. */
+static void SymTable_forget(SymTable_T oSymTable,
+                            struct SymTableNode *psNode)
+{
+    struct SymTableRecency *psLinks = SymTable_recency(psNode);
+
+    if (psLinks->psNewer != NULL)
+        SymTable_recency(psLinks->psNewer)->psOlder = psLinks->psOlder;
+    else
+        oSymTable->psNewest = psLinks->psOlder;
+
+    if (psLinks->psOlder != NULL)
+        SymTable_recency(psLinks->psOlder)->psNewer = psLinks->psNewer;
+    else
+        oSymTable->psOldest = psLinks->psNewer;
+}
+
+/* Function that makes psNode the most recently used binding of
+   oSymTable if oSymTable is a cache. */
+static void SymTable_touch(SymTable_T oSymTable,
+                           struct SymTableNode *psNode)
+{
+    if (oSymTable->maxBindings == 0 || oSymTable->psNewest == psNode)
+        return;
+
+    SymTable_forget(oSymTable, psNode);
+    SymTable_pushNewest(oSymTable, psNode);
+}
+
+/* Function that removes the least recently used binding of oSymTable,
+   a cache that is not empty, passing it to the eviction function
+   first. */
+static void SymTable_evict(SymTable_T oSymTable)
+{
+    struct SymTableNode *psNode = oSymTable->psOldest;
+
+    assert(psNode != NULL);
+
+    (void)SymTable_unlink(oSymTable, psNode);
+    SymTable_forget(oSymTable, psNode);
+    oSymTable->bindingCount -= 1;
+    oSymTable->evictionCount += 1;
+
+    if (oSymTable->pfEvict != NULL)
+        (*oSymTable->pfEvict)(psNode->pcKey, (void *)psNode->pvValue,
+                              (void *)oSymTable->pvEvictExtra);
+
+    SymTable_freeKey(psNode->pcKey);
+    SymTable_freeNode(oSymTable, psNode);
+}
+
+/* Function that returns the timer of psNode, a node of an expiring
+   table. */
+static struct SymTableTimer *SymTable_timer(struct SymTableNode *psNode)
+{
+    return (struct SymTableTimer *)(void *)((char *)psNode
+               + SymTable_roundUp(sizeof(struct SymTableNode)));
+}
+
+/* Function that files psNode, which is on no slot of psWheel, in the
+   slot its deadline belongs in, or in the overdue list if the wheel
+   has already passed it. */
+static void SymTable_schedule(struct SymTableWheel *psWheel,
+                              struct SymTableNode *psNode)
+{
+    struct SymTableTimer *psTimer = SymTable_timer(psNode);
+    uint64_t uDeadline = psTimer->deadline;
+    size_t uLevel;
+    size_t uSlot;
+
+    assert(psTimer->deadline != NO_DEADLINE);
+
+    if (uDeadline <= psWheel->now)
+        psTimer->slotIndex = OVERDUE_SLOT;
+    else
+    {
+        for (uLevel = 0; uLevel < WHEEL_LEVELS - 1; uLevel++)
+        {
+            if ((uDeadline >> (WHEEL_SLOT_BITS * (uLevel + 1))) ==
+                (psWheel->now >> (WHEEL_SLOT_BITS * (uLevel + 1))))
+                break;
+        }
+        uSlot = (size_t)(uDeadline >> (WHEEL_SLOT_BITS * uLevel))
+                & (WHEEL_SLOTS - 1);
+        psTimer->slotIndex = uLevel * WHEEL_SLOTS + uSlot;
+        psWheel->occupied[uLevel] |= (uint64_t)1 << uSlot;
+    }
+
+    psTimer->ppsPrevTimer = &psWheel->slots[psTimer->slotIndex];
+    psTimer->psNextTimer = psWheel->slots[psTimer->slotIndex];
+    if (psTimer->psNextTimer != NULL)
+        SymTable_timer(psTimer->psNextTimer)->ppsPrevTimer =
+            &psTimer->psNextTimer;
+    psWheel->slots[psTimer->slotIndex] = psNode;
+}
+
+/* Function that takes psNode off its slot of psWheel, if it is on
+   one. */
+static void SymTable_unschedule(struct SymTableWheel *psWheel,
+                                struct SymTableNode *psNode)
+{
+    struct SymTableTimer *psTimer = SymTable_timer(psNode);
+
+    if (psTimer->slotIndex == NOT_SCHEDULED)
+        return;
+
+    *psTimer->ppsPrevTimer = psTimer->psNextTimer;
+    if (psTimer->psNextTimer != NULL)
+        SymTable_timer(psTimer->psNextTimer)->ppsPrevTimer =
+            psTimer->ppsPrevTimer;
+    if (psTimer->slotIndex != OVERDUE_SLOT &&
+        psWheel->slots[psTimer->slotIndex] == NULL)
+        psWheel->occupied[psTimer->slotIndex / WHEEL_SLOTS] &=
+            ~((uint64_t)1 << (psTimer->slotIndex % WHEEL_SLOTS));
+    psTimer->slotIndex = NOT_SCHEDULED;
+}
+
+/* Function that moves every node in slot uIndex of psWheel onto the
+   list *ppsDue, linked through their timers, leaving the slot empty.
+   The caller clears the slot's occupancy bit. */
+static void SymTable_takeSlot(struct SymTableWheel *psWheel,
+                              size_t uIndex,
+                              struct SymTableNode **ppsDue)
+{
+    struct SymTableNode *psCurrentNode;
+    struct SymTableNode *psNextNode;
+    struct SymTableTimer *psTimer;
+
+    for (psCurrentNode = psWheel->slots[uIndex];
+         psCurrentNode != NULL;
+         psCurrentNode = psNextNode)
+    {
+        psTimer = SymTable_timer(psCurrentNode);
+        psNextNode = psTimer->psNextTimer;
+        psTimer->slotIndex = NOT_SCHEDULED;
+        psTimer->psNextTimer = *ppsDue;
+        *ppsDue = psCurrentNode;
+    }
+    psWheel->slots[uIndex] = NULL;
+}
+
+/* Function that returns 1 if psNode, a node of oSymTable, has a
+   deadline that has passed, or 0 otherwise. Only asks the clock for
+   bindings with a deadline. */
+static int SymTable_hasExpired(SymTable_T oSymTable,
+                               struct SymTableNode *psNode)
+{
+    uint64_t uDeadline;
+
+    if (oSymTable->psWheel == NULL)
+        return 0;
+
+    uDeadline = SymTable_timer(psNode)->deadline;
+    return uDeadline != NO_DEADLINE
+           && uDeadline <= (*oSymTable->psWheel->pfNow)();
+}
+
+/* Function that removes psNode, an expired binding of oSymTable, from
+   its bucket and the timer wheel, passing it to the expiry function
+   first. */
+static void SymTable_expire(SymTable_T oSymTable,
+                            struct SymTableNode *psNode)
+{
+    (void)SymTable_unlink(oSymTable, psNode);
+    SymTable_unschedule(oSymTable->psWheel, psNode);
+    oSymTable->bindingCount -= 1;
+    oSymTable->expiredCount += 1;
+
+    if (oSymTable->pfEvict != NULL)
+        (*oSymTable->pfEvict)(psNode->pcKey, (void *)psNode->pvValue,
+                              (void *)oSymTable->pvEvictExtra);
+
+    SymTable_freeKey(psNode->pcKey);
+    SymTable_freeNode(oSymTable, psNode);
+}
+
+SymTable_T SymTable_new(void)
+{
+    return SymTable_newWithCapacity(0);
+}
+
+SymTable_T SymTable_newInline(size_t uValueSize)
+{
+    SymTable_T oSymTable;
+    size_t uValueStride;
+
+    assert(uValueSize > 0);
+
+    uValueStride = SymTable_roundUp(uValueSize);
+    if (uValueStride == 0 || uValueStride > (size_t)-1
+        - SymTable_roundUp(sizeof(struct SymTableNode)))
+        return NULL;
+
+    oSymTable = SymTable_new();
+    if (oSymTable == NULL)
+        return NULL;
+
+    /* The table has no nodes yet, so every block is allocated at the
+       new size. */
+    oSymTable->valueSize = uValueSize;
+    oSymTable->nodeSize = SymTable_roundUp(sizeof(struct SymTableNode))
+                          + uValueStride;
+    return oSymTable;
+}
+
+SymTable_T SymTable_newCache(size_t uMaxBindings,
+                             void (*pfEvict)(const char *pcKey,
+                                             void *pvValue,
+                                             void *pvExtra),
+                             const void *pvExtra)
+{
+    SymTable_T oSymTable;
+
+    assert(uMaxBindings > 0);
+
+    oSymTable = SymTable_new();
+    if (oSymTable == NULL)
+        return NULL;
+
+    /* As with inline values, the table has no nodes yet, so every
+       block is allocated with room for the links. */
+    oSymTable->maxBindings = uMaxBindings;
+    oSymTable->pfEvict = pfEvict;
+    oSymTable->pvEvictExtra = pvExtra;
+    oSymTable->nodeSize = SymTable_roundUp(sizeof(struct SymTableNode))
+                          + sizeof(struct SymTableRecency);
+    return oSymTable;
+}
+
+SymTable_T SymTable_newExpiring(uint64_t (*pfNow)(void),
+                                void (*pfExpire)(const char *pcKey,
+                                                 void *pvValue,
+                                                 void *pvExtra),
+                                const void *pvExtra)
+{
+    SymTable_T oSymTable;
+    struct SymTableWheel *psWheel;
+
+    assert(pfNow != NULL);
+
+    psWheel = (struct SymTableWheel *)calloc(1,
+                  sizeof(struct SymTableWheel));
+    if (psWheel == NULL)
+        return NULL;
+
+    oSymTable = SymTable_new();
+    if (oSymTable == NULL)
+    {
+        free(psWheel);
+        return NULL;
+    }
+
+    psWheel->now = (*pfNow)();
+    psWheel->pfNow = pfNow;
+    oSymTable->psWheel = psWheel;
+    oSymTable->pfEvict = pfExpire;
+    oSymTable->pvEvictExtra = pvExtra;
+    oSymTable->nodeSize = SymTable_roundUp(sizeof(struct SymTableNode))
+                          + sizeof(struct SymTableTimer);
+    return oSymTable;
+}
+
+SymTable_T SymTable_newWithCapacity(size_t uCapacity)
+{
+    SymTable_T oSymTable;
+    size_t uIndex;
+
+    oSymTable = (SymTable_T)malloc(sizeof(struct SymTable));
+
+    if (oSymTable == NULL)
+        return NULL;
+
+    uIndex = SymTable_indexForCapacity(uCapacity);
+
+    oSymTable->hugePages = 0;
+    oSymTable->buckets = SymTable_allocBuckets(oSymTable,
+                                               bucketCount[uIndex]);
+
+    if (oSymTable->buckets == NULL)
+    {
+        free(oSymTable);
+        return NULL;
+    }
+
+    oSymTable->bucketCount = bucketCount[uIndex];
+    oSymTable->bindingCount = 0;
+    oSymTable->currentBucketIndex = uIndex;
+    oSymTable->minBucketIndex = uIndex;
+    oSymTable->psFreeNodes = NULL;
+    oSymTable->psBlocks = NULL;
+    oSymTable->psKeyBlocks = NULL;
+    oSymTable->nodeCount = 0;
+    oSymTable->reservedCount = uCapacity;
+    oSymTable->selfOrganizing = 0;
+    oSymTable->valueSize = 0;
+    oSymTable->nodeSize = sizeof(struct SymTableNode);
+    oSymTable->positionOffset = 0;
+    oSymTable->undoLog = NULL;
+    oSymTable->undoLength = 0;
+    oSymTable->undoCapacity = 0;
+    oSymTable->shadowedCount = 0;
+    oSymTable->scopeStarts = NULL;
+    oSymTable->scopeDepth = 0;
+    oSymTable->scopeCapacity = 0;
+    oSymTable->oldBuckets = NULL;
+    oSymTable->oldBucketCount = 0;
+    oSymTable->psResizer = NULL;
+    oSymTable->scheduledIndex = 0;
+    oSymTable->filter = NULL;
+    oSymTable->filterBlockCount = 0;
+    oSymTable->filterKeys = 0;
+    oSymTable->filterCapacity = 0;
+    oSymTable->filterRejects = 0;
+    oSymTable->filterFalsePositives = 0;
+    oSymTable->maxBindings = 0;
+    oSymTable->psNewest = NULL;
+    oSymTable->psOldest = NULL;
+    oSymTable->pfEvict = NULL;
+    oSymTable->pvEvictExtra = NULL;
+    oSymTable->evictionCount = 0;
+    oSymTable->psWheel = NULL;
+    oSymTable->expiredCount = 0;
+    oSymTable->integerKeys = 0;
+    oSymTable->autoCompact = 0;
+    oSymTable->releasedCount = 0;
+    oSymTable->releaseCheckCount = MIN_COMPACT_RELEASES;
+
+    if (uCapacity > 0 && ! SymTable_addBlock(oSymTable, uCapacity))
+    {
+        SymTable_freeLarge(oSymTable->buckets);
+        free(oSymTable);
+        return NULL;
+    }
+
+#ifdef SYMTABLE_TRACE
+    oSymTable->traceId = SymTableTrace_newTable();
+#endif
+
+    return oSymTable;
+}
+
+/* Function that grows the nodes and buckets of oSymTable to hold
+   uCapacity visible bindings without further allocation. Unlike
+   SymTable_reserve, it records no reservation, so the table may shrink
+   again as bindings are removed. Returns 1 if successful, or 0 if
+   insufficient memory is available. */
+static int SymTable_grow(SymTable_T oSymTable, size_t uCapacity)
+{
+    size_t uIndex;
+    size_t uNodes;
+
+    /* Grow the node pool first: if rehashing then fails, the extra
+       nodes simply wait on the free list. Shadowed bindings hold nodes
+       of their own. */
+    if (uCapacity > (size_t)-1 - oSymTable->shadowedCount)
+        return 0;
+    uNodes = uCapacity + oSymTable->shadowedCount;
+    if (uNodes > oSymTable->nodeCount)
+    {
+        if (! SymTable_addBlock(oSymTable,
+                                uNodes - oSymTable->nodeCount))
+            return 0;
+    }
+
+    uIndex = SymTable_indexForCapacity(uCapacity);
+    if (uIndex > oSymTable->currentBucketIndex)
+        return SymTable_rehash(oSymTable, uIndex);
+
+    return 1;
+}
+
+int SymTable_reserve(SymTable_T oSymTable, size_t uCapacity)
+{
+    size_t uIndex;
+
+    assert(oSymTable != NULL);
+
+    if (! SymTable_grow(oSymTable, uCapacity))
+        return 0;
+
+    if (uCapacity > oSymTable->reservedCount)
+        oSymTable->reservedCount = uCapacity;
+    uIndex = SymTable_indexForCapacity(uCapacity);
+    if (uIndex > oSymTable->minBucketIndex)
+        oSymTable->minBucketIndex = uIndex;
+
+    return 1;
+}
+
+void SymTable_shrinkToFit(SymTable_T oSymTable)
+{
+    size_t uIndex;
+
+    assert(oSymTable != NULL);
+
+    /* The scope arrays are returned only if no scope is open. */
+    if (oSymTable->scopeDepth == 0)
+    {
+        free(oSymTable->undoLog);
+        free(oSymTable->scopeStarts);
+        oSymTable->undoLog = NULL;
+        oSymTable->undoCapacity = 0;
+        oSymTable->scopeStarts = NULL;
+        oSymTable->scopeCapacity = 0;
+    }
+
+    oSymTable->minBucketIndex = 0;
+    oSymTable->reservedCount = 0;
+    uIndex = SymTable_indexForCapacity(oSymTable->bindingCount);
+    if (uIndex < oSymTable->currentBucketIndex)
+        (void)SymTable_rehash(oSymTable, uIndex);
+
+    /* Unused nodes, whether reserved or left over from a spike, go
+       back with the blocks they are in once the bindings have moved to
+       a block of their own. */
+    if (oSymTable->nodeCount > oSymTable->bindingCount
+                               + oSymTable->shadowedCount)
+        (void)SymTable_compact(oSymTable);
+
+    /* A rebuilt filter is sized for the bindings left and drops the
+       bits of removed keys. */
+    if (oSymTable->filter != NULL)
+        (void)SymTable_buildFilter(oSymTable, oSymTable->bindingCount
+                                   + oSymTable->shadowedCount);
+}
+
+void SymTable_setSelfOrganizing(SymTable_T oSymTable, int iEnabled)
+{
+    assert(oSymTable != NULL);
+    oSymTable->selfOrganizing = iEnabled;
+}
+
+void SymTable_free(SymTable_T oSymTable)
+{
+    struct SymTableNode *psCurrentNode;
+    struct SymTableBlock *psCurrentBlock;
+    struct SymTableBlock *psNextBlock;
+    struct SymTableKeyBlock *psKeyBlock;
+    struct SymTableKeyBlock *psNextKeyBlock;
+    size_t bucketIndex;
+    size_t u;
+
+    assert(oSymTable != NULL);
+
+    SYMTABLE_TRACE_OP(oSymTable, SYMTABLE_TRACE_FREE, NULL, 1);
+
+    if (oSymTable->psResizer != NULL)
+        SymTable_stopResizer(oSymTable);
+
+    for (bucketIndex = 0;
+         bucketIndex < oSymTable->bucketCount;
+         bucketIndex++)
+    {
+        for (psCurrentNode = oSymTable->buckets[bucketIndex];
+             psCurrentNode != NULL;
+             psCurrentNode = psCurrentNode->psNextNode)
+        {
+            SymTable_freeKey(psCurrentNode->pcKey);
+        }
+    }
+
+    /* Shadowed bindings are on no bucket. */
+    for (u = 0; u < oSymTable->undoLength; u++)
+    {
+        if (oSymTable->undoLog[u].psShadowed != NULL)
+            SymTable_freeKey(oSymTable->undoLog[u].psShadowed->pcKey);
+    }
+
+    for (psCurrentBlock = oSymTable->psBlocks;
+         psCurrentBlock != NULL;
+         psCurrentBlock = psNextBlock)
+    {
+        psNextBlock = psCurrentBlock->psNextBlock;
+        SymTable_freeLarge(psCurrentBlock);
+    }
+
+    for (psKeyBlock = oSymTable->psKeyBlocks;
+         psKeyBlock != NULL;
+         psKeyBlock = psNextKeyBlock)
+    {
+        psNextKeyBlock = psKeyBlock->psNextKeyBlock;
+        free(psKeyBlock);
+    }
+
+    free(oSymTable->undoLog);
+    free(oSymTable->scopeStarts);
+    free(oSymTable->filter);
+    free(oSymTable->psWheel);
+    SymTable_freeLarge(oSymTable->buckets);
+    free(oSymTable);
+}
+
+size_t SymTable_getLength(SymTable_T oSymTable)
+{
+    assert(oSymTable != NULL);
+    return oSymTable->bindingCount;
+}
+
+/* Function that searches the bucket *ppsBucket of oSymTable for
+   pcKey, whose SymTable_mix hash is uMixed, filling in *psSearch so
+   that SymTable_link can bind pcKey without searching again. An
+   expired binding of pcKey is expired on the way, as though it were
+   already gone. Returns the visible binding of pcKey, or NULL if there
+   is none. */
+static struct SymTableNode *SymTable_search(SymTable_T oSymTable,
+                                            const char *pcKey,
+                                            uint32_t uMixed,
+                                            struct SymTableNode **ppsBucket,
+                                            struct SymTableSearch *psSearch)
+{
+    struct SymTableNode *psCurrentNode;
+    struct SymTableNode *psPrevNode = NULL;
+    int iExcluded;
+
+    assert(! oSymTable->integerKeys);
+
+    psSearch->keyLength = strlen(pcKey);
+    psSearch->keyPrefix = SymTable_prefix(pcKey, psSearch->keyLength);
+    psSearch->ppsBucket = ppsBucket;
+    psSearch->psFound = NULL;
+    psSearch->psBeforeFound = NULL;
+
+    /* A key the filter rules out is bound nowhere, not even in an
+       outer scope, so there is nothing to search for. */
+    iExcluded = SymTable_filterExcludes(oSymTable, uMixed);
+    for (psCurrentNode = iExcluded ? NULL : *ppsBucket;
+         psCurrentNode != NULL;
+         psCurrentNode = psCurrentNode->psNextNode)
+    {
+        if (SymTable_matches(psCurrentNode, pcKey, psSearch->keyLength,
+                             psSearch->keyPrefix))
+        {
+            /* An expired binding makes way for the new one. Expiring
+               tables have no scopes, so nothing is shadowed. */
+            if (SymTable_hasExpired(oSymTable, psCurrentNode))
+            {
+                SymTable_expire(oSymTable, psCurrentNode);
+                break;
+            }
+            psSearch->psFound = psCurrentNode;
+            psSearch->psBeforeFound = psPrevNode;
+            return psCurrentNode;
+        }
+        psPrevNode = psCurrentNode;
+    }
+    if (oSymTable->filter != NULL && ! iExcluded)
+        oSymTable->filterFalsePositives += 1;
+
+    return NULL;
+}
+
+/* Function that returns 1 if a new binding may hide psNode, the
+   visible binding of its key in oSymTable, because a scope is open
+   and psNode was made outside it, or 0 otherwise. */
+static int SymTable_canShadow(SymTable_T oSymTable,
+                              struct SymTableNode *psNode)
+{
+    return oSymTable->scopeDepth > 0 &&
+           *SymTable_logPosition(oSymTable, psNode) <=
+           oSymTable->scopeStarts[oSymTable->scopeDepth - 1];
+}
+
+/* Function that adds a binding for pcKey, whose SymTable_mix hash is
+   uMixed, to oSymTable, where SymTable_search found, in *psSearch,
+   either no binding of pcKey or one that SymTable_canShadow says the
+   new binding may hide until its scope is popped. If ppcKeyStorage is
+   NULL the key is copied into memory of its own; otherwise it is
+   copied to *ppcKeyStorage, which is advanced past the copy. Returns
+   the new node, whose value the caller sets, or NULL if insufficient
+   memory is available. */
+static struct SymTableNode *SymTable_link(SymTable_T oSymTable,
+                                          const char *pcKey,
+                                          uint32_t uMixed,
+                                          const struct SymTableSearch
+                                              *psSearch,
+                                          char **ppcKeyStorage)
+{
+    char *keyCopy;
+    struct SymTableNode *psNewNode;
+    struct SymTableNode *psShadowed = psSearch->psFound;
+    struct SymTableNode **ppsBucket = psSearch->ppsBucket;
+    struct SymTableUndo *psUndo;
+    size_t uLength = psSearch->keyLength;
+
+    if (oSymTable->scopeDepth > 0 &&
+        oSymTable->undoLength == oSymTable->undoCapacity &&
+        ! SymTable_growArray((void **)&oSymTable->undoLog,
+                             &oSymTable->undoCapacity,
+                             sizeof(struct SymTableUndo)))
+        return NULL;
+
+    psNewNode = SymTable_allocNode(oSymTable);
+    if (psNewNode == NULL)
+        return NULL;
+
+    if (ppcKeyStorage == NULL)
+    {
+        keyCopy = SymTable_copyKey(pcKey, uLength);
+        if (keyCopy == NULL)
+        {
+            SymTable_freeNode(oSymTable, psNewNode);
+            return NULL;
+        }
+    }
+    else
+    {
+        keyCopy = *ppcKeyStorage + 1;
+        keyCopy[-1] = KEY_IN_BLOCK;
+        memcpy(keyCopy, pcKey, uLength + 1);
+        *ppcKeyStorage += uLength + 2;
+    }
+    psNewNode->pcKey = keyCopy;
+    psNewNode->keyLength = uLength;
+    psNewNode->keyPrefix = psSearch->keyPrefix;
+    if (oSymTable->positionOffset != 0)
+        *SymTable_logPosition(oSymTable, psNewNode) = 0;
+
+    if (oSymTable->psWheel != NULL)
+    {
+        SymTable_timer(psNewNode)->deadline = NO_DEADLINE;
+        SymTable_timer(psNewNode)->slotIndex = NOT_SCHEDULED;
+    }
+
+    /* A full cache makes room only once nothing else can fail. The
+       evicted node may share the bucket, which stays valid. */
+    if (oSymTable->maxBindings != 0)
+    {
+        if (oSymTable->bindingCount == oSymTable->maxBindings)
+            SymTable_evict(oSymTable);
+        SymTable_pushNewest(oSymTable, psNewNode);
+    }
+
+    /* A shadowed binding leaves its bucket, so lookups find only the
+       innermost one. */
+    if (psShadowed != NULL)
+    {
+        if (psSearch->psBeforeFound == NULL)
+            *ppsBucket = psShadowed->psNextNode;
+        else
+            psSearch->psBeforeFound->psNextNode = psShadowed->psNextNode;
+        oSymTable->shadowedCount += 1;
+    }
+    else
+        oSymTable->bindingCount += 1;
+
+    psNewNode->psNextNode = *ppsBucket;
+    *ppsBucket = psNewNode;
+
+    if (oSymTable->scopeDepth > 0)
+    {
+        psUndo = &oSymTable->undoLog[oSymTable->undoLength];
+        psUndo->psNode = psNewNode;
+        psUndo->psShadowed = psShadowed;
+        oSymTable->undoLength += 1;
+        *SymTable_logPosition(oSymTable, psNewNode) =
+            oSymTable->undoLength;
+    }
+
+    /* Past its capacity the filter lets more misses through, so it is
+       rebuilt at twice the size of the table. If that fails it keeps
+       working, only less well. */
+    if (oSymTable->filter != NULL)
+    {
+        SymTable_filterSet(oSymTable->filter,
+                           oSymTable->filterBlockCount, uMixed);
+        oSymTable->filterKeys += 1;
+        if (oSymTable->filterKeys > oSymTable->filterCapacity)
+            (void)SymTable_buildFilter(oSymTable,
+                                       2 * (oSymTable->bindingCount
+                                            + oSymTable->shadowedCount));
+    }
+
+    return psNewNode;
+}
+
+/* Function that adds a binding for pcKey, whose SymTable_mix hash is
+   uMixed and which belongs in bucket *ppsBucket, to oSymTable, as
+   SymTable_link does, if pcKey does not exist in oSymTable, or if a
+   scope is open and pcKey was bound outside it. Returns the new node,
+   whose value the caller sets, or NULL if the key already exists or
+   insufficient memory is available. */
+static struct SymTableNode *SymTable_insertAt(SymTable_T oSymTable,
+                                              const char *pcKey,
+                                              uint32_t uMixed,
+                                              struct SymTableNode **ppsBucket,
+                                              char **ppcKeyStorage)
+{
+    struct SymTableSearch sSearch;
+    struct SymTableNode *psFound;
+
+    psFound = SymTable_search(oSymTable, pcKey, uMixed, ppsBucket,
+                              &sSearch);
+    if (psFound != NULL && ! SymTable_canShadow(oSymTable, psFound))
+        return NULL;
+    return SymTable_link(oSymTable, pcKey, uMixed, &sSearch,
+                         ppcKeyStorage);
+}
+
+/* Function that gets oSymTable ready for one more binding: compacts it
+   if automatic compaction is due, ends a migration the worker has
+   finished, and grows the buckets if they are full, or lets the worker
+   grow them. Any bucket or node found before the call may have
+   moved. */
+static void SymTable_makeRoom(SymTable_T oSymTable)
+{
+    /* Once as many nodes have been freed as the table holds, the free
+       list has handed the live ones out all over the blocks. */
+    if (oSymTable->autoCompact &&
+        oSymTable->releasedCount >= MIN_COMPACT_RELEASES &&
+        oSymTable->releasedCount >= oSymTable->bindingCount
+                                    + oSymTable->shadowedCount)
+        (void)SymTable_compact(oSymTable);
+
+    if (oSymTable->oldBuckets != NULL)
+        SymTable_pollMigration(oSymTable);
+
+    if (oSymTable->psResizer != NULL)
+        SymTable_growInBackground(oSymTable);
+    else if (oSymTable->bindingCount > oSymTable->bucketCount) 
+    {
+        SymTable_expand(oSymTable);
+    }
+
+    /* Evicting from a full cache and rebuilding a full filter reach
+       past the one bucket that SymTable_link holds locked, so the
+       worker must be done first. */
+    if (oSymTable->oldBuckets != NULL &&
+        ((oSymTable->maxBindings != 0 &&
+          oSymTable->bindingCount >= oSymTable->maxBindings) ||
+         (oSymTable->filter != NULL &&
+          oSymTable->filterKeys >= oSymTable->filterCapacity)))
+        SymTable_finishMigration(oSymTable);
+}
+
+/* Function that adds a binding for pcKey to oSymTable as
+   SymTable_insertAt does, after making room for it. */
+static struct SymTableNode *SymTable_insert(SymTable_T oSymTable,
+                                            const char *pcKey)
+{
+    struct SymTableNode *psNewNode;
+    struct SymTableNode **ppsBucket;
+    pthread_mutex_t *psLock;
+    uint32_t uMixed;
+
+    SymTable_makeRoom(oSymTable);
+
+    uMixed = SymTable_mix(pcKey);
+    ppsBucket = SymTable_lockBucket(oSymTable, uMixed, &psLock);
+    psNewNode = SymTable_insertAt(oSymTable, pcKey, uMixed, ppsBucket,
+                                  NULL);
+    SymTable_unlockBucket(psLock);
+    return psNewNode;
+}
+
+int SymTable_put(SymTable_T oSymTable,
+                 const char *pcKey, const void *pvValue)
+{
+    struct SymTableNode *psNewNode;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    assert(oSymTable->valueSize == 0);
+
+    psNewNode = SymTable_insert(oSymTable, pcKey);
+    SYMTABLE_TRACE_OP(oSymTable, SYMTABLE_TRACE_PUT, pcKey,
+                      psNewNode != NULL);
+    if (psNewNode == NULL)
+        return 0;
+
+    psNewNode->pvValue = pvValue;
+    return 1;
+}
+
+int SymTable_putValue(SymTable_T oSymTable,
+                      const char *pcKey, const void *pvValue)
+{
+    struct SymTableNode *psNewNode;
+    void *pvStorage;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    assert(pvValue != NULL);
+    assert(oSymTable->valueSize > 0);
+
+    psNewNode = SymTable_insert(oSymTable, pcKey);
+    SYMTABLE_TRACE_OP(oSymTable, SYMTABLE_TRACE_PUT, pcKey,
+                      psNewNode != NULL);
+    if (psNewNode == NULL)
+        return 0;
+
+    /* The value follows the node in its block. */
+    pvStorage = (char *)psNewNode
+                + SymTable_roundUp(sizeof(struct SymTableNode));
+    memcpy(pvStorage, pvValue, oSymTable->valueSize);
+    psNewNode->pvValue = pvStorage;
+    return 1;
+}
+
+/* Function that replaces the value of the binding for pcKey in
+   oSymTable with pvValue, as SymTable_replace does. Returns the old
+   value, or NULL if pcKey is absent. */
+static void *SymTable_replaceBinding(SymTable_T oSymTable,
+                                     const char *pcKey,
+                                     const void *pvValue)
+{
+    struct SymTableNode *psCurrentNode;
+    void *oldValue;
+    struct SymTableNode **ppsBucket;
+    pthread_mutex_t *psLock;
+    uint32_t uMixed;
+    size_t uLength;
+    uint64_t uPrefix;
+
+    assert(! oSymTable->integerKeys);
+
+    if (oSymTable->oldBuckets != NULL)
+        SymTable_pollMigration(oSymTable);
+
+    uMixed = SymTable_mix(pcKey);
+    if (SymTable_filterExcludes(oSymTable, uMixed))
+        return NULL;
+
+    uLength = strlen(pcKey);
+    uPrefix = SymTable_prefix(pcKey, uLength);
+    ppsBucket = SymTable_lockBucket(oSymTable, uMixed, &psLock);
+
+    for (psCurrentNode = *ppsBucket;
+         psCurrentNode != NULL;
+         psCurrentNode = psCurrentNode->psNextNode)
+    {
+        if (SymTable_matches(psCurrentNode, pcKey, uLength, uPrefix))
+        {
+            if (SymTable_hasExpired(oSymTable, psCurrentNode))
+            {
+                SymTable_expire(oSymTable, psCurrentNode);
+                SymTable_unlockBucket(psLock);
+                return NULL;
+            }
+            oldValue = (void *)psCurrentNode->pvValue;
+            psCurrentNode->pvValue = pvValue;
+            SymTable_touch(oSymTable, psCurrentNode);
+            SymTable_unlockBucket(psLock);
+            return oldValue;
+        }
+    }
+    SymTable_unlockBucket(psLock);
+
+    if (oSymTable->filter != NULL)
+        oSymTable->filterFalsePositives += 1;
+    return NULL;
+}
+
+void *SymTable_replace(SymTable_T oSymTable,
+                       const char *pcKey, const void *pvValue)
+{
+    void *oldValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    assert(oSymTable->valueSize == 0);
+
+    oldValue = SymTable_replaceBinding(oSymTable, pcKey, pvValue);
+    SYMTABLE_TRACE_OP(oSymTable, SYMTABLE_TRACE_REPLACE, pcKey,
+                      oldValue != NULL);
+    return oldValue;
+}
+
+/* Function that finds the node holding pcKey in oSymTable. If the
+   table is self-organizing, moves the node to the front of its bucket,
+   and if it is a cache, makes the binding its most recently used.
+   Returns the node, or NULL if pcKey is absent. */
+static struct SymTableNode *SymTable_lookup(SymTable_T oSymTable,
+                                            const char *pcKey)
+{
+    struct SymTableNode *psCurrentNode;
+    struct SymTableNode *psPrevNode = NULL;
+    struct SymTableNode **ppsBucket;
+    pthread_mutex_t *psLock;
+    uint32_t uMixed;
+    size_t uLength;
+    uint64_t uPrefix;
+
+    assert(! oSymTable->integerKeys);
+
+    if (oSymTable->oldBuckets != NULL)
+        SymTable_pollMigration(oSymTable);
+
+    uMixed = SymTable_mix(pcKey);
+    if (SymTable_filterExcludes(oSymTable, uMixed))
+        return NULL;
+
+    uLength = strlen(pcKey);
+    uPrefix = SymTable_prefix(pcKey, uLength);
+    ppsBucket = SymTable_lockBucket(oSymTable, uMixed, &psLock);
+
+    for (psCurrentNode = *ppsBucket;
+         psCurrentNode != NULL;
+         psCurrentNode = psCurrentNode->psNextNode)
+    {
+        if (SymTable_matches(psCurrentNode, pcKey, uLength, uPrefix))
+        {
+            if (SymTable_hasExpired(oSymTable, psCurrentNode))
+            {
+                SymTable_expire(oSymTable, psCurrentNode);
+                SymTable_unlockBucket(psLock);
+                return NULL;
+            }
+            if (oSymTable->selfOrganizing && psPrevNode != NULL)
+            {
+                psPrevNode->psNextNode = psCurrentNode->psNextNode;
+                psCurrentNode->psNextNode = *ppsBucket;
+                *ppsBucket = psCurrentNode;
+            }
+            SymTable_touch(oSymTable, psCurrentNode);
+            SymTable_unlockBucket(psLock);
+            return psCurrentNode;
+        }
+        psPrevNode = psCurrentNode;
+    }
+    SymTable_unlockBucket(psLock);
+
+    if (oSymTable->filter != NULL)
+        oSymTable->filterFalsePositives += 1;
+    return NULL;
+}
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey)
+{
+    int iFound;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    iFound = SymTable_lookup(oSymTable, pcKey) != NULL;
+    SYMTABLE_TRACE_OP(oSymTable, SYMTABLE_TRACE_CONTAINS, pcKey, iFound);
+    return iFound;
+}
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey)
+{
+    struct SymTableNode *psNode;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    psNode = SymTable_lookup(oSymTable, pcKey);
+    SYMTABLE_TRACE_OP(oSymTable, SYMTABLE_TRACE_GET, pcKey,
+                      psNode != NULL && psNode->pvValue != NULL);
+    if (psNode == NULL)
+        return NULL;
+    return (void *)psNode->pvValue;
+}
+
+void *SymTable_getRef(SymTable_T oSymTable, const char *pcKey)
+{
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    assert(oSymTable->valueSize > 0);
+
+    /* An inline node's pvValue points at its own storage. */
+    return SymTable_get(oSymTable, pcKey);
+}
+
+/* Function that removes the binding for pcKey from oSymTable, as
+   SymTable_remove does. Returns its value, or NULL if pcKey is
+   absent. */
+static void *SymTable_removeBinding(SymTable_T oSymTable,
+                                    const char *pcKey)
+{
+    struct SymTableNode *psCurrentNode;
+    struct SymTableNode *psPrevNode = NULL;
+    struct SymTableNode *psShadowed = NULL;
+    struct SymTableUndo *psUndo;
+    void *pvValue;
+    struct SymTableNode **ppsBucket;
+    pthread_mutex_t *psLock;
+    uint32_t uMixed;
+    size_t uLength;
+    uint64_t uPrefix;
+
+    assert(! oSymTable->integerKeys);
+
+    if (oSymTable->oldBuckets != NULL)
+        SymTable_pollMigration(oSymTable);
+
+    uMixed = SymTable_mix(pcKey);
+    if (SymTable_filterExcludes(oSymTable, uMixed))
+        return NULL;
+
+    uLength = strlen(pcKey);
+    uPrefix = SymTable_prefix(pcKey, uLength);
+    ppsBucket = SymTable_lockBucket(oSymTable, uMixed, &psLock);
+
+    for (psCurrentNode = *ppsBucket;
+         psCurrentNode != NULL;
+         psCurrentNode = psCurrentNode->psNextNode)
+    {
+        if (SymTable_matches(psCurrentNode, pcKey, uLength, uPrefix))
+        {
+            if (SymTable_hasExpired(oSymTable, psCurrentNode))
+            {
+                SymTable_expire(oSymTable, psCurrentNode);
+                SymTable_unlockBucket(psLock);
+                return NULL;
+            }
+            pvValue = (void *)psCurrentNode->pvValue;
+
+            if (psPrevNode == NULL)
+            {
+                *ppsBucket = psCurrentNode->psNextNode;
+            }
+            else
+            {
+                psPrevNode->psNextNode = psCurrentNode->psNextNode;
+            }
+
+            /* Popping the scope must not touch the node again, and
+               whatever it shadowed comes back now. */
+            if (oSymTable->positionOffset != 0 &&
+                *SymTable_logPosition(oSymTable, psCurrentNode) != 0)
+            {
+                psUndo = &oSymTable->undoLog[
+                    *SymTable_logPosition(oSymTable, psCurrentNode) - 1];
+                psShadowed = psUndo->psShadowed;
+                psUndo->psNode = NULL;
+                psUndo->psShadowed = NULL;
+            }
+
+            if (oSymTable->maxBindings != 0)
+                SymTable_forget(oSymTable, psCurrentNode);
+            if (oSymTable->psWheel != NULL)
+                SymTable_unschedule(oSymTable->psWheel, psCurrentNode);
+            SymTable_freeKey(psCurrentNode->pcKey);
+            SymTable_freeNode(oSymTable, psCurrentNode);
+
+            if (psShadowed != NULL)
+            {
+                oSymTable->shadowedCount -= 1;
+                psShadowed->psNextNode = *ppsBucket;
+                *ppsBucket = psShadowed;
+                SymTable_unlockBucket(psLock);
+                return pvValue;
+            }
+            SymTable_unlockBucket(psLock);
+
+            oSymTable->bindingCount -= 1;
+            SymTable_contract(oSymTable);
+            return pvValue;
+        }
+        psPrevNode = psCurrentNode;
+    }
+    SymTable_unlockBucket(psLock);
+
+    if (oSymTable->filter != NULL)
+        oSymTable->filterFalsePositives += 1;
+    return NULL;
+}
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
+{
+    void *pvValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    pvValue = SymTable_removeBinding(oSymTable, pcKey);
+    SYMTABLE_TRACE_OP(oSymTable, SYMTABLE_TRACE_REMOVE, pcKey,
+                      pvValue != NULL);
+    return pvValue;
+}
+
+void SymTable_map(SymTable_T oSymTable,
+                  void (*pfApply)(const char *pcKey, void *pvValue,
+                                  void *pvExtra),
+                  const void *pvExtra)
+{
+    struct SymTableNode *psCurrentNode;
+    size_t bucketIndex;
+    uint64_t uNow = 0;
+
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+    assert(! oSymTable->integerKeys);
+
+    /* Expired bindings are skipped but left in place, since pfApply
+       may be iterating over them. */
+    if (oSymTable->psWheel != NULL)
+        uNow = (*oSymTable->psWheel->pfNow)();
+
+    SymTable_finishMigration(oSymTable);
+    for (bucketIndex = 0;
+         bucketIndex < oSymTable->bucketCount;
+         bucketIndex++)
+    {
+
+        for (psCurrentNode = oSymTable->buckets[bucketIndex];
+             psCurrentNode != NULL;
+             psCurrentNode = psCurrentNode->psNextNode)
+        {
+            if (oSymTable->psWheel != NULL &&
+                SymTable_timer(psCurrentNode)->deadline <= uNow)
+                continue;
+            (*pfApply)(psCurrentNode->pcKey,
+                       (void *)psCurrentNode->pvValue, (void *)pvExtra);
+        }
+    }
+
+    SYMTABLE_TRACE_OP(oSymTable, SYMTABLE_TRACE_MAP, NULL, 1);
+}
+
+/* Function that copies psNode, a node of oSymTable, to *ppcNodeStorage,
+   zeroing the rest of its uNodeSize bytes, and its key, with its tag,
+   to *ppcKeyStorage, advancing each past its copy, and frees the old
+   key. The psNextNode of psNode is left
+   pointing to the copy, so that links to psNode can be moved over.
+   Returns the copy. */
+static struct SymTableNode *SymTable_moveNode(SymTable_T oSymTable,
+                                              struct SymTableNode *psNode,
+                                              char **ppcNodeStorage,
+                                              char **ppcKeyStorage,
+                                              size_t uNodeSize)
+{
+    struct SymTableNode *psCopy;
+    char *pcKeyCopy;
+
+    psCopy = (struct SymTableNode *)(void *)*ppcNodeStorage;
+    memcpy(psCopy, psNode, oSymTable->nodeSize);
+    memset(*ppcNodeStorage + oSymTable->nodeSize, 0,
+           uNodeSize - oSymTable->nodeSize);
+    *ppcNodeStorage += uNodeSize;
+
+    if (oSymTable->valueSize > 0)
+        psCopy->pvValue = (char *)psCopy
+                          + SymTable_roundUp(sizeof(struct SymTableNode));
+
+    if (psNode->pcKey != NULL)
+    {
+        pcKeyCopy = *ppcKeyStorage + 1;
+        pcKeyCopy[-1] = KEY_IN_BLOCK;
+        memcpy(pcKeyCopy, psNode->pcKey, psNode->keyLength + 1);
+        psCopy->pcKey = pcKeyCopy;
+        *ppcKeyStorage += psNode->keyLength + 2;
+        SymTable_freeKey(psNode->pcKey);
+    }
+
+    psNode->psNextNode = psCopy;
+    return psCopy;
+}
+
+/* Function that returns the copy SymTable_moveNode made of psNode, or
+   NULL if psNode is NULL. */
+static struct SymTableNode *SymTable_forward(struct SymTableNode *psNode)
+{
+    if (psNode == NULL)
+        return NULL;
+    return psNode->psNextNode;
+}
+
+/* Function that points the recency links and timers of the uNodeCount
+   nodes of oSymTable that SymTable_compact copied to pcStorage, one
+   after another, at the
+   copies, instead of the nodes they were copied from. Each timer wheel
+   slot is rebuilt from the nodes filed in it; the order within a slot
+   does not matter. */
+static void SymTable_relinkCopies(SymTable_T oSymTable, char *pcStorage,
+                                  size_t uNodeCount)
+{
+    struct SymTableNode *psCopy;
+    struct SymTableRecency *psLinks;
+    struct SymTableTimer *psTimer;
+    struct SymTableWheel *psWheel = oSymTable->psWheel;
+    size_t u;
+
+    if (psWheel != NULL)
+        for (u = 0; u <= OVERDUE_SLOT; u++)
+            psWheel->slots[u] = NULL;
+
+    for (u = 0; u < uNodeCount; u++)
+    {
+        psCopy = (struct SymTableNode *)(void *)(pcStorage
+                     + u * oSymTable->nodeSize);
+
+        if (oSymTable->maxBindings != 0)
+        {
+            psLinks = SymTable_recency(psCopy);
+            psLinks->psNewer = SymTable_forward(psLinks->psNewer);
+            psLinks->psOlder = SymTable_forward(psLinks->psOlder);
+        }
+
+        if (psWheel != NULL)
+        {
+            psTimer = SymTable_timer(psCopy);
+            if (psTimer->slotIndex == NOT_SCHEDULED)
+                continue;
+            psTimer->ppsPrevTimer = &psWheel->slots[psTimer->slotIndex];
+            psTimer->psNextTimer = psWheel->slots[psTimer->slotIndex];
+            if (psTimer->psNextTimer != NULL)
+                SymTable_timer(psTimer->psNextTimer)->ppsPrevTimer =
+                    &psTimer->psNextTimer;
+            psWheel->slots[psTimer->slotIndex] = psCopy;
+        }
+    }
+
+    oSymTable->psNewest = SymTable_forward(oSymTable->psNewest);
+    oSymTable->psOldest = SymTable_forward(oSymTable->psOldest);
+}
+
+/* Function that moves every node of oSymTable that holds a binding,
+   shown or shadowed, into one new block, with their keys after them,
+   and frees the old blocks, as SymTable_compact does, but with the
+   copies uNodeSize bytes apart. uNodeSize must be at least
+   oSymTable->nodeSize, which it becomes, and the bytes each copy gains
+   are zeroed. Returns 1 if successful, or 0 if insufficient memory is
+   available, in which case oSymTable is unchanged. */
+static int SymTable_rebuildNodes(SymTable_T oSymTable, size_t uNodeSize)
+{
+    struct SymTableBlock *psBlock;
+    struct SymTableBlock *psCurrentBlock;
+    struct SymTableBlock *psNextBlock;
+    struct SymTableKeyBlock *psKeyBlock;
+    struct SymTableKeyBlock *psNextKeyBlock;
+    struct SymTableNode *psCurrentNode;
+    struct SymTableNode *psNextNode;
+    struct SymTableNode **ppsLink;
+    struct SymTableUndo *psUndo;
+    char *pcNodeStorage;
+    char *pcKeyStorage;
+    size_t uHeaderSize = SymTable_roundUp(sizeof(struct SymTableBlock));
+    size_t uKeyBytes = 0;
+    size_t uNodeCount = 0;
+    size_t uSize;
+    size_t bucketIndex;
+    size_t u;
+
+    assert(uNodeSize >= oSymTable->nodeSize);
+
+    SymTable_finishMigration(oSymTable);
+
+    /* Count every node on a bucket, and every shadowed one, which only
+       the undo log holds. Each key already fits in memory with its tag
+       and '\0', so only the sums can overflow. */
+    for (bucketIndex = 0;
+         bucketIndex < oSymTable->bucketCount;
+         bucketIndex++)
+    {
+        for (psCurrentNode = oSymTable->buckets[bucketIndex];
+             psCurrentNode != NULL;
+             psCurrentNode = psCurrentNode->psNextNode)
+        {
+            if (psCurrentNode->pcKey != NULL &&
+                psCurrentNode->keyLength + 2 > (size_t)-1 - uKeyBytes)
+                return 0;
+            if (psCurrentNode->pcKey != NULL)
+                uKeyBytes += psCurrentNode->keyLength + 2;
+            uNodeCount++;
+        }
+    }
+    for (u = 0; u < oSymTable->undoLength; u++)
+    {
+        psCurrentNode = oSymTable->undoLog[u].psShadowed;
+        if (psCurrentNode == NULL)
+            continue;
+        if (psCurrentNode->keyLength + 2 > (size_t)-1 - uKeyBytes)
+            return 0;
+        uKeyBytes += psCurrentNode->keyLength + 2;
+        uNodeCount++;
+    }
+
+    if (uNodeCount > ((size_t)-1 - uHeaderSize - uKeyBytes)
+                     / uNodeSize)
+        return 0;
+    uSize = uHeaderSize + uNodeCount * uNodeSize + uKeyBytes;
+    psBlock = (struct SymTableBlock *)SymTable_allocLarge(&uSize,
+                  oSymTable->hugePages, 0);
+    if (psBlock == NULL)
+        return 0;
+    psBlock->nodeCount = uNodeCount;
+    pcNodeStorage = (char *)psBlock + uHeaderSize;
+    pcKeyStorage = pcNodeStorage + uNodeCount * uNodeSize;
+
+    /* Nothing can fail from here on. Copy the chains in bucket order,
+       so that each chain is one run of nodes, and its keys one run of
+       keys. */
+    for (bucketIndex = 0;
+         bucketIndex < oSymTable->bucketCount;
+         bucketIndex++)
+    {
+        ppsLink = &oSymTable->buckets[bucketIndex];
+        for (psCurrentNode = *ppsLink;
+             psCurrentNode != NULL;
+             psCurrentNode = psNextNode)
+        {
+            psNextNode = psCurrentNode->psNextNode;
+            *ppsLink = SymTable_moveNode(oSymTable, psCurrentNode,
+                                         &pcNodeStorage, &pcKeyStorage,
+                                         uNodeSize);
+            ppsLink = &(*ppsLink)->psNextNode;
+        }
+    }
+    for (u = 0; u < oSymTable->undoLength; u++)
+    {
+        psUndo = &oSymTable->undoLog[u];
+        if (psUndo->psShadowed != NULL)
+            psUndo->psShadowed = SymTable_moveNode(oSymTable,
+                                                   psUndo->psShadowed,
+                                                   &pcNodeStorage,
+                                                   &pcKeyStorage,
+                                                   uNodeSize);
+    }
+
+    /* Every node is copied, so links to the old nodes can now be
+       followed to their copies. */
+    for (u = 0; u < oSymTable->undoLength; u++)
+        oSymTable->undoLog[u].psNode =
+            SymTable_forward(oSymTable->undoLog[u].psNode);
+    oSymTable->nodeSize = uNodeSize;
+    SymTable_relinkCopies(oSymTable, (char *)psBlock + uHeaderSize,
+                          uNodeCount);
+
+    /* The old blocks hold only unused nodes and old copies now, and
+       every key has been copied out of the key blocks. */
+    for (psCurrentBlock = oSymTable->psBlocks;
+         psCurrentBlock != NULL;
+         psCurrentBlock = psNextBlock)
+    {
+        psNextBlock = psCurrentBlock->psNextBlock;
+        SymTable_freeLarge(psCurrentBlock);
+    }
+    for (psKeyBlock = oSymTable->psKeyBlocks;
+         psKeyBlock != NULL;
+         psKeyBlock = psNextKeyBlock)
+    {
+        psNextKeyBlock = psKeyBlock->psNextKeyBlock;
+        free(psKeyBlock);
+    }
+
+    psBlock->psNextBlock = NULL;
+    oSymTable->psBlocks = psBlock;
+    oSymTable->psKeyBlocks = NULL;
+    oSymTable->psFreeNodes = NULL;
+    oSymTable->nodeCount = uNodeCount;
+    oSymTable->releasedCount = 0;
+    oSymTable->releaseCheckCount = MIN_COMPACT_RELEASES;
+    return 1;
+}
+
+int SymTable_pushScope(SymTable_T oSymTable)
+{
+    size_t uTrailerSize;
+
+    assert(oSymTable != NULL);
+    assert(oSymTable->maxBindings == 0);
+    assert(oSymTable->psWheel == NULL);
+    assert(! oSymTable->integerKeys);
+
+    /* Only a table that opens a scope pays for the log position, so the
+       first scope adds it to the end of every node. Nodes that follow
+       an inline value stay aligned for the next one. */
+    if (oSymTable->positionOffset == 0)
+    {
+        uTrailerSize = oSymTable->valueSize > 0
+                       ? SymTable_roundUp(sizeof(size_t))
+                       : sizeof(size_t);
+        if (oSymTable->nodeSize > (size_t)-1 - uTrailerSize)
+            return 0;
+        if (oSymTable->nodeCount == 0)
+            oSymTable->nodeSize += uTrailerSize;
+        else if (! SymTable_rebuildNodes(oSymTable,
+                                         oSymTable->nodeSize
+                                         + uTrailerSize))
+            return 0;
+        oSymTable->positionOffset = oSymTable->nodeSize - uTrailerSize;
+    }
+
+    if (oSymTable->scopeDepth == oSymTable->scopeCapacity &&
+        ! SymTable_growArray((void **)&oSymTable->scopeStarts,
+                             &oSymTable->scopeCapacity, sizeof(size_t)))
+        return 0;
+
+    oSymTable->scopeStarts[oSymTable->scopeDepth] =
+        oSymTable->undoLength;
+    oSymTable->scopeDepth += 1;
+    return 1;
+}
+
+void SymTable_popScope(SymTable_T oSymTable)
+{
+    struct SymTableUndo *psUndo;
+    struct SymTableNode **ppsBucket;
+    pthread_mutex_t *psLock;
+    size_t uStart;
+
+    assert(oSymTable != NULL);
+    assert(oSymTable->scopeDepth > 0);
+
+    oSymTable->scopeDepth -= 1;
+    uStart = oSymTable->scopeStarts[oSymTable->scopeDepth];
+
+    /* Undo the newest binding first, so that a key bound twice in
+       nested scopes gets its bindings back in order. */
+    while (oSymTable->undoLength > uStart)
+    {
+        oSymTable->undoLength -= 1;
+        psUndo = &oSymTable->undoLog[oSymTable->undoLength];
+        if (psUndo->psNode == NULL)
+            continue;
+
+        (void)SymTable_lockBucket(oSymTable,
+                                  SymTable_mix(psUndo->psNode->pcKey),
+                                  &psLock);
+        ppsBucket = SymTable_unlink(oSymTable, psUndo->psNode);
+        if (psUndo->psShadowed != NULL)
+        {
+            psUndo->psShadowed->psNextNode = *ppsBucket;
+            *ppsBucket = psUndo->psShadowed;
+            oSymTable->shadowedCount -= 1;
+        }
+        else
+            oSymTable->bindingCount -= 1;
+        SymTable_unlockBucket(psLock);
+
+        SymTable_freeKey(psUndo->psNode->pcKey);
+        SymTable_freeNode(oSymTable, psUndo->psNode);
+    }
+
+    SymTable_contract(oSymTable);
+}
+
+/* Function that binds each of the uCount keys of ppcKeys to the value
+   at the same index of ppvValues in oSymTable, as SymTable_put would.
+   A key that is already bound keeps its value unless iReplace, in
+   which case the value is replaced. Everything the batch needs is
+   allocated before the first binding is made: the buckets are sized
+   once, the nodes come from at most one new block, and the keys are
+   copied into one SymTableKeyBlock. The keys are then hashed in one
+   pass, which lets the hashes of different keys overlap in the CPU,
+   unless puHashes already holds their SymTable_mix hashes, and linked
+   in a second pass that prefetches the buckets a few keys ahead.
+   The batch reserves nothing, so the table shrinks as its bindings
+   are removed. Returns 1 if successful, or 0 if insufficient memory is
+   available, in which case oSymTable is unchanged. */
+static int SymTable_putMany(SymTable_T oSymTable,
+                            char *const ppcKeys[],
+                            void *const ppvValues[],
+                            const uint32_t puHashes[], size_t uCount,
+                            int iReplace)
+{
+    struct SymTableKeyBlock *psKeyBlock;
+    struct SymTableNode *psNode;
+    struct SymTableSearch sSearch;
+    uint32_t *puMixed = NULL;
+    const uint32_t *puKeyHashes = puHashes;
+    char *pcKeyStorage;
+    size_t uKeyBytes = 0;
+    size_t uLength;
+    size_t u;
+
+    if (uCount == 0)
+        return 1;
+    if (uCount > (size_t)-1 / sizeof(uint32_t) ||
+        uCount > (size_t)-1 - oSymTable->bindingCount)
+        return 0;
+
+    for (u = 0; u < uCount; u++)
+    {
+        assert(ppcKeys[u] != NULL);
+        uLength = strlen(ppcKeys[u]);
+        if (uLength > (size_t)-1 - 2 - uKeyBytes)
+            return 0;
+        uKeyBytes += uLength + 2;
+    }
+    if (uKeyBytes > (size_t)-1 - sizeof(struct SymTableKeyBlock))
+        return 0;
+
+    while (oSymTable->scopeDepth > 0 &&
+           uCount > oSymTable->undoCapacity - oSymTable->undoLength)
+    {
+        if (! SymTable_growArray((void **)&oSymTable->undoLog,
+                                 &oSymTable->undoCapacity,
+                                 sizeof(struct SymTableUndo)))
+            return 0;
+    }
+
+    if (puHashes == NULL)
+    {
+        puMixed = (uint32_t *)malloc(uCount * sizeof(uint32_t));
+        if (puMixed == NULL)
+            return 0;
+    }
+
+    psKeyBlock = (struct SymTableKeyBlock *)malloc(
+                     sizeof(struct SymTableKeyBlock) + uKeyBytes);
+    if (psKeyBlock == NULL)
+    {
+        free(puMixed);
+        return 0;
+    }
+
+    /* Once the nodes and buckets are reserved and any migration is
+       done, no binding can fail and nothing can move the buckets the
+       first pass picks. */
+    SymTable_finishMigration(oSymTable);
+    if (! SymTable_grow(oSymTable, oSymTable->bindingCount + uCount))
+    {
+        free(psKeyBlock);
+        free(puMixed);
+        return 0;
+    }
+
+    psKeyBlock->psNextKeyBlock = oSymTable->psKeyBlocks;
+    oSymTable->psKeyBlocks = psKeyBlock;
+    pcKeyStorage = (char *)(psKeyBlock + 1);
+
+    if (puMixed != NULL)
+    {
+        for (u = 0; u < uCount; u++)
+            puMixed[u] = SymTable_mix(ppcKeys[u]);
+        puKeyHashes = puMixed;
+    }
+
+    for (u = 0; u < uCount; u++)
+    {
+        if (u + PREFETCH_DISTANCE < uCount)
+            __builtin_prefetch(&oSymTable->buckets[SymTable_reduce(
+                puKeyHashes[u + PREFETCH_DISTANCE],
+                oSymTable->bucketCount)]);
+
+        /* A key that is already bound is replaced where the search
+           found it, without a second search. */
+        psNode = SymTable_search(oSymTable, ppcKeys[u], puKeyHashes[u],
+                                 &oSymTable->buckets[SymTable_reduce(
+                                     puKeyHashes[u],
+                                     oSymTable->bucketCount)],
+                                 &sSearch);
+        if (psNode != NULL && ! SymTable_canShadow(oSymTable, psNode))
+        {
+            if (iReplace)
+            {
+                psNode->pvValue = ppvValues[u];
+                SymTable_touch(oSymTable, psNode);
+            }
+            SYMTABLE_TRACE_OP(oSymTable,
+                              iReplace ? SYMTABLE_TRACE_REPLACE
+                                       : SYMTABLE_TRACE_PUT,
+                              ppcKeys[u], iReplace);
+            continue;
+        }
+
+        psNode = SymTable_link(oSymTable, ppcKeys[u], puKeyHashes[u],
+                               &sSearch, &pcKeyStorage);
+        SYMTABLE_TRACE_OP(oSymTable, SYMTABLE_TRACE_PUT, ppcKeys[u],
+                          psNode != NULL);
+        if (psNode != NULL)
+            psNode->pvValue = ppvValues[u];
+    }
 
-    /* tracks which index the bucketCount is at in order to dynamically
-       expand */
-    size_t currentBucketIndex;
-};
+    free(puMixed);
+    return 1;
+}
 
-/* Function that hashes pcKey based on uBucketCount. Returns the modulus
-   which equals which bucket it goes into. */
-static size_t SymTable_hash(const char *pcKey, size_t uBucketCount)
+int SymTable_putBatch(SymTable_T oSymTable, char *const ppcKeys[],
+                      void *const ppvValues[], size_t uCount)
 {
-    const size_t HASH_MULTIPLIER = 65599;
-    size_t u;
-    size_t uHash = 0;
+    assert(oSymTable != NULL);
+    assert(ppcKeys != NULL || uCount == 0);
+    assert(ppvValues != NULL || uCount == 0);
+    assert(oSymTable->valueSize == 0);
+    assert(oSymTable->maxBindings == 0);
+
+    return SymTable_putMany(oSymTable, ppcKeys, ppvValues, NULL, uCount,
+                            0);
+}
 
+uint32_t SymTable_hashKey(const char *pcKey)
+{
     assert(pcKey != NULL);
 
-    for (u = 0; pcKey[u] != '\0'; u++)
-        uHash = uHash * HASH_MULTIPLIER + (size_t)pcKey[u];
+    return SymTable_mix(pcKey);
+}
 
-    return uHash % uBucketCount;
+int SymTable_putBatchHashed(SymTable_T oSymTable, char *const ppcKeys[],
+                            void *const ppvValues[],
+                            const uint32_t puHashes[], size_t uCount)
+{
+    assert(oSymTable != NULL);
+    assert(ppcKeys != NULL || uCount == 0);
+    assert(ppvValues != NULL || uCount == 0);
+    assert(puHashes != NULL || uCount == 0);
+    assert(oSymTable->valueSize == 0);
+    assert(oSymTable->maxBindings == 0);
+
+    return SymTable_putMany(oSymTable, ppcKeys, ppvValues, puHashes,
+                            uCount, 0);
 }
 
-/* Function that takes oSymTable and expands the buckets in it if it
-   reaches the max bucket count, listed in bucketCount. Index zero is
-   what the starting number of buckets is, and each index after is what
-   it should expand to. Stops expanding after 65521 buckets. */
-static void SymTable_expand(SymTable_T oSymTable)
+int SymTable_merge(SymTable_T oDest, SymTable_T oSource,
+                   enum SymTableConflict eConflict)
 {
-    struct SymTableNode **moreBuckets;
     struct SymTableNode *psCurrentNode;
-    struct SymTableNode *psNextNode;
-    size_t oldBucketCount;
-    size_t newBucketCount;
-    size_t oldBucketIndex;
-    size_t newBucketIndex;
+    char **ppcKeys;
+    void **ppvValues;
+    size_t bucketIndex;
+    size_t u = 0;
+    int iSuccessful;
+
+    assert(oDest != NULL);
+    assert(oSource != NULL);
+    assert(oDest != oSource);
+    assert(oDest->valueSize == 0);
+    assert(oDest->maxBindings == 0);
+    assert(oSource->valueSize == 0);
+    assert(! oDest->integerKeys);
+    assert(! oSource->integerKeys);
+    assert(eConflict == SYMTABLE_KEEP_OLD ||
+           eConflict == SYMTABLE_REPLACE_OLD);
+
+    if (oSource->bindingCount == 0)
+        return 1;
+    SymTable_finishMigration(oSource);
+    if (oSource->bindingCount > (size_t)-1 / sizeof(char *))
+        return 0;
 
-    if (oSymTable->bucketCount == MAX_BUCKET_COUNT)
+    ppcKeys = (char **)malloc(oSource->bindingCount * sizeof(char *));
+    if (ppcKeys == NULL)
+        return 0;
+    ppvValues = (void **)malloc(oSource->bindingCount * sizeof(void *));
+    if (ppvValues == NULL)
     {
-        return;
+        free(ppcKeys);
+        return 0;
     }
 
-    oSymTable->currentBucketIndex++;
-    oldBucketCount = oSymTable->bucketCount;
-    newBucketCount = bucketCount[oSymTable->currentBucketIndex];
-    oSymTable->bucketCount = newBucketCount; 
-    
-    moreBuckets = (struct SymTableNode **)calloc(newBucketCount, 
-                                        sizeof(struct SymTableNode *));
-    if (moreBuckets == NULL)
-        return; 
-
-    /* Rehashes nodes from old buckets into the new buckets */
-    for (oldBucketIndex = 0; 
-         oldBucketIndex < oldBucketCount; 
-         oldBucketIndex++)
+    for (bucketIndex = 0;
+         bucketIndex < oSource->bucketCount;
+         bucketIndex++)
     {
-        for (psCurrentNode = oSymTable->buckets[oldBucketIndex]; 
-             psCurrentNode != NULL; 
-             psCurrentNode = psNextNode)
+        for (psCurrentNode = oSource->buckets[bucketIndex];
+             psCurrentNode != NULL;
+             psCurrentNode = psCurrentNode->psNextNode)
         {
-            psNextNode = psCurrentNode->psNextNode;
-
-            newBucketIndex = SymTable_hash(psCurrentNode->pcKey, 
-                                                        newBucketCount);
-
-            psCurrentNode->psNextNode = moreBuckets[newBucketIndex];
-            moreBuckets[newBucketIndex] = psCurrentNode;
+            ppcKeys[u] = (char *)psCurrentNode->pcKey;
+            ppvValues[u] = (void *)psCurrentNode->pvValue;
+            u++;
         }
     }
+    assert(u == oSource->bindingCount);
 
-    free(oSymTable->buckets);
+    iSuccessful = SymTable_putMany(oDest, ppcKeys, ppvValues, NULL, u,
+                                   eConflict == SYMTABLE_REPLACE_OLD);
 
-    oSymTable->buckets = moreBuckets;
+    free(ppvValues);
+    free(ppcKeys);
+    return iSuccessful;
 }
 
-SymTable_T SymTable_new(void)
+int SymTable_setBackgroundResize(SymTable_T oSymTable, int iEnabled)
 {
-    SymTable_T oSymTable;
+    struct SymTableResizer *psResizer;
+    size_t u;
 
-    oSymTable = (SymTable_T)malloc(sizeof(struct SymTable));
+    assert(oSymTable != NULL);
 
-    if (oSymTable == NULL)
-        return NULL;
+    if (! iEnabled)
+    {
+        /* A migration in progress is finished first. */
+        if (oSymTable->psResizer != NULL)
+            SymTable_stopResizer(oSymTable);
+        return 1;
+    }
 
-    oSymTable->buckets = (struct SymTableNode **)calloc(bucketCount[0],
-                          sizeof(struct SymTableNode *));
+    if (oSymTable->psResizer != NULL)
+        return 1;
 
-    if (oSymTable->buckets == NULL)
+    psResizer = (struct SymTableResizer *)malloc(
+                    sizeof(struct SymTableResizer));
+    if (psResizer == NULL)
+        return 0;
+
+    psResizer->requestedIndex = 0;
+    psResizer->isReady = 0;
+    psResizer->preparedBuckets = NULL;
+    psResizer->preparedIndex = 0;
+    psResizer->mustMigrate = 0;
+    psResizer->isMigrated = 0;
+    psResizer->oldBuckets = NULL;
+    psResizer->oldBucketCount = 0;
+    psResizer->newBuckets = NULL;
+    psResizer->newBucketCount = 0;
+    psResizer->isStopping = 0;
+    psResizer->hugePages = 0;
+    psResizer->integerKeys = oSymTable->integerKeys;
+
+    /* Default mutexes cannot fail to initialize on Linux, so only the
+       thread is checked. */
+    for (u = 0; u < LOCK_STRIPES; u++)
     {
-        free(oSymTable);
-        return NULL;
+        pthread_mutex_init(&psResizer->oldLocks[u], NULL);
+        pthread_mutex_init(&psResizer->newLocks[u], NULL);
     }
+    pthread_mutex_init(&psResizer->mutex, NULL);
+    pthread_cond_init(&psResizer->wakeUp, NULL);
+    pthread_cond_init(&psResizer->migrated, NULL);
 
-    oSymTable->bucketCount = bucketCount[0];
-    oSymTable->bindingCount = 0;
-    oSymTable->currentBucketIndex = 0;
+    if (pthread_create(&psResizer->thread, NULL,
+                       SymTable_resizeWorker, psResizer) != 0)
+    {
+        for (u = 0; u < LOCK_STRIPES; u++)
+        {
+            pthread_mutex_destroy(&psResizer->oldLocks[u]);
+            pthread_mutex_destroy(&psResizer->newLocks[u]);
+        }
+        pthread_cond_destroy(&psResizer->migrated);
+        pthread_cond_destroy(&psResizer->wakeUp);
+        pthread_mutex_destroy(&psResizer->mutex);
+        free(psResizer);
+        return 0;
+    }
 
-    return oSymTable;
+    oSymTable->psResizer = psResizer;
+    return 1;
 }
 
-void SymTable_free(SymTable_T oSymTable)
+int SymTable_setFilter(SymTable_T oSymTable, int iEnabled)
 {
-    struct SymTableNode *psCurrentNode;
-    struct SymTableNode *psNextNode;
-    size_t bucketIndex;
-
     assert(oSymTable != NULL);
+    assert(! oSymTable->integerKeys);
 
-    for (bucketIndex = 0;
-         bucketIndex < oSymTable->bucketCount;
-         bucketIndex++)
+    if (! iEnabled)
     {
-        for (psCurrentNode = oSymTable->buckets[bucketIndex];
-             psCurrentNode != NULL;
-             psCurrentNode = psNextNode)
-        {
-            psNextNode = psCurrentNode->psNextNode;
-            free((void *)psCurrentNode->pcKey);
-            free(psCurrentNode);
-        }
+        free(oSymTable->filter);
+        oSymTable->filter = NULL;
+        oSymTable->filterBlockCount = 0;
+        oSymTable->filterKeys = 0;
+        oSymTable->filterCapacity = 0;
+        return 1;
     }
-    free(oSymTable->buckets);
-    free(oSymTable);
+
+    if (oSymTable->filter != NULL)
+        return 1;
+
+    if (! SymTable_buildFilter(oSymTable,
+                               2 * (oSymTable->bindingCount
+                                    + oSymTable->shadowedCount)))
+        return 0;
+    oSymTable->filterRejects = 0;
+    oSymTable->filterFalsePositives = 0;
+    return 1;
 }
 
-size_t SymTable_getLength(SymTable_T oSymTable)
+int SymTable_compact(SymTable_T oSymTable)
 {
     assert(oSymTable != NULL);
-    return oSymTable->bindingCount;
+
+    return SymTable_rebuildNodes(oSymTable, oSymTable->nodeSize);
 }
 
-int SymTable_put(SymTable_T oSymTable,
-                 const char *pcKey, const void *pvValue)
+void SymTable_setAutoCompact(SymTable_T oSymTable, int iEnabled)
 {
-    char *keyCopy;
-    struct SymTableNode *psNewNode;
-    struct SymTableNode *psCurrentNode;
-    size_t bucketIndex;
+    assert(oSymTable != NULL);
+    oSymTable->autoCompact = iEnabled;
+}
 
+void SymTable_setHugePages(SymTable_T oSymTable, int iEnabled)
+{
     assert(oSymTable != NULL);
-    assert(pcKey != NULL);
+    oSymTable->hugePages = iEnabled;
+}
 
-    if (oSymTable->bindingCount > oSymTable->bucketCount) 
-    {
-        SymTable_expand(oSymTable);
-    }
+void SymTable_getStats(SymTable_T oSymTable,
+                       struct SymTableStats *psStats)
+{
+    size_t uMisses;
 
-    /* find which bucket by hashing key */
-    bucketIndex = SymTable_hash(pcKey, oSymTable->bucketCount);
+    assert(oSymTable != NULL);
+    assert(psStats != NULL);
+
+    psStats->length = oSymTable->bindingCount;
+    psStats->bucketCount = oSymTable->bucketCount;
+    psStats->nodeCount = oSymTable->nodeCount;
+    psStats->filterBytes = oSymTable->filterBlockCount
+                           * FILTER_BLOCK_WORDS * sizeof(uint32_t);
+    psStats->filterRejects = oSymTable->filterRejects;
+    psStats->filterFalsePositives = oSymTable->filterFalsePositives;
+    psStats->evictionCount = oSymTable->evictionCount;
+    psStats->expiredCount = oSymTable->expiredCount;
+
+    uMisses = oSymTable->filterRejects
+              + oSymTable->filterFalsePositives;
+    psStats->filterFalsePositiveRate =
+        uMisses == 0 ? 0.0
+                     : (double)oSymTable->filterFalsePositives
+                       / (double)uMisses;
+}
 
-    for (psCurrentNode = oSymTable->buckets[bucketIndex];
-         psCurrentNode != NULL;
-         psCurrentNode = psCurrentNode->psNextNode)
-    {
-        if (strcmp(psCurrentNode->pcKey, pcKey) == 0)
-        {
-            return 0;
-        }
-    }
+int SymTable_putWithTTL(SymTable_T oSymTable, const char *pcKey,
+                        const void *pvValue, uint64_t uTTL)
+{
+    struct SymTableNode *psNewNode;
+    struct SymTableTimer *psTimer;
+    uint64_t uNow;
 
-    psNewNode = (struct SymTableNode *)malloc(sizeof(struct
-                                                     SymTableNode));
-    if (psNewNode == NULL)
-        return 0;
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    assert(oSymTable->psWheel != NULL);
 
-    keyCopy = (char *)malloc(strlen(pcKey) + 1);
-    if (keyCopy == NULL)
-    {
-        free(psNewNode);
+    psNewNode = SymTable_insert(oSymTable, pcKey);
+    SYMTABLE_TRACE_OP(oSymTable, SYMTABLE_TRACE_PUT, pcKey,
+                      psNewNode != NULL);
+    if (psNewNode == NULL)
         return 0;
-    }
 
-    strcpy(keyCopy, pcKey);
-    psNewNode->pcKey = keyCopy;
     psNewNode->pvValue = pvValue;
 
-    psNewNode->psNextNode = oSymTable->buckets[bucketIndex];
-    oSymTable->buckets[bucketIndex] = psNewNode;
-    oSymTable->bindingCount += 1;
-
+    uNow = (*oSymTable->psWheel->pfNow)();
+    psTimer = SymTable_timer(psNewNode);
+    psTimer->deadline = uTTL < NO_DEADLINE - uNow ? uNow + uTTL
+                                                  : NO_DEADLINE - 1;
+    SymTable_schedule(oSymTable->psWheel, psNewNode);
     return 1;
 }
 
-void *SymTable_replace(SymTable_T oSymTable,
-                       const char *pcKey, const void *pvValue)
+size_t SymTable_expireDue(SymTable_T oSymTable, uint64_t uNow)
 {
+    struct SymTableWheel *psWheel;
+    struct SymTableNode *psDue = NULL;
     struct SymTableNode *psCurrentNode;
-    void *oldValue;
-    size_t bucketIndex;
+    struct SymTableNode *psNextNode;
+    pthread_mutex_t *psLock;
+    uint64_t uFirst;
+    uint64_t uLast;
+    uint64_t uMask;
+    uint64_t uRun;
+    size_t uStart;
+    size_t uLevel;
+    size_t uSlot;
+    size_t uExpired = 0;
 
     assert(oSymTable != NULL);
-    assert(pcKey != NULL);
+    assert(oSymTable->psWheel != NULL);
+
+    psWheel = oSymTable->psWheel;
+    SymTable_takeSlot(psWheel, OVERDUE_SLOT, &psDue);
+
+    /* Take every node off the slots the wheel passes on its way to
+       uNow: at each level, those from just after the wheel's time up
+       to uNow, all of them if that is a full turn. Once a level does
+       not move, neither do those above it. */
+    for (uLevel = 0; uLevel < WHEEL_LEVELS && uNow > psWheel->now;
+         uLevel++)
+    {
+        uFirst = (psWheel->now >> (WHEEL_SLOT_BITS * uLevel)) + 1;
+        uLast = uNow >> (WHEEL_SLOT_BITS * uLevel);
+        if (uLast < uFirst)
+            break;
+
+        if (uLast - uFirst >= WHEEL_SLOTS - 1)
+            uMask = ~(uint64_t)0;
+        else
+        {
+            uRun = ((uint64_t)1 << (uLast - uFirst + 1)) - 1;
+            uStart = (size_t)(uFirst & (WHEEL_SLOTS - 1));
+            uMask = uStart == 0 ? uRun
+                                : (uRun << uStart)
+                                  | (uRun >> (WHEEL_SLOTS - uStart));
+        }
+        uMask &= psWheel->occupied[uLevel];
+        psWheel->occupied[uLevel] &= ~uMask;
 
-    bucketIndex = SymTable_hash(pcKey, oSymTable->bucketCount);
+        while (uMask != 0)
+        {
+            uSlot = (size_t)__builtin_ctzll(uMask);
+            uMask &= uMask - 1;
+            SymTable_takeSlot(psWheel, uLevel * WHEEL_SLOTS + uSlot,
+                              &psDue);
+        }
+    }
 
-    for (psCurrentNode = oSymTable->buckets[bucketIndex];
+    /* The nodes that are due go; the rest are filed again, closer to
+       the bottom of the wheel. */
+    if (uNow > psWheel->now)
+        psWheel->now = uNow;
+    for (psCurrentNode = psDue;
          psCurrentNode != NULL;
-         psCurrentNode = psCurrentNode->psNextNode)
+         psCurrentNode = psNextNode)
     {
-        if (strcmp(psCurrentNode->pcKey, pcKey) == 0)
+        psNextNode = SymTable_timer(psCurrentNode)->psNextTimer;
+        if (SymTable_timer(psCurrentNode)->deadline <= uNow)
         {
-            oldValue = (void *)psCurrentNode->pvValue;
-            psCurrentNode->pvValue = pvValue;
-            return oldValue;
+            (void)SymTable_lockBucket(oSymTable,
+                                      SymTable_mix(psCurrentNode->pcKey),
+                                      &psLock);
+            SymTable_expire(oSymTable, psCurrentNode);
+            SymTable_unlockBucket(psLock);
+            uExpired++;
         }
+        else
+            SymTable_schedule(psWheel, psCurrentNode);
     }
 
-    return NULL;
+    SymTable_contract(oSymTable);
+    return uExpired;
 }
 
-int SymTable_contains(SymTable_T oSymTable, const char *pcKey)
+SymTable_T SymTable_newCounter(void)
+{
+    return SymTable_newInline(sizeof(int64_t));
+}
+
+/* Function that returns the node holding pcKey, whose SymTable_mix
+   hash is uMixed, in oSymTable, or NULL if pcKey is absent. Changes
+   nothing, not even the order of the bucket, so that
+   SymTable_incrementAtomic can call it from many threads at once. */
+static struct SymTableNode *SymTable_find(SymTable_T oSymTable,
+                                          const char *pcKey,
+                                          uint32_t uMixed)
 {
     struct SymTableNode *psCurrentNode;
-    size_t bucketIndex;
+    pthread_mutex_t *psLock;
+    size_t uLength;
+    uint64_t uPrefix;
+
+    uLength = strlen(pcKey);
+    uPrefix = SymTable_prefix(pcKey, uLength);
+
+    for (psCurrentNode = *SymTable_lockBucket(oSymTable, uMixed, &psLock);
+         psCurrentNode != NULL;
+         psCurrentNode = psCurrentNode->psNextNode)
+    {
+        if (SymTable_matches(psCurrentNode, pcKey, uLength, uPrefix))
+            break;
+    }
+    SymTable_unlockBucket(psLock);
+
+    return psCurrentNode;
+}
+
+int SymTable_increment(SymTable_T oSymTable, const char *pcKey,
+                       int64_t iDelta)
+{
+    struct SymTableNode *psNode;
+    struct SymTableSearch sSearch;
+    struct SymTableNode **ppsBucket;
+    pthread_mutex_t *psLock;
+    uint32_t uMixed;
 
     assert(oSymTable != NULL);
     assert(pcKey != NULL);
+    assert(oSymTable->valueSize == sizeof(int64_t));
 
-    bucketIndex = SymTable_hash(pcKey, oSymTable->bucketCount);
+    if (oSymTable->oldBuckets != NULL)
+        SymTable_pollMigration(oSymTable);
 
-    for (psCurrentNode = oSymTable->buckets[bucketIndex];
-         psCurrentNode != NULL;
-         psCurrentNode = psCurrentNode->psNextNode)
+    uMixed = SymTable_mix(pcKey);
+    ppsBucket = SymTable_lockBucket(oSymTable, uMixed, &psLock);
+    psNode = SymTable_search(oSymTable, pcKey, uMixed, ppsBucket,
+                             &sSearch);
+    SymTable_unlockBucket(psLock);
+    if (psNode != NULL)
     {
-        if (strcmp(psCurrentNode->pcKey, pcKey) == 0)
-            return 1;
+        *(int64_t *)(void *)psNode->pvValue += iDelta;
+        SYMTABLE_TRACE_OP(oSymTable, SYMTABLE_TRACE_REPLACE, pcKey, 1);
+        return 1;
     }
 
-    return 0;
+    /* Only a new key makes room. Growing may move the buckets, but the
+       search found nothing to keep, so it need only find the bucket
+       again, which takes no search. */
+    SymTable_makeRoom(oSymTable);
+    sSearch.ppsBucket = SymTable_lockBucket(oSymTable, uMixed, &psLock);
+    psNode = SymTable_link(oSymTable, pcKey, uMixed, &sSearch, NULL);
+    SymTable_unlockBucket(psLock);
+    SYMTABLE_TRACE_OP(oSymTable, SYMTABLE_TRACE_PUT, pcKey,
+                      psNode != NULL);
+    if (psNode == NULL)
+        return 0;
+
+    psNode->pvValue = (char *)psNode
+                      + SymTable_roundUp(sizeof(struct SymTableNode));
+    memcpy((void *)psNode->pvValue, &iDelta, sizeof(int64_t));
+    return 1;
 }
 
-void *SymTable_get(SymTable_T oSymTable, const char *pcKey)
+int SymTable_incrementAtomic(SymTable_T oSymTable, const char *pcKey,
+                             int64_t iDelta)
 {
-    struct SymTableNode *psCurrentNode;
-    size_t bucketIndex;
+    struct SymTableNode *psNode;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    assert(oSymTable->valueSize == sizeof(int64_t));
+
+    psNode = SymTable_find(oSymTable, pcKey, SymTable_mix(pcKey));
+    SYMTABLE_TRACE_OP(oSymTable, SYMTABLE_TRACE_REPLACE, pcKey,
+                      psNode != NULL);
+    if (psNode == NULL)
+        return 0;
+
+    (void)__atomic_add_fetch((int64_t *)(void *)psNode->pvValue, iDelta,
+                             __ATOMIC_RELAXED);
+    return 1;
+}
+
+int64_t SymTable_getCount(SymTable_T oSymTable, const char *pcKey)
+{
+    int64_t *piCount;
 
     assert(oSymTable != NULL);
     assert(pcKey != NULL);
+    assert(oSymTable->valueSize == sizeof(int64_t));
 
-    bucketIndex = SymTable_hash(pcKey, oSymTable->bucketCount);
+    piCount = (int64_t *)SymTable_get(oSymTable, pcKey);
+    if (piCount == NULL)
+        return 0;
+    return *piCount;
+}
+
+SymTable_T SymTable_newU64(void)
+{
+    SymTable_T oSymTable;
+
+    oSymTable = SymTable_new();
+    if (oSymTable == NULL)
+        return NULL;
+
+    oSymTable->integerKeys = 1;
+    return oSymTable;
+}
+
+int SymTable_putU64(SymTable_T oSymTable, uint64_t uKey,
+                    const void *pvValue)
+{
+    struct SymTableNode *psCurrentNode;
+    struct SymTableNode *psNewNode;
+    struct SymTableNode **ppsBucket;
+    pthread_mutex_t *psLock;
+
+    assert(oSymTable != NULL);
+    assert(oSymTable->integerKeys);
+
+    SymTable_makeRoom(oSymTable);
 
-    for (psCurrentNode = oSymTable->buckets[bucketIndex];
+    ppsBucket = SymTable_lockBucket(oSymTable, SymTable_mixU64(uKey),
+                                    &psLock);
+    for (psCurrentNode = *ppsBucket;
          psCurrentNode != NULL;
          psCurrentNode = psCurrentNode->psNextNode)
     {
-        if (strcmp(psCurrentNode->pcKey, pcKey) == 0)
-            return (void *)psCurrentNode->pvValue;
+        if (psCurrentNode->keyPrefix == uKey)
+        {
+            SymTable_unlockBucket(psLock);
+            return 0;
+        }
     }
 
-    return NULL;
+    psNewNode = SymTable_allocNode(oSymTable);
+    if (psNewNode == NULL)
+    {
+        SymTable_unlockBucket(psLock);
+        return 0;
+    }
+
+    /* The key is the node's own, so there is nothing to copy. */
+    psNewNode->pcKey = NULL;
+    psNewNode->pvValue = pvValue;
+    psNewNode->keyLength = 0;
+    psNewNode->keyPrefix = uKey;
+    psNewNode->psNextNode = *ppsBucket;
+    *ppsBucket = psNewNode;
+    SymTable_unlockBucket(psLock);
+
+    oSymTable->bindingCount += 1;
+    return 1;
 }
 
-void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
+void *SymTable_getU64(SymTable_T oSymTable, uint64_t uKey)
 {
     struct SymTableNode *psCurrentNode;
     struct SymTableNode *psPrevNode = NULL;
-    void *pvValue;
-    size_t bucketIndex;
+    struct SymTableNode **ppsBucket;
+    pthread_mutex_t *psLock;
+    void *pvValue = NULL;
 
     assert(oSymTable != NULL);
-    assert(pcKey != NULL);
+    assert(oSymTable->integerKeys);
 
-    bucketIndex = SymTable_hash(pcKey, oSymTable->bucketCount);
+    if (oSymTable->oldBuckets != NULL)
+        SymTable_pollMigration(oSymTable);
 
-    for (psCurrentNode = oSymTable->buckets[bucketIndex];
+    ppsBucket = SymTable_lockBucket(oSymTable, SymTable_mixU64(uKey),
+                                    &psLock);
+    for (psCurrentNode = *ppsBucket;
          psCurrentNode != NULL;
          psCurrentNode = psCurrentNode->psNextNode)
     {
-        if (strcmp(psCurrentNode->pcKey, pcKey) == 0)
+        if (psCurrentNode->keyPrefix == uKey)
         {
-            pvValue = (void *)psCurrentNode->pvValue;
-
-            if (psPrevNode == NULL)
-            {
-                oSymTable->buckets[bucketIndex] = 
-                                            psCurrentNode->psNextNode;
-            }
-            else
+            if (oSymTable->selfOrganizing && psPrevNode != NULL)
             {
                 psPrevNode->psNextNode = psCurrentNode->psNextNode;
+                psCurrentNode->psNextNode = *ppsBucket;
+                *ppsBucket = psCurrentNode;
             }
+            pvValue = (void *)psCurrentNode->pvValue;
+            break;
+        }
+        psPrevNode = psCurrentNode;
+    }
+    SymTable_unlockBucket(psLock);
+
+    return pvValue;
+}
+
+void *SymTable_removeU64(SymTable_T oSymTable, uint64_t uKey)
+{
+    struct SymTableNode *psCurrentNode;
+    struct SymTableNode **ppsLink;
+    pthread_mutex_t *psLock;
+    void *pvValue;
+
+    assert(oSymTable != NULL);
+    assert(oSymTable->integerKeys);
+
+    if (oSymTable->oldBuckets != NULL)
+        SymTable_pollMigration(oSymTable);
 
-            free((void *)psCurrentNode->pcKey);
-            free(psCurrentNode);
+    for (ppsLink = SymTable_lockBucket(oSymTable, SymTable_mixU64(uKey),
+                                       &psLock);
+         *ppsLink != NULL;
+         ppsLink = &(*ppsLink)->psNextNode)
+    {
+        psCurrentNode = *ppsLink;
+        if (psCurrentNode->keyPrefix == uKey)
+        {
+            pvValue = (void *)psCurrentNode->pvValue;
+            *ppsLink = psCurrentNode->psNextNode;
+            SymTable_unlockBucket(psLock);
+            SymTable_freeNode(oSymTable, psCurrentNode);
 
             oSymTable->bindingCount -= 1;
+            SymTable_contract(oSymTable);
             return pvValue;
         }
-        psPrevNode = psCurrentNode;
     }
+    SymTable_unlockBucket(psLock);
 
     return NULL;
 }
 
-void SymTable_map(SymTable_T oSymTable,
-                  void (*pfApply)(const char *pcKey, void *pvValue,
-                                  void *pvExtra),
-                  const void *pvExtra)
+void SymTable_mapU64(SymTable_T oSymTable,
+                     void (*pfApply)(uint64_t uKey, void *pvValue,
+                                     void *pvExtra),
+                     const void *pvExtra)
 {
     struct SymTableNode *psCurrentNode;
     size_t bucketIndex;
 
     assert(oSymTable != NULL);
+    assert(oSymTable->integerKeys);
     assert(pfApply != NULL);
 
+    SymTable_finishMigration(oSymTable);
     for (bucketIndex = 0;
          bucketIndex < oSymTable->bucketCount;
          bucketIndex++)
     {
-
         for (psCurrentNode = oSymTable->buckets[bucketIndex];
              psCurrentNode != NULL;
              psCurrentNode = psCurrentNode->psNextNode)
         {
-            (*pfApply)(psCurrentNode->pcKey,
+            (*pfApply)(psCurrentNode->keyPrefix,
                        (void *)psCurrentNode->pvValue, (void *)pvExtra);
         }
     }
@@ -0,0 +1,329 @@
+/*--------------------------------------------------------------------*/
+/* symtablehash.h                                                     */
+/* Author: Ryan Chen                                                  */
+/*--------------------------------------------------------------------*/
+
+#ifndef symtablehash
+#define symtablehash
+#include "symtable.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Operations that only the hash table implementation in symtablehash.c
+   provides, on top of those in symtable.h. */
+
+/* Compiled with SYMTABLE_TRACE defined, symtablehash.c traces tables
+   as symtabletrace.h describes. It records the operations of
+   symtable.h as they are called, and those here as the operations they
+   are made of. SymTable_putValue, SymTable_putWithTTL and each key of
+   SymTable_putBatch or SymTable_merge record a put, SymTable_getRef
+   and SymTable_getCount a get, and changing a value already bound, by
+   SymTable_increment, SymTable_incrementAtomic, SymTable_putBatch or
+   SymTable_merge, a replace. Operations on integer keys are not
+   recorded. */
+
+/* Return a new SymTable_T object whose values are uValueSize bytes
+   each, copied into the table beside their keys instead of being
+   pointed to, or NULL if insufficient memory is available. uValueSize
+   must be positive. Bind values with SymTable_putValue, not
+   SymTable_put or SymTable_replace. SymTable_get, SymTable_remove and
+   SymTable_map give the address of the value inside the table; the
+   address SymTable_remove returns stays valid until the next binding is
+   added or the first scope is opened. */
+SymTable_T SymTable_newInline(size_t uValueSize);
+
+/* Adds pcKey to oSymTable, a table from SymTable_newInline, bound to a
+   copy of the value that pvValue points to, if pcKey doesn't exist in
+   oSymTable. Otherwise, leaves oSymTable unchanged. Returns 1 if
+   successful, 0 if the key already exists or insufficient memory is
+   available. */
+int SymTable_putValue(SymTable_T oSymTable,
+     const char *pcKey, const void *pvValue);
+
+/* Returns the address of the value bound to pcKey in oSymTable, a
+   table from SymTable_newInline, through which the value can be read
+   or updated in place, or NULL if the key does not exist. The address
+   stays valid until pcKey is removed, oSymTable is compacted or shrunk
+   to fit, its first scope is opened, or oSymTable is freed. */
+void *SymTable_getRef(SymTable_T oSymTable, const char *pcKey);
+
+/* Return a new SymTable_T object whose values are int64_t counts held
+   inline, as from SymTable_newInline(sizeof(int64_t)), or NULL if
+   insufficient memory is available. */
+SymTable_T SymTable_newCounter(void);
+
+/* Adds iDelta to the count bound to pcKey in oSymTable, a table from
+   SymTable_newCounter, binding pcKey to iDelta if it does not exist.
+   Hashes pcKey once and searches for it once, whether or not it
+   exists. Returns 1 if successful, or 0 if insufficient memory is
+   available. */
+int SymTable_increment(SymTable_T oSymTable, const char *pcKey,
+     int64_t iDelta);
+
+/* Adds iDelta to the count bound to pcKey in oSymTable, a table from
+   SymTable_newCounter, with a single atomic addition, if pcKey exists.
+   Otherwise, leaves oSymTable unchanged. Changes nothing else about
+   oSymTable, so any number of threads may call it at once on the same
+   table, provided no thread calls anything else on the table
+   meanwhile; bind the keys beforehand. Returns 1 if pcKey exists, or 0
+   otherwise. */
+int SymTable_incrementAtomic(SymTable_T oSymTable, const char *pcKey,
+     int64_t iDelta);
+
+/* Returns the count bound to pcKey in oSymTable, a table from
+   SymTable_newCounter, or 0 if the key does not exist. */
+int64_t SymTable_getCount(SymTable_T oSymTable, const char *pcKey);
+
+/* Return a new SymTable_T object whose keys are uint64_t integers
+   rather than strings, or NULL if insufficient memory is available.
+   Keys are held in the table's nodes, with no copy, hashed with one
+   multiply and shift, and compared as integers. Use the table only
+   with SymTable_putU64, SymTable_getU64, SymTable_removeU64,
+   SymTable_mapU64, and those functions of symtable.h and this file
+   that take no key, except SymTable_map, SymTable_merge,
+   SymTable_pushScope and SymTable_setFilter. */
+SymTable_T SymTable_newU64(void);
+
+/* Adds uKey to oSymTable, a table from SymTable_newU64, bound to
+   pvValue, if uKey doesn't exist in oSymTable. Otherwise, leaves
+   oSymTable unchanged. Returns 1 if successful, 0 if the key already
+   exists or insufficient memory is available. */
+int SymTable_putU64(SymTable_T oSymTable, uint64_t uKey,
+     const void *pvValue);
+
+/* Returns the value bound to uKey in oSymTable, a table from
+   SymTable_newU64, or NULL if the key does not exist. */
+void *SymTable_getU64(SymTable_T oSymTable, uint64_t uKey);
+
+/* Removes the binding of uKey from oSymTable, a table from
+   SymTable_newU64, and returns its value, or returns NULL if the key
+   does not exist. */
+void *SymTable_removeU64(SymTable_T oSymTable, uint64_t uKey);
+
+/* Applies the function *pfApply to each binding in oSymTable, a table
+   from SymTable_newU64, passing pvExtra as an extra parameter. */
+void SymTable_mapU64(SymTable_T oSymTable,
+     void (*pfApply)(uint64_t uKey, void *pvValue, void *pvExtra),
+     const void *pvExtra);
+
+/* Return a new SymTable_T object that holds at most uMaxBindings
+   bindings, or NULL if insufficient memory is available. uMaxBindings
+   must be positive. The table keeps its bindings in order of use:
+   binding a key, and finding or replacing it with SymTable_contains,
+   SymTable_get or SymTable_replace, makes it the most recently used.
+   When a new key is bound to a full table, the least recently used
+   binding is removed first, in constant time, and passed to pfEvict
+   along with pvExtra unless pfEvict is NULL. pfEvict must not use the
+   table. Evicted and removed bindings give their memory back to the
+   table, so it stays bounded however many keys pass through.
+   SymTable_free evicts nothing. The table may not be used with
+   SymTable_pushScope, SymTable_putBatch, or as the destination of
+   SymTable_merge. */
+SymTable_T SymTable_newCache(size_t uMaxBindings,
+     void (*pfEvict)(const char *pcKey, void *pvValue, void *pvExtra),
+     const void *pvExtra);
+
+/* Return a new SymTable_T object whose bindings may expire, or NULL
+   if insufficient memory is available. pfNow returns the current time,
+   in whatever unit the client measures time-to-live in, and must never
+   go backwards. Bindings made with SymTable_putWithTTL expire once
+   pfNow reaches their deadline; those made any other way never do. An
+   expired binding is removed the next time a search finds it, or by
+   SymTable_expireDue, whichever comes first, and is passed to pfExpire
+   along with pvExtra unless pfExpire is NULL. pfExpire must not use
+   the table. Until then it still counts in SymTable_getLength, but
+   every other operation acts as though it were gone. The table may not
+   be used with SymTable_pushScope. */
+SymTable_T SymTable_newExpiring(uint64_t (*pfNow)(void),
+     void (*pfExpire)(const char *pcKey, void *pvValue, void *pvExtra),
+     const void *pvExtra);
+
+/* Adds pcKey to oSymTable, a table from SymTable_newExpiring, bound to
+   pvValue until uTTL after the current time, if pcKey doesn't exist in
+   oSymTable. Otherwise, leaves oSymTable unchanged. Returns 1 if
+   successful, 0 if the key already exists or insufficient memory is
+   available. */
+int SymTable_putWithTTL(SymTable_T oSymTable, const char *pcKey,
+     const void *pvValue, uint64_t uTTL);
+
+/* Removes every binding of oSymTable, a table from
+   SymTable_newExpiring, whose deadline is at or before uNow, passing
+   each to the expiry function. The bindings wait on a hierarchical
+   timer wheel, so this only visits those that are due and, now and
+   then, a few whose deadline is near enough to move down the wheel.
+   Returns the number of bindings removed. */
+size_t SymTable_expireDue(SymTable_T oSymTable, uint64_t uNow);
+
+/* Opens a new innermost scope in oSymTable. Until it is popped,
+   SymTable_put and SymTable_putValue may bind a key that was bound
+   outside the scope; the new binding hides the old one, which comes
+   back when the scope is popped. Binding a key twice in one scope
+   still fails. Lookups see only the innermost binding of each key and
+   cost the same at any depth. SymTable_getLength and SymTable_map
+   count and visit only visible bindings. SymTable_replace changes the
+   visible binding in whatever scope it was made, and SymTable_remove
+   deletes it for good, bringing back any binding it hid. The first
+   scope ever opened in oSymTable gives each binding room to record
+   the scope it was made in, compacting oSymTable if it has any, as
+   SymTable_compact does. Returns 1 if successful, or 0 if insufficient
+   memory is available, in which case oSymTable is unchanged. */
+int SymTable_pushScope(SymTable_T oSymTable);
+
+/* Closes the innermost scope of oSymTable, removing every binding made
+   in it that is still there and bringing back the bindings they hid.
+   Takes time proportional to the number of bindings made in the
+   scope. At least one scope must be open. */
+void SymTable_popScope(SymTable_T oSymTable);
+
+/* Binds each of the uCount keys of ppcKeys to the value at the same
+   index of ppvValues in oSymTable, as uCount calls of SymTable_put
+   would, skipping keys that are already bound. oSymTable must not be
+   from SymTable_newInline. All the memory the batch needs is
+   allocated at once, and the keys are copied into a single block that
+   is only released when oSymTable is freed, so keys removed later do
+   not give their bytes back. Returns 1 if successful, or 0 if
+   insufficient memory is available, in which case oSymTable is
+   unchanged. */
+int SymTable_putBatch(SymTable_T oSymTable, char *const ppcKeys[],
+     void *const ppvValues[], size_t uCount);
+
+/* Returns the hash of pcKey that SymTable_putBatchHashed takes. It
+   depends only on the characters of pcKey, so any thread may compute
+   it. */
+uint32_t SymTable_hashKey(const char *pcKey);
+
+/* Does what SymTable_putBatch does, but takes the SymTable_hashKey
+   hash of each key of ppcKeys at the same index of puHashes instead of
+   computing it, so that a client can hash a large batch in parallel
+   before binding it. */
+int SymTable_putBatchHashed(SymTable_T oSymTable, char *const ppcKeys[],
+     void *const ppvValues[], const uint32_t puHashes[], size_t uCount);
+
+/* Turns background resizing of oSymTable on if iEnabled, or off
+   otherwise. When it is on, a put that finds the buckets getting full
+   only asks a worker thread for a bigger array. The worker allocates
+   it, the table switches to it, and the worker then moves the bindings
+   over while the table goes on being used, so no put pays for a
+   rehash. While the worker is moving bindings, each operation locks
+   the one bucket it uses; otherwise nothing is locked. oSymTable is still used from one thread at a time, apart
+   from the worker. An operation that visits every binding, or evicts
+   or rebuilds the filter, first waits for the worker to finish moving
+   them. Turning it off waits likewise. Returns 1 if successful, or 0
+   if the worker could not be started. */
+int SymTable_setBackgroundResize(SymTable_T oSymTable, int iEnabled);
+
+/* Turns the lookup filter of oSymTable on if iEnabled, or off
+   otherwise. The filter is a blocked Bloom filter over the hashes of
+   the keys in oSymTable, at 8 to 16 bits per key, that rules out most
+   keys that are not bound after reading one cache line, without
+   walking their bucket. Every search consults it: SymTable_contains,
+   SymTable_get, SymTable_replace, SymTable_remove, and the check for
+   an existing key when binding one. A removed key keeps its bits until
+   the filter is next rebuilt, which happens whenever it has taken in
+   as many keys as it was sized for, and in SymTable_shrinkToFit.
+   Turning the filter on resets its counts in SymTable_getStats.
+   Returns 1 if successful, or 0 if insufficient memory is
+   available. */
+int SymTable_setFilter(SymTable_T oSymTable, int iEnabled);
+
+/* Moves every binding of oSymTable into one new block of memory, the
+   nodes in bucket order, and in chain order within each bucket, with
+   their keys after them in the same order, then frees the blocks the
+   bindings came from, unused nodes and all. After a long run of puts
+   and removes has scattered the bindings, this makes each chain, and
+   SymTable_map, a walk through adjacent memory. Keys and inline values
+   move, so keys that SymTable_map passed out, and addresses of inline
+   values from SymTable_get and SymTable_getRef, are no longer valid.
+   SymTable_shrinkToFit and opening the first scope of oSymTable
+   compact it too. Removing bindings never does; once more than eight
+   unused nodes are left to each binding or reserved one, it frees only
+   the blocks of nodes that hold no binding, unless oSymTable holds its
+   values inline. Returns 1 if successful, or 0 if insufficient
+   memory is available, in which case oSymTable is unchanged. */
+int SymTable_compact(SymTable_T oSymTable);
+
+/* Turns automatic compaction of oSymTable on if iEnabled, or off
+   otherwise. When it is on, adding a binding first calls
+   SymTable_compact if at least 1024 nodes, and at least as many as
+   oSymTable has bindings, have been freed since it was last compacted.
+   It is off by default, since it moves keys and inline values whose
+   addresses a client may still hold. */
+void SymTable_setAutoCompact(SymTable_T oSymTable, int iEnabled);
+
+/* Turns huge pages for oSymTable on if iEnabled, or off otherwise.
+   While they are on, each bucket array and each block of nodes that
+   fills at least one 2 MB page is allocated, from then on, in 2 MB
+   huge pages, so that a table of millions of bindings takes far fewer
+   TLB entries to cover. Pages from the kernel's reserved pool are used
+   if any are left, or else transparent huge pages, which the kernel
+   backs with huge pages when it can. Where neither is available the
+   memory comes from malloc as usual. Memory already allocated stays
+   where it is, so turn them on before the table grows; afterwards,
+   SymTable_compact moves the nodes, and the next resize the
+   buckets. */
+void SymTable_setHugePages(SymTable_T oSymTable, int iEnabled);
+
+/* Statistics about a SymTable_T object */
+struct SymTableStats
+{
+    /* number of visible bindings */
+    size_t length;
+
+    /* number of buckets */
+    size_t bucketCount;
+
+    /* number of nodes allocated, used or not */
+    size_t nodeCount;
+
+    /* size of the lookup filter, or 0 if there is none */
+    size_t filterBytes;
+
+    /* number of searches the filter answered on its own */
+    size_t filterRejects;
+
+    /* number of searches the filter let through that found nothing */
+    size_t filterFalsePositives;
+
+    /* filterFalsePositives as a fraction of all searches for keys that
+       were not bound, or 0 if there were none */
+    double filterFalsePositiveRate;
+
+    /* number of bindings evicted from a table from SymTable_newCache */
+    size_t evictionCount;
+
+    /* number of bindings expired from a table from
+       SymTable_newExpiring */
+    size_t expiredCount;
+};
+
+/* Fills in *psStats with statistics about oSymTable. */
+void SymTable_getStats(SymTable_T oSymTable,
+     struct SymTableStats *psStats);
+
+/* What SymTable_merge does with a key bound in both tables */
+enum SymTableConflict
+{
+    /* keep the value bound in the destination */
+    SYMTABLE_KEEP_OLD,
+
+    /* replace it with the value bound in the source */
+    SYMTABLE_REPLACE_OLD
+};
+
+/* Adds every visible binding of oSource to oDest, as SymTable_putBatch
+   would, resolving keys bound in both as eConflict says. oSource is
+   unchanged. Neither table may be from SymTable_newInline, and they
+   must be different tables. Returns 1 if successful, or 0 if
+   insufficient memory is available, in which case oDest is
+   unchanged. */
+int SymTable_merge(SymTable_T oDest, SymTable_T oSource,
+     enum SymTableConflict eConflict);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
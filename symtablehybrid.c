@@ -0,0 +1,643 @@
+/*--------------------------------------------------------------------*/
+/* symtablehybrid.c                                                   */
+/* Author: Ryan Chen                                                  */
+/*--------------------------------------------------------------------*/
+
+#include "symtable.h"
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include <stdint.h>
+
+/* Most bindings a SymTable keeps in its small array before it moves
+   them into a hash table */
+enum {SMALL_MAX = 16};
+
+/* A hash table moves its bindings back into the small array once it
+   holds no more than DEMOTE_COUNT of them. Keeping this well below
+   SMALL_MAX stops a table that hovers around SMALL_MAX from migrating
+   on every put and remove. */
+static const size_t DEMOTE_COUNT = 8;
+
+/* Fewest slots the hash table ever has. Must be a power of two. */
+static const size_t MIN_SLOT_COUNT = 32;
+
+/* The hash table grows once more than MAX_LOAD_TENTHS tenths of its
+   slots are full. */
+static const size_t MAX_LOAD_TENTHS = 9;
+
+/* The hash table shrinks once it has more than SHRINK_DIVISOR slots
+   per binding. */
+static const size_t SHRINK_DIVISOR = 8;
+
+/* Each SymTableSlot stores one binding of the hash table inline, along
+   with the full hash of its key. */
+struct SymTableSlot
+{
+    /* the key, or NULL if the slot is empty */
+    const char *pcKey;
+
+    /* the value */
+    const void *pvValue;
+
+    /* the hash of the key */
+    size_t uHash;
+};
+
+/* SymTable starts as a small array of bindings that is searched
+   linearly, which needs no hashing and no bucket array. Past SMALL_MAX
+   bindings it moves them into a Robin Hood hash table, and it moves
+   them back once the table drains. */
+struct SymTable
+{
+    /* the keys of the small array */
+    const char *smallKeys[SMALL_MAX];
+
+    /* the values of the small array */
+    const void *smallValues[SMALL_MAX];
+
+    /* the first character of each key of the small array, compared
+       before the key itself is read */
+    char smallFirsts[SMALL_MAX];
+
+    /* the slots of the hash table, or NULL while the array is used */
+    struct SymTableSlot *slots;
+
+    /* number of slots, always a power of two */
+    size_t slotCount;
+
+    /* total number of bindings in the SymTable */
+    size_t bindingCount;
+
+    /* fewest slots the hash table shrinks back to on its own, set by
+       the capacity the client asked for, or 0 if it may move back to
+       the small array */
+    size_t minSlotCount;
+
+    /* nonzero if lookups move the key they find one place toward the
+       front of the small array */
+    int selfOrganizing;
+};
+
+/* Function that hashes pcKey. Returns the hash, mixed so that its low
+   bits depend on every character and can index the slots directly. */
+static size_t SymTable_hash(const char *pcKey)
+{
+    const size_t HASH_MULTIPLIER = 65599;
+    const uint64_t MIX_MULTIPLIER = UINT64_C(0x9E3779B97F4A7C15);
+    size_t u;
+    size_t uHash = 0;
+    uint64_t uMixed;
+
+    assert(pcKey != NULL);
+
+    for (u = 0; pcKey[u] != '\0'; u++)
+        uHash = uHash * HASH_MULTIPLIER + (size_t)pcKey[u];
+
+    uMixed = (uint64_t)uHash;
+    uMixed ^= uMixed >> 32;
+    uMixed *= MIX_MULTIPLIER;
+    uMixed ^= uMixed >> 29;
+
+    return (size_t)uMixed;
+}
+
+/* Function that returns how far slot uSlotIndex of oSymTable is from
+   the home slot of the binding it holds. */
+static size_t SymTable_distance(SymTable_T oSymTable, size_t uSlotIndex)
+{
+    size_t uMask = oSymTable->slotCount - 1;
+
+    return (uSlotIndex - (oSymTable->slots[uSlotIndex].uHash & uMask))
+           & uMask;
+}
+
+/* Function that returns the smallest slot count that holds uCapacity
+   bindings without growing, or 0 if no slot count a size_t can hold
+   does. */
+static size_t SymTable_slotsForCapacity(size_t uCapacity)
+{
+    size_t uSlotCount = MIN_SLOT_COUNT;
+
+    if (uCapacity > (size_t)-1 / 10)
+        return 0;
+
+    while (uSlotCount * MAX_LOAD_TENTHS < uCapacity * 10)
+    {
+        if (uSlotCount > (size_t)-1 / 2 / MAX_LOAD_TENTHS)
+            return 0;
+        uSlotCount *= 2;
+    }
+
+    return uSlotCount;
+}
+
+/* Function that places the binding sSlot, whose key is known to be
+   absent, into the slots of oSymTable, displacing bindings that are
+   nearer their home slots. Does not change bindingCount. */
+static void SymTable_place(SymTable_T oSymTable,
+                           struct SymTableSlot sSlot)
+{
+    struct SymTableSlot sTemp;
+    size_t uMask = oSymTable->slotCount - 1;
+    size_t uIndex = sSlot.uHash & uMask;
+    size_t uDistance = 0;
+    size_t uOtherDistance;
+
+    for (;;)
+    {
+        if (oSymTable->slots[uIndex].pcKey == NULL)
+        {
+            oSymTable->slots[uIndex] = sSlot;
+            return;
+        }
+
+        uOtherDistance = SymTable_distance(oSymTable, uIndex);
+        if (uOtherDistance < uDistance)
+        {
+            sTemp = oSymTable->slots[uIndex];
+            oSymTable->slots[uIndex] = sSlot;
+            sSlot = sTemp;
+            uDistance = uOtherDistance;
+        }
+
+        uIndex = (uIndex + 1) & uMask;
+        uDistance++;
+    }
+}
+
+/* Function that moves every binding of oSymTable, from the small array
+   or the current slots, into a new array of uNewSlotCount slots.
+   Returns 1 if successful, or 0 if insufficient memory is available,
+   in which case oSymTable is left unchanged. */
+static int SymTable_resize(SymTable_T oSymTable, size_t uNewSlotCount)
+{
+    struct SymTableSlot *oldSlots = oSymTable->slots;
+    struct SymTableSlot sSlot;
+    size_t oldSlotCount = oSymTable->slotCount;
+    size_t u;
+
+    assert(uNewSlotCount * MAX_LOAD_TENTHS >=
+           oSymTable->bindingCount * 10);
+
+    oSymTable->slots = (struct SymTableSlot *)calloc(uNewSlotCount,
+                                        sizeof(struct SymTableSlot));
+    if (oSymTable->slots == NULL)
+    {
+        oSymTable->slots = oldSlots;
+        return 0;
+    }
+    oSymTable->slotCount = uNewSlotCount;
+
+    if (oldSlots == NULL)
+    {
+        for (u = 0; u < oSymTable->bindingCount; u++)
+        {
+            sSlot.pcKey = oSymTable->smallKeys[u];
+            sSlot.pvValue = oSymTable->smallValues[u];
+            sSlot.uHash = SymTable_hash(sSlot.pcKey);
+            SymTable_place(oSymTable, sSlot);
+        }
+        return 1;
+    }
+
+    for (u = 0; u < oldSlotCount; u++)
+        if (oldSlots[u].pcKey != NULL)
+            SymTable_place(oSymTable, oldSlots[u]);
+
+    free(oldSlots);
+    return 1;
+}
+
+/* Function that moves every binding of oSymTable's hash table back
+   into the small array and frees the slots. oSymTable must hold no
+   more than SMALL_MAX bindings. */
+static void SymTable_demote(SymTable_T oSymTable)
+{
+    size_t uSmall = 0;
+    size_t u;
+
+    assert(oSymTable->slots != NULL);
+    assert(oSymTable->bindingCount <= SMALL_MAX);
+
+    for (u = 0; u < oSymTable->slotCount; u++)
+    {
+        if (oSymTable->slots[u].pcKey != NULL)
+        {
+            oSymTable->smallKeys[uSmall] = oSymTable->slots[u].pcKey;
+            oSymTable->smallValues[uSmall] = oSymTable->slots[u].pvValue;
+            oSymTable->smallFirsts[uSmall] = oSymTable->slots[u].pcKey[0];
+            uSmall++;
+        }
+    }
+
+    free(oSymTable->slots);
+    oSymTable->slots = NULL;
+    oSymTable->slotCount = 0;
+}
+
+/* Function that shrinks oSymTable once its hash table is mostly empty:
+   back to the small array if few enough bindings are left and no
+   capacity was reserved, or else to about two slots per binding. If
+   memory runs out the table keeps its current slots. */
+static void SymTable_contract(SymTable_T oSymTable)
+{
+    size_t uSlotCount;
+
+    if (oSymTable->slots == NULL)
+        return;
+
+    if (oSymTable->minSlotCount == 0 &&
+        oSymTable->bindingCount <= DEMOTE_COUNT)
+    {
+        SymTable_demote(oSymTable);
+        return;
+    }
+
+    if (oSymTable->slotCount <= oSymTable->minSlotCount ||
+        oSymTable->slotCount <= MIN_SLOT_COUNT ||
+        oSymTable->bindingCount * SHRINK_DIVISOR >= oSymTable->slotCount)
+    {
+        return;
+    }
+
+    uSlotCount = SymTable_slotsForCapacity(2 * oSymTable->bindingCount);
+    if (uSlotCount < oSymTable->minSlotCount)
+        uSlotCount = oSymTable->minSlotCount;
+
+    (void)SymTable_resize(oSymTable, uSlotCount);
+}
+
+/* Function that returns the index of pcKey in the small array of
+   oSymTable, or SMALL_MAX if it is absent. */
+static size_t SymTable_findSmall(SymTable_T oSymTable, const char *pcKey)
+{
+    size_t u;
+
+    for (u = 0; u < oSymTable->bindingCount; u++)
+    {
+        if (oSymTable->smallFirsts[u] == pcKey[0] &&
+            strcmp(oSymTable->smallKeys[u], pcKey) == 0)
+            return u;
+    }
+
+    return SMALL_MAX;
+}
+
+/* Function that returns the index of the slot of oSymTable holding
+   pcKey, or oSymTable->slotCount if there is none. */
+static size_t SymTable_findLarge(SymTable_T oSymTable, const char *pcKey)
+{
+    struct SymTableSlot *psSlot;
+    size_t uHash = SymTable_hash(pcKey);
+    size_t uMask = oSymTable->slotCount - 1;
+    size_t uIndex = uHash & uMask;
+    size_t uDistance;
+
+    for (uDistance = 0; ; uDistance++)
+    {
+        psSlot = &oSymTable->slots[uIndex];
+
+        /* Stop at an empty slot, or at a binding nearer its home than
+           pcKey would be: pcKey would have displaced it. */
+        if (psSlot->pcKey == NULL ||
+            SymTable_distance(oSymTable, uIndex) < uDistance)
+            return oSymTable->slotCount;
+
+        if (psSlot->uHash == uHash && strcmp(psSlot->pcKey, pcKey) == 0)
+            return uIndex;
+
+        uIndex = (uIndex + 1) & uMask;
+    }
+}
+
+/* Function that swaps the bindings at uIndex and uIndex - 1 of the
+   small array of oSymTable. */
+static void SymTable_transpose(SymTable_T oSymTable, size_t uIndex)
+{
+    const char *pcKey = oSymTable->smallKeys[uIndex];
+    const void *pvValue = oSymTable->smallValues[uIndex];
+    char cFirst = oSymTable->smallFirsts[uIndex];
+
+    oSymTable->smallKeys[uIndex] = oSymTable->smallKeys[uIndex - 1];
+    oSymTable->smallValues[uIndex] = oSymTable->smallValues[uIndex - 1];
+    oSymTable->smallFirsts[uIndex] = oSymTable->smallFirsts[uIndex - 1];
+    oSymTable->smallKeys[uIndex - 1] = pcKey;
+    oSymTable->smallValues[uIndex - 1] = pvValue;
+    oSymTable->smallFirsts[uIndex - 1] = cFirst;
+}
+
+/* Function that returns the address of the value bound to pcKey in
+   oSymTable, or NULL if pcKey is absent. If the table is
+   self-organizing and small, first moves pcKey one place toward the
+   front: a transposition costs one swap, where moving to the front
+   would shift the whole array. */
+static const void **SymTable_findValue(SymTable_T oSymTable,
+                                       const char *pcKey)
+{
+    size_t uIndex;
+
+    if (oSymTable->slots == NULL)
+    {
+        uIndex = SymTable_findSmall(oSymTable, pcKey);
+        if (uIndex == SMALL_MAX)
+            return NULL;
+        if (oSymTable->selfOrganizing && uIndex > 0)
+        {
+            SymTable_transpose(oSymTable, uIndex);
+            uIndex--;
+        }
+        return &oSymTable->smallValues[uIndex];
+    }
+
+    uIndex = SymTable_findLarge(oSymTable, pcKey);
+    if (uIndex == oSymTable->slotCount)
+        return NULL;
+    return &oSymTable->slots[uIndex].pvValue;
+}
+
+SymTable_T SymTable_new(void)
+{
+    return SymTable_newWithCapacity(0);
+}
+
+SymTable_T SymTable_newWithCapacity(size_t uCapacity)
+{
+    SymTable_T oSymTable;
+
+    oSymTable = (SymTable_T)malloc(sizeof(struct SymTable));
+
+    if (oSymTable == NULL)
+        return NULL;
+
+    oSymTable->slots = NULL;
+    oSymTable->slotCount = 0;
+    oSymTable->bindingCount = 0;
+    oSymTable->minSlotCount = 0;
+    oSymTable->selfOrganizing = 0;
+
+    if (uCapacity > SMALL_MAX &&
+        ! SymTable_reserve(oSymTable, uCapacity))
+    {
+        free(oSymTable);
+        return NULL;
+    }
+
+    return oSymTable;
+}
+
+int SymTable_reserve(SymTable_T oSymTable, size_t uCapacity)
+{
+    size_t uSlotCount;
+
+    assert(oSymTable != NULL);
+
+    /* The small array already holds SMALL_MAX bindings. */
+    if (uCapacity <= SMALL_MAX)
+        return 1;
+
+    uSlotCount = SymTable_slotsForCapacity(uCapacity);
+    if (uSlotCount == 0)
+        return 0;
+    if (uSlotCount > oSymTable->minSlotCount)
+        oSymTable->minSlotCount = uSlotCount;
+    if (uSlotCount > oSymTable->slotCount)
+        return SymTable_resize(oSymTable, uSlotCount);
+
+    return 1;
+}
+
+void SymTable_shrinkToFit(SymTable_T oSymTable)
+{
+    size_t uSlotCount;
+
+    assert(oSymTable != NULL);
+
+    oSymTable->minSlotCount = 0;
+    if (oSymTable->slots == NULL)
+        return;
+
+    if (oSymTable->bindingCount <= SMALL_MAX)
+    {
+        SymTable_demote(oSymTable);
+        return;
+    }
+
+    uSlotCount = SymTable_slotsForCapacity(oSymTable->bindingCount);
+    if (uSlotCount < oSymTable->slotCount)
+        (void)SymTable_resize(oSymTable, uSlotCount);
+}
+
+void SymTable_setSelfOrganizing(SymTable_T oSymTable, int iEnabled)
+{
+    assert(oSymTable != NULL);
+
+    /* Only the small array is searched in order; the hash table
+       places each key by its hash. */
+    oSymTable->selfOrganizing = iEnabled;
+}
+
+void SymTable_free(SymTable_T oSymTable)
+{
+    size_t u;
+
+    assert(oSymTable != NULL);
+
+    if (oSymTable->slots == NULL)
+    {
+        for (u = 0; u < oSymTable->bindingCount; u++)
+            free((void *)oSymTable->smallKeys[u]);
+    }
+    else
+    {
+        for (u = 0; u < oSymTable->slotCount; u++)
+            free((void *)oSymTable->slots[u].pcKey);
+        free(oSymTable->slots);
+    }
+
+    free(oSymTable);
+}
+
+size_t SymTable_getLength(SymTable_T oSymTable)
+{
+    assert(oSymTable != NULL);
+    return oSymTable->bindingCount;
+}
+
+int SymTable_put(SymTable_T oSymTable,
+                 const char *pcKey, const void *pvValue)
+{
+    struct SymTableSlot sSlot;
+    char *keyCopy;
+    size_t uSlotCount;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    if (SymTable_findValue(oSymTable, pcKey) != NULL)
+        return 0;
+
+    /* Move to a hash table once the small array is full, and grow the
+       hash table before its load passes MAX_LOAD_TENTHS. */
+    if (oSymTable->slots == NULL)
+    {
+        if (oSymTable->bindingCount == SMALL_MAX &&
+            ! SymTable_resize(oSymTable,
+                              SymTable_slotsForCapacity(2 * SMALL_MAX)))
+            return 0;
+    }
+    else if ((oSymTable->bindingCount + 1) * 10 >
+             oSymTable->slotCount * MAX_LOAD_TENTHS)
+    {
+        uSlotCount = oSymTable->slotCount;
+        if (! SymTable_resize(oSymTable, uSlotCount * 2) &&
+            oSymTable->bindingCount + 1 >= uSlotCount)
+            return 0;
+    }
+
+    keyCopy = (char *)malloc(strlen(pcKey) + 1);
+    if (keyCopy == NULL)
+        return 0;
+    strcpy(keyCopy, pcKey);
+
+    if (oSymTable->slots == NULL)
+    {
+        oSymTable->smallKeys[oSymTable->bindingCount] = keyCopy;
+        oSymTable->smallValues[oSymTable->bindingCount] = pvValue;
+        oSymTable->smallFirsts[oSymTable->bindingCount] = keyCopy[0];
+    }
+    else
+    {
+        sSlot.pcKey = keyCopy;
+        sSlot.pvValue = pvValue;
+        sSlot.uHash = SymTable_hash(keyCopy);
+        SymTable_place(oSymTable, sSlot);
+    }
+    oSymTable->bindingCount += 1;
+
+    return 1;
+}
+
+void *SymTable_replace(SymTable_T oSymTable,
+                       const char *pcKey, const void *pvValue)
+{
+    const void **ppvValue;
+    void *oldValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    ppvValue = SymTable_findValue(oSymTable, pcKey);
+    if (ppvValue == NULL)
+        return NULL;
+
+    oldValue = (void *)*ppvValue;
+    *ppvValue = pvValue;
+    return oldValue;
+}
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey)
+{
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    return SymTable_findValue(oSymTable, pcKey) != NULL;
+}
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey)
+{
+    const void **ppvValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    ppvValue = SymTable_findValue(oSymTable, pcKey);
+    if (ppvValue == NULL)
+        return NULL;
+
+    return (void *)*ppvValue;
+}
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
+{
+    void *pvValue;
+    size_t uMask;
+    size_t uIndex;
+    size_t uNext;
+    size_t uLast;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    if (oSymTable->slots == NULL)
+    {
+        uIndex = SymTable_findSmall(oSymTable, pcKey);
+        if (uIndex == SMALL_MAX)
+            return NULL;
+
+        pvValue = (void *)oSymTable->smallValues[uIndex];
+        free((void *)oSymTable->smallKeys[uIndex]);
+
+        /* Fill the hole with the last binding. */
+        uLast = oSymTable->bindingCount - 1;
+        oSymTable->smallKeys[uIndex] = oSymTable->smallKeys[uLast];
+        oSymTable->smallValues[uIndex] = oSymTable->smallValues[uLast];
+        oSymTable->smallFirsts[uIndex] = oSymTable->smallFirsts[uLast];
+
+        oSymTable->bindingCount -= 1;
+        return pvValue;
+    }
+
+    uIndex = SymTable_findLarge(oSymTable, pcKey);
+    if (uIndex == oSymTable->slotCount)
+        return NULL;
+
+    pvValue = (void *)oSymTable->slots[uIndex].pvValue;
+    free((void *)oSymTable->slots[uIndex].pcKey);
+
+    /* Backward-shift deletion: pull each following binding that is
+       away from its home one slot back, so no tombstone is left. */
+    uMask = oSymTable->slotCount - 1;
+    for (uNext = (uIndex + 1) & uMask;
+         oSymTable->slots[uNext].pcKey != NULL &&
+         SymTable_distance(oSymTable, uNext) > 0;
+         uNext = (uNext + 1) & uMask)
+    {
+        oSymTable->slots[uIndex] = oSymTable->slots[uNext];
+        uIndex = uNext;
+    }
+    oSymTable->slots[uIndex].pcKey = NULL;
+
+    oSymTable->bindingCount -= 1;
+    SymTable_contract(oSymTable);
+
+    return pvValue;
+}
+
+void SymTable_map(SymTable_T oSymTable,
+                  void (*pfApply)(const char *pcKey, void *pvValue,
+                                  void *pvExtra),
+                  const void *pvExtra)
+{
+    size_t u;
+
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+
+    if (oSymTable->slots == NULL)
+    {
+        for (u = 0; u < oSymTable->bindingCount; u++)
+            (*pfApply)(oSymTable->smallKeys[u],
+                       (void *)oSymTable->smallValues[u],
+                       (void *)pvExtra);
+        return;
+    }
+
+    for (u = 0; u < oSymTable->slotCount; u++)
+    {
+        if (oSymTable->slots[u].pcKey != NULL)
+            (*pfApply)(oSymTable->slots[u].pcKey,
+                       (void *)oSymTable->slots[u].pvValue,
+                       (void *)pvExtra);
+    }
+}
@@ -7,6 +7,10 @@
 #include <stdlib.h>
 #include <assert.h>
 #include <string.h>
+#include <stdint.h>
+
+/* Number of leading key bytes copied into each SymTableNode */
+enum {PREFIX_SIZE = sizeof(uint64_t)};
 
 /* Each SymTableNode stores a key-pair pair. SymTableNodes are linked to
    form a list.  */
@@ -20,6 +24,12 @@ struct SymTableNode
 
      /* address of next SymTableNode */
      struct SymTableNode *psNextNode;
+
+     /* the length of the key */
+     size_t keyLength;
+
+     /* the first PREFIX_SIZE bytes of the key, padded with zeros */
+     uint64_t keyPrefix;
 };
 
 /* A SymTable is a structure that points to the first SymTableNode and
@@ -31,6 +41,9 @@ struct SymTable
 
      /* stores length of the list of SymTableNodes */
      size_t length;
+
+     /* nonzero if lookups move the node they find to the front */
+     int selfOrganizing;
 };
 
 SymTable_T SymTable_new(void)
@@ -44,9 +57,95 @@ SymTable_T SymTable_new(void)
 
      oSymTable->psFirstNode = NULL;
      oSymTable->length = 0;
+     oSymTable->selfOrganizing = 0;
      return oSymTable;
 }
 
+SymTable_T SymTable_newWithCapacity(size_t uCapacity)
+{
+     /* A list has nothing to size up front. */
+     (void)uCapacity;
+     return SymTable_new();
+}
+
+int SymTable_reserve(SymTable_T oSymTable, size_t uCapacity)
+{
+     assert(oSymTable != NULL);
+
+     /* A list has nothing to size up front. */
+     (void)uCapacity;
+     return 1;
+}
+
+void SymTable_shrinkToFit(SymTable_T oSymTable)
+{
+     assert(oSymTable != NULL);
+
+     /* A list holds no storage beyond its nodes. */
+}
+
+void SymTable_setSelfOrganizing(SymTable_T oSymTable, int iEnabled)
+{
+     assert(oSymTable != NULL);
+     oSymTable->selfOrganizing = iEnabled;
+}
+
+/* Function that returns the first PREFIX_SIZE bytes of the uLength
+   bytes of pcKey as one integer, padded with zeros if the key is
+   shorter. */
+static uint64_t SymTable_prefix(const char *pcKey, size_t uLength)
+{
+     uint64_t uPrefix = 0;
+
+     memcpy(&uPrefix, pcKey,
+          uLength < PREFIX_SIZE ? uLength : (size_t)PREFIX_SIZE);
+     return uPrefix;
+}
+
+/* Function that returns 1 if psNode holds pcKey, whose length is
+   uLength and whose prefix is uPrefix, or 0 otherwise. The key itself
+   is only read once the length and prefix stored in psNode agree. */
+static int SymTable_matches(const struct SymTableNode *psNode,
+     const char *pcKey, size_t uLength, uint64_t uPrefix)
+{
+     if (psNode->keyPrefix != uPrefix || psNode->keyLength != uLength)
+          return 0;
+     if (uLength <= PREFIX_SIZE)
+          return 1;
+     return memcmp((const char *)psNode->pcKey + PREFIX_SIZE,
+          pcKey + PREFIX_SIZE, uLength - PREFIX_SIZE) == 0;
+}
+
+/* Function that finds the node holding pcKey in oSymTable. If the
+   table is self-organizing, moves the node to the front of the list.
+   Returns the node, or NULL if pcKey is absent. */
+static struct SymTableNode *SymTable_lookup(SymTable_T oSymTable,
+     const char *pcKey)
+{
+     struct SymTableNode *psCurrentNode;
+     struct SymTableNode *psPrevNode = NULL;
+     size_t uLength = strlen(pcKey);
+     uint64_t uPrefix = SymTable_prefix(pcKey, uLength);
+
+     for (psCurrentNode = oSymTable->psFirstNode;
+          psCurrentNode != NULL;
+          psCurrentNode = psCurrentNode->psNextNode)
+     {
+          if (SymTable_matches(psCurrentNode, pcKey, uLength, uPrefix))
+          {
+               if (oSymTable->selfOrganizing && psPrevNode != NULL)
+               {
+                    psPrevNode->psNextNode = psCurrentNode->psNextNode;
+                    psCurrentNode->psNextNode = oSymTable->psFirstNode;
+                    oSymTable->psFirstNode = psCurrentNode;
+               }
+               return psCurrentNode;
+          }
+          psPrevNode = psCurrentNode;
+     }
+     return NULL;
+}
+
 void SymTable_free(SymTable_T oSymTable)
 {
      struct SymTableNode *psCurrentNode;
@@ -77,6 +176,7 @@ int SymTable_put(SymTable_T oSymTable,
 {
      char *keyCopy;
      struct SymTableNode *psNewNode;
+     size_t uLength;
 
      assert(oSymTable != NULL);
      assert(pcKey != NULL);
@@ -84,22 +184,26 @@ int SymTable_put(SymTable_T oSymTable,
      if (SymTable_contains(oSymTable, pcKey))
           return 0;
 
+     uLength = strlen(pcKey);
+
      psNewNode = (struct SymTableNode *)malloc(sizeof(struct
                                                       SymTableNode));
 
      if (psNewNode == NULL)
           return 0;
 
-     keyCopy = (char *)malloc(strlen(pcKey) + 1);
+     keyCopy = (char *)malloc(uLength + 1);
      if (keyCopy == NULL)
      {
           free(psNewNode);
           return 0;
      }
      
-     strcpy(keyCopy, pcKey);
+     memcpy(keyCopy, pcKey, uLength + 1);
 
      psNewNode->pcKey = keyCopy;
+     psNewNode->keyLength = uLength;
+     psNewNode->keyPrefix = SymTable_prefix(pcKey, uLength);
      psNewNode->pvValue = pvValue;
 
      psNewNode->psNextNode = oSymTable->psFirstNode;
@@ -114,15 +218,20 @@ void *SymTable_replace(SymTable_T oSymTable,
 {
      struct SymTableNode *psCurrentNode;
      void *oldValue;
+     size_t uLength;
+     uint64_t uPrefix;
 
      assert(oSymTable != NULL);
      assert(pcKey != NULL);
 
+     uLength = strlen(pcKey);
+     uPrefix = SymTable_prefix(pcKey, uLength);
+
      for (psCurrentNode = oSymTable->psFirstNode;
           psCurrentNode != NULL;
           psCurrentNode = psCurrentNode->psNextNode)
      {
-          if (strcmp(psCurrentNode->pcKey, pcKey) == 0)
+          if (SymTable_matches(psCurrentNode, pcKey, uLength, uPrefix))
           {
                oldValue = (void *)psCurrentNode->pvValue;
                psCurrentNode->pvValue = pvValue;
@@ -135,36 +244,23 @@ void *SymTable_replace(SymTable_T oSymTable,
 
 int SymTable_contains(SymTable_T oSymTable, const char *pcKey)
 {
-     struct SymTableNode *psCurrentNode;
-
      assert(oSymTable != NULL);
      assert(pcKey != NULL);
 
-     for (psCurrentNode = oSymTable->psFirstNode;
-          psCurrentNode != NULL;
-          psCurrentNode = psCurrentNode->psNextNode)
-     {
-          if (strcmp(psCurrentNode->pcKey, pcKey) == 0)
-               return 1;
-     }
-     return 0;
+     return SymTable_lookup(oSymTable, pcKey) != NULL;
 }
 
 void *SymTable_get(SymTable_T oSymTable, const char *pcKey)
 {
-     struct SymTableNode *psCurrentNode;
+     struct SymTableNode *psNode;
 
      assert(oSymTable != NULL);
      assert(pcKey != NULL);
 
-     for (psCurrentNode = oSymTable->psFirstNode;
-          psCurrentNode != NULL;
-          psCurrentNode = psCurrentNode->psNextNode)
-     {
-          if (strcmp(psCurrentNode->pcKey, pcKey) == 0)
-               return (void *)psCurrentNode->pvValue;
-     }
-     return NULL;
+     psNode = SymTable_lookup(oSymTable, pcKey);
+     if (psNode == NULL)
+          return NULL;
+     return (void *)psNode->pvValue;
 }
 
 void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
@@ -172,15 +268,20 @@ void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
      struct SymTableNode *psCurrentNode = oSymTable->psFirstNode;
      struct SymTableNode *psPrevNode = NULL;
      void *pvValue;
+     size_t uLength;
+     uint64_t uPrefix;
 
      assert(oSymTable != NULL);
      assert(pcKey != NULL);
 
+     uLength = strlen(pcKey);
+     uPrefix = SymTable_prefix(pcKey, uLength);
+
      for (psCurrentNode = oSymTable->psFirstNode;
           psCurrentNode != NULL;
           psCurrentNode = psCurrentNode->psNextNode)
      {
-          if (strcmp(psCurrentNode->pcKey, pcKey) == 0)
+          if (SymTable_matches(psCurrentNode, pcKey, uLength, uPrefix))
           {               
                pvValue = (void *)psCurrentNode->pvValue;
 
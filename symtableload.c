@@ -0,0 +1,347 @@
+/*--------------------------------------------------------------------*/
+/* symtableload.c                                                     */
+/* Author: Ryan Chen                                                  */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+#include "symtableload.h"
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include <stdint.h>
+
+/* A SymTableLoad owns the text of a loaded file. */
+struct SymTableLoad
+{
+    /* the file, mapped private and writable so that its lines can be
+       ended in place, or NULL if the file is empty */
+    char *pcText;
+
+    /* size of the file in bytes */
+    size_t byteCount;
+
+    /* a copy of the last line of the file, ended in a newline, if the
+       file does not end in one, or else NULL */
+    char *pcLastLine;
+
+    /* length of pcLastLine, counting the newline */
+    size_t lastLineLength;
+
+    /* number of lines parsed, not counting empty ones */
+    size_t lineCount;
+};
+
+/* A SymTableChunk is a run of whole lines that one thread parses. */
+struct SymTableChunk
+{
+    /* the first character of the chunk */
+    char *pcStart;
+
+    /* one past the last character of the chunk, which is a newline */
+    char *pcEnd;
+
+    /* number of lines in the chunk, not counting empty ones */
+    size_t lineCount;
+
+    /* where the chunk's keys, values and hashes go in the batch, or
+       NULL while the lines are only being counted */
+    char **ppcKeys;
+    void **ppvValues;
+    uint32_t *puHashes;
+
+    /* the thread parsing the chunk, if iStarted */
+    pthread_t thread;
+    int iStarted;
+};
+
+/* Function that returns the length of the line that starts at pcLine
+   and ends in the newline at pcNewline, not counting a carriage return
+   before the newline. */
+static size_t SymTableLoad_lineLength(const char *pcLine,
+                                      const char *pcNewline)
+{
+    if (pcNewline > pcLine && pcNewline[-1] == '\r')
+        return (size_t)(pcNewline - 1 - pcLine);
+    return (size_t)(pcNewline - pcLine);
+}
+
+/* Function that runs on the SymTableChunk that pvChunk points to. If
+   its ppcKeys is NULL, counts its lines; otherwise ends each line and
+   its key with '\0' in place, and stores the key, value and
+   SymTable_hashKey hash of each in the chunk's arrays. Returns
+   NULL. */
+static void *SymTableLoad_parse(void *pvChunk)
+{
+    struct SymTableChunk *psChunk = (struct SymTableChunk *)pvChunk;
+    char *pcLine;
+    char *pcNewline;
+    char *pcTab;
+    size_t uLength;
+    size_t u = 0;
+
+    for (pcLine = psChunk->pcStart;
+         pcLine < psChunk->pcEnd;
+         pcLine = pcNewline + 1)
+    {
+        pcNewline = (char *)memchr(pcLine, '\n',
+                                   (size_t)(psChunk->pcEnd - pcLine));
+        assert(pcNewline != NULL);
+
+        uLength = SymTableLoad_lineLength(pcLine, pcNewline);
+        if (uLength == 0)
+            continue;
+
+        if (psChunk->ppcKeys != NULL)
+        {
+            pcLine[uLength] = '\0';
+            pcTab = (char *)memchr(pcLine, '\t', uLength);
+            if (pcTab != NULL)
+            {
+                *pcTab = '\0';
+                psChunk->ppvValues[u] = pcTab + 1;
+            }
+            else
+                psChunk->ppvValues[u] = pcLine + uLength;
+            psChunk->ppcKeys[u] = pcLine;
+            psChunk->puHashes[u] = SymTable_hashKey(pcLine);
+        }
+        u++;
+    }
+
+    psChunk->lineCount = u;
+    return NULL;
+}
+
+/* Function that runs SymTableLoad_parse on each of the uChunkCount
+   SymTableChunks of psChunks, all but the first in threads of their
+   own. A chunk whose thread cannot be started is parsed by the calling
+   thread instead. */
+static void SymTableLoad_parseAll(struct SymTableChunk *psChunks,
+                                  size_t uChunkCount)
+{
+    size_t u;
+
+    for (u = 1; u < uChunkCount; u++)
+        psChunks[u].iStarted = pthread_create(&psChunks[u].thread, NULL,
+                                              SymTableLoad_parse,
+                                              &psChunks[u]) == 0;
+
+    (void)SymTableLoad_parse(&psChunks[0]);
+
+    for (u = 1; u < uChunkCount; u++)
+    {
+        if (psChunks[u].iStarted)
+            pthread_join(psChunks[u].thread, NULL);
+        else
+            (void)SymTableLoad_parse(&psChunks[u]);
+    }
+}
+
+/* Function that maps the file pcFileName into oSymTableLoad, and
+   copies its last line if it has no newline. Returns 1 if successful,
+   or 0 if the file cannot be read or insufficient memory is
+   available. */
+static int SymTableLoad_map(SymTableLoad_T oSymTableLoad,
+                            const char *pcFileName)
+{
+    struct stat sStat;
+    char *pcLastLine;
+    void *pvText;
+    size_t uLength;
+    int iFd;
+
+    iFd = open(pcFileName, O_RDONLY);
+    if (iFd < 0)
+        return 0;
+
+    if (fstat(iFd, &sStat) != 0)
+    {
+        close(iFd);
+        return 0;
+    }
+    oSymTableLoad->byteCount = (size_t)sStat.st_size;
+    if (oSymTableLoad->byteCount == 0)
+    {
+        close(iFd);
+        return 1;
+    }
+
+    pvText = mmap(NULL, oSymTableLoad->byteCount,
+                  PROT_READ | PROT_WRITE, MAP_PRIVATE, iFd, 0);
+    close(iFd);
+    if (pvText == MAP_FAILED)
+        return 0;
+    oSymTableLoad->pcText = (char *)pvText;
+    (void)posix_madvise(pvText, oSymTableLoad->byteCount,
+                        POSIX_MADV_SEQUENTIAL);
+
+    /* The mapping may end on a page boundary, so a last line with no
+       newline cannot be ended in place. */
+    if (oSymTableLoad->pcText[oSymTableLoad->byteCount - 1] != '\n')
+    {
+        for (uLength = 1;
+             uLength < oSymTableLoad->byteCount &&
+             oSymTableLoad->pcText[oSymTableLoad->byteCount - uLength
+                                   - 1] != '\n';
+             uLength++)
+            ;
+        pcLastLine = (char *)malloc(uLength + 1);
+        if (pcLastLine == NULL)
+            return 0;
+        memcpy(pcLastLine,
+               oSymTableLoad->pcText + oSymTableLoad->byteCount - uLength,
+               uLength);
+        pcLastLine[uLength] = '\n';
+        oSymTableLoad->pcLastLine = pcLastLine;
+        oSymTableLoad->lastLineLength = uLength + 1;
+    }
+
+    return 1;
+}
+
+SymTableLoad_T SymTableLoad_file(SymTable_T oSymTable,
+                                 const char *pcFileName,
+                                 size_t uThreadCount)
+{
+    SymTableLoad_T oSymTableLoad;
+    struct SymTableChunk *psChunks;
+    char **ppcKeys = NULL;
+    void **ppvValues = NULL;
+    uint32_t *puHashes = NULL;
+    char *pcStart;
+    char *pcEnd;
+    char *pcSplit;
+    size_t uTextLength;
+    size_t uChunkCount;
+    size_t uLineCount;
+    size_t u;
+    int iSuccessful = 0;
+
+    assert(oSymTable != NULL);
+    assert(pcFileName != NULL);
+    assert(uThreadCount > 0);
+
+    oSymTableLoad = (SymTableLoad_T)calloc(1, sizeof(struct SymTableLoad));
+    if (oSymTableLoad == NULL)
+        return NULL;
+
+    if (! SymTableLoad_map(oSymTableLoad, pcFileName))
+    {
+        SymTableLoad_free(oSymTableLoad);
+        return NULL;
+    }
+
+    /* Each chunk of the mapping ends in a newline; the copied last
+       line, if any, is a chunk of its own. */
+    psChunks = (struct SymTableChunk *)calloc(uThreadCount + 1,
+                                              sizeof(struct SymTableChunk));
+    if (psChunks == NULL)
+    {
+        SymTableLoad_free(oSymTableLoad);
+        return NULL;
+    }
+
+    uTextLength = oSymTableLoad->byteCount;
+    if (oSymTableLoad->pcLastLine != NULL)
+        uTextLength -= oSymTableLoad->lastLineLength - 1;
+
+    uChunkCount = 0;
+    pcStart = oSymTableLoad->pcText;
+    pcEnd = uTextLength > 0 ? oSymTableLoad->pcText + uTextLength : NULL;
+    for (u = 1; u <= uThreadCount && pcStart < pcEnd; u++)
+    {
+        pcSplit = oSymTableLoad->pcText + uTextLength / uThreadCount * u;
+        if (u == uThreadCount || pcSplit >= pcEnd)
+            pcSplit = pcEnd;
+        else if (pcSplit < pcStart)
+            continue;
+        else
+            pcSplit = (char *)memchr(pcSplit, '\n',
+                                     (size_t)(pcEnd - pcSplit)) + 1;
+
+        psChunks[uChunkCount].pcStart = pcStart;
+        psChunks[uChunkCount].pcEnd = pcSplit;
+        uChunkCount++;
+        pcStart = pcSplit;
+    }
+    if (oSymTableLoad->pcLastLine != NULL)
+    {
+        psChunks[uChunkCount].pcStart = oSymTableLoad->pcLastLine;
+        psChunks[uChunkCount].pcEnd = oSymTableLoad->pcLastLine
+                                      + oSymTableLoad->lastLineLength;
+        uChunkCount++;
+    }
+
+    /* Count the lines of each chunk, so that each knows where its
+       bindings go in the batch, then parse them. */
+    SymTableLoad_parseAll(psChunks, uChunkCount);
+    uLineCount = 0;
+    for (u = 0; u < uChunkCount; u++)
+        uLineCount += psChunks[u].lineCount;
+
+    if (uLineCount > 0 && uLineCount <= (size_t)-1 / sizeof(char *))
+    {
+        ppcKeys = (char **)malloc(uLineCount * sizeof(char *));
+        ppvValues = (void **)malloc(uLineCount * sizeof(void *));
+        puHashes = (uint32_t *)malloc(uLineCount * sizeof(uint32_t));
+    }
+
+    if (uLineCount == 0)
+        iSuccessful = 1;
+    else if (ppcKeys != NULL && ppvValues != NULL && puHashes != NULL)
+    {
+        uLineCount = 0;
+        for (u = 0; u < uChunkCount; u++)
+        {
+            psChunks[u].ppcKeys = ppcKeys + uLineCount;
+            psChunks[u].ppvValues = ppvValues + uLineCount;
+            psChunks[u].puHashes = puHashes + uLineCount;
+            uLineCount += psChunks[u].lineCount;
+        }
+        SymTableLoad_parseAll(psChunks, uChunkCount);
+
+        iSuccessful = SymTable_putBatchHashed(oSymTable, ppcKeys,
+                                              ppvValues, puHashes,
+                                              uLineCount);
+    }
+    oSymTableLoad->lineCount = uLineCount;
+
+    free(puHashes);
+    free(ppvValues);
+    free(ppcKeys);
+    free(psChunks);
+
+    if (! iSuccessful)
+    {
+        SymTableLoad_free(oSymTableLoad);
+        return NULL;
+    }
+    return oSymTableLoad;
+}
+
+size_t SymTableLoad_getLineCount(SymTableLoad_T oSymTableLoad)
+{
+    assert(oSymTableLoad != NULL);
+    return oSymTableLoad->lineCount;
+}
+
+size_t SymTableLoad_getByteCount(SymTableLoad_T oSymTableLoad)
+{
+    assert(oSymTableLoad != NULL);
+    return oSymTableLoad->byteCount;
+}
+
+void SymTableLoad_free(SymTableLoad_T oSymTableLoad)
+{
+    assert(oSymTableLoad != NULL);
+
+    if (oSymTableLoad->pcText != NULL)
+        munmap(oSymTableLoad->pcText, oSymTableLoad->byteCount);
+    free(oSymTableLoad->pcLastLine);
+    free(oSymTableLoad);
+}
@@ -0,0 +1,49 @@
+/*--------------------------------------------------------------------*/
+/* symtableload.h                                                     */
+/* Author: Ryan Chen                                                  */
+/*--------------------------------------------------------------------*/
+
+#ifndef symtableload
+#define symtableload
+#include "symtablehash.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* A SymTableLoad_T object owns the text of a file loaded into a
+   SymTable_T object: the values the file's bindings point to. */
+typedef struct SymTableLoad *SymTableLoad_T;
+
+/* Binds the key of each line of the file pcFileName in oSymTable to
+   the rest of the line, as SymTable_putBatch would. A line is a key, a
+   tab, and a value; a line with no tab is a key bound to the empty
+   string, and empty lines are skipped. A trailing carriage return is
+   not part of the line. A key that is already bound, in oSymTable or
+   earlier in the file, keeps its first value. oSymTable must be from
+   SymTable_new or SymTable_newWithCapacity. The file is mapped into
+   memory and split into uThreadCount chunks, which are parsed and
+   hashed in parallel; the bindings are then made in one batch. Values
+   point into the mapping, so return a SymTableLoad_T object that owns
+   it, which must outlive every use of the values, or NULL if the file
+   cannot be read or insufficient memory is available, in which case
+   oSymTable is unchanged. uThreadCount must be positive. */
+SymTableLoad_T SymTableLoad_file(SymTable_T oSymTable,
+     const char *pcFileName, size_t uThreadCount);
+
+/* Returns the number of lines oSymTableLoad parsed, not counting empty
+   ones. */
+size_t SymTableLoad_getLineCount(SymTableLoad_T oSymTableLoad);
+
+/* Returns the size in bytes of the file oSymTableLoad loaded. */
+size_t SymTableLoad_getByteCount(SymTableLoad_T oSymTableLoad);
+
+/* Frees oSymTableLoad and the text it owns. The values it loaded are
+   no longer valid afterwards. */
+void SymTableLoad_free(SymTableLoad_T oSymTableLoad);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
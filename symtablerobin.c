@@ -0,0 +1,446 @@
+/*--------------------------------------------------------------------*/
+/* symtablerobin.c                                                    */
+/* Author: Ryan Chen                                                  */
+/*--------------------------------------------------------------------*/
+
+#include "symtable.h"
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include <stdint.h>
+
+/* Fewest slots a SymTable ever has. Must be a power of two. */
+static const size_t MIN_SLOT_COUNT = 16;
+
+/* The table grows once more than MAX_LOAD_TENTHS tenths of its slots
+   are full. */
+static const size_t MAX_LOAD_TENTHS = 9;
+
+/* The table shrinks once it has more than SHRINK_DIVISOR slots per
+   binding, leaving a gap with the growth threshold so that remove/put
+   cycles do not resize back and forth. */
+static const size_t SHRINK_DIVISOR = 8;
+
+/* Each SymTableSlot stores one binding inline, along with the full
+   hash of its key so that probing and resizing never rehash a key. */
+struct SymTableSlot
+{
+    /* the key, or NULL if the slot is empty */
+    const char *pcKey;
+
+    /* the value */
+    const void *pvValue;
+
+    /* the hash of the key */
+    size_t uHash;
+};
+
+/* SymTable represents a Robin Hood hash table: an open-addressed array
+   of slots probed linearly, where a binding being inserted takes the
+   slot of any binding that sits closer to its home slot. Probe lengths
+   stay even, and a search can stop as soon as it passes the point
+   where its key would have been placed. */
+struct SymTable
+{
+    /* the array of slots */
+    struct SymTableSlot *slots;
+
+    /* number of slots, always a power of two */
+    size_t slotCount;
+
+    /* total number of bindings in the SymTable */
+    size_t bindingCount;
+
+    /* fewest slots the table shrinks back to on its own, set by the
+       capacity the client asked for */
+    size_t minSlotCount;
+};
+
+/* Function that hashes pcKey. Returns the hash, mixed so that its low
+   bits depend on every character and can index the slots directly. */
+static size_t SymTable_hash(const char *pcKey)
+{
+    const size_t HASH_MULTIPLIER = 65599;
+    const uint64_t MIX_MULTIPLIER = UINT64_C(0x9E3779B97F4A7C15);
+    size_t u;
+    size_t uHash = 0;
+    uint64_t uMixed;
+
+    assert(pcKey != NULL);
+
+    for (u = 0; pcKey[u] != '\0'; u++)
+        uHash = uHash * HASH_MULTIPLIER + (size_t)pcKey[u];
+
+    uMixed = (uint64_t)uHash;
+    uMixed ^= uMixed >> 32;
+    uMixed *= MIX_MULTIPLIER;
+    uMixed ^= uMixed >> 29;
+
+    return (size_t)uMixed;
+}
+
+/* Function that returns how far slot uSlotIndex of oSymTable is from
+   the home slot of the binding it holds. */
+static size_t SymTable_distance(SymTable_T oSymTable, size_t uSlotIndex)
+{
+    size_t uMask = oSymTable->slotCount - 1;
+
+    return (uSlotIndex - (oSymTable->slots[uSlotIndex].uHash & uMask))
+           & uMask;
+}
+
+/* Function that returns the smallest slot count that holds uCapacity
+   bindings without growing, or 0 if no slot count a size_t can hold
+   does. */
+static size_t SymTable_slotsForCapacity(size_t uCapacity)
+{
+    size_t uSlotCount = MIN_SLOT_COUNT;
+
+    if (uCapacity > (size_t)-1 / 10)
+        return 0;
+
+    while (uSlotCount * MAX_LOAD_TENTHS < uCapacity * 10)
+    {
+        if (uSlotCount > (size_t)-1 / 2 / MAX_LOAD_TENTHS)
+            return 0;
+        uSlotCount *= 2;
+    }
+
+    return uSlotCount;
+}
+
+/* Function that places the binding sSlot, whose key is known to be
+   absent, into the slots of oSymTable, displacing bindings that are
+   nearer their home slots. Does not change bindingCount. */
+static void SymTable_place(SymTable_T oSymTable,
+                           struct SymTableSlot sSlot)
+{
+    struct SymTableSlot sTemp;
+    size_t uMask = oSymTable->slotCount - 1;
+    size_t uIndex = sSlot.uHash & uMask;
+    size_t uDistance = 0;
+    size_t uOtherDistance;
+
+    for (;;)
+    {
+        if (oSymTable->slots[uIndex].pcKey == NULL)
+        {
+            oSymTable->slots[uIndex] = sSlot;
+            return;
+        }
+
+        uOtherDistance = SymTable_distance(oSymTable, uIndex);
+        if (uOtherDistance < uDistance)
+        {
+            sTemp = oSymTable->slots[uIndex];
+            oSymTable->slots[uIndex] = sSlot;
+            sSlot = sTemp;
+            uDistance = uOtherDistance;
+        }
+
+        uIndex = (uIndex + 1) & uMask;
+        uDistance++;
+    }
+}
+
+/* Function that moves every binding of oSymTable into a new array of
+   uNewSlotCount slots. Returns 1 if successful, or 0 if insufficient
+   memory is available, in which case oSymTable is left unchanged. */
+static int SymTable_resize(SymTable_T oSymTable, size_t uNewSlotCount)
+{
+    struct SymTableSlot *oldSlots = oSymTable->slots;
+    size_t oldSlotCount = oSymTable->slotCount;
+    size_t u;
+
+    assert(uNewSlotCount * MAX_LOAD_TENTHS >=
+           oSymTable->bindingCount * 10);
+
+    oSymTable->slots = (struct SymTableSlot *)calloc(uNewSlotCount,
+                                        sizeof(struct SymTableSlot));
+    if (oSymTable->slots == NULL)
+    {
+        oSymTable->slots = oldSlots;
+        return 0;
+    }
+    oSymTable->slotCount = uNewSlotCount;
+
+    for (u = 0; u < oldSlotCount; u++)
+        if (oldSlots[u].pcKey != NULL)
+            SymTable_place(oSymTable, oldSlots[u]);
+
+    free(oldSlots);
+    return 1;
+}
+
+/* Function that shrinks the slots of oSymTable once they are mostly
+   empty, leaving about two slots per binding but never going below
+   minSlotCount. If memory runs out the table keeps its current slots. */
+static void SymTable_contract(SymTable_T oSymTable)
+{
+    size_t uSlotCount;
+
+    if (oSymTable->slotCount <= oSymTable->minSlotCount ||
+        oSymTable->bindingCount * SHRINK_DIVISOR >= oSymTable->slotCount)
+    {
+        return;
+    }
+
+    uSlotCount = SymTable_slotsForCapacity(2 * oSymTable->bindingCount);
+    if (uSlotCount < oSymTable->minSlotCount)
+        uSlotCount = oSymTable->minSlotCount;
+
+    (void)SymTable_resize(oSymTable, uSlotCount);
+}
+
+/* Function that returns the index of the slot of oSymTable holding
+   pcKey, or oSymTable->slotCount if there is none. */
+static size_t SymTable_find(SymTable_T oSymTable, const char *pcKey)
+{
+    struct SymTableSlot *psSlot;
+    size_t uHash = SymTable_hash(pcKey);
+    size_t uMask = oSymTable->slotCount - 1;
+    size_t uIndex = uHash & uMask;
+    size_t uDistance;
+
+    for (uDistance = 0; ; uDistance++)
+    {
+        psSlot = &oSymTable->slots[uIndex];
+
+        /* Stop at an empty slot, or at a binding nearer its home than
+           pcKey would be: pcKey would have displaced it. */
+        if (psSlot->pcKey == NULL ||
+            SymTable_distance(oSymTable, uIndex) < uDistance)
+            return oSymTable->slotCount;
+
+        if (psSlot->uHash == uHash && strcmp(psSlot->pcKey, pcKey) == 0)
+            return uIndex;
+
+        uIndex = (uIndex + 1) & uMask;
+    }
+}
+
+SymTable_T SymTable_new(void)
+{
+    return SymTable_newWithCapacity(0);
+}
+
+SymTable_T SymTable_newWithCapacity(size_t uCapacity)
+{
+    SymTable_T oSymTable;
+    size_t uSlotCount;
+
+    oSymTable = (SymTable_T)malloc(sizeof(struct SymTable));
+
+    if (oSymTable == NULL)
+        return NULL;
+
+    uSlotCount = SymTable_slotsForCapacity(uCapacity);
+    if (uSlotCount == 0)
+    {
+        free(oSymTable);
+        return NULL;
+    }
+
+    oSymTable->slots = (struct SymTableSlot *)calloc(uSlotCount,
+                                        sizeof(struct SymTableSlot));
+    if (oSymTable->slots == NULL)
+    {
+        free(oSymTable);
+        return NULL;
+    }
+
+    oSymTable->slotCount = uSlotCount;
+    oSymTable->bindingCount = 0;
+    oSymTable->minSlotCount = uSlotCount;
+
+    return oSymTable;
+}
+
+int SymTable_reserve(SymTable_T oSymTable, size_t uCapacity)
+{
+    size_t uSlotCount;
+
+    assert(oSymTable != NULL);
+
+    uSlotCount = SymTable_slotsForCapacity(uCapacity);
+    if (uSlotCount == 0)
+        return 0;
+    if (uSlotCount > oSymTable->minSlotCount)
+        oSymTable->minSlotCount = uSlotCount;
+    if (uSlotCount > oSymTable->slotCount)
+        return SymTable_resize(oSymTable, uSlotCount);
+
+    return 1;
+}
+
+void SymTable_shrinkToFit(SymTable_T oSymTable)
+{
+    size_t uSlotCount;
+
+    assert(oSymTable != NULL);
+
+    oSymTable->minSlotCount = MIN_SLOT_COUNT;
+    uSlotCount = SymTable_slotsForCapacity(oSymTable->bindingCount);
+    if (uSlotCount < oSymTable->slotCount)
+        (void)SymTable_resize(oSymTable, uSlotCount);
+}
+
+void SymTable_setSelfOrganizing(SymTable_T oSymTable, int iEnabled)
+{
+    assert(oSymTable != NULL);
+    (void)iEnabled;
+
+    /* Each key's slot follows from its hash and the keys placed
+       before it, so there is no order to reorganize. */
+}
+
+void SymTable_free(SymTable_T oSymTable)
+{
+    size_t u;
+
+    assert(oSymTable != NULL);
+
+    for (u = 0; u < oSymTable->slotCount; u++)
+        free((void *)oSymTable->slots[u].pcKey);
+
+    free(oSymTable->slots);
+    free(oSymTable);
+}
+
+size_t SymTable_getLength(SymTable_T oSymTable)
+{
+    assert(oSymTable != NULL);
+    return oSymTable->bindingCount;
+}
+
+int SymTable_put(SymTable_T oSymTable,
+                 const char *pcKey, const void *pvValue)
+{
+    struct SymTableSlot sSlot;
+    char *keyCopy;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    if (SymTable_find(oSymTable, pcKey) != oSymTable->slotCount)
+        return 0;
+
+    /* Grow before the load passes MAX_LOAD_TENTHS; if memory runs out
+       the table can still take bindings until it is full. */
+    if ((oSymTable->bindingCount + 1) * 10 >
+        oSymTable->slotCount * MAX_LOAD_TENTHS)
+    {
+        if (! SymTable_resize(oSymTable, oSymTable->slotCount * 2) &&
+            oSymTable->bindingCount + 1 >= oSymTable->slotCount)
+            return 0;
+    }
+
+    keyCopy = (char *)malloc(strlen(pcKey) + 1);
+    if (keyCopy == NULL)
+        return 0;
+
+    strcpy(keyCopy, pcKey);
+    sSlot.pcKey = keyCopy;
+    sSlot.pvValue = pvValue;
+    sSlot.uHash = SymTable_hash(pcKey);
+
+    SymTable_place(oSymTable, sSlot);
+    oSymTable->bindingCount += 1;
+
+    return 1;
+}
+
+void *SymTable_replace(SymTable_T oSymTable,
+                       const char *pcKey, const void *pvValue)
+{
+    void *oldValue;
+    size_t uIndex;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uIndex = SymTable_find(oSymTable, pcKey);
+    if (uIndex == oSymTable->slotCount)
+        return NULL;
+
+    oldValue = (void *)oSymTable->slots[uIndex].pvValue;
+    oSymTable->slots[uIndex].pvValue = pvValue;
+    return oldValue;
+}
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey)
+{
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    return SymTable_find(oSymTable, pcKey) != oSymTable->slotCount;
+}
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey)
+{
+    size_t uIndex;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uIndex = SymTable_find(oSymTable, pcKey);
+    if (uIndex == oSymTable->slotCount)
+        return NULL;
+
+    return (void *)oSymTable->slots[uIndex].pvValue;
+}
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
+{
+    void *pvValue;
+    size_t uMask;
+    size_t uIndex;
+    size_t uNext;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uIndex = SymTable_find(oSymTable, pcKey);
+    if (uIndex == oSymTable->slotCount)
+        return NULL;
+
+    pvValue = (void *)oSymTable->slots[uIndex].pvValue;
+    free((void *)oSymTable->slots[uIndex].pcKey);
+
+    /* Backward-shift deletion: pull each following binding that is
+       away from its home one slot back, so no tombstone is left. */
+    uMask = oSymTable->slotCount - 1;
+    for (uNext = (uIndex + 1) & uMask;
+         oSymTable->slots[uNext].pcKey != NULL &&
+         SymTable_distance(oSymTable, uNext) > 0;
+         uNext = (uNext + 1) & uMask)
+    {
+        oSymTable->slots[uIndex] = oSymTable->slots[uNext];
+        uIndex = uNext;
+    }
+    oSymTable->slots[uIndex].pcKey = NULL;
+
+    oSymTable->bindingCount -= 1;
+    SymTable_contract(oSymTable);
+
+    return pvValue;
+}
+
+void SymTable_map(SymTable_T oSymTable,
+                  void (*pfApply)(const char *pcKey, void *pvValue,
+                                  void *pvExtra),
+                  const void *pvExtra)
+{
+    size_t u;
+
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+
+    for (u = 0; u < oSymTable->slotCount; u++)
+    {
+        if (oSymTable->slots[u].pcKey != NULL)
+            (*pfApply)(oSymTable->slots[u].pcKey,
+                       (void *)oSymTable->slots[u].pvValue,
+                       (void *)pvExtra);
+    }
+}
@@ -0,0 +1,637 @@
+/*--------------------------------------------------------------------*/
+/* symtableshm.c                                                      */
+/* Author: Ryan Chen                                                  */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+#include "symtableshm.h"
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include <stdint.h>
+
+/* Number the header of every region starts with, so that attaching to
+   a region that holds no table fails */
+static const uint64_t SHM_MAGIC = UINT64_C(0x53796d5461626c31);
+
+/* Number of buckets of an empty table. Each later bucket array is
+   twice as big, so bucket counts are powers of two. */
+static const uint64_t INITIAL_BUCKET_COUNT = 1024;
+
+/* Alignment of everything allocated in a region, enough for any value
+   a client copies in */
+static const uint64_t SHM_ALIGNMENT = 16;
+
+/* The offset that stands for a null link. Offset 0 is the header, so
+   no node is ever there. */
+static const uint64_t NO_NODE = 0;
+
+/* A SymTableShmHeader starts every region. All the table's state that
+   processes share is here or in the rest of the region. */
+struct SymTableShmHeader
+{
+    /* SHM_MAGIC */
+    uint64_t magic;
+
+    /* size of the region in bytes */
+    uint64_t regionSize;
+
+    /* size of each value in bytes */
+    uint64_t valueSize;
+
+    /* offset of the bucket array, an array of bucketCount offsets of
+       the first node of each bucket */
+    uint64_t bucketsOffset;
+
+    /* number of buckets, a power of two */
+    uint64_t bucketCount;
+
+    /* total number of bindings in the table */
+    uint64_t bindingCount;
+
+    /* offset of the first byte not yet allocated. Bytes are allocated
+       in order and never given back. */
+    uint64_t usedBytes;
+
+    /* taken for reading or writing by every operation through a
+       writable handle */
+    pthread_rwlock_t lock;
+};
+
+/* A SymTableShmNode is one binding. Its value follows it at
+   SymTableShm_roundUp(sizeof(struct SymTableShmNode)), and its key,
+   ending in '\0', follows the value. */
+struct SymTableShmNode
+{
+    /* offset of the next node in the bucket, or NO_NODE */
+    uint64_t nextOffset;
+
+    /* the mixed hash of the key, kept so that growing the bucket array
+       does not read the keys */
+    uint32_t hash;
+
+    /* the length of the key */
+    uint32_t keyLength;
+};
+
+/* A SymTableShm is one process's handle on a region. */
+struct SymTableShm
+{
+    /* where the region is mapped in this process */
+    char *pcBase;
+
+    /* nonzero if the region is mapped writable and operations lock */
+    int writable;
+};
+
+/* Function that returns the mixed hash of the uLength characters of
+   pcKey: a polynomial hash whose high bits are then made to depend on
+   every character. */
+static uint32_t SymTableShm_mix(const char *pcKey, size_t uLength)
+{
+    const size_t HASH_MULTIPLIER = 65599;
+    const uint64_t MIX_MULTIPLIER = UINT64_C(0x9E3779B97F4A7C15);
+    size_t u;
+    size_t uHash = 0;
+    uint64_t uMixed;
+
+    for (u = 0; u < uLength; u++)
+        uHash = uHash * HASH_MULTIPLIER + (size_t)pcKey[u];
+
+    uMixed = (uint64_t)uHash;
+    uMixed ^= uMixed >> 32;
+    uMixed *= MIX_MULTIPLIER;
+
+    return (uint32_t)(uMixed >> 32);
+}
+
+/* Function that maps uHash, a hash from SymTableShm_mix, onto
+   [0, uBucketCount) with Lemire's multiply-shift reduction. */
+static uint64_t SymTableShm_reduce(uint32_t uHash, uint64_t uBucketCount)
+{
+    return ((uint64_t)uHash * uBucketCount) >> 32;
+}
+
+/* Function that returns uSize rounded up to a multiple of
+   SHM_ALIGNMENT. */
+static uint64_t SymTableShm_roundUp(uint64_t uSize)
+{
+    return (uSize + SHM_ALIGNMENT - 1) / SHM_ALIGNMENT * SHM_ALIGNMENT;
+}
+
+/* Function that returns the header of the region of oSymTableShm. */
+static struct SymTableShmHeader *SymTableShm_header(
+    SymTableShm_T oSymTableShm)
+{
+    return (struct SymTableShmHeader *)(void *)oSymTableShm->pcBase;
+}
+
+/* Function that returns the address in the region of oSymTableShm of
+   the offset uOffset. */
+static void *SymTableShm_at(SymTableShm_T oSymTableShm, uint64_t uOffset)
+{
+    return oSymTableShm->pcBase + uOffset;
+}
+
+/* Function that returns the value of psNode. */
+static char *SymTableShm_value(struct SymTableShmNode *psNode)
+{
+    return (char *)psNode
+           + SymTableShm_roundUp(sizeof(struct SymTableShmNode));
+}
+
+/* Function that returns the key of psNode, a node of a table whose
+   values are uValueSize bytes each. */
+static char *SymTableShm_key(struct SymTableShmNode *psNode,
+                             uint64_t uValueSize)
+{
+    return SymTableShm_value(psNode) + SymTableShm_roundUp(uValueSize);
+}
+
+/* Function that allocates uSize bytes from the region of oSymTableShm.
+   Returns their offset, or NO_NODE if the region is full. */
+static uint64_t SymTableShm_allocate(SymTableShm_T oSymTableShm,
+                                     uint64_t uSize)
+{
+    struct SymTableShmHeader *psHeader = SymTableShm_header(oSymTableShm);
+    uint64_t uOffset;
+
+    uSize = SymTableShm_roundUp(uSize);
+    if (uSize > psHeader->regionSize - psHeader->usedBytes)
+        return NO_NODE;
+
+    uOffset = psHeader->usedBytes;
+    psHeader->usedBytes += uSize;
+    return uOffset;
+}
+
+/* Function that takes the lock of oSymTableShm, for writing if
+   iWriting, unless the handle is read-only. */
+static void SymTableShm_lock(SymTableShm_T oSymTableShm, int iWriting)
+{
+    struct SymTableShmHeader *psHeader = SymTableShm_header(oSymTableShm);
+
+    if (! oSymTableShm->writable)
+        return;
+
+    if (iWriting)
+        pthread_rwlock_wrlock(&psHeader->lock);
+    else
+        pthread_rwlock_rdlock(&psHeader->lock);
+}
+
+/* Function that releases the lock SymTableShm_lock took. */
+static void SymTableShm_unlock(SymTableShm_T oSymTableShm)
+{
+    if (oSymTableShm->writable)
+        pthread_rwlock_unlock(&SymTableShm_header(oSymTableShm)->lock);
+}
+
+/* Function that returns the link that points to the node holding
+   pcKey, whose length is uLength and whose hash is uHash, in the table
+   of oSymTableShm, or the null link at the end of its bucket if the
+   key does not exist. */
+static uint64_t *SymTableShm_find(SymTableShm_T oSymTableShm,
+                                  const char *pcKey, size_t uLength,
+                                  uint32_t uHash)
+{
+    struct SymTableShmHeader *psHeader = SymTableShm_header(oSymTableShm);
+    struct SymTableShmNode *psNode;
+    uint64_t *puBuckets;
+    uint64_t *puLink;
+
+    puBuckets = (uint64_t *)SymTableShm_at(oSymTableShm,
+                                           psHeader->bucketsOffset);
+    for (puLink = &puBuckets[SymTableShm_reduce(uHash,
+                                                psHeader->bucketCount)];
+         *puLink != NO_NODE;
+         puLink = &psNode->nextOffset)
+    {
+        psNode = (struct SymTableShmNode *)SymTableShm_at(oSymTableShm,
+                                                          *puLink);
+        if (psNode->hash == uHash && psNode->keyLength == uLength &&
+            memcmp(SymTableShm_key(psNode, psHeader->valueSize), pcKey,
+                   uLength) == 0)
+            break;
+    }
+
+    return puLink;
+}
+
+/* Function that moves every node of the table of oSymTableShm to a new
+   bucket array twice as big, allocated from the region. The old array
+   is not reused. Leaves the table unchanged if the region is full. */
+static void SymTableShm_expand(SymTableShm_T oSymTableShm)
+{
+    struct SymTableShmHeader *psHeader = SymTableShm_header(oSymTableShm);
+    struct SymTableShmNode *psNode;
+    uint64_t *puOldBuckets;
+    uint64_t *puNewBuckets;
+    uint64_t uNewOffset;
+    uint64_t uNewCount;
+    uint64_t uNodeOffset;
+    uint64_t uNextOffset;
+    uint64_t uIndex;
+    uint64_t u;
+
+    uNewCount = psHeader->bucketCount * 2;
+    if (uNewCount > (uint64_t)UINT32_MAX + 1)
+        return;
+
+    uNewOffset = SymTableShm_allocate(oSymTableShm,
+                                      uNewCount * sizeof(uint64_t));
+    if (uNewOffset == NO_NODE)
+        return;
+    puNewBuckets = (uint64_t *)SymTableShm_at(oSymTableShm, uNewOffset);
+    memset(puNewBuckets, 0, uNewCount * sizeof(uint64_t));
+
+    puOldBuckets = (uint64_t *)SymTableShm_at(oSymTableShm,
+                                              psHeader->bucketsOffset);
+    for (u = 0; u < psHeader->bucketCount; u++)
+    {
+        for (uNodeOffset = puOldBuckets[u];
+             uNodeOffset != NO_NODE;
+             uNodeOffset = uNextOffset)
+        {
+            psNode = (struct SymTableShmNode *)SymTableShm_at(
+                oSymTableShm, uNodeOffset);
+            uNextOffset = psNode->nextOffset;
+
+            uIndex = SymTableShm_reduce(psNode->hash, uNewCount);
+            psNode->nextOffset = puNewBuckets[uIndex];
+            puNewBuckets[uIndex] = uNodeOffset;
+        }
+    }
+
+    psHeader->bucketsOffset = uNewOffset;
+    psHeader->bucketCount = uNewCount;
+}
+
+/* Function that maps the region open as iFd, of uRegionSize bytes,
+   and returns a handle on it, writable if iWritable, or NULL if it
+   cannot be mapped or insufficient memory is available. */
+static SymTableShm_T SymTableShm_mapRegion(int iFd,
+                                           size_t uRegionSize,
+                                           int iWritable)
+{
+    SymTableShm_T oSymTableShm;
+    void *pvBase;
+
+    oSymTableShm = (SymTableShm_T)malloc(sizeof(struct SymTableShm));
+    if (oSymTableShm == NULL)
+        return NULL;
+
+    pvBase = mmap(NULL, uRegionSize,
+                  iWritable ? PROT_READ | PROT_WRITE : PROT_READ,
+                  MAP_SHARED, iFd, 0);
+    if (pvBase == MAP_FAILED)
+    {
+        free(oSymTableShm);
+        return NULL;
+    }
+
+    oSymTableShm->pcBase = (char *)pvBase;
+    oSymTableShm->writable = iWritable;
+    return oSymTableShm;
+}
+
+SymTableShm_T SymTableShm_create(const char *pcName, size_t uRegionSize,
+                                 size_t uValueSize)
+{
+    SymTableShm_T oSymTableShm;
+    struct SymTableShmHeader *psHeader;
+    pthread_rwlockattr_t sAttr;
+    uint64_t uHeaderSize;
+    uint64_t uBucketsSize;
+    int iFd;
+
+    assert(pcName != NULL);
+    assert(uValueSize > 0);
+
+    uHeaderSize = SymTableShm_roundUp(sizeof(struct SymTableShmHeader));
+    uBucketsSize = INITIAL_BUCKET_COUNT * sizeof(uint64_t);
+    if (uRegionSize < uHeaderSize + uBucketsSize ||
+        uValueSize > UINT32_MAX)
+        return NULL;
+
+    iFd = shm_open(pcName, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (iFd < 0)
+        return NULL;
+
+    if (ftruncate(iFd, (off_t)uRegionSize) != 0)
+    {
+        close(iFd);
+        shm_unlink(pcName);
+        return NULL;
+    }
+
+    oSymTableShm = SymTableShm_mapRegion(iFd, uRegionSize, 1);
+    close(iFd);
+    if (oSymTableShm == NULL)
+    {
+        shm_unlink(pcName);
+        return NULL;
+    }
+
+    /* ftruncate filled the region with zeros, so the first bucket
+       array is already empty. */
+    psHeader = SymTableShm_header(oSymTableShm);
+    psHeader->regionSize = uRegionSize;
+    psHeader->valueSize = uValueSize;
+    psHeader->bucketsOffset = uHeaderSize;
+    psHeader->bucketCount = INITIAL_BUCKET_COUNT;
+    psHeader->bindingCount = 0;
+    psHeader->usedBytes = uHeaderSize + uBucketsSize;
+
+    if (pthread_rwlockattr_init(&sAttr) != 0 ||
+        pthread_rwlockattr_setpshared(&sAttr,
+                                      PTHREAD_PROCESS_SHARED) != 0 ||
+        pthread_rwlock_init(&psHeader->lock, &sAttr) != 0)
+    {
+        SymTableShm_detach(oSymTableShm);
+        shm_unlink(pcName);
+        return NULL;
+    }
+    pthread_rwlockattr_destroy(&sAttr);
+
+    /* The magic number goes in last, so that no process attaches to a
+       half-made table. */
+    __atomic_store_n(&psHeader->magic, SHM_MAGIC, __ATOMIC_RELEASE);
+    return oSymTableShm;
+}
+
+SymTableShm_T SymTableShm_attach(const char *pcName, int iWritable)
+{
+    SymTableShm_T oSymTableShm;
+    struct SymTableShmHeader *psHeader;
+    struct stat sStat;
+    int iFd;
+
+    assert(pcName != NULL);
+
+    iFd = shm_open(pcName, iWritable ? O_RDWR : O_RDONLY, 0);
+    if (iFd < 0)
+        return NULL;
+
+    if (fstat(iFd, &sStat) != 0 ||
+        (size_t)sStat.st_size < sizeof(struct SymTableShmHeader))
+    {
+        close(iFd);
+        return NULL;
+    }
+
+    oSymTableShm = SymTableShm_mapRegion(iFd, (size_t)sStat.st_size,
+                                         iWritable);
+    close(iFd);
+    if (oSymTableShm == NULL)
+        return NULL;
+
+    psHeader = SymTableShm_header(oSymTableShm);
+    if (__atomic_load_n(&psHeader->magic, __ATOMIC_ACQUIRE) != SHM_MAGIC
+        || psHeader->regionSize != (uint64_t)sStat.st_size)
+    {
+        SymTableShm_detach(oSymTableShm);
+        return NULL;
+    }
+
+    return oSymTableShm;
+}
+
+void SymTableShm_detach(SymTableShm_T oSymTableShm)
+{
+    assert(oSymTableShm != NULL);
+
+    munmap(oSymTableShm->pcBase,
+           (size_t)SymTableShm_header(oSymTableShm)->regionSize);
+    free(oSymTableShm);
+}
+
+int SymTableShm_unlink(const char *pcName)
+{
+    assert(pcName != NULL);
+
+    return shm_unlink(pcName) == 0;
+}
+
+size_t SymTableShm_getLength(SymTableShm_T oSymTableShm)
+{
+    size_t uLength;
+
+    assert(oSymTableShm != NULL);
+
+    SymTableShm_lock(oSymTableShm, 0);
+    uLength = (size_t)SymTableShm_header(oSymTableShm)->bindingCount;
+    SymTableShm_unlock(oSymTableShm);
+    return uLength;
+}
+
+size_t SymTableShm_getFreeBytes(SymTableShm_T oSymTableShm)
+{
+    struct SymTableShmHeader *psHeader;
+    size_t uFree;
+
+    assert(oSymTableShm != NULL);
+
+    psHeader = SymTableShm_header(oSymTableShm);
+    SymTableShm_lock(oSymTableShm, 0);
+    uFree = (size_t)(psHeader->regionSize - psHeader->usedBytes);
+    SymTableShm_unlock(oSymTableShm);
+    return uFree;
+}
+
+int SymTableShm_put(SymTableShm_T oSymTableShm, const char *pcKey,
+                    const void *pvValue)
+{
+    struct SymTableShmHeader *psHeader;
+    struct SymTableShmNode *psNode;
+    uint64_t *puBuckets;
+    uint64_t uNodeOffset;
+    uint64_t uIndex;
+    size_t uLength;
+    uint32_t uHash;
+
+    assert(oSymTableShm != NULL);
+    assert(oSymTableShm->writable);
+    assert(pcKey != NULL);
+    assert(pvValue != NULL);
+
+    uLength = strlen(pcKey);
+    if (uLength >= UINT32_MAX)
+        return 0;
+    uHash = SymTableShm_mix(pcKey, uLength);
+
+    psHeader = SymTableShm_header(oSymTableShm);
+    SymTableShm_lock(oSymTableShm, 1);
+
+    if (*SymTableShm_find(oSymTableShm, pcKey, uLength, uHash) != NO_NODE)
+    {
+        SymTableShm_unlock(oSymTableShm);
+        return 0;
+    }
+
+    if (psHeader->bindingCount >= psHeader->bucketCount)
+        SymTableShm_expand(oSymTableShm);
+
+    uNodeOffset = SymTableShm_allocate(oSymTableShm,
+        SymTableShm_roundUp(sizeof(struct SymTableShmNode))
+        + SymTableShm_roundUp(psHeader->valueSize) + uLength + 1);
+    if (uNodeOffset == NO_NODE)
+    {
+        SymTableShm_unlock(oSymTableShm);
+        return 0;
+    }
+
+    psNode = (struct SymTableShmNode *)SymTableShm_at(oSymTableShm,
+                                                      uNodeOffset);
+    psNode->hash = uHash;
+    psNode->keyLength = (uint32_t)uLength;
+    memcpy(SymTableShm_value(psNode), pvValue,
+           (size_t)psHeader->valueSize);
+    memcpy(SymTableShm_key(psNode, psHeader->valueSize), pcKey,
+           uLength + 1);
+
+    puBuckets = (uint64_t *)SymTableShm_at(oSymTableShm,
+                                           psHeader->bucketsOffset);
+    uIndex = SymTableShm_reduce(uHash, psHeader->bucketCount);
+    psNode->nextOffset = puBuckets[uIndex];
+    puBuckets[uIndex] = uNodeOffset;
+    psHeader->bindingCount += 1;
+
+    SymTableShm_unlock(oSymTableShm);
+    return 1;
+}
+
+int SymTableShm_replace(SymTableShm_T oSymTableShm, const char *pcKey,
+                        const void *pvValue)
+{
+    struct SymTableShmHeader *psHeader;
+    struct SymTableShmNode *psNode;
+    uint64_t uNodeOffset;
+    size_t uLength;
+
+    assert(oSymTableShm != NULL);
+    assert(oSymTableShm->writable);
+    assert(pcKey != NULL);
+    assert(pvValue != NULL);
+
+    uLength = strlen(pcKey);
+    psHeader = SymTableShm_header(oSymTableShm);
+    SymTableShm_lock(oSymTableShm, 1);
+
+    uNodeOffset = *SymTableShm_find(oSymTableShm, pcKey, uLength,
+                                    SymTableShm_mix(pcKey, uLength));
+    if (uNodeOffset != NO_NODE)
+    {
+        psNode = (struct SymTableShmNode *)SymTableShm_at(oSymTableShm,
+                                                          uNodeOffset);
+        memcpy(SymTableShm_value(psNode), pvValue,
+               (size_t)psHeader->valueSize);
+    }
+
+    SymTableShm_unlock(oSymTableShm);
+    return uNodeOffset != NO_NODE;
+}
+
+int SymTableShm_contains(SymTableShm_T oSymTableShm, const char *pcKey)
+{
+    return SymTableShm_get(oSymTableShm, pcKey, NULL);
+}
+
+int SymTableShm_get(SymTableShm_T oSymTableShm, const char *pcKey,
+                    void *pvValue)
+{
+    struct SymTableShmHeader *psHeader;
+    struct SymTableShmNode *psNode;
+    uint64_t uNodeOffset;
+    size_t uLength;
+
+    assert(oSymTableShm != NULL);
+    assert(pcKey != NULL);
+
+    uLength = strlen(pcKey);
+    psHeader = SymTableShm_header(oSymTableShm);
+    SymTableShm_lock(oSymTableShm, 0);
+
+    uNodeOffset = *SymTableShm_find(oSymTableShm, pcKey, uLength,
+                                    SymTableShm_mix(pcKey, uLength));
+    if (uNodeOffset != NO_NODE && pvValue != NULL)
+    {
+        psNode = (struct SymTableShmNode *)SymTableShm_at(oSymTableShm,
+                                                          uNodeOffset);
+        memcpy(pvValue, SymTableShm_value(psNode),
+               (size_t)psHeader->valueSize);
+    }
+
+    SymTableShm_unlock(oSymTableShm);
+    return uNodeOffset != NO_NODE;
+}
+
+int SymTableShm_remove(SymTableShm_T oSymTableShm, const char *pcKey)
+{
+    struct SymTableShmNode *psNode;
+    uint64_t *puLink;
+    size_t uLength;
+    int iFound = 0;
+
+    assert(oSymTableShm != NULL);
+    assert(oSymTableShm->writable);
+    assert(pcKey != NULL);
+
+    uLength = strlen(pcKey);
+    SymTableShm_lock(oSymTableShm, 1);
+
+    puLink = SymTableShm_find(oSymTableShm, pcKey, uLength,
+                              SymTableShm_mix(pcKey, uLength));
+    if (*puLink != NO_NODE)
+    {
+        psNode = (struct SymTableShmNode *)SymTableShm_at(oSymTableShm,
+                                                          *puLink);
+        *puLink = psNode->nextOffset;
+        SymTableShm_header(oSymTableShm)->bindingCount -= 1;
+        iFound = 1;
+    }
+
+    SymTableShm_unlock(oSymTableShm);
+    return iFound;
+}
+
+void SymTableShm_map(SymTableShm_T oSymTableShm,
+                     void (*pfApply)(const char *pcKey,
+                                     const void *pvValue,
+                                     void *pvExtra),
+                     const void *pvExtra)
+{
+    struct SymTableShmHeader *psHeader;
+    struct SymTableShmNode *psNode;
+    uint64_t *puBuckets;
+    uint64_t uNodeOffset;
+    uint64_t u;
+
+    assert(oSymTableShm != NULL);
+    assert(pfApply != NULL);
+
+    psHeader = SymTableShm_header(oSymTableShm);
+    SymTableShm_lock(oSymTableShm, 0);
+
+    puBuckets = (uint64_t *)SymTableShm_at(oSymTableShm,
+                                           psHeader->bucketsOffset);
+    for (u = 0; u < psHeader->bucketCount; u++)
+    {
+        for (uNodeOffset = puBuckets[u];
+             uNodeOffset != NO_NODE;
+             uNodeOffset = psNode->nextOffset)
+        {
+            psNode = (struct SymTableShmNode *)SymTableShm_at(
+                oSymTableShm, uNodeOffset);
+            (*pfApply)(SymTableShm_key(psNode, psHeader->valueSize),
+                       SymTableShm_value(psNode), (void *)pvExtra);
+        }
+    }
+
+    SymTableShm_unlock(oSymTableShm);
+}
@@ -0,0 +1,99 @@
+/*--------------------------------------------------------------------*/
+/* symtableshm.h                                                      */
+/* Author: Ryan Chen                                                  */
+/*--------------------------------------------------------------------*/
+
+#ifndef symtableshm
+#define symtableshm
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* A SymTableShm_T object is a handle on a hash table that lives in a
+   named POSIX shared memory region, so that several processes can use
+   one copy of it. Every link inside the region is an offset from its
+   start, so each process may map it at a different address. Values
+   are byte strings of a size fixed when the table is created, copied
+   into the region beside their keys. */
+typedef struct SymTableShm *SymTableShm_T;
+
+/* Creates a shared memory region named pcName, of uRegionSize bytes,
+   holding an empty table whose values are uValueSize bytes each, and
+   returns a writable handle on it. pcName must start with '/' and
+   name no existing region; uValueSize must be positive. Bindings are
+   allocated from the region in order and the region never grows, so
+   uRegionSize bounds what the table can hold. Returns NULL if the
+   region cannot be created or is too small for an empty table. */
+SymTableShm_T SymTableShm_create(const char *pcName, size_t uRegionSize,
+     size_t uValueSize);
+
+/* Returns a handle on the table in the region named pcName, made by
+   SymTableShm_create in this or another process, or NULL if it cannot
+   be opened or holds no table. If iWritable, the handle may change
+   the table, and every operation through it takes a process-shared
+   read-write lock in the region, so any number of processes may share
+   the table read-write. Otherwise the region is mapped read-only and
+   operations take no lock, so no process may change the table while
+   the handle is in use: build it first, then attach the readers. */
+SymTableShm_T SymTableShm_attach(const char *pcName, int iWritable);
+
+/* Unmaps the region of oSymTableShm and frees the handle. The table
+   stays in the region for other handles. */
+void SymTableShm_detach(SymTableShm_T oSymTableShm);
+
+/* Removes the name pcName, so that it can be created again. Processes
+   that have the region attached keep it until they detach. Returns 1
+   if successful, or 0 if there is no such region. */
+int SymTableShm_unlink(const char *pcName);
+
+/* Returns the number of bindings in the table of oSymTableShm. */
+size_t SymTableShm_getLength(SymTableShm_T oSymTableShm);
+
+/* Returns the number of bytes of the region of oSymTableShm not yet
+   used. */
+size_t SymTableShm_getFreeBytes(SymTableShm_T oSymTableShm);
+
+/* Adds pcKey to the table of oSymTableShm, a writable handle, bound to
+   a copy of the value that pvValue points to, if pcKey doesn't exist
+   in the table. Otherwise, leaves the table unchanged. Returns 1 if
+   successful, 0 if the key already exists or the region is full. */
+int SymTableShm_put(SymTableShm_T oSymTableShm, const char *pcKey,
+     const void *pvValue);
+
+/* Replaces the value bound to pcKey in the table of oSymTableShm, a
+   writable handle, with a copy of the value that pvValue points to.
+   Returns 1 if successful, or 0 if the key does not exist. */
+int SymTableShm_replace(SymTableShm_T oSymTableShm, const char *pcKey,
+     const void *pvValue);
+
+/* Checks if pcKey exists in the table of oSymTableShm. Returns 1 if
+   the key exists, 0 otherwise. */
+int SymTableShm_contains(SymTableShm_T oSymTableShm, const char *pcKey);
+
+/* Copies the value bound to pcKey in the table of oSymTableShm to
+   pvValue, unless pvValue is NULL. The copy is made under the lock,
+   so it is never torn by a concurrent SymTableShm_replace. Returns 1
+   if the key exists, 0 otherwise. */
+int SymTableShm_get(SymTableShm_T oSymTableShm, const char *pcKey,
+     void *pvValue);
+
+/* Removes the binding of pcKey from the table of oSymTableShm, a
+   writable handle, if it exists. The region does not reuse the
+   binding's bytes. Returns 1 if the key existed, 0 otherwise. */
+int SymTableShm_remove(SymTableShm_T oSymTableShm, const char *pcKey);
+
+/* Applies function pfApply to each binding in the table of
+   oSymTableShm, passing pvExtra as an extra parameter. pvValue points
+   into the region; pfApply must not use oSymTableShm. */
+void SymTableShm_map(SymTableShm_T oSymTableShm,
+    void (*pfApply)(const char *pcKey, const void *pvValue,
+                    void *pvExtra),
+    const void *pvExtra);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,483 @@
+/*--------------------------------------------------------------------*/
+/* symtabletrace.c                                                    */
+/* Author: Ryan Chen                                                  */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+#include "symtabletrace.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/* First bytes of every trace file */
+static const char TRACE_MAGIC[8] = {'S', 'Y', 'M', 'T', 'R', 'C', '0', '1'};
+
+/* Bytes of records buffered before they are written */
+enum {BUFFER_SIZE = 65536};
+
+/* Most bytes a varint of a uint64_t takes */
+enum {MAX_VARINT_SIZE = 10};
+
+/* The clock is read for one record in every TIME_STRIDE, and the
+   records between take that time. Reading it orders the processor's
+   loads, so reading it for every record would keep the misses of one
+   lookup from overlapping those of the next, and more than double the
+   cost of tracing a table bigger than the cache. */
+enum {TIME_STRIDE = 16};
+
+/* Each record is an op byte, whose low bits are the SymTableTraceOp and
+   whose RESULT_BIT is the result, then the varints of the table id and
+   of the nanoseconds since the record before, and then, for an
+   operation on a key, the varint of its length and its bytes. */
+enum {OP_MASK = 0x0F, RESULT_BIT = 0x10};
+
+/* The trace this process writes. All but the settings read once are
+   guarded by traceMutex. */
+static pthread_once_t traceOnce = PTHREAD_ONCE_INIT;
+static pthread_mutex_t traceMutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* the trace file, or NULL if the process does not trace */
+static FILE *psTraceFile;
+
+/* the name of the trace file of the process that started the trace,
+   with room after it for the process id that names the file of each
+   child it forks */
+static char *pcForkFileName;
+static size_t traceNameLength;
+
+/* number of tables created before this process was forked from the
+   one it inherited them from, which traces them instead */
+static unsigned long inheritedCount;
+
+/* one table in every sampleInterval is traced */
+static unsigned long sampleInterval = 1;
+
+/* number of tables created, traced or not */
+static unsigned long tableCount;
+
+/* the time the trace started, and that of the record last made */
+static uint64_t startTime;
+static uint64_t lastTime;
+
+/* number of records made since the clock was last read */
+static unsigned untimedCount;
+
+/* records not yet written */
+static unsigned char traceBuffer[BUFFER_SIZE];
+static size_t bufferLength;
+
+/* A SymTableTraceReader holds a whole trace file. */
+struct SymTableTraceReader
+{
+    /* the contents of the file */
+    unsigned char *pucText;
+
+    /* length of pucText */
+    size_t length;
+
+    /* offset of the next record */
+    size_t position;
+
+    /* time of the record last read */
+    uint64_t time;
+};
+
+/* Function that returns the time in nanoseconds since some fixed
+   point. */
+static uint64_t SymTableTrace_now(void)
+{
+    struct timespec sNow;
+
+    clock_gettime(CLOCK_MONOTONIC, &sNow);
+    return (uint64_t)sNow.tv_sec * UINT64_C(1000000000)
+           + (uint64_t)sNow.tv_nsec;
+}
+
+/* Function that writes the buffered records to the trace file. The
+   caller holds traceMutex. A trace that cannot be written is given up,
+   so that the process goes on untraced. */
+static void SymTableTrace_flush(void)
+{
+    if (bufferLength > 0 &&
+        fwrite(traceBuffer, 1, bufferLength, psTraceFile)
+        != bufferLength)
+    {
+        fclose(psTraceFile);
+        psTraceFile = NULL;
+    }
+    bufferLength = 0;
+}
+
+/* Function that appends the uLength bytes of pvBytes to the trace,
+   writing out the buffer whenever it fills. The caller holds
+   traceMutex. */
+static void SymTableTrace_append(const void *pvBytes, size_t uLength)
+{
+    const unsigned char *pucBytes = (const unsigned char *)pvBytes;
+    size_t uChunk;
+
+    while (uLength > 0 && psTraceFile != NULL)
+    {
+        if (bufferLength == BUFFER_SIZE)
+            SymTableTrace_flush();
+        uChunk = BUFFER_SIZE - bufferLength;
+        if (uChunk > uLength)
+            uChunk = uLength;
+        memcpy(traceBuffer + bufferLength, pucBytes, uChunk);
+        bufferLength += uChunk;
+        pucBytes += uChunk;
+        uLength -= uChunk;
+    }
+}
+
+/* Function that stores uValue at pucOut as a varint: seven bits to a
+   byte, low bits first, with the top bit of each byte but the last
+   set. Returns the number of bytes stored. */
+static size_t SymTableTrace_putVarint(unsigned char *pucOut,
+                                      uint64_t uValue)
+{
+    size_t u = 0;
+
+    while (uValue >= 0x80)
+    {
+        pucOut[u++] = (unsigned char)(uValue | 0x80);
+        uValue >>= 7;
+    }
+    pucOut[u++] = (unsigned char)uValue;
+    return u;
+}
+
+/* Function that writes the rest of the trace when the process
+   exits. */
+static void SymTableTrace_finish(void)
+{
+    pthread_mutex_lock(&traceMutex);
+    if (psTraceFile != NULL)
+    {
+        SymTableTrace_flush();
+        if (psTraceFile != NULL)
+            fclose(psTraceFile);
+        psTraceFile = NULL;
+    }
+    pthread_mutex_unlock(&traceMutex);
+}
+
+/* Function that takes traceMutex before the process forks, so that no
+   other thread is in the middle of a record. */
+static void SymTableTrace_prepareFork(void)
+{
+    pthread_mutex_lock(&traceMutex);
+}
+
+/* Function that releases traceMutex in the parent after a fork. */
+static void SymTableTrace_parentFork(void)
+{
+    pthread_mutex_unlock(&traceMutex);
+}
+
+/* Function that gives a child process a trace of its own after a fork,
+   in a file named for its process id. The records buffered in the
+   parent are the parent's to write, so they are dropped here, and the
+   stream of the parent's file buffers nothing, so closing it here
+   writes nothing. The tables the child inherits are left to the
+   parent's trace, since their creation is recorded there. If the new
+   file cannot be opened, the child goes untraced. */
+static void SymTableTrace_childFork(void)
+{
+    bufferLength = 0;
+    if (psTraceFile != NULL)
+    {
+        fclose(psTraceFile);
+        sprintf(pcForkFileName + traceNameLength, ".%ld",
+                (long)getpid());
+        psTraceFile = fopen(pcForkFileName, "wb");
+        if (psTraceFile != NULL)
+            setvbuf(psTraceFile, NULL, _IONBF, 0);
+    }
+
+    inheritedCount = tableCount;
+    memcpy(traceBuffer, TRACE_MAGIC, sizeof(TRACE_MAGIC));
+    bufferLength = sizeof(TRACE_MAGIC);
+    startTime = SymTableTrace_now();
+    lastTime = 0;
+    untimedCount = TIME_STRIDE - 1;
+    pthread_mutex_unlock(&traceMutex);
+}
+
+/* Function that opens the trace file the environment names, if any,
+   and reads the sampling interval. Runs once, before the first table
+   is created. */
+static void SymTableTrace_start(void)
+{
+    const char *pcFileName;
+    const char *pcSample;
+    char *pcEnd;
+    unsigned long ulInterval;
+
+    pcFileName = getenv("SYMTABLE_TRACE");
+    if (pcFileName == NULL || *pcFileName == '\0')
+        return;
+
+    pcSample = getenv("SYMTABLE_TRACE_SAMPLE");
+    if (pcSample != NULL)
+    {
+        ulInterval = strtoul(pcSample, &pcEnd, 10);
+        if (*pcEnd == '\0' && ulInterval > 0)
+            sampleInterval = ulInterval;
+    }
+
+    /* Room for a '.', the digits of a long, and a '\0' */
+    traceNameLength = strlen(pcFileName);
+    pcForkFileName = (char *)malloc(traceNameLength + 2
+                                    + 3 * sizeof(long));
+    if (pcForkFileName == NULL)
+        return;
+    strcpy(pcForkFileName, pcFileName);
+
+    /* Records are buffered in traceBuffer only, so that a child
+       inherits no records of its parent that stdio has yet to
+       write. */
+    psTraceFile = fopen(pcFileName, "wb");
+    if (psTraceFile == NULL)
+        return;
+    setvbuf(psTraceFile, NULL, _IONBF, 0);
+    if (atexit(SymTableTrace_finish) != 0 ||
+        pthread_atfork(SymTableTrace_prepareFork,
+                       SymTableTrace_parentFork,
+                       SymTableTrace_childFork) != 0)
+    {
+        fclose(psTraceFile);
+        psTraceFile = NULL;
+        return;
+    }
+
+    memcpy(traceBuffer, TRACE_MAGIC, sizeof(TRACE_MAGIC));
+    bufferLength = sizeof(TRACE_MAGIC);
+    startTime = SymTableTrace_now();
+    lastTime = 0;
+    untimedCount = TIME_STRIDE - 1;
+}
+
+/* Function that appends a record of eOp on the table traced under
+   ulTableId to the trace. The caller holds traceMutex. */
+static void SymTableTrace_write(unsigned long ulTableId,
+                                enum SymTableTraceOp eOp,
+                                const char *pcKey, int iResult)
+{
+    unsigned char aucHeader[1 + 3 * MAX_VARINT_SIZE];
+    size_t uLength = 1;
+    size_t uKeyLength = 0;
+    uint64_t uNow;
+
+    if (psTraceFile == NULL || ulTableId <= inheritedCount)
+        return;
+
+    /* Threads may take the time in one order and the mutex in the
+       other, so the clock is read under the mutex. */
+    uNow = lastTime;
+    if (++untimedCount == TIME_STRIDE)
+    {
+        untimedCount = 0;
+        uNow = SymTableTrace_now() - startTime;
+        if (uNow < lastTime)
+            uNow = lastTime;
+    }
+
+    aucHeader[0] = (unsigned char)((unsigned)eOp
+                                   | (iResult ? RESULT_BIT : 0));
+    uLength += SymTableTrace_putVarint(aucHeader + uLength,
+                                       (uint64_t)ulTableId);
+    uLength += SymTableTrace_putVarint(aucHeader + uLength,
+                                       uNow - lastTime);
+    if (pcKey != NULL)
+    {
+        uKeyLength = strlen(pcKey);
+        uLength += SymTableTrace_putVarint(aucHeader + uLength,
+                                           (uint64_t)uKeyLength);
+    }
+    lastTime = uNow;
+
+    SymTableTrace_append(aucHeader, uLength);
+    if (pcKey != NULL)
+        SymTableTrace_append(pcKey, uKeyLength);
+}
+
+unsigned long SymTableTrace_newTable(void)
+{
+    unsigned long ulTableId = 0;
+
+    pthread_once(&traceOnce, SymTableTrace_start);
+    if (psTraceFile == NULL)
+        return 0;
+
+    pthread_mutex_lock(&traceMutex);
+    tableCount += 1;
+    if ((tableCount - 1) % sampleInterval == 0)
+    {
+        ulTableId = tableCount;
+        SymTableTrace_write(ulTableId, SYMTABLE_TRACE_NEW, NULL, 1);
+    }
+    pthread_mutex_unlock(&traceMutex);
+
+    return ulTableId;
+}
+
+void SymTableTrace_record(unsigned long ulTableId,
+                          enum SymTableTraceOp eOp, const char *pcKey,
+                          int iResult)
+{
+    assert(ulTableId != 0);
+
+    pthread_mutex_lock(&traceMutex);
+    SymTableTrace_write(ulTableId, eOp, pcKey, iResult);
+    pthread_mutex_unlock(&traceMutex);
+}
+
+/* Function that reads a varint from oReader into *puValue. Returns 1
+   if successful, or 0 if the trace ends first or the varint is too
+   long. */
+static int SymTableTraceReader_getVarint(SymTableTraceReader_T oReader,
+                                         uint64_t *puValue)
+{
+    uint64_t uValue = 0;
+    unsigned uShift = 0;
+    unsigned char ucByte;
+
+    do
+    {
+        if (oReader->position == oReader->length ||
+            uShift >= 7 * MAX_VARINT_SIZE)
+            return 0;
+        ucByte = oReader->pucText[oReader->position++];
+        uValue |= (uint64_t)(ucByte & 0x7F) << uShift;
+        uShift += 7;
+    } while (ucByte & 0x80);
+
+    *puValue = uValue;
+    return 1;
+}
+
+SymTableTraceReader_T SymTableTraceReader_open(const char *pcFileName)
+{
+    SymTableTraceReader_T oReader;
+    FILE *psFile;
+    unsigned char *pucText = NULL;
+    unsigned char *pucMore;
+    size_t uCapacity = 0;
+    size_t uLength = 0;
+
+    assert(pcFileName != NULL);
+
+    psFile = fopen(pcFileName, "rb");
+    if (psFile == NULL)
+        return NULL;
+
+    /* Read to the end, doubling the buffer, so that a trace still
+       being written or piped in is read as far as it goes. */
+    for (;;)
+    {
+        if (uLength == uCapacity)
+        {
+            uCapacity = uCapacity == 0 ? BUFFER_SIZE : 2 * uCapacity;
+            pucMore = (unsigned char *)realloc(pucText, uCapacity);
+            if (pucMore == NULL)
+            {
+                free(pucText);
+                fclose(psFile);
+                return NULL;
+            }
+            pucText = pucMore;
+        }
+        uLength += fread(pucText + uLength, 1, uCapacity - uLength,
+                         psFile);
+        if (uLength < uCapacity)
+            break;
+    }
+    fclose(psFile);
+
+    if (uLength < sizeof(TRACE_MAGIC) ||
+        memcmp(pucText, TRACE_MAGIC, sizeof(TRACE_MAGIC)) != 0)
+    {
+        free(pucText);
+        return NULL;
+    }
+
+    oReader = (SymTableTraceReader_T)malloc(
+                  sizeof(struct SymTableTraceReader));
+    if (oReader == NULL)
+    {
+        free(pucText);
+        return NULL;
+    }
+
+    oReader->pucText = pucText;
+    oReader->length = uLength;
+    oReader->position = sizeof(TRACE_MAGIC);
+    oReader->time = 0;
+    return oReader;
+}
+
+int SymTableTraceReader_next(SymTableTraceReader_T oReader,
+                             struct SymTableTraceRecord *psRecord)
+{
+    unsigned char ucOp;
+    uint64_t uTableId;
+    uint64_t uDelta;
+    uint64_t uKeyLength;
+
+    assert(oReader != NULL);
+    assert(psRecord != NULL);
+
+    if (oReader->position == oReader->length)
+        return 0;
+
+    ucOp = oReader->pucText[oReader->position++];
+    if ((ucOp & OP_MASK) > SYMTABLE_TRACE_MAP ||
+        (ucOp & ~(OP_MASK | RESULT_BIT)) != 0)
+        return -1;
+    if (! SymTableTraceReader_getVarint(oReader, &uTableId) ||
+        uTableId == 0 || uTableId > (uint64_t)(unsigned long)-1 ||
+        ! SymTableTraceReader_getVarint(oReader, &uDelta))
+        return -1;
+
+    psRecord->op = (enum SymTableTraceOp)(ucOp & OP_MASK);
+    psRecord->tableId = (unsigned long)uTableId;
+    psRecord->result = (ucOp & RESULT_BIT) != 0;
+    oReader->time += uDelta;
+    psRecord->time = oReader->time;
+    psRecord->pcKey = NULL;
+    psRecord->keyLength = 0;
+
+    switch (psRecord->op)
+    {
+        case SYMTABLE_TRACE_PUT:
+        case SYMTABLE_TRACE_GET:
+        case SYMTABLE_TRACE_CONTAINS:
+        case SYMTABLE_TRACE_REPLACE:
+        case SYMTABLE_TRACE_REMOVE:
+            if (! SymTableTraceReader_getVarint(oReader, &uKeyLength) ||
+                uKeyLength > oReader->length - oReader->position)
+                return -1;
+            psRecord->pcKey =
+                (const char *)oReader->pucText + oReader->position;
+            psRecord->keyLength = (size_t)uKeyLength;
+            oReader->position += (size_t)uKeyLength;
+            break;
+        default:
+            break;
+    }
+
+    return 1;
+}
+
+void SymTableTraceReader_free(SymTableTraceReader_T oReader)
+{
+    assert(oReader != NULL);
+
+    free(oReader->pucText);
+    free(oReader);
+}
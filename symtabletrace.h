@@ -0,0 +1,105 @@
+/*--------------------------------------------------------------------*/
+/* symtabletrace.h                                                    */
+/* Author: Ryan Chen                                                  */
+/*--------------------------------------------------------------------*/
+
+#ifndef symtabletrace
+#define symtabletrace
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Operations a trace records. The records of each table come between
+   the SYMTABLE_TRACE_NEW and SYMTABLE_TRACE_FREE records of its id,
+   unless the process exited with the table still in use. */
+enum SymTableTraceOp
+{
+    SYMTABLE_TRACE_NEW,
+    SYMTABLE_TRACE_FREE,
+    SYMTABLE_TRACE_PUT,
+    SYMTABLE_TRACE_GET,
+    SYMTABLE_TRACE_CONTAINS,
+    SYMTABLE_TRACE_REPLACE,
+    SYMTABLE_TRACE_REMOVE,
+    SYMTABLE_TRACE_MAP
+};
+
+/* One record of a trace */
+struct SymTableTraceRecord
+{
+    /* the operation */
+    enum SymTableTraceOp op;
+
+    /* the id of the table it was called on, never 0 */
+    unsigned long tableId;
+
+    /* nanoseconds from the start of the trace to the end of the
+       operation, or of one at most 15 records before it, since the
+       clock is read for only one record in 16 */
+    uint64_t time;
+
+    /* the key, not ending in '\0', or NULL if the operation takes
+       none */
+    const char *pcKey;
+
+    /* the length of the key */
+    size_t keyLength;
+
+    /* 1 if SymTable_put succeeded, SymTable_contains found the key, or
+       SymTable_get, SymTable_replace or SymTable_remove returned a
+       value other than NULL, or else 0 */
+    int result;
+};
+
+/* Returns the id under which to trace a new table, having recorded
+   that it was created, or 0 if it is not to be traced. Implementations
+   compiled with SYMTABLE_TRACE call it, and then SymTableTrace_record,
+   for each table. A process traces only if the environment variable
+   SYMTABLE_TRACE names a file that can be written to when its first
+   table is created. It then traces one table in every
+   SYMTABLE_TRACE_SAMPLE, or every table if that is not set, and each
+   traced table for its whole life, so that the trace can be replayed.
+   Records are buffered, and the trace is finished when the process
+   exits. A child forked after the trace started writes a trace of its
+   own, to the file named by SYMTABLE_TRACE followed by '.' and the
+   child's process id, or none if that file cannot be written. It
+   traces only the tables it creates, so that its trace can be
+   replayed alone; what it does with the tables it inherits is traced
+   nowhere. */
+unsigned long SymTableTrace_newTable(void);
+
+/* Records operation eOp, just completed on the table traced under
+   ulTableId, on the key pcKey, or NULL if eOp takes none, with iResult
+   as the result of struct SymTableTraceRecord. ulTableId must not be
+   0. Tables may be traced from any number of threads. */
+void SymTableTrace_record(unsigned long ulTableId,
+     enum SymTableTraceOp eOp, const char *pcKey, int iResult);
+
+/* A SymTableTraceReader_T object reads the records of a trace in the
+   order they were made. */
+typedef struct SymTableTraceReader *SymTableTraceReader_T;
+
+/* Returns a new SymTableTraceReader_T object positioned at the first
+   record of the trace in the file pcFileName, or NULL if the file
+   cannot be read, is not a trace, or insufficient memory is
+   available. */
+SymTableTraceReader_T SymTableTraceReader_open(const char *pcFileName);
+
+/* Fills in *psRecord with the next record of oReader. Its key stays
+   valid until oReader is freed. Returns 1 if there was a record, 0 at
+   the end of the trace, or -1 if the rest of the trace is
+   malformed, as a trace cut short by a crash is. */
+int SymTableTraceReader_next(SymTableTraceReader_T oReader,
+     struct SymTableTraceRecord *psRecord);
+
+/* Frees oReader and the keys of its records. */
+void SymTableTraceReader_free(SymTableTraceReader_T oReader);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
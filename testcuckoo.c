@@ -0,0 +1,258 @@
+/*--------------------------------------------------------------------*/
+/* testcuckoo.c                                                       */
+/* Author: Ryan Chen                                                  */
+/*--------------------------------------------------------------------*/
+
+#include "symtable.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <stdint.h>
+
+/* The table this test runs against must start every hash from this
+   seed, so that the test knows which keys collide. */
+#ifndef SYMTABLE_FIXED_SEED
+#error "build with -DSYMTABLE_FIXED_SEED=n, as symtablecuckoo.c was"
+#endif
+
+/*--------------------------------------------------------------------*/
+
+#define ASSURE(i) assure(i, __LINE__)
+
+/*--------------------------------------------------------------------*/
+
+/* If !iSuccessful, print a message to stdout indicating that the
+   test at line iLineNum failed. */
+
+static void assure(int iSuccessful, int iLineNum)
+{
+   if (! iSuccessful)
+   {
+      printf("Test at line %d failed.\n", iLineNum);
+      fflush(stdout);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+enum {SLOTS_PER_BUCKET = 4, STASH_SIZE = 4, MAX_KEY_LENGTH = 24};
+
+/* The colliding keys share both their buckets in any table of up to
+   COLLISION_BUCKETS buckets. */
+enum {COLLISION_BUCKETS = 1024};
+
+/* Enough colliding keys to fill both their buckets and the stash, and
+   one more */
+enum {COLLIDING_COUNT = 2 * SLOTS_PER_BUCKET + STASH_SIZE + 1};
+
+/*--------------------------------------------------------------------*/
+
+/* Return the hash of pcKey with uSeed, exactly as symtablecuckoo.c
+   computes it. */
+
+static uint64_t hashKey(const char *pcKey, uint64_t uSeed)
+{
+   const uint64_t HASH_MULTIPLIER = UINT64_C(0x100000001B3);
+   const uint64_t MIX_MULTIPLIER = UINT64_C(0x9E3779B97F4A7C15);
+   uint64_t uHash = uSeed;
+   size_t u;
+
+   for (u = 0; pcKey[u] != '\0'; u++)
+      uHash = (uHash ^ (unsigned char)pcKey[u]) * HASH_MULTIPLIER;
+
+   uHash ^= uHash >> 32;
+   uHash *= MIX_MULTIPLIER;
+   uHash ^= uHash >> 29;
+
+   return uHash;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a number that two keys share exactly when, in any table of up
+   to COLLISION_BUCKETS buckets seeded with SYMTABLE_FIXED_SEED, they
+   have the same first bucket and the same offset to their second, as
+   symtablecuckoo.c derives them. */
+
+static size_t bucketsOf(const char *pcKey)
+{
+   uint64_t uHash = hashKey(pcKey, (uint64_t)SYMTABLE_FIXED_SEED);
+   uint32_t uTag = (uint32_t)(uHash >> 32);
+   size_t uFirst = (size_t)uHash & (COLLISION_BUCKETS - 1);
+   size_t uOffset = ((size_t)(uTag * UINT32_C(0x5BD1E995))
+                     & (COLLISION_BUCKETS - 1)) | 1;
+
+   return uFirst * COLLISION_BUCKETS + uOffset;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Add the int that pvValue points to to the long that pvExtra points
+   to. */
+
+static void sumInts(const char *pcKey, void *pvValue, void *pvExtra)
+{
+   assert(pcKey != NULL);
+   assert(pvValue != NULL);
+   assert(pvExtra != NULL);
+
+   *(long*)pvExtra += *(int*)pvValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that keys chosen so that they all share both their buckets are
+   each still found, and that the table stays correct: the first ones
+   fill the two buckets, the next ones go to the stash, and the last
+   one makes the table rebuild with a new seed. Then fill the table
+   with ordinary keys, which the search for a free slot has to move
+   around, and take the colliding keys out again. Do it in a table that
+   starts small and grows, and in one sized up front. */
+
+static void testCollisions(void)
+{
+   enum {ORDINARY_COUNT = 800};
+
+   static char aacColliding[COLLIDING_COUNT][MAX_KEY_LENGTH];
+   static char aacOrdinary[ORDINARY_COUNT][MAX_KEY_LENGTH];
+   static int aiValues[COLLIDING_COUNT + ORDINARY_COUNT];
+   const size_t auCapacities[] = {0, ORDINARY_COUNT};
+   SymTable_T oSymTable;
+   char acKey[MAX_KEY_LENGTH];
+   size_t uBuckets;
+   size_t uTable;
+   long lSum;
+   long lExpected;
+   int iFound = 0;
+   int iSuccessful;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable objects with colliding keys.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   uBuckets = bucketsOf("collide0");
+   for (i = 0; iFound < COLLIDING_COUNT; i++)
+   {
+      sprintf(acKey, "collide%d", i);
+      if (bucketsOf(acKey) == uBuckets)
+         strcpy(aacColliding[iFound++], acKey);
+   }
+   for (i = 0; i < ORDINARY_COUNT; i++)
+      sprintf(aacOrdinary[i], "ordinary%d", i);
+   for (i = 0; i < COLLIDING_COUNT + ORDINARY_COUNT; i++)
+      aiValues[i] = i;
+
+   for (uTable = 0;
+        uTable < sizeof(auCapacities) / sizeof(auCapacities[0]);
+        uTable++)
+   {
+      oSymTable = SymTable_newWithCapacity(auCapacities[uTable]);
+      ASSURE(oSymTable != NULL);
+
+      /* Both buckets fill, then the stash. */
+      for (i = 0; i < COLLIDING_COUNT - 1; i++)
+      {
+         iSuccessful = SymTable_put(oSymTable, aacColliding[i],
+                                    &aiValues[i]);
+         ASSURE(iSuccessful);
+      }
+      ASSURE(SymTable_getLength(oSymTable) == COLLIDING_COUNT - 1);
+      for (i = 0; i < COLLIDING_COUNT - 1; i++)
+         ASSURE(SymTable_get(oSymTable, aacColliding[i])
+                == &aiValues[i]);
+      ASSURE(! SymTable_contains(oSymTable,
+                                 aacColliding[COLLIDING_COUNT - 1]));
+
+      /* A key leaves a bucket, and another the stash, and both come
+         back. */
+      ASSURE(SymTable_remove(oSymTable, aacColliding[0])
+             == &aiValues[0]);
+      ASSURE(SymTable_remove(oSymTable, aacColliding[COLLIDING_COUNT - 2])
+             == &aiValues[COLLIDING_COUNT - 2]);
+      ASSURE(! SymTable_contains(oSymTable, aacColliding[0]));
+      ASSURE(! SymTable_contains(oSymTable,
+                                 aacColliding[COLLIDING_COUNT - 2]));
+      for (i = 1; i < COLLIDING_COUNT - 2; i++)
+         ASSURE(SymTable_get(oSymTable, aacColliding[i])
+                == &aiValues[i]);
+      iSuccessful = SymTable_put(oSymTable, aacColliding[0],
+                                 &aiValues[0]);
+      ASSURE(iSuccessful);
+      iSuccessful = SymTable_put(oSymTable,
+                                 aacColliding[COLLIDING_COUNT - 2],
+                                 &aiValues[COLLIDING_COUNT - 2]);
+      ASSURE(iSuccessful);
+      iSuccessful = SymTable_put(oSymTable, aacColliding[0],
+                                 &aiValues[1]);
+      ASSURE(! iSuccessful);
+
+      /* With the stash full, the last key makes the table rebuild. */
+      iSuccessful = SymTable_put(oSymTable,
+                                 aacColliding[COLLIDING_COUNT - 1],
+                                 &aiValues[COLLIDING_COUNT - 1]);
+      ASSURE(iSuccessful);
+      ASSURE(SymTable_getLength(oSymTable) == COLLIDING_COUNT);
+      for (i = 0; i < COLLIDING_COUNT; i++)
+         ASSURE(SymTable_get(oSymTable, aacColliding[i])
+                == &aiValues[i]);
+
+      /* Ordinary keys crowd in around them. */
+      for (i = 0; i < ORDINARY_COUNT; i++)
+      {
+         iSuccessful = SymTable_put(oSymTable, aacOrdinary[i],
+                                    &aiValues[COLLIDING_COUNT + i]);
+         ASSURE(iSuccessful);
+      }
+      ASSURE(SymTable_getLength(oSymTable)
+             == COLLIDING_COUNT + ORDINARY_COUNT);
+      for (i = 0; i < COLLIDING_COUNT; i++)
+         ASSURE(SymTable_get(oSymTable, aacColliding[i])
+                == &aiValues[i]);
+      for (i = 0; i < ORDINARY_COUNT; i++)
+         ASSURE(SymTable_get(oSymTable, aacOrdinary[i])
+                == &aiValues[COLLIDING_COUNT + i]);
+      for (i = 0; i < ORDINARY_COUNT; i++)
+      {
+         sprintf(acKey, "absent%d", i);
+         ASSURE(! SymTable_contains(oSymTable, acKey));
+      }
+      lExpected = (long)(COLLIDING_COUNT + ORDINARY_COUNT)
+                  * (COLLIDING_COUNT + ORDINARY_COUNT - 1) / 2;
+      lSum = 0;
+      SymTable_map(oSymTable, sumInts, &lSum);
+      ASSURE(lSum == lExpected);
+
+      /* The colliding keys go, and the ordinary ones stay. */
+      for (i = 0; i < COLLIDING_COUNT; i++)
+         ASSURE(SymTable_remove(oSymTable, aacColliding[i])
+                == &aiValues[i]);
+      ASSURE(SymTable_getLength(oSymTable) == ORDINARY_COUNT);
+      for (i = 0; i < COLLIDING_COUNT; i++)
+         ASSURE(! SymTable_contains(oSymTable, aacColliding[i]));
+      for (i = 0; i < ORDINARY_COUNT; i++)
+         ASSURE(SymTable_get(oSymTable, aacOrdinary[i])
+                == &aiValues[COLLIDING_COUNT + i]);
+
+      SymTable_free(oSymTable);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test symtablecuckoo.c with keys crafted to collide. As always, argc
+   is the command-line argument count and argv contains the
+   command-line arguments. Return 0. */
+
+int main(int argc, char *argv[])
+{
+   (void)argc;
+
+   testCollisions();
+
+   printf("------------------------------------------------------\n");
+   printf("End of %s.\n", argv[0]);
+   return 0;
+}
@@ -0,0 +1,1759 @@
+/*--------------------------------------------------------------------*/
+/* testhashext.c                                                      */
+/* Author: Ryan Chen                                                  */
+/*--------------------------------------------------------------------*/
+
+#include "symtablehash.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+
+/*--------------------------------------------------------------------*/
+
+#define ASSURE(i) assure(i, __LINE__)
+
+/*--------------------------------------------------------------------*/
+
+/* If !iSuccessful, print a message to stdout indicating that the
+   test at line iLineNum failed. */
+
+static void assure(int iSuccessful, int iLineNum)
+{
+   if (! iSuccessful)
+   {
+      printf("Test at line %d failed.\n", iLineNum);
+      fflush(stdout);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* A Position is a small struct of the kind a symbol table binds to
+   each name. */
+struct Position
+{
+   int iLine;
+   int iColumn;
+   double dWeight;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Add the iLine of the Position that pvValue points to to the int that
+   pvExtra points to. */
+
+static void sumLines(const char *pcKey, void *pvValue, void *pvExtra)
+{
+   assert(pcKey != NULL);
+   assert(pvValue != NULL);
+   assert(pvExtra != NULL);
+
+   *(int*)pvExtra += ((struct Position*)pvValue)->iLine;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_newInline(), SymTable_putValue() and
+   SymTable_getRef(). */
+
+static void testInline(void)
+{
+   enum {BINDING_COUNT = 10000, MAX_KEY_LENGTH = 12,
+      BIG_VALUE_SIZE = 1000};
+
+   SymTable_T oSymTable;
+   struct Position sPosition;
+   struct Position *psPosition;
+   char acKey[MAX_KEY_LENGTH];
+   char acBig[BIG_VALUE_SIZE];
+   char *pcBig;
+   int iSuccessful;
+   int iFound;
+   int iSum;
+   int iExpected;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing a SymTable object with inline values.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_newInline(sizeof(struct Position));
+   ASSURE(oSymTable != NULL);
+
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      sPosition.iLine = i;
+      sPosition.iColumn = -i;
+      sPosition.dWeight = 0.5;
+      iSuccessful = SymTable_putValue(oSymTable, acKey, &sPosition);
+      ASSURE(iSuccessful);
+   }
+
+   /* The table holds copies: changing the original changes nothing. */
+   sPosition.iLine = -1;
+   iSuccessful = SymTable_putValue(oSymTable, "0", &sPosition);
+   ASSURE(! iSuccessful);
+
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      psPosition = (struct Position*)SymTable_getRef(oSymTable, acKey);
+      ASSURE(psPosition != NULL);
+      ASSURE(psPosition->iLine == i);
+      ASSURE(psPosition->iColumn == -i);
+      ASSURE(psPosition->dWeight == 0.5);
+   }
+
+   /* Values can be updated in place, and SymTable_get sees them. */
+   psPosition = (struct Position*)SymTable_getRef(oSymTable, "42");
+   ASSURE(psPosition != NULL);
+   psPosition->iColumn = 7;
+   psPosition = (struct Position*)SymTable_get(oSymTable, "42");
+   ASSURE(psPosition != NULL);
+   ASSURE(psPosition->iColumn == 7);
+
+   psPosition = (struct Position*)SymTable_getRef(oSymTable, "Ruth");
+   ASSURE(psPosition == NULL);
+
+   /* A removed value can be read until the next binding is added. */
+   psPosition = (struct Position*)SymTable_remove(oSymTable, "42");
+   ASSURE(psPosition != NULL);
+   ASSURE(psPosition->iLine == 42);
+   iFound = SymTable_contains(oSymTable, "42");
+   ASSURE(! iFound);
+
+   for (i = 0; i < BINDING_COUNT; i += 2)
+   {
+      sprintf(acKey, "%d", i);
+      psPosition = (struct Position*)SymTable_remove(oSymTable, acKey);
+      if (i == 42)
+         ASSURE(psPosition == NULL);
+      else
+         ASSURE(psPosition != NULL && psPosition->iLine == i);
+   }
+
+   /* Freed nodes are reused for new bindings. */
+   sPosition.iLine = 1;
+   for (i = 0; i < BINDING_COUNT; i += 2)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_putValue(oSymTable, acKey, &sPosition);
+      ASSURE(iSuccessful);
+   }
+
+   /* Odd keys keep their own line; even keys now have line 1. */
+   iExpected = 0;
+   for (i = 0; i < BINDING_COUNT; i++)
+      iExpected += (i % 2 == 1) ? i : 1;
+   iSum = 0;
+   SymTable_map(oSymTable, sumLines, &iSum);
+   ASSURE(iSum == iExpected);
+   ASSURE(SymTable_getLength(oSymTable) == BINDING_COUNT);
+
+   SymTable_shrinkToFit(oSymTable);
+   psPosition = (struct Position*)SymTable_getRef(oSymTable, "9999");
+   ASSURE(psPosition != NULL && psPosition->iLine == 9999);
+
+   SymTable_free(oSymTable);
+
+   /* Values of one byte, and values larger than a node, also work. */
+   oSymTable = SymTable_newInline(1);
+   ASSURE(oSymTable != NULL);
+   iSuccessful = SymTable_putValue(oSymTable, "Ruth", "R");
+   ASSURE(iSuccessful);
+   ASSURE(*(char*)SymTable_getRef(oSymTable, "Ruth") == 'R');
+   SymTable_free(oSymTable);
+
+   oSymTable = SymTable_newInline(BIG_VALUE_SIZE);
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < 100; i++)
+   {
+      memset(acBig, i, sizeof(acBig));
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_putValue(oSymTable, acKey, acBig);
+      ASSURE(iSuccessful);
+   }
+   for (i = 0; i < 100; i++)
+   {
+      sprintf(acKey, "%d", i);
+      pcBig = (char*)SymTable_getRef(oSymTable, acKey);
+      ASSURE(pcBig != NULL && pcBig[BIG_VALUE_SIZE - 1] == (char)i);
+   }
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_pushScope() and SymTable_popScope(). */
+
+static void testScopes(void)
+{
+   enum {DEPTH = 100, KEY_RANGE = 50, STEP_COUNT = 20000,
+      MAX_KEY_LENGTH = 12};
+
+   /* aiBound[iDepth][iKey] is 1 if iKey was bound in scope iDepth of
+      the model, where scope 0 is outside every scope. */
+   static int aiBound[DEPTH + 1][KEY_RANGE];
+   static int aiValues[DEPTH + 1];
+   SymTable_T oSymTable;
+   char acKey[MAX_KEY_LENGTH];
+   unsigned long ulSeed = 12345;
+   size_t uLength;
+   int *piValue;
+   int iSuccessful;
+   int iDepth = 0;
+   int iVisible;
+   int iStep;
+   int iKey;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing a SymTable object with nested scopes.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   iSuccessful = SymTable_put(oSymTable, "x", &aiValues[0]);
+   ASSURE(iSuccessful);
+
+   /* An inner binding hides an outer one until its scope is popped. */
+   iSuccessful = SymTable_pushScope(oSymTable);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_put(oSymTable, "x", &aiValues[1]);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_put(oSymTable, "x", &aiValues[2]);
+   ASSURE(! iSuccessful);
+   iSuccessful = SymTable_put(oSymTable, "y", &aiValues[1]);
+   ASSURE(iSuccessful);
+   ASSURE(SymTable_get(oSymTable, "x") == &aiValues[1]);
+   ASSURE(SymTable_getLength(oSymTable) == 2);
+
+   iSuccessful = SymTable_pushScope(oSymTable);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_put(oSymTable, "x", &aiValues[2]);
+   ASSURE(iSuccessful);
+   ASSURE(SymTable_get(oSymTable, "x") == &aiValues[2]);
+
+   /* Removing the innermost binding brings back the one it hid. */
+   ASSURE(SymTable_remove(oSymTable, "x") == &aiValues[2]);
+   ASSURE(SymTable_get(oSymTable, "x") == &aiValues[1]);
+   SymTable_popScope(oSymTable);
+   ASSURE(SymTable_get(oSymTable, "x") == &aiValues[1]);
+
+   /* Replacing changes the binding in the scope that made it. */
+   ASSURE(SymTable_replace(oSymTable, "x", &aiValues[3])
+          == &aiValues[1]);
+   SymTable_popScope(oSymTable);
+   ASSURE(SymTable_get(oSymTable, "x") == &aiValues[0]);
+   ASSURE(! SymTable_contains(oSymTable, "y"));
+   ASSURE(SymTable_getLength(oSymTable) == 1);
+
+   /* A binding removed for good in an inner scope stays removed. */
+   iSuccessful = SymTable_pushScope(oSymTable);
+   ASSURE(iSuccessful);
+   ASSURE(SymTable_remove(oSymTable, "x") == &aiValues[0]);
+   SymTable_popScope(oSymTable);
+   ASSURE(SymTable_getLength(oSymTable) == 0);
+
+   /* Random puts, removes and scope changes, checked against a model
+      that keeps every scope's bindings. */
+   for (iStep = 0; iStep < STEP_COUNT; iStep++)
+   {
+      ulSeed = ulSeed * 1103515245UL + 12345UL;
+      iKey = (int)((ulSeed >> 8) % KEY_RANGE);
+      sprintf(acKey, "%d", iKey);
+
+      for (iVisible = iDepth; iVisible >= 0; iVisible--)
+         if (aiBound[iVisible][iKey])
+            break;
+
+      switch ((ulSeed >> 20) % 8)
+      {
+         case 0:
+            if (iDepth < DEPTH)
+            {
+               iSuccessful = SymTable_pushScope(oSymTable);
+               ASSURE(iSuccessful);
+               iDepth++;
+            }
+            break;
+         case 1:
+            if (iDepth > 0)
+            {
+               SymTable_popScope(oSymTable);
+               for (i = 0; i < KEY_RANGE; i++)
+                  aiBound[iDepth][i] = 0;
+               iDepth--;
+            }
+            break;
+         case 2:
+            piValue = (int*)SymTable_remove(oSymTable, acKey);
+            if (iVisible < 0)
+               ASSURE(piValue == NULL);
+            else
+            {
+               ASSURE(piValue == &aiValues[iVisible]);
+               aiBound[iVisible][iKey] = 0;
+            }
+            break;
+         default:
+            iSuccessful = SymTable_put(oSymTable, acKey,
+               &aiValues[iDepth]);
+            ASSURE(iSuccessful == ! aiBound[iDepth][iKey]);
+            aiBound[iDepth][iKey] = 1;
+            break;
+      }
+
+      uLength = 0;
+      for (i = 0; i < KEY_RANGE; i++)
+      {
+         sprintf(acKey, "%d", i);
+         for (iVisible = iDepth; iVisible >= 0; iVisible--)
+            if (aiBound[iVisible][i])
+               break;
+         piValue = (int*)SymTable_get(oSymTable, acKey);
+         if (iVisible < 0)
+            ASSURE(piValue == NULL);
+         else
+         {
+            ASSURE(piValue == &aiValues[iVisible]);
+            uLength++;
+         }
+      }
+      ASSURE(SymTable_getLength(oSymTable) == uLength);
+   }
+
+   /* Freeing with scopes still open frees the hidden bindings too. */
+   SymTable_free(oSymTable);
+
+   /* The first scope of an inline table moves its values, whole. */
+   oSymTable = SymTable_newInline(sizeof(int));
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < KEY_RANGE; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_putValue(oSymTable, acKey, &i);
+      ASSURE(iSuccessful);
+   }
+   iSuccessful = SymTable_pushScope(oSymTable);
+   ASSURE(iSuccessful);
+   i = -1;
+   iSuccessful = SymTable_putValue(oSymTable, "0", &i);
+   ASSURE(iSuccessful);
+   piValue = (int*)SymTable_getRef(oSymTable, "0");
+   ASSURE(piValue != NULL && *piValue == -1);
+   piValue = (int*)SymTable_remove(oSymTable, "0");
+   ASSURE(piValue != NULL && *piValue == -1);
+   iSuccessful = SymTable_putValue(oSymTable, "1", &i);
+   ASSURE(iSuccessful);
+   SymTable_popScope(oSymTable);
+   for (i = 0; i < KEY_RANGE; i++)
+   {
+      sprintf(acKey, "%d", i);
+      piValue = (int*)SymTable_getRef(oSymTable, acKey);
+      ASSURE(piValue != NULL && *piValue == i);
+   }
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_putBatch() and SymTable_merge(). */
+
+static void testBatch(void)
+{
+   enum {BINDING_COUNT = 10000, MAX_KEY_LENGTH = 12};
+
+   static char acKeys[BINDING_COUNT][MAX_KEY_LENGTH];
+   static char *apcKeys[BINDING_COUNT];
+   static void *apvValues[BINDING_COUNT];
+   static int aiValues[BINDING_COUNT];
+   char *apcPair[2];
+   void *apvPair[2];
+   SymTable_T oSymTable;
+   SymTable_T oOther;
+   int *piValue;
+   int iSuccessful;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable_putBatch() and SymTable_merge().\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKeys[i], "%d", i);
+      apcKeys[i] = acKeys[i];
+      apvValues[i] = &aiValues[i];
+   }
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   iSuccessful = SymTable_putBatch(oSymTable, apcKeys, apvValues, 0);
+   ASSURE(iSuccessful);
+   ASSURE(SymTable_getLength(oSymTable) == 0);
+
+   /* A key already bound keeps its value, and so does a key that
+      appears twice in one batch. */
+   iSuccessful = SymTable_put(oSymTable, "5", &aiValues[0]);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_putBatch(oSymTable, apcKeys, apvValues,
+      BINDING_COUNT / 2);
+   ASSURE(iSuccessful);
+   apcPair[0] = acKeys[BINDING_COUNT / 2];
+   apcPair[1] = acKeys[BINDING_COUNT / 2];
+   apvPair[0] = &aiValues[BINDING_COUNT / 2];
+   apvPair[1] = &aiValues[0];
+   iSuccessful = SymTable_putBatch(oSymTable, apcPair, apvPair, 2);
+   ASSURE(iSuccessful);
+   ASSURE(SymTable_getLength(oSymTable) == BINDING_COUNT / 2 + 1);
+   ASSURE(SymTable_get(oSymTable, "5") == &aiValues[0]);
+   for (i = 0; i <= BINDING_COUNT / 2; i++)
+      if (i != 5)
+         ASSURE(SymTable_get(oSymTable, acKeys[i]) == &aiValues[i]);
+
+   /* The table copies the keys. */
+   acKeys[7][0] = 'x';
+   ASSURE(SymTable_contains(oSymTable, "7"));
+   acKeys[7][0] = '7';
+
+   /* Keys from a batch can be removed and bound again one at a
+      time. */
+   for (i = 0; i < BINDING_COUNT / 2; i += 2)
+   {
+      piValue = (int*)SymTable_remove(oSymTable, acKeys[i]);
+      ASSURE(piValue == &aiValues[i]);
+   }
+   for (i = 0; i < BINDING_COUNT / 2; i += 4)
+   {
+      iSuccessful = SymTable_put(oSymTable, acKeys[i], &aiValues[1]);
+      ASSURE(iSuccessful);
+   }
+
+   /* Merging into a table that binds some of the same keys. */
+   oOther = SymTable_new();
+   ASSURE(oOther != NULL);
+   for (i = 0; i < BINDING_COUNT; i += 3)
+   {
+      iSuccessful = SymTable_put(oOther, acKeys[i], &aiValues[2]);
+      ASSURE(iSuccessful);
+   }
+
+   iSuccessful = SymTable_merge(oSymTable, oOther, SYMTABLE_KEEP_OLD);
+   ASSURE(iSuccessful);
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      piValue = (int*)SymTable_get(oSymTable, acKeys[i]);
+      if (i < BINDING_COUNT / 2 && i % 4 == 0)
+         ASSURE(piValue == &aiValues[1]);
+      else if (i == 5)
+         ASSURE(piValue == &aiValues[0]);
+      else if (i < BINDING_COUNT / 2 && i % 2 == 1)
+         ASSURE(piValue == &aiValues[i]);
+      else if (i == BINDING_COUNT / 2)
+         ASSURE(piValue == &aiValues[i]);
+      else if (i % 3 == 0)
+         ASSURE(piValue == &aiValues[2]);
+      else
+         ASSURE(piValue == NULL);
+   }
+
+   iSuccessful = SymTable_merge(oSymTable, oOther,
+      SYMTABLE_REPLACE_OLD);
+   ASSURE(iSuccessful);
+   for (i = 0; i < BINDING_COUNT; i += 3)
+      ASSURE(SymTable_get(oSymTable, acKeys[i]) == &aiValues[2]);
+   ASSURE(SymTable_getLength(oOther) == (BINDING_COUNT + 2) / 3);
+
+   /* A batch inside a scope goes away with the scope. */
+   iSuccessful = SymTable_pushScope(oOther);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_putBatch(oOther, apcKeys, apvValues,
+      BINDING_COUNT);
+   ASSURE(iSuccessful);
+   ASSURE(SymTable_getLength(oOther) == BINDING_COUNT);
+   ASSURE(SymTable_get(oOther, "3") == &aiValues[3]);
+   SymTable_popScope(oOther);
+   ASSURE(SymTable_getLength(oOther) == (BINDING_COUNT + 2) / 3);
+   ASSURE(SymTable_get(oOther, "3") == &aiValues[2]);
+   ASSURE(! SymTable_contains(oOther, "1"));
+
+   SymTable_free(oOther);
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Add the int that pvValue points to to the long that pvExtra points
+   to. */
+
+static void sumInts(const char *pcKey, void *pvValue, void *pvExtra)
+{
+   assert(pcKey != NULL);
+   assert(pvValue != NULL);
+   assert(pvExtra != NULL);
+
+   *(long*)pvExtra += *(int*)pvValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_setBackgroundResize(). The worker moves bindings while
+   the puts, gets and removes below go on, so each check also checks
+   that none of them lost a binding the worker was moving. */
+
+static void testBackgroundResize(void)
+{
+   enum {BINDING_COUNT = 200000, MAX_KEY_LENGTH = 12};
+
+   static int aiValues[BINDING_COUNT];
+   SymTable_T oSymTable;
+   struct SymTableStats sStats;
+   char acKey[MAX_KEY_LENGTH];
+   int *piValue;
+   long lSum;
+   int iSuccessful;
+   int iPass;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing a SymTable object that resizes in the "
+      "background.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   for (i = 0; i < BINDING_COUNT; i++)
+      aiValues[i] = i;
+
+   /* The second pass turns the worker off and frees the table while
+      bindings may still be migrating. The third uses a table that
+      reorders its buckets and has a filter, and rebinds half the keys
+      in a scope, which is popped while bindings may still be
+      migrating. */
+   for (iPass = 0; iPass < 3; iPass++)
+   {
+      oSymTable = SymTable_new();
+      ASSURE(oSymTable != NULL);
+      iSuccessful = SymTable_setBackgroundResize(oSymTable, 1);
+      ASSURE(iSuccessful);
+      iSuccessful = SymTable_setBackgroundResize(oSymTable, 1);
+      ASSURE(iSuccessful);
+      if (iPass == 2)
+      {
+         SymTable_setSelfOrganizing(oSymTable, 1);
+         ASSURE(SymTable_setFilter(oSymTable, 1));
+      }
+
+      /* Every binding made so far stays reachable while the buckets
+         migrate. */
+      for (i = 0; i < BINDING_COUNT; i++)
+      {
+         sprintf(acKey, "%d", i);
+         iSuccessful = SymTable_put(oSymTable, acKey, &aiValues[i]);
+         ASSURE(iSuccessful);
+         iSuccessful = SymTable_put(oSymTable, acKey, &aiValues[0]);
+         ASSURE(! iSuccessful);
+         sprintf(acKey, "%d", i / 2);
+         ASSURE(SymTable_get(oSymTable, acKey) == &aiValues[i / 2]);
+
+         /* Each key is taken out and put back once. */
+         sprintf(acKey, "%d", i / 3);
+         if (i % 3 == 0)
+         {
+            piValue = (int*)SymTable_remove(oSymTable, acKey);
+            ASSURE(piValue == &aiValues[i / 3]);
+            ASSURE(! SymTable_contains(oSymTable, acKey));
+            iSuccessful = SymTable_put(oSymTable, acKey, piValue);
+            ASSURE(iSuccessful);
+         }
+      }
+      ASSURE(SymTable_getLength(oSymTable) == BINDING_COUNT);
+      SymTable_getStats(oSymTable, &sStats);
+      ASSURE(sStats.bucketCount >= BINDING_COUNT / 2);
+
+      if (iPass == 1)
+      {
+         iSuccessful = SymTable_setBackgroundResize(oSymTable, 0);
+         ASSURE(iSuccessful);
+         SymTable_free(oSymTable);
+         continue;
+      }
+
+      if (iPass == 2)
+      {
+         ASSURE(SymTable_pushScope(oSymTable));
+         for (i = 0; i < BINDING_COUNT; i++)
+         {
+            sprintf(acKey, "%d", BINDING_COUNT + i);
+            iSuccessful = SymTable_put(oSymTable, acKey, &aiValues[i]);
+            ASSURE(iSuccessful);
+            if (i % 2 == 0)
+            {
+               sprintf(acKey, "%d", i);
+               iSuccessful = SymTable_put(oSymTable, acKey,
+                                          &aiValues[0]);
+               ASSURE(iSuccessful);
+               ASSURE(SymTable_get(oSymTable, acKey) == &aiValues[0]);
+            }
+         }
+         ASSURE(SymTable_getLength(oSymTable) == 2 * BINDING_COUNT);
+         SymTable_popScope(oSymTable);
+         ASSURE(SymTable_getLength(oSymTable) == BINDING_COUNT);
+         for (i = 0; i < BINDING_COUNT; i++)
+         {
+            sprintf(acKey, "%d", BINDING_COUNT + i);
+            ASSURE(! SymTable_contains(oSymTable, acKey));
+         }
+      }
+
+      lSum = 0;
+      SymTable_map(oSymTable, sumInts, &lSum);
+      ASSURE(lSum == (long)BINDING_COUNT * (BINDING_COUNT - 1) / 2);
+
+      for (i = 0; i < BINDING_COUNT; i += 2)
+      {
+         sprintf(acKey, "%d", i);
+         piValue = (int*)SymTable_remove(oSymTable, acKey);
+         ASSURE(piValue == &aiValues[i]);
+      }
+      for (i = 0; i < BINDING_COUNT; i++)
+      {
+         sprintf(acKey, "%d", i);
+         ASSURE(SymTable_contains(oSymTable, acKey) == (i % 2 == 1));
+      }
+      ASSURE(SymTable_getLength(oSymTable) == BINDING_COUNT / 2);
+
+      SymTable_free(oSymTable);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_setFilter() and SymTable_getStats(). */
+
+static void testFilter(void)
+{
+   enum {BINDING_COUNT = 100000, LOOKUP_COUNT = 100000,
+      MAX_KEY_LENGTH = 13};
+
+   static int aiValues[BINDING_COUNT];
+   static char *apcKeys[BINDING_COUNT];
+   static void *apvValues[BINDING_COUNT];
+   SymTable_T oSymTable;
+   struct SymTableStats sStats;
+   char acKey[MAX_KEY_LENGTH];
+   int iValue;
+   int iSuccessful;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing a SymTable object with a lookup filter.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   for (i = 0; i < BINDING_COUNT; i++)
+      aiValues[i] = i;
+
+   /* Without a filter there is nothing to count. */
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   ASSURE(! SymTable_contains(oSymTable, "Ruth"));
+   SymTable_getStats(oSymTable, &sStats);
+   ASSURE(sStats.length == 0);
+   ASSURE(sStats.bucketCount > 0);
+   ASSURE(sStats.filterBytes == 0);
+   ASSURE(sStats.filterRejects == 0);
+   ASSURE(sStats.filterFalsePositives == 0);
+   ASSURE(sStats.filterFalsePositiveRate == 0.0);
+
+   /* Turned on halfway through, so that the filter starts from
+      bindings already there and is rebuilt as the rest arrive. */
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      if (i == BINDING_COUNT / 4)
+      {
+         iSuccessful = SymTable_setFilter(oSymTable, 1);
+         ASSURE(iSuccessful);
+         iSuccessful = SymTable_setFilter(oSymTable, 1);
+         ASSURE(iSuccessful);
+      }
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, &aiValues[i]);
+      ASSURE(iSuccessful);
+      iSuccessful = SymTable_put(oSymTable, acKey, &aiValues[0]);
+      ASSURE(! iSuccessful);
+   }
+
+   /* A filter never hides a key that is bound... */
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_get(oSymTable, acKey) == &aiValues[i]);
+   }
+
+   /* ...and turns most others away by itself. */
+   ASSURE(SymTable_setFilter(oSymTable, 0));
+   ASSURE(SymTable_setFilter(oSymTable, 1));
+   for (i = 0; i < LOOKUP_COUNT; i++)
+   {
+      sprintf(acKey, "x%d", i);
+      ASSURE(SymTable_get(oSymTable, acKey) == NULL);
+   }
+   SymTable_getStats(oSymTable, &sStats);
+   ASSURE(sStats.length == BINDING_COUNT);
+   ASSURE(sStats.filterBytes > 0);
+   ASSURE(sStats.filterRejects + sStats.filterFalsePositives
+          == LOOKUP_COUNT);
+   ASSURE(sStats.filterFalsePositiveRate < 0.05);
+
+   /* Removed keys are gone, whatever bits they left behind. */
+   for (i = 0; i < BINDING_COUNT; i += 2)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_remove(oSymTable, acKey) == &aiValues[i]);
+      ASSURE(SymTable_remove(oSymTable, acKey) == NULL);
+      ASSURE(SymTable_replace(oSymTable, acKey, &aiValues[0]) == NULL);
+   }
+   SymTable_shrinkToFit(oSymTable);
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_contains(oSymTable, acKey) == (i % 2 == 1));
+   }
+
+   /* A binding hidden by an inner scope is still found once the scope
+      is popped. */
+   iSuccessful = SymTable_pushScope(oSymTable);
+   ASSURE(iSuccessful);
+   for (i = 1; i < BINDING_COUNT; i += 2)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, &aiValues[0]);
+      ASSURE(iSuccessful);
+   }
+   SymTable_shrinkToFit(oSymTable);
+   SymTable_popScope(oSymTable);
+   for (i = 1; i < BINDING_COUNT; i += 2)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_get(oSymTable, acKey) == &aiValues[i]);
+   }
+   SymTable_free(oSymTable);
+
+   /* Batches and inline values go through the filter too. */
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      apcKeys[i] = (char*)malloc(MAX_KEY_LENGTH);
+      ASSURE(apcKeys[i] != NULL);
+      sprintf(apcKeys[i], "%d", i);
+      apvValues[i] = &aiValues[i];
+   }
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTable_setFilter(oSymTable, 1));
+   iSuccessful = SymTable_putBatch(oSymTable, apcKeys, apvValues,
+      BINDING_COUNT);
+   ASSURE(iSuccessful);
+   for (i = 0; i < BINDING_COUNT; i++)
+      ASSURE(SymTable_get(oSymTable, apcKeys[i]) == &aiValues[i]);
+   SymTable_free(oSymTable);
+   for (i = 0; i < BINDING_COUNT; i++)
+      free(apcKeys[i]);
+
+   oSymTable = SymTable_newInline(sizeof(int));
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTable_setFilter(oSymTable, 1));
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iValue = i;
+      iSuccessful = SymTable_putValue(oSymTable, acKey, &iValue);
+      ASSURE(iSuccessful);
+   }
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(*(int*)SymTable_getRef(oSymTable, acKey) == i);
+      sprintf(acKey, "x%d", i);
+      ASSURE(SymTable_getRef(oSymTable, acKey) == NULL);
+   }
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Record that a cache evicted pcKey, bound to the int that pvValue
+   points to, by appending the int to the array that pvExtra points to,
+   whose first element counts the ints after it. */
+
+static void recordEviction(const char *pcKey, void *pvValue,
+   void *pvExtra)
+{
+   int *piEvicted = (int*)pvExtra;
+
+   assert(pcKey != NULL);
+   assert(pvValue != NULL);
+   assert(pvExtra != NULL);
+
+   piEvicted[0]++;
+   piEvicted[piEvicted[0]] = *(int*)pvValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_newCache(). */
+
+static void testCache(void)
+{
+   enum {MAX_BINDINGS = 100, BINDING_COUNT = 1000,
+      STREAM_LENGTH = 1000000, MAX_KEY_LENGTH = 13};
+
+   static int aiValues[BINDING_COUNT];
+   static int aiEvicted[BINDING_COUNT + 1];
+   SymTable_T oSymTable;
+   struct SymTableStats sStats;
+   char acKey[MAX_KEY_LENGTH];
+   size_t uNodeCount;
+   long lSum;
+   int iSuccessful;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing a SymTable object used as an LRU cache.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   for (i = 0; i < BINDING_COUNT; i++)
+      aiValues[i] = i;
+
+   oSymTable = SymTable_newCache(MAX_BINDINGS, recordEviction,
+      aiEvicted);
+   ASSURE(oSymTable != NULL);
+
+   /* Filling the cache evicts nothing, and binding a key already
+      there neither succeeds nor evicts. */
+   for (i = 0; i < MAX_BINDINGS; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, &aiValues[i]);
+      ASSURE(iSuccessful);
+   }
+   iSuccessful = SymTable_put(oSymTable, "0", &aiValues[1]);
+   ASSURE(! iSuccessful);
+   ASSURE(aiEvicted[0] == 0);
+   ASSURE(SymTable_getLength(oSymTable) == MAX_BINDINGS);
+
+   /* Using a key, in any way, saves it from the next evictions. */
+   ASSURE(SymTable_get(oSymTable, "0") == &aiValues[0]);
+   ASSURE(SymTable_contains(oSymTable, "1"));
+   ASSURE(SymTable_replace(oSymTable, "2", &aiValues[2])
+          == &aiValues[2]);
+
+   sprintf(acKey, "%d", MAX_BINDINGS);
+   iSuccessful = SymTable_put(oSymTable, acKey, &aiValues[MAX_BINDINGS]);
+   ASSURE(iSuccessful);
+   ASSURE(aiEvicted[0] == 1);
+   ASSURE(aiEvicted[1] == 3);
+   ASSURE(! SymTable_contains(oSymTable, "3"));
+   ASSURE(SymTable_getLength(oSymTable) == MAX_BINDINGS);
+
+   /* A removed binding leaves room without an eviction. */
+   ASSURE(SymTable_remove(oSymTable, "4") == &aiValues[4]);
+   sprintf(acKey, "%d", MAX_BINDINGS + 1);
+   iSuccessful = SymTable_put(oSymTable, acKey,
+      &aiValues[MAX_BINDINGS + 1]);
+   ASSURE(iSuccessful);
+   ASSURE(aiEvicted[0] == 1);
+
+   /* The rest go oldest first: 5 to MAX_BINDINGS - 1, then 0, 1 and 2,
+      then the two bound since. */
+   for (i = MAX_BINDINGS + 2; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, &aiValues[i]);
+      ASSURE(iSuccessful);
+   }
+   ASSURE(SymTable_getLength(oSymTable) == MAX_BINDINGS);
+   ASSURE(aiEvicted[0] == BINDING_COUNT - MAX_BINDINGS - 1);
+   for (i = 5; i < MAX_BINDINGS; i++)
+      ASSURE(aiEvicted[i - 3] == i);
+   ASSURE(aiEvicted[MAX_BINDINGS - 3] == 0);
+   ASSURE(aiEvicted[MAX_BINDINGS - 2] == 1);
+   ASSURE(aiEvicted[MAX_BINDINGS - 1] == 2);
+   ASSURE(aiEvicted[MAX_BINDINGS] == MAX_BINDINGS);
+   ASSURE(aiEvicted[MAX_BINDINGS + 1] == MAX_BINDINGS + 1);
+
+   lSum = 0;
+   SymTable_map(oSymTable, sumInts, &lSum);
+   ASSURE(lSum == (long)(BINDING_COUNT - MAX_BINDINGS + BINDING_COUNT - 1)
+          * MAX_BINDINGS / 2);
+   SymTable_getStats(oSymTable, &sStats);
+   ASSURE(sStats.evictionCount == (size_t)aiEvicted[0]);
+
+   /* Memory stays bounded however many keys pass through. */
+   uNodeCount = sStats.nodeCount;
+   for (i = 0; i < STREAM_LENGTH; i++)
+   {
+      sprintf(acKey, "s%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, &aiValues[0]);
+      ASSURE(iSuccessful);
+      aiEvicted[0] = 0;
+   }
+   SymTable_getStats(oSymTable, &sStats);
+   ASSURE(sStats.length == MAX_BINDINGS);
+   ASSURE(sStats.nodeCount == uNodeCount);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* The time that testClock reports */
+static uint64_t uTestTime;
+
+/* Return uTestTime, so that tests can move time as they like. */
+
+static uint64_t testClock(void)
+{
+   return uTestTime;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Count that a binding of pcKey to the int that pvValue points to has
+   expired, in the element of the int array that pvExtra points to at
+   that int. */
+
+static void countExpiry(const char *pcKey, void *pvValue, void *pvExtra)
+{
+   assert(pcKey != NULL);
+   assert(pvValue != NULL);
+   assert(pvExtra != NULL);
+
+   ((int*)pvExtra)[*(int*)pvValue]++;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_newExpiring(), SymTable_putWithTTL() and
+   SymTable_expireDue(). */
+
+static void testExpiry(void)
+{
+   enum {BINDING_COUNT = 20000, STEP_COUNT = 200, MAX_KEY_LENGTH = 12};
+
+   static int aiValues[BINDING_COUNT];
+   static uint64_t auDeadlines[BINDING_COUNT];
+   static int aiExpired[BINDING_COUNT];
+   SymTable_T oSymTable;
+   struct SymTableStats sStats;
+   char acKey[MAX_KEY_LENGTH];
+   unsigned long ulSeed = 12345;
+   uint64_t uTTL;
+   size_t uDue;
+   size_t uExpired;
+   long lSum;
+   long lLiveSum;
+   int iSuccessful;
+   int iStep;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing a SymTable object whose bindings expire.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   for (i = 0; i < BINDING_COUNT; i++)
+      aiValues[i] = i;
+
+   uTestTime = 1000;
+   oSymTable = SymTable_newExpiring(testClock, countExpiry, aiExpired);
+   ASSURE(oSymTable != NULL);
+
+   /* Times to live from 1 to past the top of the wheel, so that
+      bindings start on every level. */
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      ulSeed = ulSeed * 1103515245UL + 12345UL;
+      uTTL = (uint64_t)1 << ((ulSeed >> 8) % 28);
+      ulSeed = ulSeed * 1103515245UL + 12345UL;
+      uTTL = (ulSeed >> 4) % uTTL + 1;
+      auDeadlines[i] = uTestTime + uTTL;
+
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_putWithTTL(oSymTable, acKey, &aiValues[i],
+         uTTL);
+      ASSURE(iSuccessful);
+      iSuccessful = SymTable_put(oSymTable, acKey, &aiValues[0]);
+      ASSURE(! iSuccessful);
+   }
+   iSuccessful = SymTable_put(oSymTable, "forever", &aiValues[0]);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_putWithTTL(oSymTable, "almost", &aiValues[0],
+      UINT64_MAX);
+   ASSURE(iSuccessful);
+
+   /* Move time forward in uneven steps. Each step expires exactly the
+      bindings that fell due, each of them once. */
+   uExpired = 0;
+   for (iStep = 0; iStep < STEP_COUNT; iStep++)
+   {
+      ulSeed = ulSeed * 1103515245UL + 12345UL;
+      uTestTime += (uint64_t)1 << ((ulSeed >> 8) % 24);
+
+      uDue = 0;
+      for (i = 0; i < BINDING_COUNT; i++)
+         if (auDeadlines[i] <= uTestTime)
+            uDue++;
+      uExpired += SymTable_expireDue(oSymTable, uTestTime);
+      ASSURE(uExpired == uDue);
+   }
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      ASSURE(aiExpired[i] == (auDeadlines[i] <= uTestTime));
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_contains(oSymTable, acKey)
+             == (auDeadlines[i] > uTestTime));
+   }
+   ASSURE(SymTable_getLength(oSymTable) == BINDING_COUNT - uExpired + 2);
+   SymTable_getStats(oSymTable, &sStats);
+   ASSURE(sStats.expiredCount == uExpired);
+
+   /* Without SymTable_expireDue, bindings expire as they are found.
+      Every search treats them as gone, and so does SymTable_map. */
+   uTestTime += (uint64_t)1 << 27;
+   lLiveSum = 0;
+   for (i = 0; i < BINDING_COUNT; i++)
+      if (auDeadlines[i] > uTestTime)
+         lLiveSum += i;
+   lSum = 0;
+   SymTable_map(oSymTable, sumInts, &lSum);
+   ASSURE(lSum == lLiveSum);
+
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      if (auDeadlines[i] > uTestTime - ((uint64_t)1 << 27) &&
+          auDeadlines[i] <= uTestTime)
+      {
+         sprintf(acKey, "%d", i);
+         if (i % 4 == 0)
+            ASSURE(SymTable_get(oSymTable, acKey) == NULL);
+         else if (i % 4 == 1)
+            ASSURE(SymTable_replace(oSymTable, acKey, &aiValues[0])
+                   == NULL);
+         else if (i % 4 == 2)
+            ASSURE(SymTable_remove(oSymTable, acKey) == NULL);
+         else
+         {
+            iSuccessful = SymTable_put(oSymTable, acKey, &aiValues[i]);
+            ASSURE(iSuccessful);
+            ASSURE(SymTable_get(oSymTable, acKey) == &aiValues[i]);
+         }
+         ASSURE(aiExpired[i] == 1);
+      }
+   }
+   ASSURE(SymTable_expireDue(oSymTable, uTestTime) == 0);
+
+   /* Bindings without a deadline, or with one past the end of time,
+      stay. */
+   ASSURE(SymTable_get(oSymTable, "forever") == &aiValues[0]);
+   ASSURE(SymTable_remove(oSymTable, "almost") == &aiValues[0]);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* What each thread of testCounters adds to the shared table */
+
+struct CounterWork
+{
+   /* the table, from SymTable_newCounter */
+   SymTable_T oSymTable;
+
+   /* the keys, all bound in oSymTable */
+   char (*pacKeys)[12];
+
+   /* number of keys */
+   int iKeyCount;
+
+   /* number of increments per key */
+   int iRounds;
+};
+
+/* Add 1 to every key of the struct CounterWork that pvWork points to,
+   iRounds times, with SymTable_incrementAtomic. Return NULL. */
+
+static void *incrementAll(void *pvWork)
+{
+   struct CounterWork *psWork = (struct CounterWork*)pvWork;
+   int iRound;
+   int i;
+
+   for (iRound = 0; iRound < psWork->iRounds; iRound++)
+      for (i = 0; i < psWork->iKeyCount; i++)
+         SymTable_incrementAtomic(psWork->oSymTable, psWork->pacKeys[i],
+            1);
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_newCounter(), SymTable_increment(),
+   SymTable_incrementAtomic() and SymTable_getCount(). */
+
+static void testCounters(void)
+{
+   enum {KEY_COUNT = 2000, STREAM_LENGTH = 200000, THREAD_COUNT = 4,
+      ROUND_COUNT = 50, MAX_KEY_LENGTH = 12};
+
+   static char aacKeys[KEY_COUNT][MAX_KEY_LENGTH];
+   static int64_t aiExpected[KEY_COUNT];
+   SymTable_T oSymTable;
+   pthread_t aThreads[THREAD_COUNT];
+   struct CounterWork sWork;
+   unsigned long ulSeed = 12345;
+   int64_t iDelta;
+   int iSuccessful;
+   int iKey;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing a SymTable object of counters.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   for (iKey = 0; iKey < KEY_COUNT; iKey++)
+   {
+      sprintf(aacKeys[iKey], "%d", iKey);
+      aiExpected[iKey] = 0;
+   }
+
+   oSymTable = SymTable_newCounter();
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTable_getCount(oSymTable, "0") == 0);
+
+   /* Deltas of either sign, bound on first use, through every resize
+      and with the filter on for the second half. */
+   for (i = 0; i < STREAM_LENGTH; i++)
+   {
+      if (i == STREAM_LENGTH / 2)
+         ASSURE(SymTable_setFilter(oSymTable, 1));
+      ulSeed = ulSeed * 1103515245UL + 12345UL;
+      iKey = (int)((ulSeed >> 8) % KEY_COUNT);
+      iDelta = (int64_t)((ulSeed >> 20) % 7) - 2;
+      iSuccessful = SymTable_increment(oSymTable, aacKeys[iKey], iDelta);
+      ASSURE(iSuccessful);
+      aiExpected[iKey] += iDelta;
+   }
+   for (iKey = 0; iKey < KEY_COUNT; iKey++)
+   {
+      ASSURE(SymTable_getCount(oSymTable, aacKeys[iKey])
+             == aiExpected[iKey]);
+      ASSURE(*(int64_t*)SymTable_getRef(oSymTable, aacKeys[iKey])
+             == aiExpected[iKey]);
+   }
+   ASSURE(SymTable_getLength(oSymTable) == KEY_COUNT);
+
+   /* A count can go through zero and stays bound. */
+   ASSURE(SymTable_increment(oSymTable, "new", 5));
+   ASSURE(SymTable_increment(oSymTable, "new", -5));
+   ASSURE(SymTable_contains(oSymTable, "new"));
+   ASSURE(SymTable_getCount(oSymTable, "new") == 0);
+   ASSURE(SymTable_increment(oSymTable, "big", INT64_MAX - 1));
+   ASSURE(SymTable_increment(oSymTable, "big", 1));
+   ASSURE(SymTable_getCount(oSymTable, "big") == INT64_MAX);
+
+   /* Atomic increments of keys already bound, from several threads at
+      once, lose nothing; those of unbound keys do nothing. */
+   ASSURE(! SymTable_incrementAtomic(oSymTable, "absent", 1));
+   ASSURE(! SymTable_contains(oSymTable, "absent"));
+
+   sWork.oSymTable = oSymTable;
+   sWork.pacKeys = aacKeys;
+   sWork.iKeyCount = KEY_COUNT;
+   sWork.iRounds = ROUND_COUNT;
+   for (i = 0; i < THREAD_COUNT; i++)
+      ASSURE(pthread_create(&aThreads[i], NULL, incrementAll, &sWork)
+             == 0);
+   for (i = 0; i < THREAD_COUNT; i++)
+      pthread_join(aThreads[i], NULL);
+
+   for (iKey = 0; iKey < KEY_COUNT; iKey++)
+      ASSURE(SymTable_getCount(oSymTable, aacKeys[iKey])
+             == aiExpected[iKey] + THREAD_COUNT * ROUND_COUNT);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Add uKey to the uint64_t that pvExtra points to, and check that
+   pvValue points to the int uKey was bound to. */
+
+static void sumU64Keys(uint64_t uKey, void *pvValue, void *pvExtra)
+{
+   assert(pvValue != NULL);
+   assert(pvExtra != NULL);
+
+   ASSURE(*(int*)pvValue == (int)(uKey >> 32));
+   *(uint64_t*)pvExtra += uKey;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_newU64(), SymTable_putU64(), SymTable_getU64(),
+   SymTable_removeU64() and SymTable_mapU64(). */
+
+static void testU64(void)
+{
+   enum {BINDING_COUNT = 100000};
+
+   static int aiValues[BINDING_COUNT];
+   SymTable_T oSymTable;
+   uint64_t uKey;
+   uint64_t uSum;
+   uint64_t uExpected;
+   int iSuccessful;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing a SymTable object with integer keys.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   for (i = 0; i < BINDING_COUNT; i++)
+      aiValues[i] = i;
+
+   oSymTable = SymTable_newU64();
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTable_getU64(oSymTable, 0) == NULL);
+   ASSURE(SymTable_removeU64(oSymTable, 0) == NULL);
+
+   /* Keys i << 32 differ only in their high half, and key 0 and the
+      largest key are ordinary keys. The table resizes in the background
+      for half of them. */
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      if (i == BINDING_COUNT / 2)
+         ASSURE(SymTable_setBackgroundResize(oSymTable, 1));
+      uKey = (uint64_t)i << 32;
+      iSuccessful = SymTable_putU64(oSymTable, uKey, &aiValues[i]);
+      ASSURE(iSuccessful);
+      iSuccessful = SymTable_putU64(oSymTable, uKey, &aiValues[0]);
+      ASSURE(! iSuccessful);
+   }
+   iSuccessful = SymTable_putU64(oSymTable, UINT64_MAX, &aiValues[1]);
+   ASSURE(iSuccessful);
+   ASSURE(SymTable_getLength(oSymTable) == BINDING_COUNT + 1);
+
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      ASSURE(SymTable_getU64(oSymTable, (uint64_t)i << 32)
+             == &aiValues[i]);
+      ASSURE(SymTable_getU64(oSymTable, ((uint64_t)i << 32) + 1)
+             == NULL);
+   }
+   ASSURE(SymTable_getU64(oSymTable, UINT64_MAX) == &aiValues[1]);
+   ASSURE(SymTable_removeU64(oSymTable, UINT64_MAX) == &aiValues[1]);
+
+   /* Remove the odd keys, and check that the rest are all there. */
+   uExpected = 0;
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      if (i % 2 == 1)
+         ASSURE(SymTable_removeU64(oSymTable, (uint64_t)i << 32)
+                == &aiValues[i]);
+      else
+         uExpected += (uint64_t)i << 32;
+   }
+   ASSURE(SymTable_getLength(oSymTable) == BINDING_COUNT / 2);
+   uSum = 0;
+   SymTable_mapU64(oSymTable, sumU64Keys, &uSum);
+   ASSURE(uSum == uExpected);
+
+   /* Shrinking rehashes by the integer keys. */
+   for (i = 0; i < BINDING_COUNT; i += 2)
+      if (i % 1000 != 0)
+         ASSURE(SymTable_removeU64(oSymTable, (uint64_t)i << 32)
+                == &aiValues[i]);
+   SymTable_shrinkToFit(oSymTable);
+   for (i = 0; i < BINDING_COUNT; i += 1000)
+      ASSURE(SymTable_getU64(oSymTable, (uint64_t)i << 32)
+             == &aiValues[i]);
+   ASSURE(SymTable_getLength(oSymTable) == BINDING_COUNT / 1000);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_compact() and SymTable_setAutoCompact() on each kind
+   of table. */
+
+static void testCompact(void)
+{
+   enum {BINDING_COUNT = 20000, MAX_BINDINGS = 100, CHURN_COUNT = 200000,
+      MAX_KEY_LENGTH = 40};
+
+   static int aiValues[BINDING_COUNT];
+   static int aiEvicted[BINDING_COUNT + 1];
+   static int aiExpired[BINDING_COUNT];
+   static char acBatchKeys[BINDING_COUNT][MAX_KEY_LENGTH];
+   static char *apcKeys[BINDING_COUNT];
+   static void *apvValues[BINDING_COUNT];
+   SymTable_T oSymTable;
+   struct SymTableStats sStats;
+   char acKey[MAX_KEY_LENGTH];
+   size_t uMaxNodeCount;
+   long lSum;
+   long lExpected;
+   int iSuccessful;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing compacting SymTable objects.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   for (i = 0; i < BINDING_COUNT; i++)
+      aiValues[i] = i;
+
+   /* Keys of every length, some from a batch, and scopes hiding some
+      of them: after removing most keys, compacting keeps the rest,
+      shadowed ones included, and frees every unused node. */
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTable_compact(oSymTable));
+   for (i = 0; i < BINDING_COUNT / 2; i++)
+   {
+      sprintf(acBatchKeys[i], "%.*s%d", i % 24, "abcdefghijklmnopqrstuvwx",
+         i);
+      apcKeys[i] = acBatchKeys[i];
+      apvValues[i] = &aiValues[i];
+   }
+   ASSURE(SymTable_putBatch(oSymTable, apcKeys, apvValues,
+      BINDING_COUNT / 2));
+   for (i = BINDING_COUNT / 2; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%.*s%d", i % 24, "abcdefghijklmnopqrstuvwx", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, &aiValues[i]);
+      ASSURE(iSuccessful);
+   }
+   ASSURE(SymTable_pushScope(oSymTable));
+   iSuccessful = SymTable_put(oSymTable, acBatchKeys[3], &aiValues[0]);
+   ASSURE(iSuccessful);
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      if (i % 8 == 3)
+         continue;
+      sprintf(acKey, "%.*s%d", i % 24, "abcdefghijklmnopqrstuvwx", i);
+      ASSURE(SymTable_remove(oSymTable, acKey) == &aiValues[i]);
+   }
+
+   ASSURE(SymTable_compact(oSymTable));
+   SymTable_getStats(oSymTable, &sStats);
+   ASSURE(sStats.length == BINDING_COUNT / 8);
+   ASSURE(sStats.nodeCount == BINDING_COUNT / 8 + 1);
+   ASSURE(SymTable_get(oSymTable, acBatchKeys[3]) == &aiValues[0]);
+   for (i = 11; i < BINDING_COUNT; i += 8)
+   {
+      sprintf(acKey, "%.*s%d", i % 24, "abcdefghijklmnopqrstuvwx", i);
+      ASSURE(SymTable_get(oSymTable, acKey) == &aiValues[i]);
+   }
+   SymTable_popScope(oSymTable);
+   ASSURE(SymTable_get(oSymTable, acBatchKeys[3]) == &aiValues[3]);
+   ASSURE(SymTable_getLength(oSymTable) == BINDING_COUNT / 8);
+
+   /* The table works as before afterwards. */
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%.*s%d", i % 24, "abcdefghijklmnopqrstuvwx", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, &aiValues[i]);
+      ASSURE(iSuccessful == (i % 8 != 3));
+   }
+   lSum = 0;
+   SymTable_map(oSymTable, sumInts, &lSum);
+   ASSURE(lSum == (long)BINDING_COUNT * (BINDING_COUNT - 1) / 2);
+   SymTable_free(oSymTable);
+
+   /* Inline values move with their nodes. */
+   oSymTable = SymTable_newInline(sizeof(int));
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_putValue(oSymTable, acKey, &aiValues[i]);
+      ASSURE(iSuccessful);
+   }
+   for (i = 0; i < BINDING_COUNT; i += 2)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_remove(oSymTable, acKey) != NULL);
+   }
+   ASSURE(SymTable_compact(oSymTable));
+   for (i = 1; i < BINDING_COUNT; i += 2)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(*(int*)SymTable_getRef(oSymTable, acKey) == i);
+      ASSURE(SymTable_get(oSymTable, acKey)
+             == SymTable_getRef(oSymTable, acKey));
+   }
+   SymTable_free(oSymTable);
+
+   /* A cache keeps its order of use. */
+   oSymTable = SymTable_newCache(MAX_BINDINGS, recordEviction,
+      aiEvicted);
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < MAX_BINDINGS; i++)
+   {
+      sprintf(acKey, "%d", MAX_BINDINGS - 1 - i);
+      iSuccessful = SymTable_put(oSymTable, acKey,
+         &aiValues[MAX_BINDINGS - 1 - i]);
+      ASSURE(iSuccessful);
+   }
+   ASSURE(SymTable_compact(oSymTable));
+   for (i = 0; i < MAX_BINDINGS; i++)
+   {
+      sprintf(acKey, "x%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, &aiValues[0]);
+      ASSURE(iSuccessful);
+   }
+   ASSURE(aiEvicted[0] == MAX_BINDINGS);
+   for (i = 0; i < MAX_BINDINGS; i++)
+      ASSURE(aiEvicted[i + 1] == MAX_BINDINGS - 1 - i);
+   SymTable_free(oSymTable);
+
+   /* Expiring bindings stay on the timer wheel. */
+   uTestTime = 0;
+   oSymTable = SymTable_newExpiring(testClock, countExpiry, aiExpired);
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_putWithTTL(oSymTable, acKey, &aiValues[i],
+         (uint64_t)(i * 7919 % BINDING_COUNT) * 5 + 1);
+      ASSURE(iSuccessful);
+   }
+   ASSURE(SymTable_expireDue(oSymTable, 50000)
+          == (size_t)BINDING_COUNT / 2);
+   ASSURE(SymTable_compact(oSymTable));
+   ASSURE(SymTable_expireDue(oSymTable, 100000)
+          == (size_t)BINDING_COUNT / 2);
+   for (i = 0; i < BINDING_COUNT; i++)
+      ASSURE(aiExpired[i] == 1);
+   ASSURE(SymTable_getLength(oSymTable) == 0);
+   SymTable_free(oSymTable);
+
+   /* Integer keys have no key to copy. */
+   oSymTable = SymTable_newU64();
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      iSuccessful = SymTable_putU64(oSymTable, (uint64_t)i * i,
+         &aiValues[i]);
+      ASSURE(iSuccessful);
+   }
+   ASSURE(SymTable_compact(oSymTable));
+   for (i = 0; i < BINDING_COUNT; i++)
+      ASSURE(SymTable_getU64(oSymTable, (uint64_t)i * i) == &aiValues[i]);
+   SymTable_free(oSymTable);
+
+   /* With automatic compaction, churn leaves the table compacted now
+      and then, so its nodes stay within a small multiple of its
+      bindings. */
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   SymTable_setAutoCompact(oSymTable, 1);
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, &aiValues[i]);
+      ASSURE(iSuccessful);
+   }
+   uMaxNodeCount = 0;
+   for (i = 0; i < CHURN_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i % BINDING_COUNT);
+      ASSURE(SymTable_remove(oSymTable, acKey)
+             == &aiValues[i % BINDING_COUNT]);
+      iSuccessful = SymTable_put(oSymTable, acKey,
+         &aiValues[i % BINDING_COUNT]);
+      ASSURE(iSuccessful);
+      SymTable_getStats(oSymTable, &sStats);
+      if (sStats.nodeCount > uMaxNodeCount)
+         uMaxNodeCount = sStats.nodeCount;
+   }
+   ASSURE(uMaxNodeCount <= 3 * BINDING_COUNT);
+   lExpected = (long)BINDING_COUNT * (BINDING_COUNT - 1) / 2;
+   lSum = 0;
+   SymTable_map(oSymTable, sumInts, &lSum);
+   ASSURE(lSum == lExpected);
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Record pcKey at the index, in the array of keys that pvExtra points
+   to, given by the int that pvValue points to. */
+
+static void recordKey(const char *pcKey, void *pvValue, void *pvExtra)
+{
+   assert(pcKey != NULL);
+   assert(pvValue != NULL);
+   assert(pvExtra != NULL);
+
+   ((const char **)pvExtra)[*(int*)pvValue] = pcKey;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that nodes left over from a spike, and nodes reserved up front,
+   are freed once the bindings are removed or the table is shrunk to
+   fit, and that tables with inline values keep theirs until then. */
+
+static void testReleaseNodes(void)
+{
+   enum {BINDING_COUNT = 200000, KEPT_COUNT = 100};
+
+   static int aiValues[BINDING_COUNT];
+   static char acKeys[BINDING_COUNT][16];
+   static char *apcKeys[BINDING_COUNT];
+   static void *apvValues[BINDING_COUNT];
+   static const char *apcBefore[BINDING_COUNT];
+   static const char *apcAfter[BINDING_COUNT];
+   SymTable_T oSymTable;
+   struct SymTableStats sStats;
+   char acKey[16];
+   int iSuccessful;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing freeing unused nodes of SymTable objects.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   /* Draining a table frees blocks of nodes the spike left empty as
+      it goes, without moving the bindings that remain. Shrinking to
+      fit then frees the rest. */
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      aiValues[i] = i;
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, &aiValues[i]);
+      ASSURE(iSuccessful);
+   }
+   SymTable_map(oSymTable, recordKey, apcBefore);
+   for (i = KEPT_COUNT; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_remove(oSymTable, acKey) == &aiValues[i]);
+   }
+   SymTable_getStats(oSymTable, &sStats);
+   ASSURE(sStats.length == KEPT_COUNT);
+   ASSURE(sStats.nodeCount < BINDING_COUNT);
+   SymTable_map(oSymTable, recordKey, apcAfter);
+   for (i = 0; i < KEPT_COUNT; i++)
+      ASSURE(apcAfter[i] == apcBefore[i]);
+   SymTable_shrinkToFit(oSymTable);
+   SymTable_getStats(oSymTable, &sStats);
+   ASSURE(sStats.nodeCount == KEPT_COUNT);
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_get(oSymTable, acKey)
+             == (i < KEPT_COUNT ? &aiValues[i] : NULL));
+   }
+   SymTable_free(oSymTable);
+
+   /* A table built in one batch reserves nothing, so draining it
+      shrinks its buckets just as it does after SymTable_put. Its
+      nodes come in one block, which the bindings left keep until the
+      table is shrunk to fit. */
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKeys[i], "%d", i);
+      apcKeys[i] = acKeys[i];
+      apvValues[i] = &aiValues[i];
+   }
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   iSuccessful = SymTable_putBatch(oSymTable, apcKeys, apvValues,
+                                   BINDING_COUNT);
+   ASSURE(iSuccessful);
+   SymTable_getStats(oSymTable, &sStats);
+   ASSURE(sStats.bucketCount >= BINDING_COUNT);
+   for (i = KEPT_COUNT; i < BINDING_COUNT; i++)
+      ASSURE(SymTable_remove(oSymTable, acKeys[i]) == &aiValues[i]);
+   SymTable_getStats(oSymTable, &sStats);
+   ASSURE(sStats.length == KEPT_COUNT);
+   ASSURE(sStats.bucketCount < 2048);
+   ASSURE(sStats.nodeCount == BINDING_COUNT);
+   for (i = 0; i < BINDING_COUNT; i++)
+      ASSURE(SymTable_get(oSymTable, acKeys[i])
+             == (i < KEPT_COUNT ? &aiValues[i] : NULL));
+   SymTable_shrinkToFit(oSymTable);
+   SymTable_getStats(oSymTable, &sStats);
+   ASSURE(sStats.nodeCount == KEPT_COUNT);
+   SymTable_free(oSymTable);
+
+   /* Removing keeps the capacity that was reserved, and shrinking to
+      fit gives it back. */
+   oSymTable = SymTable_newWithCapacity(BINDING_COUNT);
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, &aiValues[i]);
+      ASSURE(iSuccessful);
+   }
+   for (i = KEPT_COUNT; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_remove(oSymTable, acKey) == &aiValues[i]);
+   }
+   SymTable_getStats(oSymTable, &sStats);
+   ASSURE(sStats.nodeCount >= BINDING_COUNT);
+   SymTable_shrinkToFit(oSymTable);
+   SymTable_getStats(oSymTable, &sStats);
+   ASSURE(sStats.nodeCount == KEPT_COUNT);
+   ASSURE(SymTable_get(oSymTable, "99") == &aiValues[99]);
+   SymTable_free(oSymTable);
+
+   /* Removing from an inline table leaves the value it returns in
+      place; shrinking to fit frees the nodes. */
+   oSymTable = SymTable_newInline(sizeof(int));
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_putValue(oSymTable, acKey, &i);
+      ASSURE(iSuccessful);
+   }
+   for (i = KEPT_COUNT; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(*(int *)SymTable_remove(oSymTable, acKey) == i);
+   }
+   SymTable_getStats(oSymTable, &sStats);
+   ASSURE(sStats.nodeCount >= BINDING_COUNT);
+   SymTable_shrinkToFit(oSymTable);
+   SymTable_getStats(oSymTable, &sStats);
+   ASSURE(sStats.nodeCount == KEPT_COUNT);
+   ASSURE(*(int *)SymTable_getRef(oSymTable, "99") == 99);
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_setHugePages() on tables large enough for their bucket
+   arrays and node blocks to fill huge pages, growing in the foreground
+   and in the background. Where the system has no huge pages the table
+   works the same in ordinary memory. */
+
+static void testHugePages(void)
+{
+   enum {BINDING_COUNT = 600000, MAX_KEY_LENGTH = 12};
+
+   static int aiValues[BINDING_COUNT];
+   SymTable_T oSymTable;
+   char acKey[MAX_KEY_LENGTH];
+   long lSum;
+   int iSuccessful;
+   int iPass;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable objects in huge pages.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   for (i = 0; i < BINDING_COUNT; i++)
+      aiValues[i] = i;
+
+   for (iPass = 0; iPass < 2; iPass++)
+   {
+      oSymTable = SymTable_new();
+      ASSURE(oSymTable != NULL);
+      SymTable_setHugePages(oSymTable, 1);
+      if (iPass == 1)
+         ASSURE(SymTable_setBackgroundResize(oSymTable, 1));
+
+      for (i = 0; i < BINDING_COUNT; i++)
+      {
+         sprintf(acKey, "%d", i);
+         iSuccessful = SymTable_put(oSymTable, acKey, &aiValues[i]);
+         ASSURE(iSuccessful);
+      }
+      for (i = 0; i < BINDING_COUNT; i += 2)
+      {
+         sprintf(acKey, "%d", i);
+         ASSURE(SymTable_remove(oSymTable, acKey) == &aiValues[i]);
+      }
+
+      /* The compacted block is in huge pages too, and later puts take
+         nodes from new blocks. */
+      ASSURE(SymTable_compact(oSymTable));
+      for (i = 0; i < BINDING_COUNT; i += 2)
+      {
+         sprintf(acKey, "%d", i);
+         iSuccessful = SymTable_put(oSymTable, acKey, &aiValues[i]);
+         ASSURE(iSuccessful);
+      }
+      for (i = 0; i < BINDING_COUNT; i++)
+      {
+         sprintf(acKey, "%d", i);
+         ASSURE(SymTable_get(oSymTable, acKey) == &aiValues[i]);
+      }
+      lSum = 0;
+      SymTable_map(oSymTable, sumInts, &lSum);
+      ASSURE(lSum == (long)BINDING_COUNT * (BINDING_COUNT - 1) / 2);
+
+      /* Turning them off leaves what is mapped working. */
+      SymTable_setHugePages(oSymTable, 0);
+      for (i = 0; i < BINDING_COUNT; i++)
+      {
+         sprintf(acKey, "%d", i);
+         ASSURE(SymTable_remove(oSymTable, acKey) == &aiValues[i]);
+      }
+      ASSURE(SymTable_getLength(oSymTable) == 0);
+      SymTable_free(oSymTable);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the operations of symtablehash.h. Write the output of the tests
+   to stdout. Return 0. */
+
+int main(int argc, char *argv[])
+{
+   (void)argc;
+
+   testInline();
+   testScopes();
+   testBatch();
+   testBackgroundResize();
+   testFilter();
+   testCache();
+   testExpiry();
+   testCounters();
+   testU64();
+   testCompact();
+   testReleaseNodes();
+   testHugePages();
+
+   printf("------------------------------------------------------\n");
+   printf("End of %s.\n", argv[0]);
+   return 0;
+}
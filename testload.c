@@ -0,0 +1,200 @@
+/*--------------------------------------------------------------------*/
+/* testload.c                                                         */
+/* Author: Ryan Chen                                                  */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+#include "symtableload.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <assert.h>
+
+/*--------------------------------------------------------------------*/
+
+#define ASSURE(i) assure(i, __LINE__)
+
+/*--------------------------------------------------------------------*/
+
+/* If !iSuccessful, print a message to stdout indicating that the
+   test at line iLineNum failed. */
+
+static void assure(int iSuccessful, int iLineNum)
+{
+   if (! iSuccessful)
+   {
+      printf("Test at line %d failed.\n", iLineNum);
+      fflush(stdout);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write the uLength bytes of pcText to a new temporary file, and copy
+   its name to acFileName. */
+
+static void writeFile(char acFileName[], const char *pcText,
+   size_t uLength)
+{
+   int iFd;
+
+   strcpy(acFileName, "/tmp/testloadXXXXXX");
+   iFd = mkstemp(acFileName);
+   ASSURE(iFd >= 0);
+   ASSURE(write(iFd, pcText, uLength) == (ssize_t)uLength);
+   close(iFd);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the edge cases of the file format with every thread count from
+   1 to more threads than lines. */
+
+static void testFormat(void)
+{
+   static const char acText[] =
+      "alpha\t1\n"
+      "\n"
+      "beta\t2\r\n"
+      "alpha\tagain\n"
+      "gamma\n"
+      "\r\n"
+      "delta\ttab\tinside\n"
+      "\tempty key\n"
+      "last\tno newline";
+
+   SymTable_T oSymTable;
+   SymTableLoad_T oSymTableLoad;
+   char acFileName[32];
+   size_t uThreadCount;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTableLoad_file() on each kind of line.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   writeFile(acFileName, acText, sizeof(acText) - 1);
+
+   for (uThreadCount = 1; uThreadCount <= 20; uThreadCount++)
+   {
+      oSymTable = SymTable_new();
+      ASSURE(oSymTable != NULL);
+      ASSURE(SymTable_put(oSymTable, "beta", "bound before"));
+
+      oSymTableLoad = SymTableLoad_file(oSymTable, acFileName,
+         uThreadCount);
+      ASSURE(oSymTableLoad != NULL);
+      ASSURE(SymTableLoad_getLineCount(oSymTableLoad) == 7);
+      ASSURE(SymTableLoad_getByteCount(oSymTableLoad)
+             == sizeof(acText) - 1);
+
+      ASSURE(SymTable_getLength(oSymTable) == 6);
+      ASSURE(strcmp((char*)SymTable_get(oSymTable, "alpha"), "1") == 0);
+      ASSURE(strcmp((char*)SymTable_get(oSymTable, "beta"),
+                    "bound before") == 0);
+      ASSURE(strcmp((char*)SymTable_get(oSymTable, "gamma"), "") == 0);
+      ASSURE(strcmp((char*)SymTable_get(oSymTable, "delta"),
+                    "tab\tinside") == 0);
+      ASSURE(strcmp((char*)SymTable_get(oSymTable, ""), "empty key")
+             == 0);
+      ASSURE(strcmp((char*)SymTable_get(oSymTable, "last"),
+                    "no newline") == 0);
+
+      SymTable_free(oSymTable);
+      SymTableLoad_free(oSymTableLoad);
+   }
+   unlink(acFileName);
+
+   /* An empty file loads nothing, and a missing one fails. */
+   writeFile(acFileName, "", 0);
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   oSymTableLoad = SymTableLoad_file(oSymTable, acFileName, 4);
+   ASSURE(oSymTableLoad != NULL);
+   ASSURE(SymTableLoad_getLineCount(oSymTableLoad) == 0);
+   ASSURE(SymTable_getLength(oSymTable) == 0);
+   SymTableLoad_free(oSymTableLoad);
+   unlink(acFileName);
+
+   ASSURE(SymTableLoad_file(oSymTable, acFileName, 4) == NULL);
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test loading a file big enough for every thread to parse many
+   lines, with lines split across the chunk boundaries in every
+   way. */
+
+static void testLargeFile(void)
+{
+   enum {LINE_COUNT = 100000, MAX_LINE_LENGTH = 40};
+
+   SymTable_T oSymTable;
+   SymTableLoad_T oSymTableLoad;
+   char acFileName[32];
+   char acKey[MAX_LINE_LENGTH];
+   char acValue[MAX_LINE_LENGTH];
+   char *pcText;
+   char *pcValue;
+   size_t uLength = 0;
+   size_t uThreadCount;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTableLoad_file() on a large file.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   pcText = (char*)malloc((size_t)LINE_COUNT * MAX_LINE_LENGTH);
+   ASSURE(pcText != NULL);
+   if (pcText == NULL)
+      return;
+   for (i = 0; i < LINE_COUNT; i++)
+      uLength += (size_t)sprintf(pcText + uLength, "key%d\tvalue%d\n",
+         i % (LINE_COUNT / 2), i);
+   writeFile(acFileName, pcText, uLength);
+   free(pcText);
+
+   for (uThreadCount = 1; uThreadCount <= 16; uThreadCount *= 2)
+   {
+      oSymTable = SymTable_new();
+      ASSURE(oSymTable != NULL);
+      oSymTableLoad = SymTableLoad_file(oSymTable, acFileName,
+         uThreadCount);
+      ASSURE(oSymTableLoad != NULL);
+      ASSURE(SymTableLoad_getLineCount(oSymTableLoad) == LINE_COUNT);
+      ASSURE(SymTable_getLength(oSymTable) == LINE_COUNT / 2);
+
+      /* The first of two lines with the same key wins. */
+      for (i = 0; i < LINE_COUNT / 2; i++)
+      {
+         sprintf(acKey, "key%d", i);
+         sprintf(acValue, "value%d", i);
+         pcValue = (char*)SymTable_get(oSymTable, acKey);
+         ASSURE(pcValue != NULL && strcmp(pcValue, acValue) == 0);
+      }
+
+      SymTable_free(oSymTable);
+      SymTableLoad_free(oSymTableLoad);
+   }
+   unlink(acFileName);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the operations of symtableload.h. Write the output of the tests
+   to stdout. Return 0. */
+
+int main(int argc, char *argv[])
+{
+   (void)argc;
+
+   testFormat();
+   testLargeFile();
+
+   printf("------------------------------------------------------\n");
+   printf("End of %s.\n", argv[0]);
+   return 0;
+}
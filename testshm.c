@@ -0,0 +1,309 @@
+/*--------------------------------------------------------------------*/
+/* testshm.c                                                          */
+/* Author: Ryan Chen                                                  */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+#include "symtableshm.h"
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+/*--------------------------------------------------------------------*/
+
+#define ASSURE(i) assure(i, __LINE__)
+
+/*--------------------------------------------------------------------*/
+
+/* Number of tests that have failed in this process */
+static int iFailures = 0;
+
+/* If !iSuccessful, print a message to stdout indicating that the
+   test at line iLineNum failed. */
+
+static void assure(int iSuccessful, int iLineNum)
+{
+   if (! iSuccessful)
+   {
+      printf("Test at line %d failed.\n", iLineNum);
+      fflush(stdout);
+      iFailures++;
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Fork a process that runs pfChild with iChild, and exits with status
+   0 if no test failed in it or 1 otherwise. Return its process ID. */
+
+static pid_t startChild(void (*pfChild)(int iChild), int iChild)
+{
+   pid_t iPid;
+
+   fflush(stdout);
+   iPid = fork();
+   ASSURE(iPid >= 0);
+   if (iPid == 0)
+   {
+      iFailures = 0;
+      (*pfChild)(iChild);
+      fflush(stdout);
+      _exit(iFailures == 0 ? 0 : 1);
+   }
+   return iPid;
+}
+
+/* Wait for the process iPid, and check that it exited with status
+   0. */
+
+static void waitChild(pid_t iPid)
+{
+   int iStatus;
+
+   ASSURE(waitpid(iPid, &iStatus, 0) == iPid);
+   ASSURE(WIFEXITED(iStatus) && WEXITSTATUS(iStatus) == 0);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Add the long that pvValue points to to the long that pvExtra points
+   to. */
+
+static void sumValues(const char *pcKey, const void *pvValue,
+   void *pvExtra)
+{
+   long lValue;
+
+   assert(pcKey != NULL);
+   assert(pvValue != NULL);
+   assert(pvExtra != NULL);
+
+   memcpy(&lValue, pvValue, sizeof(long));
+   *(long*)pvExtra += lValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+enum {BINDING_COUNT = 50000, CHILD_COUNT = 4, SHARED_COUNT = 5000,
+   MAX_KEY_LENGTH = 32, REGION_SIZE = 16 * 1024 * 1024};
+
+/* Name of the region the tests share, unique to the test process */
+static char acRegionName[64];
+
+/* Attach read-only to the table that testReadOnly built, and check
+   every binding the builder left in it. */
+
+static void checkBuiltTable(int iChild)
+{
+   SymTableShm_T oSymTableShm;
+   char acKey[MAX_KEY_LENGTH];
+   long lValue;
+   long lSum;
+   int i;
+
+   (void)iChild;
+
+   oSymTableShm = SymTableShm_attach(acRegionName, 0);
+   ASSURE(oSymTableShm != NULL);
+   if (oSymTableShm == NULL)
+      return;
+
+   ASSURE(SymTableShm_getLength(oSymTableShm) == BINDING_COUNT / 2);
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "key%d", i);
+      lValue = -1;
+      if (i % 2 == 0)
+      {
+         ASSURE(SymTableShm_get(oSymTableShm, acKey, &lValue));
+         ASSURE(lValue == (i % 10 == 0 ? -i : i));
+      }
+      else
+         ASSURE(! SymTableShm_contains(oSymTableShm, acKey));
+   }
+
+   lSum = 0;
+   SymTableShm_map(oSymTableShm, sumValues, &lSum);
+   ASSURE(lSum == (long)BINDING_COUNT * (BINDING_COUNT - 2) / 4
+          - 2L * (BINDING_COUNT - 10) * (BINDING_COUNT / 10) / 2);
+
+   SymTableShm_detach(oSymTableShm);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test building a table in one process and reading it from several
+   others. */
+
+static void testReadOnly(void)
+{
+   SymTableShm_T oSymTableShm;
+   pid_t aiPids[CHILD_COUNT];
+   char acKey[MAX_KEY_LENGTH];
+   long lValue;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing a SymTableShm built by one process.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTableShm = SymTableShm_create(acRegionName, REGION_SIZE,
+      sizeof(long));
+   ASSURE(oSymTableShm != NULL);
+   if (oSymTableShm == NULL)
+      return;
+   ASSURE(SymTableShm_create(acRegionName, REGION_SIZE, sizeof(long))
+          == NULL);
+
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "key%d", i);
+      lValue = i;
+      ASSURE(SymTableShm_put(oSymTableShm, acKey, &lValue));
+      ASSURE(! SymTableShm_put(oSymTableShm, acKey, &lValue));
+   }
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "key%d", i);
+      lValue = -i;
+      if (i % 2 == 1)
+         ASSURE(SymTableShm_remove(oSymTableShm, acKey));
+      else if (i % 10 == 0)
+         ASSURE(SymTableShm_replace(oSymTableShm, acKey, &lValue));
+   }
+   ASSURE(! SymTableShm_remove(oSymTableShm, "key1"));
+   ASSURE(! SymTableShm_replace(oSymTableShm, "key1", &lValue));
+   SymTableShm_detach(oSymTableShm);
+
+   for (i = 0; i < CHILD_COUNT; i++)
+      aiPids[i] = startChild(checkBuiltTable, i);
+   for (i = 0; i < CHILD_COUNT; i++)
+      waitChild(aiPids[i]);
+
+   ASSURE(SymTableShm_unlink(acRegionName));
+   ASSURE(SymTableShm_attach(acRegionName, 0) == NULL);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Attach read-write to the table of testReadWrite and bind keys of
+   its own, along with as many of the keys every child races for as
+   it wins. */
+
+static void addBindings(int iChild)
+{
+   SymTableShm_T oSymTableShm;
+   char acKey[MAX_KEY_LENGTH];
+   long lValue = iChild;
+   int i;
+
+   oSymTableShm = SymTableShm_attach(acRegionName, 1);
+   ASSURE(oSymTableShm != NULL);
+   if (oSymTableShm == NULL)
+      return;
+
+   for (i = 0; i < BINDING_COUNT / CHILD_COUNT; i++)
+   {
+      sprintf(acKey, "child%d-%d", iChild, i);
+      ASSURE(SymTableShm_put(oSymTableShm, acKey, &lValue));
+
+      if (i < SHARED_COUNT)
+      {
+         sprintf(acKey, "shared%d", i);
+         (void)SymTableShm_put(oSymTableShm, acKey, &lValue);
+      }
+   }
+
+   SymTableShm_detach(oSymTableShm);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test several processes binding keys in one table at once. */
+
+static void testReadWrite(void)
+{
+   SymTableShm_T oSymTableShm;
+   pid_t aiPids[CHILD_COUNT];
+   char acKey[MAX_KEY_LENGTH];
+   long lValue;
+   int iChild;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing a SymTableShm shared read-write.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTableShm = SymTableShm_create(acRegionName, REGION_SIZE,
+      sizeof(long));
+   ASSURE(oSymTableShm != NULL);
+   if (oSymTableShm == NULL)
+      return;
+
+   for (i = 0; i < CHILD_COUNT; i++)
+      aiPids[i] = startChild(addBindings, i);
+   for (i = 0; i < CHILD_COUNT; i++)
+      waitChild(aiPids[i]);
+
+   /* Every child's own keys are there, and each shared key once, bound
+      by whichever child got to it first. */
+   ASSURE(SymTableShm_getLength(oSymTableShm)
+          == (size_t)(BINDING_COUNT / CHILD_COUNT * CHILD_COUNT
+                      + SHARED_COUNT));
+   for (iChild = 0; iChild < CHILD_COUNT; iChild++)
+   {
+      for (i = 0; i < BINDING_COUNT / CHILD_COUNT; i++)
+      {
+         sprintf(acKey, "child%d-%d", iChild, i);
+         ASSURE(SymTableShm_get(oSymTableShm, acKey, &lValue));
+         ASSURE(lValue == iChild);
+      }
+   }
+   for (i = 0; i < SHARED_COUNT; i++)
+   {
+      sprintf(acKey, "shared%d", i);
+      lValue = -1;
+      ASSURE(SymTableShm_get(oSymTableShm, acKey, &lValue));
+      ASSURE(lValue >= 0 && lValue < CHILD_COUNT);
+   }
+
+   /* A full region refuses new keys but keeps the old ones. */
+   lValue = 0;
+   for (i = 0; SymTableShm_getFreeBytes(oSymTableShm) > 0; i++)
+   {
+      sprintf(acKey, "filler%d", i);
+      if (! SymTableShm_put(oSymTableShm, acKey, &lValue))
+         break;
+   }
+   ASSURE(! SymTableShm_put(oSymTableShm, "one more", &lValue));
+   ASSURE(SymTableShm_contains(oSymTableShm, "shared0"));
+
+   SymTableShm_detach(oSymTableShm);
+   ASSURE(SymTableShm_unlink(acRegionName));
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the operations of symtableshm.h across processes. Write the
+   output of the tests to stdout. Return 0 if every test passed, or 1
+   otherwise. */
+
+int main(int argc, char *argv[])
+{
+   (void)argc;
+
+   sprintf(acRegionName, "/testshm-%ld", (long)getpid());
+
+   testReadOnly();
+   testReadWrite();
+
+   printf("------------------------------------------------------\n");
+   printf("End of %s.\n", argv[0]);
+   return iFailures == 0 ? 0 : 1;
+}
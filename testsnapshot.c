@@ -0,0 +1,265 @@
+/*--------------------------------------------------------------------*/
+/* testsnapshot.c                                                     */
+/* Author: Ryan Chen                                                  */
+/*--------------------------------------------------------------------*/
+
+#include "symtablehamt.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+/*--------------------------------------------------------------------*/
+
+#define ASSURE(i) assure(i, __LINE__)
+
+/*--------------------------------------------------------------------*/
+
+/* If !iSuccessful, print a message to stdout indicating that the
+   test at line iLineNum failed. */
+
+static void assure(int iSuccessful, int iLineNum)
+{
+   if (! iSuccessful)
+   {
+      printf("Test at line %d failed.\n", iLineNum);
+      fflush(stdout);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Add the int that pvValue points to to the long that pvExtra points
+   to. */
+
+static void sumValues(const char *pcKey, void *pvValue, void *pvExtra)
+{
+   assert(pcKey != NULL);
+   assert(pvValue != NULL);
+   assert(pvExtra != NULL);
+
+   *(long*)pvExtra += *(int*)pvValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that a snapshot keeps the bindings its table had when it was
+   taken, whichever of the two is changed or freed first. */
+
+static void testSnapshot(void)
+{
+   enum {BINDING_COUNT = 10000, MAX_KEY_LENGTH = 12};
+
+   static int aiValues[BINDING_COUNT];
+   SymTable_T oSymTable;
+   SymTable_T oSnapshot;
+   SymTable_T oSecond;
+   char acKey[MAX_KEY_LENGTH];
+   int *piValue;
+   long lSum;
+   int iSuccessful;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable_snapshot().\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   for (i = 0; i < BINDING_COUNT; i++)
+      aiValues[i] = i;
+
+   /* A snapshot of an empty table is empty. */
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   oSnapshot = SymTable_snapshot(oSymTable);
+   ASSURE(oSnapshot != NULL);
+   iSuccessful = SymTable_put(oSymTable, "Ruth", &aiValues[3]);
+   ASSURE(iSuccessful);
+   ASSURE(SymTable_getLength(oSnapshot) == 0);
+   ASSURE(! SymTable_contains(oSnapshot, "Ruth"));
+   SymTable_free(oSnapshot);
+
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, &aiValues[i]);
+      ASSURE(iSuccessful);
+   }
+
+   oSnapshot = SymTable_snapshot(oSymTable);
+   ASSURE(oSnapshot != NULL);
+   ASSURE(SymTable_getLength(oSnapshot) == BINDING_COUNT + 1);
+
+   /* Writes to the table after the snapshot... */
+   for (i = 0; i < BINDING_COUNT; i += 2)
+   {
+      sprintf(acKey, "%d", i);
+      piValue = (int*)SymTable_remove(oSymTable, acKey);
+      ASSURE(piValue == &aiValues[i]);
+   }
+   piValue = (int*)SymTable_replace(oSymTable, "1", &aiValues[0]);
+   ASSURE(piValue == &aiValues[1]);
+   iSuccessful = SymTable_put(oSymTable, "Gehrig", &aiValues[4]);
+   ASSURE(iSuccessful);
+
+   /* ...are not seen by the snapshot... */
+   ASSURE(SymTable_getLength(oSnapshot) == BINDING_COUNT + 1);
+   ASSURE(! SymTable_contains(oSnapshot, "Gehrig"));
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      piValue = (int*)SymTable_get(oSnapshot, acKey);
+      ASSURE(piValue == &aiValues[i]);
+   }
+
+   /* ...and writes to the snapshot are not seen by the table. */
+   piValue = (int*)SymTable_remove(oSnapshot, "Ruth");
+   ASSURE(piValue == &aiValues[3]);
+   ASSURE(SymTable_contains(oSymTable, "Ruth"));
+   ASSURE(SymTable_getLength(oSymTable) == BINDING_COUNT / 2 + 2);
+   ASSURE(*(int*)SymTable_get(oSymTable, "1") == 0);
+
+   lSum = 0;
+   SymTable_map(oSnapshot, sumValues, &lSum);
+   ASSURE(lSum == (long)BINDING_COUNT * (BINDING_COUNT - 1) / 2);
+
+   /* A snapshot of a snapshot, with the original freed first. */
+   oSecond = SymTable_snapshot(oSnapshot);
+   ASSURE(oSecond != NULL);
+   SymTable_free(oSnapshot);
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      piValue = (int*)SymTable_remove(oSecond, acKey);
+      ASSURE(piValue == &aiValues[i]);
+   }
+   ASSURE(SymTable_getLength(oSecond) == 0);
+   iSuccessful = SymTable_put(oSecond, "Mantle", &aiValues[7]);
+   ASSURE(iSuccessful);
+   ASSURE(! SymTable_contains(oSymTable, "Mantle"));
+
+   /* The table still has what it had after its own writes. */
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      piValue = (int*)SymTable_get(oSymTable, acKey);
+      if (i % 2 == 0)
+         ASSURE(piValue == NULL);
+      else if (i == 1)
+         ASSURE(piValue == &aiValues[0]);
+      else
+         ASSURE(piValue == &aiValues[i]);
+   }
+
+   SymTable_free(oSymTable);
+   SymTable_free(oSecond);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test rolling back to a snapshot: take one every ROUND_SIZE changes,
+   and check that each still holds what the table held then. */
+
+static void testRollback(void)
+{
+   enum {ROUND_COUNT = 20, ROUND_SIZE = 500, KEY_RANGE = 2000,
+      MAX_KEY_LENGTH = 12};
+
+   static int aiValues[ROUND_COUNT];
+   static int aiExpected[ROUND_COUNT][KEY_RANGE];
+   SymTable_T aoSnapshots[ROUND_COUNT];
+   SymTable_T oSymTable;
+   char acKey[MAX_KEY_LENGTH];
+   unsigned long ulSeed = 12345;
+   int aiCurrent[KEY_RANGE];
+   int *piValue;
+   size_t uLength;
+   int iRound;
+   int iKey;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing rolling back to SymTable snapshots.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   /* aiCurrent[iKey] is the round whose value iKey is bound to, or -1
+      if iKey is unbound. */
+   for (iKey = 0; iKey < KEY_RANGE; iKey++)
+      aiCurrent[iKey] = -1;
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   for (iRound = 0; iRound < ROUND_COUNT; iRound++)
+   {
+      for (i = 0; i < ROUND_SIZE; i++)
+      {
+         ulSeed = ulSeed * 1103515245UL + 12345UL;
+         iKey = (int)((ulSeed >> 8) % KEY_RANGE);
+         sprintf(acKey, "%d", iKey);
+         if (aiCurrent[iKey] < 0)
+         {
+            ASSURE(SymTable_put(oSymTable, acKey, &aiValues[iRound]));
+            aiCurrent[iKey] = iRound;
+         }
+         else if ((ulSeed >> 20) % 2 == 0)
+         {
+            ASSURE(SymTable_remove(oSymTable, acKey)
+                   == &aiValues[aiCurrent[iKey]]);
+            aiCurrent[iKey] = -1;
+         }
+         else
+         {
+            ASSURE(SymTable_replace(oSymTable, acKey, &aiValues[iRound])
+                   == &aiValues[aiCurrent[iKey]]);
+            aiCurrent[iKey] = iRound;
+         }
+      }
+
+      aoSnapshots[iRound] = SymTable_snapshot(oSymTable);
+      ASSURE(aoSnapshots[iRound] != NULL);
+      memcpy(aiExpected[iRound], aiCurrent, sizeof(aiCurrent));
+   }
+
+   /* Free every other snapshot first, then check the rest. */
+   for (iRound = 0; iRound < ROUND_COUNT; iRound += 2)
+      SymTable_free(aoSnapshots[iRound]);
+   SymTable_free(oSymTable);
+
+   for (iRound = 1; iRound < ROUND_COUNT; iRound += 2)
+   {
+      uLength = 0;
+      for (iKey = 0; iKey < KEY_RANGE; iKey++)
+      {
+         sprintf(acKey, "%d", iKey);
+         piValue = (int*)SymTable_get(aoSnapshots[iRound], acKey);
+         if (aiExpected[iRound][iKey] < 0)
+            ASSURE(piValue == NULL);
+         else
+         {
+            ASSURE(piValue == &aiValues[aiExpected[iRound][iKey]]);
+            uLength++;
+         }
+      }
+      ASSURE(SymTable_getLength(aoSnapshots[iRound]) == uLength);
+      SymTable_free(aoSnapshots[iRound]);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the operations of symtablehamt.h. Write the output of the tests
+   to stdout. Return 0. */
+
+int main(int argc, char *argv[])
+{
+   (void)argc;
+
+   testSnapshot();
+   testRollback();
+
+   printf("------------------------------------------------------\n");
+   printf("End of %s.\n", argv[0]);
+   return 0;
+}
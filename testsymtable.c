@@ -636,6 +636,80 @@ static void testLongKey(void)
 
 /*--------------------------------------------------------------------*/
 
+/* Test keys that share long prefixes or are prefixes of one another,
+   so that they differ only in length or in their last characters. */
+
+static void testSharedPrefix(void)
+{
+   enum {KEY_COUNT = 8};
+
+   static const char *apcKeys[KEY_COUNT] =
+   {
+      "prefix_", "prefix__", "prefix__a", "prefix__b", "prefix__ab",
+      "a.long.qualified.symbol.name.ending.in.1",
+      "a.long.qualified.symbol.name.ending.in.2",
+      "a.long.qualified.symbol.name.ending.in.12"
+   };
+   SymTable_T oSymTable;
+   int aiValues[KEY_COUNT];
+   int iSuccessful;
+   int iFound;
+   int i;
+   int *piValue;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing a SymTable object whose keys share prefixes.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   for (i = 0; i < KEY_COUNT; i++)
+   {
+      aiValues[i] = i;
+      iSuccessful = SymTable_put(oSymTable, apcKeys[i], &aiValues[i]);
+      ASSURE(iSuccessful);
+   }
+
+   for (i = 0; i < KEY_COUNT; i++)
+   {
+      piValue = (int*)SymTable_get(oSymTable, apcKeys[i]);
+      ASSURE(piValue == &aiValues[i]);
+   }
+
+   iFound = SymTable_contains(oSymTable, "prefix");
+   ASSURE(! iFound);
+
+   iFound = SymTable_contains(oSymTable, "prefix__c");
+   ASSURE(! iFound);
+
+   iFound = SymTable_contains(oSymTable, "prefix__abc");
+   ASSURE(! iFound);
+
+   iFound = SymTable_contains(oSymTable,
+      "a.long.qualified.symbol.name.ending.in.3");
+   ASSURE(! iFound);
+
+   piValue = (int*)SymTable_remove(oSymTable, "prefix__a");
+   ASSURE(piValue == &aiValues[2]);
+
+   piValue = (int*)SymTable_remove(oSymTable,
+      "a.long.qualified.symbol.name.ending.in.1");
+   ASSURE(piValue == &aiValues[5]);
+
+   piValue = (int*)SymTable_get(oSymTable, "prefix__ab");
+   ASSURE(piValue == &aiValues[4]);
+
+   piValue = (int*)SymTable_get(oSymTable,
+      "a.long.qualified.symbol.name.ending.in.12");
+   ASSURE(piValue == &aiValues[7]);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
 /* Test the ability of SymTable object to have values that are
    other SymTable objects. */
 
@@ -700,7 +774,7 @@ static void testTableOfTables(void)
    test assumes that a SymTable object is implemented as a hash table,
    that there are 509 buckets in the hash table, and that the
    implementation uses the hash function provided in the assignment
-   specification. */
+   specification, reduced to a bucket as in symtablehash.c. */
 
 static void testCollisions(void)
 {
@@ -723,52 +797,52 @@ static void testCollisions(void)
    oSymTable = SymTable_new();
    ASSURE(oSymTable != NULL);
 
-   /* Note that strings "250", "469", "947", "1303", and "2016" hash
-      to the same bucket -- bucket 123. */
+   /* Note that strings "250", "652", "1070", "1086", and "2774" hash
+      to the same bucket -- bucket 52. */
 
    iSuccessful = SymTable_put(oSymTable, "250", acCenterField);
    ASSURE(iSuccessful);
 
-   iSuccessful = SymTable_put(oSymTable, "469", acCatcher);
+   iSuccessful = SymTable_put(oSymTable, "652", acCatcher);
    ASSURE(iSuccessful);
 
-   iSuccessful = SymTable_put(oSymTable, "947", acFirstBase);
+   iSuccessful = SymTable_put(oSymTable, "1070", acFirstBase);
    ASSURE(iSuccessful);
 
-   iSuccessful = SymTable_put(oSymTable, "1303", acRightField);
+   iSuccessful = SymTable_put(oSymTable, "1086", acRightField);
    ASSURE(iSuccessful);
 
-   iSuccessful = SymTable_put(oSymTable, "2016", acRightField);
+   iSuccessful = SymTable_put(oSymTable, "2774", acRightField);
    ASSURE(iSuccessful);
 
    pcValue = SymTable_get(oSymTable, "250");
    ASSURE(pcValue == acCenterField);
 
-   pcValue = SymTable_get(oSymTable, "469");
+   pcValue = SymTable_get(oSymTable, "652");
    ASSURE(pcValue == acCatcher);
 
-   pcValue = SymTable_get(oSymTable, "947");
+   pcValue = SymTable_get(oSymTable, "1070");
    ASSURE(pcValue == acFirstBase);
 
-   pcValue = SymTable_get(oSymTable, "1303");
+   pcValue = SymTable_get(oSymTable, "1086");
    ASSURE(pcValue == acRightField);
 
-   pcValue = SymTable_get(oSymTable, "2016");
+   pcValue = SymTable_get(oSymTable, "2774");
    ASSURE(pcValue == acRightField);
 
-   pcValue = SymTable_remove(oSymTable, "947");
+   pcValue = SymTable_remove(oSymTable, "1070");
    ASSURE(pcValue == acFirstBase);
 
-   pcValue = SymTable_remove(oSymTable, "2016");
+   pcValue = SymTable_remove(oSymTable, "2774");
    ASSURE(pcValue == acRightField);
 
    pcValue = SymTable_remove(oSymTable, "250");
    ASSURE(pcValue == acCenterField);
 
-   pcValue = SymTable_get(oSymTable, "469");
+   pcValue = SymTable_get(oSymTable, "652");
    ASSURE(pcValue == acCatcher);
 
-   pcValue = SymTable_get(oSymTable, "1303");
+   pcValue = SymTable_get(oSymTable, "1086");
    ASSURE(pcValue == acRightField);
 
    SymTable_free(oSymTable);
@@ -776,6 +850,294 @@ static void testCollisions(void)
 
 /*--------------------------------------------------------------------*/
 
+/* Test SymTable_setSelfOrganizing(): reordering keys as they are
+   found must never lose or mislabel a binding. The colliding keys of
+   testCollisions() share one chain of a hash table. */
+
+static void testSelfOrganizing(void)
+{
+   enum {KEY_COUNT = 5, ROUND_COUNT = 20};
+
+   static const char *apcKeys[KEY_COUNT] =
+      {"250", "652", "1070", "1086", "2774"};
+   SymTable_T oSymTable;
+   int aiValues[KEY_COUNT];
+   int iSuccessful;
+   int iFound;
+   int iRound;
+   int i;
+   int *piValue;
+   size_t uLength;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing a self-organizing SymTable object.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   SymTable_setSelfOrganizing(oSymTable, 1);
+
+   for (i = 0; i < KEY_COUNT; i++)
+   {
+      aiValues[i] = i;
+      iSuccessful = SymTable_put(oSymTable, apcKeys[i], &aiValues[i]);
+      ASSURE(iSuccessful);
+   }
+
+   /* Look keys up in an order that moves every key to the front
+      at least once. */
+   for (iRound = 0; iRound < ROUND_COUNT; iRound++)
+   {
+      i = (iRound * 3) % KEY_COUNT;
+      piValue = (int*)SymTable_get(oSymTable, apcKeys[i]);
+      ASSURE(piValue == &aiValues[i]);
+      iFound = SymTable_contains(oSymTable, apcKeys[KEY_COUNT - 1 - i]);
+      ASSURE(iFound);
+   }
+
+   iFound = SymTable_contains(oSymTable, "3000");
+   ASSURE(! iFound);
+
+   iSuccessful = SymTable_put(oSymTable, "1070", &aiValues[0]);
+   ASSURE(! iSuccessful);
+
+   uLength = SymTable_getLength(oSymTable);
+   ASSURE(uLength == KEY_COUNT);
+
+   piValue = (int*)SymTable_replace(oSymTable, "2774", &aiValues[0]);
+   ASSURE(piValue == &aiValues[4]);
+
+   piValue = (int*)SymTable_get(oSymTable, "2774");
+   ASSURE(piValue == &aiValues[0]);
+
+   /* Remove a key just moved to the front, then one behind it. */
+   piValue = (int*)SymTable_get(oSymTable, "652");
+   ASSURE(piValue == &aiValues[1]);
+   piValue = (int*)SymTable_remove(oSymTable, "652");
+   ASSURE(piValue == &aiValues[1]);
+   piValue = (int*)SymTable_remove(oSymTable, "250");
+   ASSURE(piValue == &aiValues[0]);
+
+   piValue = (int*)SymTable_get(oSymTable, "1070");
+   ASSURE(piValue == &aiValues[2]);
+   piValue = (int*)SymTable_get(oSymTable, "1086");
+   ASSURE(piValue == &aiValues[3]);
+
+   /* Turning the mode off leaves the bindings as they are. */
+   SymTable_setSelfOrganizing(oSymTable, 0);
+
+   piValue = (int*)SymTable_get(oSymTable, "2774");
+   ASSURE(piValue == &aiValues[0]);
+
+   uLength = SymTable_getLength(oSymTable);
+   ASSURE(uLength == KEY_COUNT - 2);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_newWithCapacity() and SymTable_reserve(). */
+
+static void testCapacity(void)
+{
+   enum {BINDING_COUNT = 2000, MAX_KEY_LENGTH = 12};
+
+   SymTable_T oSymTable;
+   char acKey[MAX_KEY_LENGTH];
+   char acShortstop[] = "Shortstop";
+   char acCenterField[] = "CenterField";
+   char *pcValue;
+   int iSuccessful;
+   int i;
+   size_t uLength;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable objects with reserved capacity.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   /* A table created with capacity behaves like any other table. */
+   oSymTable = SymTable_newWithCapacity(BINDING_COUNT);
+   ASSURE(oSymTable != NULL);
+
+   uLength = SymTable_getLength(oSymTable);
+   ASSURE(uLength == 0);
+
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, acShortstop);
+      ASSURE(iSuccessful);
+   }
+
+   /* Past the reserved capacity the table still grows. */
+   for (i = BINDING_COUNT; i < 2 * BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, acCenterField);
+      ASSURE(iSuccessful);
+   }
+
+   uLength = SymTable_getLength(oSymTable);
+   ASSURE(uLength == 2 * BINDING_COUNT);
+
+   pcValue = (char*)SymTable_get(oSymTable, "0");
+   ASSURE(pcValue == acShortstop);
+   pcValue = (char*)SymTable_get(oSymTable, "3999");
+   ASSURE(pcValue == acCenterField);
+
+   SymTable_free(oSymTable);
+
+   /* A zero capacity is allowed. */
+   oSymTable = SymTable_newWithCapacity(0);
+   ASSURE(oSymTable != NULL);
+   SymTable_free(oSymTable);
+
+   /* A capacity too large for any table fails at once, unless the
+      table sets nothing aside up front, in which case it is ignored.
+      Either way the table is left as it was. */
+   oSymTable = SymTable_newWithCapacity((size_t)-1 / 10);
+   if (oSymTable != NULL)
+      SymTable_free(oSymTable);
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   iSuccessful = SymTable_put(oSymTable, "Jeter", acShortstop);
+   ASSURE(iSuccessful);
+   (void)SymTable_reserve(oSymTable, (size_t)-1 / 10);
+   (void)SymTable_reserve(oSymTable, (size_t)-1);
+   uLength = SymTable_getLength(oSymTable);
+   ASSURE(uLength == 1);
+   pcValue = (char*)SymTable_get(oSymTable, "Jeter");
+   ASSURE(pcValue == acShortstop);
+   SymTable_free(oSymTable);
+
+   /* Reserving keeps existing bindings, and reserving less than the
+      current size changes nothing. */
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   iSuccessful = SymTable_put(oSymTable, "Jeter", acShortstop);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_put(oSymTable, "Mantle", acCenterField);
+   ASSURE(iSuccessful);
+
+   iSuccessful = SymTable_reserve(oSymTable, 100000);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_reserve(oSymTable, 1);
+   ASSURE(iSuccessful);
+
+   uLength = SymTable_getLength(oSymTable);
+   ASSURE(uLength == 2);
+
+   pcValue = (char*)SymTable_get(oSymTable, "Jeter");
+   ASSURE(pcValue == acShortstop);
+   pcValue = (char*)SymTable_get(oSymTable, "Mantle");
+   ASSURE(pcValue == acCenterField);
+
+   pcValue = (char*)SymTable_remove(oSymTable, "Jeter");
+   ASSURE(pcValue == acShortstop);
+   iSuccessful = SymTable_put(oSymTable, "Jeter", acCenterField);
+   ASSURE(iSuccessful);
+   pcValue = (char*)SymTable_get(oSymTable, "Jeter");
+   ASSURE(pcValue == acCenterField);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that a SymTable object keeps its bindings while it shrinks,
+   either on its own as bindings are removed or through
+   SymTable_shrinkToFit(). */
+
+static void testShrink(void)
+{
+   enum {BINDING_COUNT = 20000, KEPT_COUNT = 10, MAX_KEY_LENGTH = 12};
+
+   SymTable_T oSymTable;
+   char acKey[MAX_KEY_LENGTH];
+   char acShortstop[] = "Shortstop";
+   char *pcValue;
+   int iSuccessful;
+   int iFound;
+   int i;
+   size_t uLength;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing a SymTable object that shrinks.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, acShortstop);
+      ASSURE(iSuccessful);
+   }
+
+   /* Drain all but KEPT_COUNT bindings. */
+   for (i = KEPT_COUNT; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      pcValue = (char*)SymTable_remove(oSymTable, acKey);
+      ASSURE(pcValue == acShortstop);
+   }
+
+   uLength = SymTable_getLength(oSymTable);
+   ASSURE(uLength == KEPT_COUNT);
+
+   for (i = 0; i < KEPT_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      pcValue = (char*)SymTable_get(oSymTable, acKey);
+      ASSURE(pcValue == acShortstop);
+   }
+
+   iFound = SymTable_contains(oSymTable, "10");
+   ASSURE(! iFound);
+
+   /* Oscillate around the point where the table shrank. */
+   for (i = 0; i < 100; i++)
+   {
+      iSuccessful = SymTable_put(oSymTable, "Jeter", acShortstop);
+      ASSURE(iSuccessful);
+      pcValue = (char*)SymTable_remove(oSymTable, "Jeter");
+      ASSURE(pcValue == acShortstop);
+   }
+
+   /* Shrinking a reserved table to fit keeps its bindings. */
+   iSuccessful = SymTable_reserve(oSymTable, 100000);
+   ASSURE(iSuccessful);
+   SymTable_shrinkToFit(oSymTable);
+
+   uLength = SymTable_getLength(oSymTable);
+   ASSURE(uLength == KEPT_COUNT);
+
+   for (i = 0; i < KEPT_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      pcValue = (char*)SymTable_remove(oSymTable, acKey);
+      ASSURE(pcValue == acShortstop);
+   }
+
+   /* Shrinking an empty table leaves it usable. */
+   SymTable_shrinkToFit(oSymTable);
+   iSuccessful = SymTable_put(oSymTable, "Mantle", acShortstop);
+   ASSURE(iSuccessful);
+   pcValue = (char*)SymTable_get(oSymTable, "Mantle");
+   ASSURE(pcValue == acShortstop);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
 /* Test the ability of a SymTable object to be large, that is, to
    contain iBindingCount bindings. Write the time consumed to stdout. */
 
@@ -958,8 +1320,12 @@ int main(int argc, char *argv[])
    testEmptyKey();
    testNullValue();
    testLongKey();
+   testSharedPrefix();
    testTableOfTables();
    testCollisions();
+   testSelfOrganizing();
+   testCapacity();
+   testShrink();
    testLargeTable(iBindingCount);
 
    printf("------------------------------------------------------\n");
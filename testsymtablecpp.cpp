@@ -0,0 +1,283 @@
+/*--------------------------------------------------------------------*/
+/* testsymtablecpp.cpp                                                */
+/* Author: Ryan Chen                                                  */
+/*--------------------------------------------------------------------*/
+
+#include "symtable.hpp"
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+
+/*--------------------------------------------------------------------*/
+
+#define ASSURE(i) assure(i, __LINE__)
+
+/*--------------------------------------------------------------------*/
+
+/* If !iSuccessful, print a message to stdout indicating that the
+   test at line iLineNum failed. */
+
+static void assure(int iSuccessful, int iLineNum)
+{
+   if (! iSuccessful)
+   {
+      std::printf("Test at line %d failed.\n", iLineNum);
+      std::fflush(stdout);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Keywords looked up at compile time by testFixed(). */
+static constexpr auto oKeywords = symtab::makeFixedSymTable<int>(
+   {{"if", 1}, {"else", 2}, {"while", 3}, {"for", 4}, {"return", 5},
+    {"int", 6}, {"char", 7}, {"struct", 8}});
+
+static_assert(oKeywords.getLength() == 8, "eight keywords");
+static_assert(*oKeywords.get("while") == 3, "while is bound");
+static_assert(oKeywords.contains("struct"), "struct is bound");
+static_assert(! oKeywords.contains("goto"), "goto is not bound");
+static_assert(oKeywords.get("") == nullptr, "the empty key is unbound");
+
+/*--------------------------------------------------------------------*/
+
+/* Test the basic operations of symtab::SymTable. */
+
+static void testBasics()
+{
+   symtab::SymTable<std::string> oTable;
+   std::optional<std::string> oOld;
+   std::string *psValue;
+   bool bSuccessful;
+
+   std::printf("------------------------------------------------------\n");
+   std::printf("Testing the basic operations of symtab::SymTable.\n");
+   std::printf("No output should appear here:\n");
+   std::fflush(stdout);
+
+   ASSURE(oTable.getLength() == 0);
+
+   bSuccessful = oTable.put("Ruth", "RightField");
+   ASSURE(bSuccessful);
+   bSuccessful = oTable.put("Gehrig", "FirstBase");
+   ASSURE(bSuccessful);
+   bSuccessful = oTable.put("Ruth", "CenterField");
+   ASSURE(! bSuccessful);
+   ASSURE(oTable.getLength() == 2);
+
+   psValue = oTable.get("Ruth");
+   ASSURE(psValue != nullptr && *psValue == "RightField");
+   ASSURE(oTable.get("Mantle") == nullptr);
+   ASSURE(oTable.contains("Gehrig"));
+   ASSURE(! oTable.contains("gehrig"));
+
+   /* Keys are copied: the table does not see later changes. */
+   {
+      std::string oKey = "Jeter";
+      bSuccessful = oTable.put(oKey, "Shortstop");
+      ASSURE(bSuccessful);
+      oKey[0] = 'X';
+      ASSURE(oTable.contains("Jeter"));
+      ASSURE(! oTable.contains("Xeter"));
+   }
+
+   oOld = oTable.replace("Ruth", "Pitcher");
+   ASSURE(oOld.has_value() && *oOld == "RightField");
+   ASSURE(*oTable.get("Ruth") == "Pitcher");
+   oOld = oTable.replace("Mantle", "CenterField");
+   ASSURE(! oOld.has_value());
+
+   oOld = oTable.remove("Gehrig");
+   ASSURE(oOld.has_value() && *oOld == "FirstBase");
+   oOld = oTable.remove("Gehrig");
+   ASSURE(! oOld.has_value());
+   ASSURE(oTable.getLength() == 2);
+
+   /* The empty key and keys with a shared prefix are distinct. */
+   bSuccessful = oTable.put("", "Empty");
+   ASSURE(bSuccessful);
+   bSuccessful = oTable.put("Ruthless", "Other");
+   ASSURE(bSuccessful);
+   ASSURE(*oTable.get("") == "Empty");
+   ASSURE(*oTable.get("Ruth") == "Pitcher");
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test a symtab::SymTable whose values can only be moved, and moving
+   the table itself. */
+
+static void testMoveOnly()
+{
+   symtab::SymTable<std::unique_ptr<int>> oTable;
+   symtab::SymTable<std::unique_ptr<int>> oMoved;
+   std::optional<std::unique_ptr<int>> oOld;
+   std::unique_ptr<int> *ppiValue;
+   bool bSuccessful;
+
+   std::printf("------------------------------------------------------\n");
+   std::printf("Testing a symtab::SymTable of move-only values.\n");
+   std::printf("No output should appear here:\n");
+   std::fflush(stdout);
+
+   bSuccessful = oTable.put("one", std::make_unique<int>(1));
+   ASSURE(bSuccessful);
+   bSuccessful = oTable.emplace("two", new int(2));
+   ASSURE(bSuccessful);
+
+   ppiValue = oTable.get("two");
+   ASSURE(ppiValue != nullptr && **ppiValue == 2);
+
+   oOld = oTable.replace("one", std::make_unique<int>(10));
+   ASSURE(oOld.has_value() && **oOld == 1);
+
+   oMoved = std::move(oTable);
+   ASSURE(oMoved.getLength() == 2);
+   ASSURE(oTable.getLength() == 0);
+   ASSURE(**oMoved.get("one") == 10);
+
+   oOld = oMoved.remove("two");
+   ASSURE(oOld.has_value() && **oOld == 2);
+
+   /* The moved-from table is empty, and still usable. */
+   ASSURE(! oTable.contains("one"));
+   ASSURE(oTable.get("one") == nullptr);
+   ASSURE(! oTable.remove("one").has_value());
+   ASSURE(! oTable.replace("one", std::make_unique<int>(1)).has_value());
+   oTable.shrinkToFit();
+   ASSURE(oTable.put("three", std::make_unique<int>(3)));
+   ASSURE(oTable.getLength() == 1 && **oTable.get("three") == 3);
+
+   oMoved = std::move(oTable);
+   ASSURE(! oTable.contains("three"));
+   oTable.reserve(100);
+   ASSURE(oTable.put("four", std::make_unique<int>(4)));
+   ASSURE(**oTable.get("four") == 4);
+   ASSURE(**oMoved.get("three") == 3);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test symtab::SymTable::map() with lambdas. */
+
+static void testMap()
+{
+   enum {BINDING_COUNT = 1000};
+
+   symtab::SymTable<int> oTable;
+   const symtab::SymTable<int> &oConstTable = oTable;
+   long lSum = 0;
+   std::size_t uCount = 0;
+   int i;
+
+   std::printf("------------------------------------------------------\n");
+   std::printf("Testing symtab::SymTable::map().\n");
+   std::printf("No output should appear here:\n");
+   std::fflush(stdout);
+
+   for (i = 0; i < BINDING_COUNT; i++)
+      oTable.put(std::to_string(i), i);
+
+   oTable.map([](std::string_view oKey, int &iValue)
+      {
+         (void)oKey;
+         iValue *= 2;
+      });
+
+   oConstTable.map([&](std::string_view oKey, const int &iValue)
+      {
+         ASSURE(std::to_string(iValue / 2) == oKey);
+         lSum += iValue;
+         uCount++;
+      });
+
+   ASSURE(uCount == BINDING_COUNT);
+   ASSURE(lSum == (long)BINDING_COUNT * (BINDING_COUNT - 1));
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test a symtab::SymTable that grows, shrinks and is reserved. */
+
+static void testLarge()
+{
+   enum {BINDING_COUNT = 100000, KEPT_COUNT = 10};
+
+   symtab::SymTable<int> oTable(16);
+   int *piValue;
+   int i;
+
+   std::printf("------------------------------------------------------\n");
+   std::printf("Testing a large symtab::SymTable.\n");
+   std::printf("No output should appear here:\n");
+   std::fflush(stdout);
+
+   for (i = 0; i < BINDING_COUNT; i++)
+      ASSURE(oTable.put(std::to_string(i), i));
+   ASSURE(oTable.getLength() == BINDING_COUNT);
+
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      piValue = oTable.get(std::to_string(i));
+      ASSURE(piValue != nullptr && *piValue == i);
+   }
+
+   for (i = KEPT_COUNT; i < BINDING_COUNT; i++)
+      ASSURE(oTable.remove(std::to_string(i)).value_or(-1) == i);
+   ASSURE(oTable.getLength() == KEPT_COUNT);
+
+   oTable.reserve(BINDING_COUNT);
+   oTable.shrinkToFit();
+
+   for (i = 0; i < BINDING_COUNT; i++)
+      ASSURE(oTable.contains(std::to_string(i)) == (i < KEPT_COUNT));
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test symtab::FixedSymTable at run time. */
+
+static void testFixed()
+{
+   std::string oKey = "retur";
+   int iSum = 0;
+
+   std::printf("------------------------------------------------------\n");
+   std::printf("Testing symtab::FixedSymTable.\n");
+   std::printf("No output should appear here:\n");
+   std::fflush(stdout);
+
+   ASSURE(! oKeywords.contains(oKey));
+   oKey += 'n';
+   ASSURE(oKeywords.contains(oKey));
+   ASSURE(*oKeywords.get(oKey) == 5);
+
+   oKeywords.map([&](std::string_view oName, const int &iValue)
+      {
+         ASSURE(*oKeywords.get(oName) == iValue);
+         iSum += iValue;
+      });
+   ASSURE(iSum == 36);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test symtable.hpp. Write the output of the tests to stdout. Return
+   0. */
+
+int main(int argc, char *argv[])
+{
+   (void)argc;
+
+   testBasics();
+   testMoveOnly();
+   testMap();
+   testLarge();
+   testFixed();
+
+   std::printf("------------------------------------------------------\n");
+   std::printf("End of %s.\n", argv[0]);
+   return 0;
+}
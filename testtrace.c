@@ -0,0 +1,421 @@
+/*--------------------------------------------------------------------*/
+/* testtrace.c                                                        */
+/* Author: Ryan Chen                                                  */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+#include "symtable.h"
+#include "symtabletrace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <assert.h>
+
+/*--------------------------------------------------------------------*/
+
+#define ASSURE(i) assure(i, __LINE__)
+
+/* Length of a key longer than the trace's buffer */
+enum {LONG_KEY_LENGTH = 100000};
+
+/*--------------------------------------------------------------------*/
+
+/* If !iSuccessful, print a message to stdout indicating that the
+   test at line iLineNum failed. */
+
+static void assure(int iSuccessful, int iLineNum)
+{
+   if (! iSuccessful)
+   {
+      printf("Test at line %d failed.\n", iLineNum);
+      fflush(stdout);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Copy the name of a new, empty temporary file to acFileName. */
+
+static void makeFile(char acFileName[])
+{
+   int iFd;
+
+   strcpy(acFileName, "/tmp/testtraceXXXXXX");
+   iFd = mkstemp(acFileName);
+   ASSURE(iFd >= 0);
+   close(iFd);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Run pfTraced in a child process that traces its tables to the file
+   acFileName, one in every pcSample, or all of them if pcSample is
+   NULL, and wait for it to exit and finish the trace. A process reads
+   its trace settings only once, so each trace needs a process of its
+   own. */
+
+static void traceInChild(const char acFileName[], const char *pcSample,
+   void (*pfTraced)(void))
+{
+   pid_t iPid;
+   int iStatus;
+
+   fflush(stdout);
+   iPid = fork();
+   ASSURE(iPid >= 0);
+   if (iPid == 0)
+   {
+      setenv("SYMTABLE_TRACE", acFileName, 1);
+      if (pcSample != NULL)
+         setenv("SYMTABLE_TRACE_SAMPLE", pcSample, 1);
+      (*pfTraced)();
+      exit(0);
+   }
+   ASSURE(waitpid(iPid, &iStatus, 0) == iPid);
+   ASSURE(WIFEXITED(iStatus) && WEXITSTATUS(iStatus) == 0);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Read the next record of oReader into *psRecord, and check that it
+   is eOp on the table with id ulTableId, with the key pcKey, or none
+   if pcKey is NULL, and the result iResult. */
+
+static void checkRecord(SymTableTraceReader_T oReader,
+   struct SymTableTraceRecord *psRecord, enum SymTableTraceOp eOp,
+   unsigned long ulTableId, const char *pcKey, int iResult)
+{
+   uint64_t uLastTime = psRecord->time;
+
+   ASSURE(SymTableTraceReader_next(oReader, psRecord) == 1);
+   ASSURE(psRecord->op == eOp);
+   ASSURE(psRecord->tableId == ulTableId);
+   ASSURE(psRecord->result == iResult);
+   ASSURE(psRecord->time >= uLastTime);
+   if (pcKey == NULL)
+      ASSURE(psRecord->pcKey == NULL);
+   else
+      ASSURE(psRecord->pcKey != NULL &&
+             psRecord->keyLength == strlen(pcKey) &&
+             memcmp(psRecord->pcKey, pcKey, psRecord->keyLength) == 0);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Do nothing with bindings. */
+
+static void ignoreBinding(const char *pcKey, void *pvValue,
+   void *pvExtra)
+{
+   (void)pcKey;
+   (void)pvValue;
+   (void)pvExtra;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Call each traced operation on two tables, freeing only the first,
+   with one key longer than the trace's buffer. */
+
+static void doOperations(void)
+{
+   /* Still in use at exit, but reachable */
+   static SymTable_T oSecond;
+
+   SymTable_T oFirst;
+   char *pcLongKey;
+
+   pcLongKey = (char *)malloc(LONG_KEY_LENGTH + 1);
+   ASSURE(pcLongKey != NULL);
+   memset(pcLongKey, 'k', LONG_KEY_LENGTH);
+   pcLongKey[LONG_KEY_LENGTH] = '\0';
+
+   oFirst = SymTable_new();
+   oSecond = SymTable_new();
+   ASSURE(oFirst != NULL && oSecond != NULL);
+
+   ASSURE(SymTable_put(oFirst, "alpha", "1"));
+   ASSURE(! SymTable_put(oFirst, "alpha", "2"));
+   ASSURE(SymTable_put(oSecond, "", "empty"));
+   ASSURE(SymTable_get(oFirst, "alpha") != NULL);
+   ASSURE(SymTable_get(oFirst, "beta") == NULL);
+   ASSURE(SymTable_contains(oSecond, ""));
+   ASSURE(SymTable_replace(oFirst, "alpha", "3") != NULL);
+   ASSURE(SymTable_replace(oFirst, "beta", "3") == NULL);
+   ASSURE(SymTable_put(oSecond, pcLongKey, "long"));
+   SymTable_map(oFirst, ignoreBinding, NULL);
+   ASSURE(SymTable_remove(oFirst, "alpha") != NULL);
+   ASSURE(SymTable_remove(oFirst, "alpha") == NULL);
+   SymTable_free(oFirst);
+   free(pcLongKey);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Create seven tables, putting a key in each. */
+
+static void doSampledOperations(void)
+{
+   SymTable_T aoTables[7];
+   char acKey[2];
+   size_t u;
+
+   acKey[1] = '\0';
+   for (u = 0; u < 7; u++)
+   {
+      aoTables[u] = SymTable_new();
+      ASSURE(aoTables[u] != NULL);
+      acKey[0] = (char)('a' + u);
+      ASSURE(SymTable_put(aoTables[u], acKey, "value"));
+   }
+   for (u = 0; u < 7; u++)
+      SymTable_free(aoTables[u]);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Bind a key in a table, then fork a child that binds keys in a table
+   of its own and in the inherited one, and check the child's trace.
+   Once the child has exited, bind another key in the first table and
+   free it. */
+
+static void doForkedOperations(void)
+{
+   SymTableTraceReader_T oReader;
+   struct SymTableTraceRecord sRecord;
+   SymTable_T oParent;
+   SymTable_T oChild;
+   char acChildFileName[64];
+   pid_t iPid;
+   int iStatus;
+
+   oParent = SymTable_new();
+   ASSURE(oParent != NULL);
+   ASSURE(SymTable_put(oParent, "parent", "1"));
+
+   fflush(stdout);
+   iPid = fork();
+   ASSURE(iPid >= 0);
+   if (iPid == 0)
+   {
+      oChild = SymTable_new();
+      ASSURE(oChild != NULL);
+      ASSURE(SymTable_put(oChild, "child", "2"));
+      ASSURE(SymTable_put(oParent, "inherited", "3"));
+      SymTable_free(oChild);
+      exit(0);
+   }
+   ASSURE(waitpid(iPid, &iStatus, 0) == iPid);
+   ASSURE(WIFEXITED(iStatus) && WEXITSTATUS(iStatus) == 0);
+
+   /* The child's trace holds only the table it created. */
+   sprintf(acChildFileName, "%.40s.%ld", getenv("SYMTABLE_TRACE"),
+      (long)iPid);
+   oReader = SymTableTraceReader_open(acChildFileName);
+   ASSURE(oReader != NULL);
+   sRecord.time = 0;
+   checkRecord(oReader, &sRecord, SYMTABLE_TRACE_NEW, 2, NULL, 1);
+   checkRecord(oReader, &sRecord, SYMTABLE_TRACE_PUT, 2, "child", 1);
+   checkRecord(oReader, &sRecord, SYMTABLE_TRACE_FREE, 2, NULL, 1);
+   ASSURE(SymTableTraceReader_next(oReader, &sRecord) == 0);
+   SymTableTraceReader_free(oReader);
+   unlink(acChildFileName);
+
+   ASSURE(SymTable_put(oParent, "after", "4"));
+   SymTable_free(oParent);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that a trace holds each operation on each table, in order, and
+   ends with what was still buffered when the process exited. */
+
+static void testRecords(void)
+{
+   SymTableTraceReader_T oReader;
+   struct SymTableTraceRecord sRecord;
+   char acFileName[32];
+   char *pcLongKey;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the records of each traced operation.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   makeFile(acFileName);
+   traceInChild(acFileName, NULL, doOperations);
+
+   pcLongKey = (char *)malloc(LONG_KEY_LENGTH + 1);
+   ASSURE(pcLongKey != NULL);
+   memset(pcLongKey, 'k', LONG_KEY_LENGTH);
+   pcLongKey[LONG_KEY_LENGTH] = '\0';
+
+   oReader = SymTableTraceReader_open(acFileName);
+   ASSURE(oReader != NULL);
+   sRecord.time = 0;
+   checkRecord(oReader, &sRecord, SYMTABLE_TRACE_NEW, 1, NULL, 1);
+   checkRecord(oReader, &sRecord, SYMTABLE_TRACE_NEW, 2, NULL, 1);
+   checkRecord(oReader, &sRecord, SYMTABLE_TRACE_PUT, 1, "alpha", 1);
+   checkRecord(oReader, &sRecord, SYMTABLE_TRACE_PUT, 1, "alpha", 0);
+   checkRecord(oReader, &sRecord, SYMTABLE_TRACE_PUT, 2, "", 1);
+   checkRecord(oReader, &sRecord, SYMTABLE_TRACE_GET, 1, "alpha", 1);
+   checkRecord(oReader, &sRecord, SYMTABLE_TRACE_GET, 1, "beta", 0);
+   checkRecord(oReader, &sRecord, SYMTABLE_TRACE_CONTAINS, 2, "", 1);
+   checkRecord(oReader, &sRecord, SYMTABLE_TRACE_REPLACE, 1, "alpha", 1);
+   checkRecord(oReader, &sRecord, SYMTABLE_TRACE_REPLACE, 1, "beta", 0);
+   checkRecord(oReader, &sRecord, SYMTABLE_TRACE_PUT, 2, pcLongKey, 1);
+   checkRecord(oReader, &sRecord, SYMTABLE_TRACE_MAP, 1, NULL, 1);
+   checkRecord(oReader, &sRecord, SYMTABLE_TRACE_REMOVE, 1, "alpha", 1);
+   checkRecord(oReader, &sRecord, SYMTABLE_TRACE_REMOVE, 1, "alpha", 0);
+   checkRecord(oReader, &sRecord, SYMTABLE_TRACE_FREE, 1, NULL, 1);
+   ASSURE(SymTableTraceReader_next(oReader, &sRecord) == 0);
+   SymTableTraceReader_free(oReader);
+
+   free(pcLongKey);
+   unlink(acFileName);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that SYMTABLE_TRACE_SAMPLE traces every operation of one table
+   in each so many, and none of the rest. */
+
+static void testSampling(void)
+{
+   static const unsigned long aulTraced[] = {1, 4, 7};
+   static const char *apcKeys[] = {"a", "d", "g"};
+
+   SymTableTraceReader_T oReader;
+   struct SymTableTraceRecord sRecord;
+   char acFileName[32];
+   size_t u;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing tracing one table in every three.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   makeFile(acFileName);
+   traceInChild(acFileName, "3", doSampledOperations);
+
+   oReader = SymTableTraceReader_open(acFileName);
+   ASSURE(oReader != NULL);
+   sRecord.time = 0;
+   for (u = 0; u < 3; u++)
+   {
+      checkRecord(oReader, &sRecord, SYMTABLE_TRACE_NEW, aulTraced[u],
+         NULL, 1);
+      checkRecord(oReader, &sRecord, SYMTABLE_TRACE_PUT, aulTraced[u],
+         apcKeys[u], 1);
+   }
+   for (u = 0; u < 3; u++)
+      checkRecord(oReader, &sRecord, SYMTABLE_TRACE_FREE, aulTraced[u],
+         NULL, 1);
+   ASSURE(SymTableTraceReader_next(oReader, &sRecord) == 0);
+   SymTableTraceReader_free(oReader);
+
+   unlink(acFileName);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that a trace cut short reads as far as its last whole record,
+   and that a file that is not a trace does not open. */
+
+static void testMalformed(void)
+{
+   SymTableTraceReader_T oReader;
+   struct SymTableTraceRecord sRecord;
+   char acFileName[32];
+   FILE *psFile;
+   long lLength;
+   size_t uRecordCount = 0;
+   int iStatus;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing reading a truncated trace and a non-trace.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   makeFile(acFileName);
+   traceInChild(acFileName, NULL, doOperations);
+
+   /* Cut the trace off inside its last record. */
+   psFile = fopen(acFileName, "rb");
+   ASSURE(psFile != NULL);
+   ASSURE(fseek(psFile, 0, SEEK_END) == 0);
+   lLength = ftell(psFile);
+   fclose(psFile);
+   ASSURE(truncate(acFileName, lLength - 1) == 0);
+
+   oReader = SymTableTraceReader_open(acFileName);
+   ASSURE(oReader != NULL);
+   while ((iStatus = SymTableTraceReader_next(oReader, &sRecord)) == 1)
+      uRecordCount++;
+   ASSURE(iStatus == -1);
+   ASSURE(uRecordCount == 14);
+   SymTableTraceReader_free(oReader);
+
+   psFile = fopen(acFileName, "wb");
+   ASSURE(psFile != NULL);
+   fputs("alpha\t1\n", psFile);
+   fclose(psFile);
+   ASSURE(SymTableTraceReader_open(acFileName) == NULL);
+
+   unlink(acFileName);
+   ASSURE(SymTableTraceReader_open(acFileName) == NULL);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that a child forked by a traced process writes a trace of its
+   own, and leaves the parent's trace as though the child never
+   ran. */
+
+static void testFork(void)
+{
+   SymTableTraceReader_T oReader;
+   struct SymTableTraceRecord sRecord;
+   char acFileName[32];
+
+   printf("------------------------------------------------------\n");
+   printf("Testing tracing a process that forks.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   makeFile(acFileName);
+   traceInChild(acFileName, NULL, doForkedOperations);
+
+   oReader = SymTableTraceReader_open(acFileName);
+   ASSURE(oReader != NULL);
+   sRecord.time = 0;
+   checkRecord(oReader, &sRecord, SYMTABLE_TRACE_NEW, 1, NULL, 1);
+   checkRecord(oReader, &sRecord, SYMTABLE_TRACE_PUT, 1, "parent", 1);
+   checkRecord(oReader, &sRecord, SYMTABLE_TRACE_PUT, 1, "after", 1);
+   checkRecord(oReader, &sRecord, SYMTABLE_TRACE_FREE, 1, NULL, 1);
+   ASSURE(SymTableTraceReader_next(oReader, &sRecord) == 0);
+   SymTableTraceReader_free(oReader);
+
+   unlink(acFileName);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test tracing tables and reading the traces back. Return 0. */
+
+int main(int argc, char *argv[])
+{
+   (void)argc;
+
+   testRecords();
+   testSampling();
+   testMalformed();
+   testFork();
+
+   printf("------------------------------------------------------\n");
+   printf("End of %s.\n", argv[0]);
+   return 0;
+}